@@ -31,6 +31,7 @@ extern "C" {
 #include <as-provided.h>
 #include <as-metadata.h>
 #include <as-pool.h>
+#include <as-composite-pool.h>
 #include <as-category.h>
 #include <as-distro-details.h>
 #include <as-icon.h>
@@ -28,6 +28,17 @@
 G_BEGIN_DECLS
 #pragma GCC visibility push(hidden)
 
+/**
+ * AsBundleRecord:
+ *
+ * Plain value representation of a bundle, used to avoid
+ * creating a full #AsBundle object for every cache entry.
+ */
+typedef struct {
+	AsBundleKind	kind;
+	gchar		*id;
+} AsBundleRecord;
+
 gboolean	as_bundle_load_from_xml (AsBundle *bundle,
 					AsContext *ctx,
 					xmlNode *node,
@@ -49,6 +60,13 @@ void		as_bundle_to_variant (AsBundle *bundle,
 gboolean	as_bundle_set_from_variant (AsBundle *bundle,
 					    GVariant *variant);
 
+void		as_bundle_record_clear (AsBundleRecord *rec);
+gboolean	as_bundle_record_set_from_variant (AsBundleRecord *rec,
+						   GVariant *variant);
+void		as_bundle_record_to_variant (const AsBundleRecord *rec,
+					     GVariantBuilder *builder);
+AsBundle	*as_bundle_new_from_record (AsBundleRecord *rec);
+
 #pragma GCC visibility pop
 G_END_DECLS
 
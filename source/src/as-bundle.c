@@ -299,6 +299,24 @@ as_bundle_emit_yaml (AsBundle *bundle, AsContext *ctx, yaml_emitter_t *emitter)
 	as_yaml_mapping_end (emitter);
 }
 
+/**
+ * as_bundle_variant_build:
+ *
+ * Serialize bundle data to a GVariant.
+ */
+static void
+as_bundle_variant_build (AsBundleKind kind, const gchar *id, GVariantBuilder *builder)
+{
+	GVariantBuilder bundle_b;
+
+	g_variant_builder_init (&bundle_b, G_VARIANT_TYPE_ARRAY);
+
+	g_variant_builder_add_parsed (&bundle_b, "{'type', <%u>}", kind);
+	g_variant_builder_add_parsed (&bundle_b, "{'id', <%s>}", id);
+
+	g_variant_builder_add_value (builder, g_variant_builder_end (&bundle_b));
+}
+
 /**
  * as_bundle_to_variant:
  * @bundle: a #AsBundle instance.
@@ -311,14 +329,7 @@ void
 as_bundle_to_variant (AsBundle *bundle, GVariantBuilder *builder)
 {
 	AsBundlePrivate *priv = GET_PRIVATE (bundle);
-	GVariantBuilder bundle_b;
-
-	g_variant_builder_init (&bundle_b, G_VARIANT_TYPE_ARRAY);
-
-	g_variant_builder_add_parsed (&bundle_b, "{'type', <%u>}", priv->kind);
-	g_variant_builder_add_parsed (&bundle_b, "{'id', <%s>}", priv->id);
-
-	g_variant_builder_add_value (builder, g_variant_builder_end (&bundle_b));
+	as_bundle_variant_build (priv->kind, priv->id, builder);
 }
 
 /**
@@ -333,18 +344,87 @@ gboolean
 as_bundle_set_from_variant (AsBundle *bundle, GVariant *variant)
 {
 	AsBundlePrivate *priv = GET_PRIVATE (bundle);
+	AsBundleRecord rec = { AS_BUNDLE_KIND_UNKNOWN, NULL };
+
+	if (!as_bundle_record_set_from_variant (&rec, variant))
+		return FALSE;
+
+	priv->kind = rec.kind;
+	g_free (priv->id);
+	priv->id = rec.id;
+
+	return TRUE;
+}
+
+/**
+ * as_bundle_record_clear:
+ * @rec: an #AsBundleRecord
+ *
+ * Free the data of a bundle record, but not the record itself.
+ */
+void
+as_bundle_record_clear (AsBundleRecord *rec)
+{
+	g_clear_pointer (&rec->id, g_free);
+}
+
+/**
+ * as_bundle_record_set_from_variant:
+ * @rec: an #AsBundleRecord
+ * @variant: The #GVariant to read from.
+ *
+ * Read a bundle from its #GVariant serialization without
+ * creating an #AsBundle instance.
+ */
+gboolean
+as_bundle_record_set_from_variant (AsBundleRecord *rec, GVariant *variant)
+{
 	GVariantDict tmp_dict;
 	GVariant *var2;
 
 	g_variant_dict_init (&tmp_dict, variant);
-	priv->kind = as_variant_get_dict_uint32 (&tmp_dict, "type");
-	as_bundle_set_id (bundle,
-			    as_variant_get_dict_str (&tmp_dict, "id", &var2));
+	rec->kind = as_variant_get_dict_uint32 (&tmp_dict, "type");
+	g_free (rec->id);
+	rec->id = g_strdup (as_variant_get_dict_str (&tmp_dict, "id", &var2));
 	g_variant_unref (var2);
+	g_variant_dict_clear (&tmp_dict);
 
 	return TRUE;
 }
 
+/**
+ * as_bundle_record_to_variant:
+ * @rec: an #AsBundleRecord
+ * @builder: A #GVariantBuilder
+ *
+ * Serialize a bundle record in the same way as as_bundle_to_variant().
+ */
+void
+as_bundle_record_to_variant (const AsBundleRecord *rec, GVariantBuilder *builder)
+{
+	as_bundle_variant_build (rec->kind, rec->id, builder);
+}
+
+/**
+ * as_bundle_new_from_record:
+ * @rec: an #AsBundleRecord
+ *
+ * Create a new #AsBundle, moving the data out of @rec.
+ *
+ * Returns: (transfer full): a #AsBundle
+ */
+AsBundle*
+as_bundle_new_from_record (AsBundleRecord *rec)
+{
+	AsBundle *bundle = as_bundle_new ();
+	AsBundlePrivate *priv = GET_PRIVATE (bundle);
+
+	priv->kind = rec->kind;
+	priv->id = g_steal_pointer (&rec->id);
+
+	return bundle;
+}
+
 /**
  * as_bundle_new:
  *
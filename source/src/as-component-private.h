@@ -67,6 +67,12 @@ GHashTable		*as_component_get_languages_table (AsComponent *cpt);
 
 void			as_component_set_bundles_array (AsComponent *cpt,
 							GPtrArray *bundles);
+gboolean		as_component_remove_addon (AsComponent *cpt,
+						   AsComponent *addon);
+AsBundleKind		as_component_get_first_bundle_kind (AsComponent *cpt);
+gboolean		as_component_has_launchable_entry (AsComponent *cpt,
+							   AsLaunchableKind kind,
+							   const gchar *entry);
 
 gboolean		as_component_has_package (AsComponent *cpt);
 gboolean		as_component_has_install_candidate (AsComponent *cpt);
@@ -79,15 +85,29 @@ const gchar		*as_component_get_architecture (AsComponent *cpt);
 void			 as_component_set_architecture (AsComponent *cpt,
 							const gchar *arch);
 
+AS_INTERNAL_VISIBLE
+void			as_component_pack_descriptions (AsComponent *cpt);
+
+typedef struct _AsComponentHeavy AsComponentHeavy;
+
+void			as_component_set_cache_data (AsComponent *cpt,
+						     GVariant *data,
+						     const gchar *locale);
+AS_INTERNAL_VISIBLE
+gsize			as_component_get_heavy_size (AsComponent *cpt);
+gint			as_component_get_heavy_used (AsComponent *cpt);
+AS_INTERNAL_VISIBLE
+gboolean		as_component_is_heavy_evicted (AsComponent *cpt);
+AsComponentHeavy	*as_component_evict_heavy (AsComponent *cpt);
+void			as_component_heavy_free (AsComponentHeavy *heavy);
+void			as_component_share_heavy (AsComponent *cpt,
+						  AsComponent *donor);
+gchar			*as_component_hash_variant (GVariant *cptv);
+
 void			 as_component_create_token_cache (AsComponent *cpt);
-GHashTable		*as_component_get_token_cache_table (AsComponent *cpt);
 void			 as_component_set_token_cache_valid (AsComponent *cpt,
 							     gboolean valid);
 
-guint			as_component_get_sort_score (AsComponent *cpt);
-void			as_component_set_sort_score (AsComponent *cpt,
-							guint score);
-
 void			as_component_set_ignored (AsComponent *cpt,
 						  gboolean ignore);
 
@@ -105,6 +125,7 @@ void			as_component_merge_with_mode (AsComponent *cpt,
 							AsComponent *source,
 							AsMergeKind merge_kind);
 
+AS_INTERNAL_VISIBLE
 AsContext		*as_component_get_context (AsComponent *cpt);
 void			as_component_set_context (AsComponent *cpt,
 						  AsContext *context);
@@ -23,11 +23,16 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <string.h>
 
 #include "as-utils.h"
 #include "as-utils-private.h"
+#include "as-context-private.h"
 #include "as-stemmer.h"
 #include "as-variant-cache.h"
+#include "as-intern.h"
+#include "as-packed-text.h"
+#include "as-locale.h"
 
 #include "as-icon-private.h"
 #include "as-screenshot-private.h"
@@ -58,6 +63,17 @@
  * See also: #AsProvidesKind, #AsDatabase
  */
 
+/* data which only few components have, allocated on demand */
+typedef struct
+{
+	GPtrArray		*compulsory_for_desktops; /* of utf8 */
+	GPtrArray		*suggestions; /* of AsSuggested elements */
+	GPtrArray		*recommends; /* of AsRelation */
+	GPtrArray		*requires; /* of AsRelation */
+	GPtrArray		*translations; /* of AsTranslation */
+	GHashTable		*custom; /* free-form user-defined custom data */
+} AsComponentExtra;
+
 typedef struct
 {
 	AsComponentKind 	kind;
@@ -65,57 +81,68 @@ typedef struct
 	AsOriginKind		origin_kind;
 	AsContext		*context; /* the document context associated with this component */
 	gchar			*active_locale_override;
+	const AsLocaleChain	*locale_chain; /* fallbacks for @active_locale_override */
 
-	gchar			*id;
-	gchar			*data_id;
-	gchar			*origin;
+	const gchar		*id; /* interned */
+	const gchar		*data_id; /* interned */
+	const gchar		*origin; /* interned */
 	gchar			**pkgnames;
 	gchar			*source_pkgname;
 
 	GHashTable		*name; /* localized entry */
 	GHashTable		*summary; /* localized entry */
-	GHashTable		*description; /* localized entry */
+	GHashTable		*description; /* localized entry, values may be packed */
+	GHashTable		*description_cache; /* unpacked descriptions that were read */
 	GHashTable		*keywords; /* localized entry, value:strv */
 	GHashTable		*developer_name; /* localized entry */
 
-	gchar			*metadata_license;
-	gchar			*project_license;
-	gchar			*project_group;
+	const gchar		*metadata_license; /* interned */
+	const gchar		*project_license; /* interned */
+	const gchar		*project_group; /* interned */
 
 	GPtrArray		*launchables; /* of #AsLaunchable */
 	GPtrArray		*categories; /* of utf8 */
-	GPtrArray		*compulsory_for_desktops; /* of utf8 */
 	GPtrArray		*extends; /* of utf8 */
 	GPtrArray		*addons; /* of AsComponent */
 	GPtrArray		*screenshots; /* of AsScreenshot elements */
 	GPtrArray		*releases; /* of AsRelease elements */
 	GPtrArray		*provided; /* of AsProvided */
 	GPtrArray		*bundles; /* of AsBundle */
-	GPtrArray		*suggestions; /* of AsSuggested elements */
+	GArray			*bundle_recs; /* of AsBundleRecord, not yet unpacked into @bundles */
+	GArray			*launchable_recs; /* of AsLaunchableRecord, not yet unpacked into @launchables */
 	GPtrArray		*content_ratings; /* of AsContentRating */
-	GPtrArray		*recommends; /* of AsRelation */
-	GPtrArray		*requires; /* of AsRelation */
 
 	GHashTable		*urls; /* of int:utf8 */
 	GHashTable		*languages; /* of utf8:utf8 */
 
-	GPtrArray		*translations; /* of AsTranslation */
-
 	GPtrArray		*icons; /* of AsIcon elements */
 
-	gchar			*arch; /* the architecture this data was generated from */
+	AsComponentExtra	*extra; /* rarely used data, may be %NULL */
+
+	const gchar		*arch; /* interned, the architecture this data was generated from */
 	gint			priority; /* used internally */
 	AsMergeKind		merge_kind; /* whether and how the component data should be merged */
+	AsLoadProfile		load_profile; /* the parts of the data which were loaded */
 
-	guint			sort_score; /* used to priorize components in listings */
 	gsize			token_cache_valid;
-	GHashTable		*token_cache; /* of utf8:AsTokenType* */
+	const gchar		**tokens; /* interned search tokens, sorted */
+	AsTokenType		*token_flags; /* AsTokenMatch flags of each token in @tokens */
+	guint			n_tokens;
+
+	GVariant		*cache_data; /* serialized data from the cache, to read evicted fields again */
+	const gchar		*cache_locale; /* interned, the locale @cache_data was read with */
+	gsize			heavy_size; /* serialized size of the fields which can be evicted */
+	gint			heavy_used; /* use clock value of the last access to these fields */
+	gint			heavy_evicted; /* whether these fields are currently evicted */
+	gint			heavy_shared; /* whether these fields may be shared with other components */
+	gint			heavy_pinned; /* whether these fields were handed out by public getters, so they must be kept */
+	AsContext		*shared_context; /* context of the component the fields were shared from */
+
+	gchar			*content_hash; /* checksum of the normalized serialization, created on demand */
 
 	AsValueFlags		value_flags;
 
 	gboolean		ignored; /* whether we should ignore this component */
-
-	GHashTable		*custom; /* free-form user-defined custom data */
 } AsComponentPrivate;
 
 typedef enum {
@@ -131,9 +158,23 @@ typedef enum {
 	AS_TOKEN_MATCH_LAST
 } AsTokenMatch;
 
+struct _AsComponentHeavy
+{
+	GHashTable		*description;
+	GPtrArray		*screenshots;
+	GPtrArray		*releases;
+};
+
 G_DEFINE_TYPE_WITH_PRIVATE (AsComponent, as_component, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (as_component_get_instance_private (o))
 
+static void as_component_use_heavy (AsComponent *cpt);
+static void as_component_lock_heavy (AsComponent *cpt);
+static void as_component_unlock_heavy (void);
+static void as_component_detach_heavy (AsComponent *cpt);
+static void as_component_unshare_heavy (AsComponent *cpt);
+static void as_component_clear_tokens (AsComponent *cpt);
+
 enum  {
 	AS_COMPONENT_DUMMY_PROPERTY,
 	AS_COMPONENT_KIND,
@@ -354,37 +395,10 @@ as_component_init (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
-	/* translatable entities */
-	priv->name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->summary = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->description = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->developer_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->keywords = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_strfreev);
-
-	/* lists */
-	priv->launchables = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->categories = g_ptr_array_new_with_free_func (g_free);
-	priv->compulsory_for_desktops = g_ptr_array_new_with_free_func (g_free);
-	priv->screenshots = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->releases = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->provided = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->bundles = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->extends = g_ptr_array_new_with_free_func (g_free);
-	priv->addons = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->suggestions = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->icons = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->content_ratings = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->recommends = g_ptr_array_new_with_free_func (g_object_unref);
-	priv->requires = g_ptr_array_new_with_free_func (g_object_unref);
-
-	/* others */
-	priv->urls = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
-	priv->languages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
-	priv->custom = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-
-	priv->token_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-
+	/* all lists and tables are only created once something is written to them,
+	 * see as_component_ensure_array() and as_component_ensure_table() */
 	priv->priority = 0;
+	priv->load_profile = AS_LOAD_PROFILE_FULL;
 }
 
 /**
@@ -396,52 +410,311 @@ as_component_finalize (GObject* object)
 	AsComponent *cpt = AS_COMPONENT (object);
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
-	g_free (priv->id);
-	g_free (priv->data_id);
+	as_intern_unref (priv->id);
+	as_intern_unref (priv->data_id);
+	as_intern_unref (priv->origin);
 	g_strfreev (priv->pkgnames);
-	g_free (priv->metadata_license);
-	g_free (priv->project_license);
-	g_free (priv->project_group);
+	as_intern_unref (priv->metadata_license);
+	as_intern_unref (priv->project_license);
+	as_intern_unref (priv->project_group);
 	g_free (priv->active_locale_override);
-	g_free (priv->arch);
-
-	g_hash_table_unref (priv->name);
-	g_hash_table_unref (priv->summary);
-	g_hash_table_unref (priv->description);
-	g_hash_table_unref (priv->developer_name);
-	g_hash_table_unref (priv->keywords);
-
-	g_ptr_array_unref (priv->launchables);
-	g_ptr_array_unref (priv->categories);
-	g_ptr_array_unref (priv->compulsory_for_desktops);
-
-	g_ptr_array_unref (priv->screenshots);
-	g_ptr_array_unref (priv->releases);
-	g_ptr_array_unref (priv->provided);
-	g_ptr_array_unref (priv->bundles);
-	g_ptr_array_unref (priv->extends);
-	g_ptr_array_unref (priv->addons);
-	g_ptr_array_unref (priv->suggestions);
-	g_hash_table_unref (priv->urls);
-	g_hash_table_unref (priv->languages);
-	g_hash_table_unref (priv->custom);
-	g_ptr_array_unref (priv->content_ratings);
-	g_ptr_array_unref (priv->icons);
-
-	g_ptr_array_unref (priv->recommends);
-	g_ptr_array_unref (priv->requires);
-
-	if (priv->translations != NULL)
-		g_ptr_array_unref (priv->translations);
-
-	g_hash_table_unref (priv->token_cache);
+	as_intern_unref (priv->arch);
+	as_intern_unref (priv->cache_locale);
+	if (priv->cache_data != NULL)
+		g_variant_unref (priv->cache_data);
+	g_free (priv->content_hash);
+
+	g_clear_pointer (&priv->name, g_hash_table_unref);
+	g_clear_pointer (&priv->summary, g_hash_table_unref);
+	g_clear_pointer (&priv->description, g_hash_table_unref);
+	g_clear_pointer (&priv->description_cache, g_hash_table_unref);
+	g_clear_pointer (&priv->developer_name, g_hash_table_unref);
+	g_clear_pointer (&priv->keywords, g_hash_table_unref);
+
+	g_clear_pointer (&priv->launchables, g_ptr_array_unref);
+	g_clear_pointer (&priv->categories, g_ptr_array_unref);
+
+	g_clear_pointer (&priv->screenshots, g_ptr_array_unref);
+	g_clear_pointer (&priv->releases, g_ptr_array_unref);
+	g_clear_pointer (&priv->provided, g_ptr_array_unref);
+	g_clear_pointer (&priv->bundles, g_ptr_array_unref);
+	g_clear_pointer (&priv->bundle_recs, g_array_unref);
+	g_clear_pointer (&priv->launchable_recs, g_array_unref);
+	g_clear_pointer (&priv->extends, g_ptr_array_unref);
+	g_clear_pointer (&priv->addons, g_ptr_array_unref);
+	g_clear_pointer (&priv->urls, g_hash_table_unref);
+	g_clear_pointer (&priv->languages, g_hash_table_unref);
+	g_clear_pointer (&priv->content_ratings, g_ptr_array_unref);
+	g_clear_pointer (&priv->icons, g_ptr_array_unref);
+
+	if (priv->extra != NULL) {
+		g_clear_pointer (&priv->extra->compulsory_for_desktops, g_ptr_array_unref);
+		g_clear_pointer (&priv->extra->suggestions, g_ptr_array_unref);
+		g_clear_pointer (&priv->extra->recommends, g_ptr_array_unref);
+		g_clear_pointer (&priv->extra->requires, g_ptr_array_unref);
+		g_clear_pointer (&priv->extra->translations, g_ptr_array_unref);
+		g_clear_pointer (&priv->extra->custom, g_hash_table_unref);
+		g_slice_free (AsComponentExtra, priv->extra);
+	}
+
+	as_component_clear_tokens (cpt);
 
 	if (priv->context != NULL)
 		g_object_unref (priv->context);
+	if (priv->shared_context != NULL)
+		g_object_unref (priv->shared_context);
 
 	G_OBJECT_CLASS (as_component_parent_class)->finalize (object);
 }
 
+/**
+ * as_component_empty_array:
+ *
+ * Get the array which is read internally for lists that were never written to.
+ * It is shared by all components, so it must never be modified or be handed
+ * out to callers, public getters use as_component_get_array() instead.
+ */
+static GPtrArray*
+as_component_empty_array (void)
+{
+	static GPtrArray *empty = NULL;
+
+	if (g_once_init_enter (&empty)) {
+		GPtrArray *array = g_ptr_array_new ();
+		g_once_init_leave (&empty, array);
+	}
+
+	return empty;
+}
+
+/**
+ * as_component_empty_table:
+ *
+ * Get the table which is read internally for tables that were never written to.
+ * It is shared by all components, so it must never be modified or be handed
+ * out to callers, public getters use as_component_get_table() instead.
+ * Direct hashing is used, so any kind of key can be looked up in it.
+ */
+static GHashTable*
+as_component_empty_table (void)
+{
+	static GHashTable *empty = NULL;
+
+	if (g_once_init_enter (&empty)) {
+		GHashTable *table = g_hash_table_new (g_direct_hash, g_direct_equal);
+		g_once_init_leave (&empty, table);
+	}
+
+	return empty;
+}
+
+/* read access to containers which may not have been created yet */
+#define AS_CPT_ARRAY(a)		(((a) != NULL)? (a) : as_component_empty_array ())
+#define AS_CPT_TABLE(t)		(((t) != NULL)? (t) : as_component_empty_table ())
+#define AS_CPT_EXTRA(priv, m)	(((priv)->extra != NULL)? (priv)->extra->m : NULL)
+
+/**
+ * as_component_ensure_array:
+ *
+ * Create a list of the component on first write.
+ */
+static GPtrArray*
+as_component_ensure_array (GPtrArray **array, GDestroyNotify element_free_func)
+{
+	if (*array == NULL)
+		*array = g_ptr_array_new_with_free_func (element_free_func);
+	return *array;
+}
+
+/**
+ * as_component_ensure_table:
+ *
+ * Create a table of the component on first write.
+ */
+static GHashTable*
+as_component_ensure_table (GHashTable **table,
+			   GHashFunc hash_func,
+			   GEqualFunc key_equal_func,
+			   GDestroyNotify key_destroy_func,
+			   GDestroyNotify value_destroy_func)
+{
+	if (*table == NULL)
+		*table = g_hash_table_new_full (hash_func,
+						key_equal_func,
+						key_destroy_func,
+						value_destroy_func);
+	return *table;
+}
+
+/**
+ * as_component_ensure_l10n_table:
+ *
+ * Create a table of localized strings on first write.
+ * The locale keys are interned (see as_component_intern()).
+ */
+static GHashTable*
+as_component_ensure_l10n_table (GHashTable **table)
+{
+	return as_component_ensure_table (table, g_str_hash, g_str_equal, NULL, g_free);
+}
+
+/**
+ * as_component_get_array:
+ *
+ * Get a list of the component for a public getter, creating it if needed.
+ * Callers may modify what they get, so unlike AS_CPT_ARRAY() this never
+ * returns the shared empty array. Getters may run in several threads at once,
+ * so the list is published atomically.
+ */
+static GPtrArray*
+as_component_get_array (GPtrArray **array, GDestroyNotify element_free_func)
+{
+	GPtrArray *new_array;
+
+	if (g_atomic_pointer_get (array) != NULL)
+		return *array;
+
+	new_array = g_ptr_array_new_with_free_func (element_free_func);
+	if (!g_atomic_pointer_compare_and_exchange (array, NULL, new_array))
+		g_ptr_array_unref (new_array);
+	return g_atomic_pointer_get (array);
+}
+
+/**
+ * as_component_get_table:
+ *
+ * Get a table of the component for a public getter, creating it if needed.
+ * See as_component_get_array().
+ */
+static GHashTable*
+as_component_get_table (GHashTable **table,
+			GHashFunc hash_func,
+			GEqualFunc key_equal_func,
+			GDestroyNotify key_destroy_func,
+			GDestroyNotify value_destroy_func)
+{
+	GHashTable *new_table;
+
+	if (g_atomic_pointer_get (table) != NULL)
+		return *table;
+
+	new_table = g_hash_table_new_full (hash_func,
+					   key_equal_func,
+					   key_destroy_func,
+					   value_destroy_func);
+	if (!g_atomic_pointer_compare_and_exchange (table, NULL, new_table))
+		g_hash_table_unref (new_table);
+	return g_atomic_pointer_get (table);
+}
+
+/**
+ * as_component_get_extra:
+ *
+ * Get the rarely used data of the component for a public getter,
+ * creating it if needed. See as_component_get_array().
+ */
+static AsComponentExtra*
+as_component_get_extra (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	AsComponentExtra *extra;
+
+	if (g_atomic_pointer_get (&priv->extra) != NULL)
+		return priv->extra;
+
+	extra = g_slice_new0 (AsComponentExtra);
+	if (!g_atomic_pointer_compare_and_exchange (&priv->extra, NULL, extra))
+		g_slice_free (AsComponentExtra, extra);
+	return g_atomic_pointer_get (&priv->extra);
+}
+
+/**
+ * as_component_ensure_extra:
+ *
+ * Get the rarely used data of the component, creating it if needed.
+ */
+static AsComponentExtra*
+as_component_ensure_extra (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	if (priv->extra == NULL)
+		priv->extra = g_slice_new0 (AsComponentExtra);
+	return priv->extra;
+}
+
+/* protects unpacking value records into objects */
+static GMutex records_mutex;
+
+/**
+ * as_component_unpack_records:
+ *
+ * Create the #AsBundle and #AsLaunchable objects for value records
+ * which were loaded from the cache, so they can be handed out.
+ * Until that happens, the records are much cheaper to keep around.
+ */
+static void
+as_component_unpack_records (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	guint i;
+
+	/* fast path, nothing left to unpack */
+	if (g_atomic_pointer_get (&priv->bundle_recs) == NULL &&
+	    g_atomic_pointer_get (&priv->launchable_recs) == NULL)
+		return;
+
+	g_mutex_lock (&records_mutex);
+	if (priv->bundle_recs != NULL) {
+		GPtrArray *bundles = as_component_ensure_array (&priv->bundles, g_object_unref);
+		for (i = 0; i < priv->bundle_recs->len; i++)
+			g_ptr_array_add (bundles,
+					 as_bundle_new_from_record (&g_array_index (priv->bundle_recs, AsBundleRecord, i)));
+		g_array_unref (priv->bundle_recs);
+		g_atomic_pointer_set (&priv->bundle_recs, NULL);
+	}
+	if (priv->launchable_recs != NULL) {
+		GPtrArray *launchables = as_component_ensure_array (&priv->launchables, g_object_unref);
+		for (i = 0; i < priv->launchable_recs->len; i++)
+			g_ptr_array_add (launchables,
+					 as_launchable_new_from_record (&g_array_index (priv->launchable_recs, AsLaunchableRecord, i)));
+		g_array_unref (priv->launchable_recs);
+		g_atomic_pointer_set (&priv->launchable_recs, NULL);
+	}
+	g_mutex_unlock (&records_mutex);
+}
+
+/**
+ * as_component_intern:
+ *
+ * Get a shared copy of a short string which is repeated a lot
+ * across components, like locale names and categories.
+ * The string is interned in the context this component was loaded with,
+ * or in the global GLib string pool if the component has no context.
+ */
+static const gchar*
+as_component_intern (AsComponent *cpt, const gchar *str)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	if (priv->context != NULL)
+		return as_context_intern (priv->context, str);
+	return g_intern_string (str);
+}
+
+/**
+ * as_component_set_interned:
+ *
+ * Replace the value of a string field which holds a reference
+ * on the global string table.
+ */
+static void
+as_component_set_interned (const gchar **field, const gchar *value)
+{
+	const gchar *tmp = as_intern_ref (value);
+	as_intern_unref (*field);
+	*field = tmp;
+}
+
 /**
  * as_component_invalidate_data_id:
  *
@@ -454,10 +727,24 @@ as_component_invalidate_data_id (AsComponent *cpt)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	if (priv->data_id == NULL)
 		return;
-	g_free (priv->data_id);
+	as_intern_unref (priv->data_id);
 	priv->data_id = NULL;
 }
 
+/**
+ * as_component_invalidate_content_hash:
+ *
+ * Internal method to mark the content hash as outdated, so
+ * it will be computed again when it is requested next time.
+ * Every method which modifies data of the component needs to call this.
+ */
+static void
+as_component_invalidate_content_hash (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	g_clear_pointer (&priv->content_hash, g_free);
+}
+
 /**
  * as_component_is_valid:
  * @cpt: a #AsComponent instance.
@@ -535,10 +822,10 @@ as_component_to_string (AsComponent *cpt)
 void
 as_component_add_screenshot (AsComponent *cpt, AsScreenshot* sshot)
 {
-	GPtrArray* sslist;
-
-	sslist = as_component_get_screenshots (cpt);
-	g_ptr_array_add (sslist, g_object_ref (sshot));
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_detach_heavy (cpt);
+	g_ptr_array_add (as_component_ensure_array (&priv->screenshots, g_object_unref),
+			 g_object_ref (sshot));
 }
 
 /**
@@ -548,13 +835,27 @@ as_component_add_screenshot (AsComponent *cpt, AsScreenshot* sshot)
  * Get an array of the #AsRelease items this component
  * provides.
  *
+ * The array stays valid as long as the component, so once it was
+ * requested, the releases of a component are not evicted anymore
+ * to stay within the memory budget of an #AsPool.
+ *
  * Return value: (element-type AsRelease) (transfer none): A list of releases
  **/
 GPtrArray*
 as_component_get_releases (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->releases;
+	GPtrArray *releases;
+
+	/* callers may modify the array, so it must not be shared with other components */
+	as_component_unshare_heavy (cpt);
+
+	as_component_lock_heavy (cpt);
+	releases = as_component_get_array (&priv->releases, g_object_unref);
+	g_atomic_int_set (&priv->heavy_pinned, TRUE);
+	as_component_unlock_heavy ();
+
+	return releases;
 }
 
 /**
@@ -567,10 +868,10 @@ as_component_get_releases (AsComponent *cpt)
 void
 as_component_add_release (AsComponent *cpt, AsRelease* release)
 {
-	GPtrArray* releases;
-
-	releases = as_component_get_releases (cpt);
-	g_ptr_array_add (releases, g_object_ref (release));
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_detach_heavy (cpt);
+	g_ptr_array_add (as_component_ensure_array (&priv->releases, g_object_unref),
+			 g_object_ref (release));
 }
 
 /**
@@ -588,7 +889,7 @@ const gchar*
 as_component_get_url (AsComponent *cpt, AsUrlKind url_kind)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return g_hash_table_lookup (priv->urls,
+	return g_hash_table_lookup (AS_CPT_TABLE (priv->urls),
 				    GINT_TO_POINTER (url_kind));
 }
 
@@ -606,6 +907,8 @@ void
 as_component_add_url (AsComponent *cpt, AsUrlKind url_kind, const gchar *url)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_invalidate_content_hash (cpt);
+	as_component_ensure_table (&priv->urls, g_direct_hash, g_direct_equal, NULL, g_free);
 	g_hash_table_insert (priv->urls,
 			     GINT_TO_POINTER (url_kind),
 			     g_strdup (url));
@@ -628,7 +931,7 @@ GPtrArray*
 as_component_get_extends (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->extends;
+	return as_component_get_array (&priv->extends, g_free);
 }
 
 /**
@@ -645,12 +948,13 @@ as_component_add_extends (AsComponent* cpt, const gchar* cpt_id)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	if (as_flags_contains (priv->value_flags, AS_VALUE_FLAG_DUPLICATE_CHECK)) {
 		/* check for duplicates */
-		if (as_ptr_array_find_string (priv->extends, cpt_id) != NULL)
+		if (as_ptr_array_find_string (AS_CPT_ARRAY (priv->extends), cpt_id) != NULL)
 			return;
 	}
-	g_ptr_array_add (priv->extends,
+	g_ptr_array_add (as_component_ensure_array (&priv->extends, g_free),
 			 g_strdup (cpt_id));
 }
 
@@ -671,7 +975,7 @@ GPtrArray*
 as_component_get_addons (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->addons;
+	return as_component_get_array (&priv->addons, g_object_unref);
 }
 
 /**
@@ -687,7 +991,31 @@ void
 as_component_add_addon (AsComponent* cpt, AsComponent *addon)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_ptr_array_add (priv->addons, g_object_ref (addon));
+	as_component_invalidate_content_hash (cpt);
+	g_ptr_array_add (as_component_ensure_array (&priv->addons, g_object_unref),
+			 g_object_ref (addon));
+}
+
+/**
+ * as_component_remove_addon:
+ * @cpt: a #AsComponent instance.
+ * @addon: an addon of @cpt
+ *
+ * Remove the reference to an addon which was added with as_component_add_addon().
+ *
+ * Returns: %TRUE if @addon was an addon of @cpt.
+ **/
+gboolean
+as_component_remove_addon (AsComponent *cpt, AsComponent *addon)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	if (priv->addons == NULL)
+		return FALSE;
+	if (!g_ptr_array_remove (priv->addons, addon))
+		return FALSE;
+	as_component_invalidate_content_hash (cpt);
+	return TRUE;
 }
 
 /**
@@ -704,7 +1032,8 @@ GPtrArray*
 as_component_get_bundles (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->bundles;
+	as_component_unpack_records (cpt);
+	return as_component_get_array (&priv->bundles, g_object_unref);
 }
 
 /**
@@ -717,8 +1046,11 @@ void
 as_component_set_bundles_array (AsComponent *cpt, GPtrArray *bundles)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_ptr_array_unref (priv->bundles);
-	priv->bundles = g_ptr_array_ref (bundles);
+	as_component_invalidate_content_hash (cpt);
+	as_component_unpack_records (cpt);
+	g_clear_pointer (&priv->bundles, g_ptr_array_unref);
+	if (bundles->len > 0)
+		priv->bundles = g_ptr_array_ref (bundles);
 	as_component_invalidate_data_id (cpt);
 }
 
@@ -739,6 +1071,9 @@ as_component_get_bundle (AsComponent *cpt, AsBundleKind bundle_kind)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	guint i;
 
+	as_component_unpack_records (cpt);
+	if (priv->bundles == NULL)
+		return NULL;
 	for (i = 0; i < priv->bundles->len; i++) {
 		AsBundle *bundle = AS_BUNDLE (g_ptr_array_index (priv->bundles, i));
 		if (as_bundle_get_kind (bundle) == bundle_kind)
@@ -761,7 +1096,9 @@ void
 as_component_add_bundle (AsComponent *cpt, AsBundle *bundle)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_ptr_array_add (priv->bundles,
+	as_component_invalidate_content_hash (cpt);
+	as_component_unpack_records (cpt);
+	g_ptr_array_add (as_component_ensure_array (&priv->bundles, g_object_unref),
 			 g_object_ref (bundle));
 	as_component_invalidate_data_id (cpt);
 }
@@ -776,7 +1113,39 @@ gboolean
 as_component_has_bundle (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->bundles->len > 0;
+	if (g_atomic_pointer_get (&priv->bundle_recs) != NULL)
+		return TRUE;
+	return priv->bundles != NULL && priv->bundles->len > 0;
+}
+
+/**
+ * as_component_get_first_bundle_kind:
+ * @cpt: a #AsComponent instance.
+ *
+ * Get the kind of the first bundle of this component, without
+ * creating any #AsBundle objects for cached data.
+ *
+ * Returns: an #AsBundleKind, or %AS_BUNDLE_KIND_UNKNOWN if there is no bundle.
+ **/
+AsBundleKind
+as_component_get_first_bundle_kind (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	AsBundleKind kind = AS_BUNDLE_KIND_UNKNOWN;
+
+	if (g_atomic_pointer_get (&priv->bundle_recs) != NULL) {
+		g_mutex_lock (&records_mutex);
+		if (priv->bundle_recs != NULL) {
+			kind = g_array_index (priv->bundle_recs, AsBundleRecord, 0).kind;
+			g_mutex_unlock (&records_mutex);
+			return kind;
+		}
+		g_mutex_unlock (&records_mutex);
+	}
+
+	if (priv->bundles != NULL && priv->bundles->len > 0)
+		kind = as_bundle_get_kind (AS_BUNDLE (g_ptr_array_index (priv->bundles, 0)));
+	return kind;
 }
 
 /**
@@ -831,6 +1200,7 @@ as_component_set_kind (AsComponent *cpt, AsComponentKind value)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	priv->kind = value;
 	g_object_notify ((GObject *) cpt, "kind");
 }
@@ -888,6 +1258,7 @@ as_component_set_pkgnames (AsComponent *cpt, gchar **packages)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	g_strfreev (priv->pkgnames);
 	priv->pkgnames = g_strdupv (packages);
 	g_object_notify ((GObject *) cpt, "pkgnames");
@@ -916,6 +1287,7 @@ as_component_set_source_pkgname (AsComponent *cpt, const gchar* spkgname)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	g_free (priv->source_pkgname);
 	priv->source_pkgname = g_strdup (spkgname);
 }
@@ -952,8 +1324,8 @@ as_component_set_id (AsComponent *cpt, const gchar* value)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
-	g_free (priv->id);
-	priv->id = g_strdup (value);
+	as_component_invalidate_content_hash (cpt);
+	as_component_set_interned (&priv->id, value);
 	g_object_notify ((GObject *) cpt, "id");
 	as_component_invalidate_data_id (cpt);
 }
@@ -979,8 +1351,10 @@ const gchar*
 as_component_get_data_id (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	if (priv->data_id == NULL)
-		priv->data_id = as_utils_build_data_id_for_cpt (cpt);
+	if (priv->data_id == NULL) {
+		g_autofree gchar *data_id = as_utils_build_data_id_for_cpt (cpt);
+		priv->data_id = as_intern_ref (data_id);
+	}
 	return priv->data_id;
 }
 
@@ -999,8 +1373,7 @@ void
 as_component_set_data_id (AsComponent *cpt, const gchar* value)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_free (priv->data_id);
-	priv->data_id = g_strdup (value);
+	as_component_set_interned (&priv->data_id, value);
 }
 
 /**
@@ -1025,8 +1398,7 @@ void
 as_component_set_origin (AsComponent *cpt, const gchar *origin)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_free (priv->origin);
-	priv->origin = g_strdup (origin);
+	as_component_set_interned (&priv->origin, origin);
 	as_component_invalidate_data_id (cpt);
 }
 
@@ -1054,8 +1426,8 @@ void
 as_component_set_architecture (AsComponent *cpt, const gchar *arch)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_free (priv->arch);
-	priv->arch = g_strdup (arch);
+	as_component_invalidate_content_hash (cpt);
+	as_component_set_interned (&priv->arch, arch);
 }
 
 /**
@@ -1101,14 +1473,36 @@ as_component_set_active_locale (AsComponent *cpt, const gchar *locale)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	g_free (priv->active_locale_override);
 	priv->active_locale_override = g_strdup (locale);
+	priv->locale_chain = as_locale_chain_get (locale);
+}
+
+/**
+ * as_component_get_locale_chain:
+ *
+ * Get the fallback chain of the current active locale.
+ */
+static const AsLocaleChain*
+as_component_get_locale_chain (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	const AsLocaleChain *chain;
+
+	/* use the context locale, if the locale isn't explicitly overridden for this component */
+	if ((priv->context != NULL) && (priv->active_locale_override == NULL))
+		chain = as_context_get_locale_chain (priv->context);
+	else
+		chain = priv->locale_chain;
+
+	return (chain != NULL)? chain : as_locale_chain_get (NULL);
 }
 
 /**
  * as_component_localized_get:
  * @cpt: a #AsComponent instance.
- * @lht: (element-type utf8 utf8): the #GHashTable on which the value will be retreived.
+ * @lht: (element-type utf8 utf8) (nullable): the #GHashTable on which the value will be retreived.
  *
  * Helper function to get a localized property using the current
  * active locale for this component.
@@ -1117,140 +1511,576 @@ static const gchar*
 as_component_localized_get (AsComponent *cpt, GHashTable *lht)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	const gchar *locale;
-	gchar *msg;
-
-	locale = as_component_get_active_locale (cpt);
-	msg = g_hash_table_lookup (lht, locale);
-	if ((msg == NULL) && (!as_flags_contains (priv->value_flags, AS_VALUE_FLAG_NO_TRANSLATION_FALLBACK))) {
-		g_autofree gchar *lang = as_utils_locale_to_language (locale);
-		/* fall back to language string */
-		msg = g_hash_table_lookup (lht, lang);
-		if (msg == NULL) {
-			/* fall back to untranslated / default */
-			msg = g_hash_table_lookup (lht, "C");
-		}
-	}
 
-	return msg;
+	/* try less specific locales and the untranslated value, unless fallbacks are disabled */
+	return as_locale_chain_lookup (as_component_get_locale_chain (cpt),
+				       lht,
+				       !as_flags_contains (priv->value_flags, AS_VALUE_FLAG_NO_TRANSLATION_FALLBACK));
 }
 
 /**
  * as_component_localized_set:
  * @cpt: a #AsComponent instance.
- * @lht: (element-type utf8 utf8): the #GHashTable on which the value will be added.
+ * @lht: (element-type utf8 utf8): location of the #GHashTable on which the value will be added,
+ *       it is created if it doesn't exist yet.
  * @value: the value to add.
  * @locale: (nullable): the locale, or %NULL. e.g. "en_GB".
  *
  * Helper function to set a localized property.
  */
 static void
-as_component_localized_set (AsComponent *cpt, GHashTable *lht, const gchar* value, const gchar *locale)
+as_component_localized_set (AsComponent *cpt, GHashTable **lht, const gchar* value, const gchar *locale)
 {
-	/* if no locale was specified, we assume the default locale */
+	/* if no locale was specified, we assume the default locale, or the first one if there are several */
 	/* CAVE: %NULL does NOT mean lang=C! */
 	if (locale == NULL)
-		locale = as_component_get_active_locale (cpt);
+		locale = as_locale_chain_get_locales (as_component_get_locale_chain (cpt))[0];
+
+	if (g_strstr_len (locale, -1, ".UTF-8") != NULL) {
+		g_autofree gchar *tmp = as_locale_strip_encoding (g_strdup (locale));
+		locale = as_component_intern (cpt, tmp);
+	} else {
+		locale = as_component_intern (cpt, locale);
+	}
 
-	g_hash_table_insert (lht,
-				as_locale_strip_encoding (g_strdup (locale)),
+	g_hash_table_insert (as_component_ensure_l10n_table (lht),
+				(gpointer) locale,
 				g_strdup (value));
 }
 
 /**
- * as_component_get_name:
+ * as_component_get_name:
+ * @cpt: a #AsComponent instance.
+ *
+ * A human-readable name for this component.
+ *
+ * Returns: the name.
+ */
+const gchar*
+as_component_get_name (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	return as_component_localized_get (cpt, priv->name);
+}
+
+/**
+ * as_component_set_name:
+ * @cpt: A valid #AsComponent
+ * @value: The name
+ * @locale: (nullable): The locale the used for this value, or %NULL to use the current active one.
+ *
+ * Set a human-readable name for this component.
+ */
+void
+as_component_set_name (AsComponent *cpt, const gchar* value, const gchar *locale)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	as_component_invalidate_content_hash (cpt);
+	as_component_localized_set (cpt, &priv->name, value, locale);
+	g_object_notify ((GObject *) cpt, "name");
+}
+
+/**
+ * as_component_get_summary:
+ * @cpt: a #AsComponent instance.
+ *
+ * Get a short description of this component.
+ *
+ * Returns: the summary.
+ */
+const gchar*
+as_component_get_summary (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	return as_component_localized_get (cpt, priv->summary);
+}
+
+/**
+ * as_component_set_summary:
+ * @cpt: A valid #AsComponent
+ * @value: The summary
+ * @locale: (nullable): The locale the used for this value, or %NULL to use the current active one.
+ *
+ * Set a short description for this component.
+ */
+void
+as_component_set_summary (AsComponent *cpt, const gchar* value, const gchar *locale)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	as_component_invalidate_content_hash (cpt);
+	as_component_localized_set (cpt, &priv->summary, value, locale);
+	g_object_notify ((GObject *) cpt, "summary");
+}
+
+/**
+ * as_component_get_description:
+ * @cpt: a #AsComponent instance.
+ *
+ * Get the localized long description of this component.
+ *
+ * The text stays valid as long as the component, unless the description
+ * is changed, so once it was requested, the long description of a component
+ * is not evicted anymore to stay within the memory budget of an #AsPool.
+ *
+ * Returns: the description.
+ */
+const gchar*
+as_component_get_description (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	const gchar *desc;
+
+	as_component_lock_heavy (cpt);
+	desc = as_component_localized_get (cpt, priv->description);
+	g_atomic_int_set (&priv->heavy_pinned, TRUE);
+	as_component_unlock_heavy ();
+
+	/* the text can not be evicted anymore, so we don't need to hold the lock while it is unpacked */
+	return as_packed_text_get (&priv->description_cache, desc);
+}
+
+/**
+ * as_component_set_description:
+ * @cpt: A valid #AsComponent
+ * @value: The long description
+ * @locale: (nullable): The locale the used for this value, or %NULL to use the current active one.
+ *
+ * Set long description for this component.
+ */
+void
+as_component_set_description (AsComponent *cpt, const gchar* value, const gchar *locale)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	as_component_detach_heavy (cpt);
+	as_component_localized_set (cpt, &priv->description, value, locale);
+	g_clear_pointer (&priv->description_cache, g_hash_table_unref);
+	g_object_notify ((GObject *) cpt, "description");
+}
+
+/**
+ * as_component_dup_description:
+ *
+ * Get a copy of the description, without keeping it unpacked
+ * in this component.
+ */
+static gchar*
+as_component_dup_description (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_use_heavy (cpt);
+	return as_packed_text_unpack_cached (as_component_localized_get (cpt, priv->description));
+}
+
+/**
+ * as_component_pack_descriptions:
+ * @cpt: a #AsComponent instance.
+ *
+ * Store the long descriptions of this component and its releases
+ * compressed, until they are read again.
+ */
+void
+as_component_pack_descriptions (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	guint i;
+
+	as_packed_text_pack_table (priv->description);
+
+	for (i = 0; i < AS_CPT_ARRAY (priv->releases)->len; i++)
+		as_release_pack_description (AS_RELEASE (g_ptr_array_index (priv->releases, i)));
+}
+
+/* protects evicting and reading back the heavy fields */
+static GMutex heavy_mutex;
+/* counts accesses to heavy fields, to find the least recently used ones */
+static gint heavy_use_clock = 0;
+
+/**
+ * as_component_load_heavy_data:
+ *
+ * Read the long description, screenshots and releases of a component
+ * from its cache serialization. These are the largest and least used
+ * parts of the data, which may be evicted again later.
+ *
+ * Returns: the serialized size of the data that was read.
+ */
+static gsize
+as_component_load_heavy_data (AsComponent *cpt, GVariantDict *dict, const gchar *locale)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	GVariant *var;
+	GVariant *child;
+	GVariantIter gvi;
+	const gchar *str;
+	gsize size = 0;
+
+	/* long description */
+	var = g_variant_dict_lookup_value (dict, "description", G_VARIANT_TYPE_MAYBE);
+	if (var != NULL) {
+		size += g_variant_get_size (var);
+		str = as_variant_get_mstring (&var);
+		if (str != NULL)
+			as_component_localized_set (cpt, &priv->description, str, locale);
+		g_variant_unref (var);
+	}
+
+	/* screenshots */
+	var = g_variant_dict_lookup_value (dict, "screenshots", G_VARIANT_TYPE_ARRAY);
+	if (var != NULL) {
+		size += g_variant_get_size (var);
+		g_variant_iter_init (&gvi, var);
+		while ((child = g_variant_iter_next_value (&gvi))) {
+			g_autoptr(AsScreenshot) scr = as_screenshot_new ();
+			if (as_screenshot_set_from_variant (scr, child, locale))
+				g_ptr_array_add (as_component_ensure_array (&priv->screenshots, g_object_unref),
+						 g_object_ref (scr));
+			g_variant_unref (child);
+		}
+		g_variant_unref (var);
+	}
+
+	/* releases */
+	var = g_variant_dict_lookup_value (dict, "releases", G_VARIANT_TYPE_ARRAY);
+	if (var != NULL) {
+		size += g_variant_get_size (var);
+		g_variant_iter_init (&gvi, var);
+		while ((child = g_variant_iter_next_value (&gvi))) {
+			g_autoptr(AsRelease) rel = as_release_new ();
+			if (as_release_set_from_variant (rel, child, locale))
+				g_ptr_array_add (as_component_ensure_array (&priv->releases, g_object_unref),
+						 g_object_ref (rel));
+			g_variant_unref (child);
+		}
+		g_variant_unref (var);
+	}
+
+	return size;
+}
+
+/**
+ * as_component_lock_heavy:
+ *
+ * Mark the heavy fields of this component as used, read them back
+ * from the cache data if they were evicted, and keep them from being
+ * evicted until as_component_unlock_heavy() is called, so they can be read.
+ */
+static void
+as_component_lock_heavy (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	g_mutex_lock (&heavy_mutex);
+
+	/* only components with cache data can be evicted */
+	if (priv->cache_data == NULL)
+		return;
+
+	g_atomic_int_set (&priv->heavy_used, g_atomic_int_add (&heavy_use_clock, 1));
+	if (priv->heavy_evicted) {
+		GVariantDict dict;
+
+		g_variant_dict_init (&dict, priv->cache_data);
+		as_component_load_heavy_data (cpt, &dict, priv->cache_locale);
+		g_variant_dict_clear (&dict);
+
+		/* keep the same representation the pool gave the data initially */
+		as_component_pack_descriptions (cpt);
+		g_atomic_int_set (&priv->heavy_evicted, FALSE);
+	}
+}
+
+/**
+ * as_component_unlock_heavy:
+ *
+ * Allow evicting the heavy fields of components again.
+ */
+static void
+as_component_unlock_heavy (void)
+{
+	g_mutex_unlock (&heavy_mutex);
+}
+
+/**
+ * as_component_use_heavy:
+ *
+ * Mark the heavy fields of this component as used, and read them
+ * back from the cache data if they were evicted.
+ */
+static void
+as_component_use_heavy (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	/* fast path, only components with cache data can be evicted */
+	if (g_atomic_pointer_get (&priv->cache_data) == NULL)
+		return;
+
+	as_component_lock_heavy (cpt);
+	as_component_unlock_heavy ();
+}
+
+/**
+ * as_component_unshare_heavy:
+ *
+ * Give this component its own copies of the containers of the heavy
+ * fields, if they are shared with other components, so they can be
+ * modified.
+ */
+static void
+as_component_unshare_heavy (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	GHashTable *desc;
+	GPtrArray *array;
+	guint i;
+
+	if (!g_atomic_int_get (&priv->heavy_shared))
+		return;
+
+	g_mutex_lock (&heavy_mutex);
+	if (priv->description != NULL) {
+		GHashTableIter iter;
+		gpointer key, value;
+
+		/* the keys stay valid, as we keep a reference on the context they belong to */
+		desc = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+		g_hash_table_iter_init (&iter, priv->description);
+		while (g_hash_table_iter_next (&iter, &key, &value))
+			g_hash_table_insert (desc, key, as_packed_text_dup (value));
+		g_hash_table_unref (priv->description);
+		priv->description = desc;
+	}
+	if (priv->screenshots != NULL) {
+		array = g_ptr_array_new_full (priv->screenshots->len, g_object_unref);
+		for (i = 0; i < priv->screenshots->len; i++)
+			g_ptr_array_add (array, g_object_ref (g_ptr_array_index (priv->screenshots, i)));
+		g_ptr_array_unref (priv->screenshots);
+		priv->screenshots = array;
+	}
+	if (priv->releases != NULL) {
+		array = g_ptr_array_new_full (priv->releases->len, g_object_unref);
+		for (i = 0; i < priv->releases->len; i++)
+			g_ptr_array_add (array, g_object_ref (g_ptr_array_index (priv->releases, i)));
+		g_ptr_array_unref (priv->releases);
+		priv->releases = array;
+	}
+	g_atomic_int_set (&priv->heavy_shared, FALSE);
+	g_mutex_unlock (&heavy_mutex);
+}
+
+/**
+ * as_component_detach_heavy:
+ *
+ * Read back evicted fields and drop the cache data before the heavy
+ * fields are modified, as they can not be restored from it anymore.
+ */
+static void
+as_component_detach_heavy (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	GVariant *data;
+
+	/* the data is about to change */
+	as_component_invalidate_content_hash (cpt);
+	as_component_unshare_heavy (cpt);
+
+	if (g_atomic_pointer_get (&priv->cache_data) == NULL)
+		return;
+	as_component_use_heavy (cpt);
+
+	g_mutex_lock (&heavy_mutex);
+	data = priv->cache_data;
+	g_atomic_pointer_set (&priv->cache_data, NULL);
+	g_mutex_unlock (&heavy_mutex);
+	if (data != NULL)
+		g_variant_unref (data);
+}
+
+/**
+ * as_component_set_cache_data:
+ * @cpt: a #AsComponent instance.
+ * @data: the #GVariant this component was read from.
+ * @locale: the locale of @data.
+ *
+ * Keep the cache serialization this component was loaded from, so
+ * its heavy fields can be evicted with as_component_evict_heavy()
+ * and read back from @data when needed.
+ * This should only be used if @data is cheap to keep around, e.g.
+ * because it is backed by a memory-mapped file.
+ */
+void
+as_component_set_cache_data (AsComponent *cpt, GVariant *data, const gchar *locale)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	g_mutex_lock (&heavy_mutex);
+	if (priv->cache_data != NULL)
+		g_variant_unref (priv->cache_data);
+	priv->cache_data = (data != NULL)? g_variant_ref (data) : NULL;
+	as_component_set_interned (&priv->cache_locale, locale);
+	g_mutex_unlock (&heavy_mutex);
+}
+
+/**
+ * as_component_get_heavy_size:
  * @cpt: a #AsComponent instance.
  *
- * A human-readable name for this component.
- *
- * Returns: the name.
+ * Returns: the approximate size of the data as_component_evict_heavy() can
+ *          free, or 0 if this component can not be evicted.
  */
-const gchar*
-as_component_get_name (AsComponent *cpt)
+gsize
+as_component_get_heavy_size (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return as_component_localized_get (cpt, priv->name);
+	if (g_atomic_pointer_get (&priv->cache_data) == NULL)
+		return 0;
+	return priv->heavy_size;
 }
 
 /**
- * as_component_set_name:
- * @cpt: A valid #AsComponent
- * @value: The name
- * @locale: (nullable): The locale the used for this value, or %NULL to use the current active one.
+ * as_component_get_heavy_used:
+ * @cpt: a #AsComponent instance.
  *
- * Set a human-readable name for this component.
+ * Returns: a value which is larger for more recent accesses to the heavy fields.
  */
-void
-as_component_set_name (AsComponent *cpt, const gchar* value, const gchar *locale)
+gint
+as_component_get_heavy_used (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-
-	as_component_localized_set (cpt, priv->name, value, locale);
-	g_object_notify ((GObject *) cpt, "name");
+	return g_atomic_int_get (&priv->heavy_used);
 }
 
 /**
- * as_component_get_summary:
+ * as_component_is_heavy_evicted:
  * @cpt: a #AsComponent instance.
  *
- * Get a short description of this component.
- *
- * Returns: the summary.
+ * Returns: %TRUE if the heavy fields of this component are currently evicted.
  */
-const gchar*
-as_component_get_summary (AsComponent *cpt)
+gboolean
+as_component_is_heavy_evicted (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return as_component_localized_get (cpt, priv->summary);
+	return g_atomic_int_get (&priv->heavy_evicted);
 }
 
 /**
- * as_component_set_summary:
- * @cpt: A valid #AsComponent
- * @value: The summary
- * @locale: (nullable): The locale the used for this value, or %NULL to use the current active one.
+ * as_component_evict_heavy:
+ * @cpt: a #AsComponent instance.
  *
- * Set a short description for this component.
+ * Drop the long description, screenshots and releases of a component
+ * which has cache data, they are read back when they are accessed again.
+ * Components which handed out their description, releases or screenshots
+ * to API users keep them, as these may be used for as long as the component lives.
+ * Internal code may still hold pointers into the dropped data, so it is
+ * handed over to be freed later with as_component_heavy_free().
+ *
+ * Returns: (transfer full) (nullable): the evicted data, or %NULL if nothing was evicted.
  */
-void
-as_component_set_summary (AsComponent *cpt, const gchar* value, const gchar *locale)
+AsComponentHeavy*
+as_component_evict_heavy (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	AsComponentHeavy *heavy = NULL;
 
-	as_component_localized_set (cpt, priv->summary, value, locale);
-	g_object_notify ((GObject *) cpt, "summary");
+	if (g_atomic_pointer_get (&priv->cache_data) == NULL)
+		return NULL;
+
+	g_mutex_lock (&heavy_mutex);
+	if (priv->cache_data != NULL && !priv->heavy_evicted && !priv->heavy_pinned) {
+		heavy = g_slice_new0 (AsComponentHeavy);
+		heavy->description = g_steal_pointer (&priv->description);
+		heavy->screenshots = g_steal_pointer (&priv->screenshots);
+		heavy->releases = g_steal_pointer (&priv->releases);
+		g_atomic_int_set (&priv->heavy_shared, FALSE);
+		g_atomic_int_set (&priv->heavy_evicted, TRUE);
+	}
+	g_mutex_unlock (&heavy_mutex);
+
+	return heavy;
 }
 
 /**
- * as_component_get_description:
- * @cpt: a #AsComponent instance.
- *
- * Get the localized long description of this component.
+ * as_component_heavy_free:
+ * @heavy: data returned by as_component_evict_heavy().
  *
- * Returns: the description.
+ * Free evicted component data.
  */
-const gchar*
-as_component_get_description (AsComponent *cpt)
+void
+as_component_heavy_free (AsComponentHeavy *heavy)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return as_component_localized_get (cpt, priv->description);
+	if (heavy == NULL)
+		return;
+	g_clear_pointer (&heavy->description, g_hash_table_unref);
+	g_clear_pointer (&heavy->screenshots, g_ptr_array_unref);
+	g_clear_pointer (&heavy->releases, g_ptr_array_unref);
+	g_slice_free (AsComponentHeavy, heavy);
 }
 
 /**
- * as_component_set_description:
- * @cpt: A valid #AsComponent
- * @value: The long description
- * @locale: (nullable): The locale the used for this value, or %NULL to use the current active one.
- *
- * Set long description for this component.
+ * as_component_share_heavy:
+ * @cpt: a #AsComponent instance.
+ * @donor: a component with the same content hash as @cpt.
+ *
+ * Replace the long description, screenshots and releases of @cpt
+ * with references to the ones of @donor, which hold the same data.
+ * Both components get their own copies of the containers again as soon
+ * as one of them modifies these fields through an #AsComponent method, or
+ * hands them out through a public getter.
+ *
+ * The #AsRelease and #AsScreenshot objects themselves are not copied,
+ * and stay shared between both components. Modifying one of them in
+ * place changes it for every component it is shared with, so only call
+ * this for components whose data is final, like the ones of a #AsPool.
  */
 void
-as_component_set_description (AsComponent *cpt, const gchar* value, const gchar *locale)
+as_component_share_heavy (AsComponent *cpt, AsComponent *donor)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	AsComponentPrivate *dpriv = GET_PRIVATE (donor);
+	GVariant *data;
 
-	as_component_localized_set (cpt, priv->description, value, locale);
-	g_object_notify ((GObject *) cpt, "description");
+	if (cpt == donor)
+		return;
+	as_component_use_heavy (donor);
+
+	g_mutex_lock (&heavy_mutex);
+	if (dpriv->heavy_evicted || priv->heavy_pinned) {
+		/* evicted again in the meantime, or our own data was handed out already, so keep it */
+		g_mutex_unlock (&heavy_mutex);
+		return;
+	}
+
+	/* our own fields can not be read back from the cache once they are replaced */
+	data = priv->cache_data;
+	g_atomic_pointer_set (&priv->cache_data, NULL);
+
+	g_clear_pointer (&priv->description, g_hash_table_unref);
+	g_clear_pointer (&priv->screenshots, g_ptr_array_unref);
+	g_clear_pointer (&priv->releases, g_ptr_array_unref);
+	if (dpriv->description != NULL)
+		priv->description = g_hash_table_ref (dpriv->description);
+	if (dpriv->screenshots != NULL)
+		priv->screenshots = g_ptr_array_ref (dpriv->screenshots);
+	if (dpriv->releases != NULL)
+		priv->releases = g_ptr_array_ref (dpriv->releases);
+
+	/* the locale keys of the description belong to the context of the donor */
+	if (dpriv->context != NULL && dpriv->context != priv->shared_context) {
+		if (priv->shared_context != NULL)
+			g_object_unref (priv->shared_context);
+		priv->shared_context = g_object_ref (dpriv->context);
+	}
+
+	g_atomic_int_set (&priv->heavy_evicted, FALSE);
+	g_atomic_int_set (&priv->heavy_shared, TRUE);
+	g_atomic_int_set (&dpriv->heavy_shared, TRUE);
+	g_mutex_unlock (&heavy_mutex);
+
+	if (data != NULL)
+		g_variant_unref (data);
 }
 
 /**
@@ -1262,16 +2092,8 @@ as_component_set_description (AsComponent *cpt, const gchar* value, const gchar
 gchar**
 as_component_get_keywords (AsComponent *cpt)
 {
-	gchar **strv;
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-
-	strv = g_hash_table_lookup (priv->keywords, as_component_get_active_locale (cpt));
-	if (strv == NULL) {
-		/* fall back to untranslated */
-		strv = g_hash_table_lookup (priv->keywords, "C");
-	}
-
-	return strv;
+	return as_locale_chain_lookup (as_component_get_locale_chain (cpt), priv->keywords, TRUE);
 }
 
 /**
@@ -1287,12 +2109,14 @@ as_component_set_keywords (AsComponent *cpt, gchar **value, const gchar *locale)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	/* if no locale was specified, we assume the default locale */
 	if (locale == NULL)
 		locale = as_component_get_active_locale (cpt);
 
+	as_component_ensure_table (&priv->keywords, g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_strfreev);
 	g_hash_table_insert (priv->keywords,
-				g_strdup (locale),
+				(gpointer) as_component_intern (cpt, locale),
 				g_strdupv (value));
 
 	g_object_notify ((GObject *) cpt, "keywords");
@@ -1308,7 +2132,7 @@ GPtrArray*
 as_component_get_icons (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->icons;
+	return as_component_get_array (&priv->icons, g_object_unref);
 }
 
 /**
@@ -1334,6 +2158,8 @@ as_component_get_icon_by_size (AsComponent *cpt, guint width, guint height)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	guint i;
 
+	if (priv->icons == NULL)
+		return NULL;
 	for (i = 0; i < priv->icons->len; i++) {
 		AsIcon *icon = AS_ICON (g_ptr_array_index (priv->icons, i));
 		/* ignore scaled icons */
@@ -1358,7 +2184,9 @@ void
 as_component_add_icon (AsComponent *cpt, AsIcon *icon)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_ptr_array_add (priv->icons, g_object_ref (icon));
+	as_component_invalidate_content_hash (cpt);
+	g_ptr_array_add (as_component_ensure_array (&priv->icons, g_object_unref),
+			 g_object_ref (icon));
 }
 
 /**
@@ -1371,7 +2199,7 @@ GPtrArray*
 as_component_get_categories (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->categories;
+	return as_component_get_array (&priv->categories, NULL);
 }
 
 /**
@@ -1386,13 +2214,15 @@ as_component_add_category (AsComponent *cpt, const gchar *category)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	if (as_flags_contains (priv->value_flags, AS_VALUE_FLAG_DUPLICATE_CHECK)) {
 		/* check for duplicates */
-		if (as_ptr_array_find_string (priv->categories, category) != NULL)
+		if (as_ptr_array_find_string (AS_CPT_ARRAY (priv->categories), category) != NULL)
 			return;
 	}
-	g_ptr_array_add (priv->categories,
-			 g_strdup (category));
+	/* categories are interned, so the array doesn't own them */
+	g_ptr_array_add (as_component_ensure_array (&priv->categories, NULL),
+			 (gpointer) as_component_intern (cpt, category));
 }
 
 /**
@@ -1408,7 +2238,7 @@ gboolean
 as_component_has_category (AsComponent *cpt, const gchar *category)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return as_ptr_array_find_string (priv->categories, category) != NULL;
+	return as_ptr_array_find_string (AS_CPT_ARRAY (priv->categories), category) != NULL;
 }
 
 /**
@@ -1437,8 +2267,8 @@ void
 as_component_set_metadata_license (AsComponent *cpt, const gchar *value)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_free (priv->metadata_license);
-	priv->metadata_license = g_strdup (value);
+	as_component_invalidate_content_hash (cpt);
+	as_component_set_interned (&priv->metadata_license, value);
 }
 
 /**
@@ -1468,8 +2298,8 @@ as_component_set_project_license (AsComponent *cpt, const gchar *value)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
-	g_free (priv->project_license);
-	priv->project_license = g_strdup (value);
+	as_component_invalidate_content_hash (cpt);
+	as_component_set_interned (&priv->project_license, value);
 	g_object_notify ((GObject *) cpt, "project-license");
 }
 
@@ -1500,8 +2330,8 @@ as_component_set_project_group (AsComponent *cpt, const gchar *value)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
-	g_free (priv->project_group);
-	priv->project_group = g_strdup (value);
+	as_component_invalidate_content_hash (cpt);
+	as_component_set_interned (&priv->project_group, value);
 }
 
 /**
@@ -1531,7 +2361,8 @@ void
 as_component_set_developer_name (AsComponent *cpt, const gchar *value, const gchar *locale)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	as_component_localized_set (cpt, priv->developer_name, value, locale);
+	as_component_invalidate_content_hash (cpt);
+	as_component_localized_set (cpt, &priv->developer_name, value, locale);
 }
 
 /**
@@ -1540,13 +2371,25 @@ as_component_set_developer_name (AsComponent *cpt, const gchar *value, const gch
  *
  * Get a list of associated screenshots.
  *
+ * The array stays valid as long as the component, see as_component_get_releases().
+ *
  * Returns: (element-type AsScreenshot) (transfer none): an array of #AsScreenshot instances
  */
 GPtrArray*
 as_component_get_screenshots (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->screenshots;
+	GPtrArray *screenshots;
+
+	/* callers may modify the array, so it must not be shared with other components */
+	as_component_unshare_heavy (cpt);
+
+	as_component_lock_heavy (cpt);
+	screenshots = as_component_get_array (&priv->screenshots, g_object_unref);
+	g_atomic_int_set (&priv->heavy_pinned, TRUE);
+	as_component_unlock_heavy ();
+
+	return screenshots;
 }
 
 /**
@@ -1558,8 +2401,7 @@ as_component_get_screenshots (AsComponent *cpt)
 GPtrArray*
 as_component_get_compulsory_for_desktops (AsComponent *cpt)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->compulsory_for_desktops;
+	return as_component_get_array (&as_component_get_extra (cpt)->compulsory_for_desktops, g_free);
 }
 
 /**
@@ -1575,12 +2417,13 @@ as_component_set_compulsory_for_desktop (AsComponent *cpt, const gchar *desktop)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	g_return_if_fail (desktop != NULL);
 
+	as_component_invalidate_content_hash (cpt);
 	if (as_flags_contains (priv->value_flags, AS_VALUE_FLAG_DUPLICATE_CHECK)) {
 		/* check for duplicates */
-		if (as_ptr_array_find_string (priv->compulsory_for_desktops, desktop) != NULL)
+		if (as_component_is_compulsory_for_desktop (cpt, desktop))
 			return;
 	}
-	g_ptr_array_add (priv->compulsory_for_desktops,
+	g_ptr_array_add (as_component_ensure_array (&as_component_ensure_extra (cpt)->compulsory_for_desktops, g_free),
 			 g_strdup (desktop));
 }
 
@@ -1597,7 +2440,7 @@ gboolean
 as_component_is_compulsory_for_desktop (AsComponent *cpt, const gchar *desktop)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return as_ptr_array_find_string (priv->compulsory_for_desktops, desktop) != NULL;
+	return as_ptr_array_find_string (AS_CPT_ARRAY (AS_CPT_EXTRA (priv, compulsory_for_desktops)), desktop) != NULL;
 }
 
 /**
@@ -1617,6 +2460,8 @@ as_component_get_provided_for_kind (AsComponent *cpt, AsProvidedKind kind)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	guint i;
 
+	if (priv->provided == NULL)
+		return NULL;
 	for (i = 0; i < priv->provided->len; i++) {
 		AsProvided *prov = AS_PROVIDED (g_ptr_array_index (priv->provided, i));
 		if (as_provided_get_kind (prov) == kind)
@@ -1637,7 +2482,7 @@ GPtrArray*
 as_component_get_provided (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->provided;
+	return as_component_get_array (&priv->provided, g_object_unref);
 }
 
 /**
@@ -1654,6 +2499,8 @@ as_component_add_provided (AsComponent *cpt, AsProvided *prov)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
+	as_component_ensure_array (&priv->provided, g_object_unref);
 	if (as_flags_contains (priv->value_flags, AS_VALUE_FLAG_DUPLICATE_CHECK)) {
 		guint i;
 		for (i = 0; i < priv->provided->len; i++) {
@@ -1688,6 +2535,7 @@ as_component_add_provided_item (AsComponent *cpt, AsProvidedKind kind, const gch
 	AsProvided *prov;
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	/* we just skip empty items */
 	if (as_str_empty (item))
 		return;
@@ -1696,7 +2544,7 @@ as_component_add_provided_item (AsComponent *cpt, AsProvidedKind kind, const gch
 	if (prov == NULL) {
 		prov = as_provided_new ();
 		as_provided_set_kind (prov, kind);
-		g_ptr_array_add (priv->provided, prov);
+		g_ptr_array_add (as_component_ensure_array (&priv->provided, g_object_unref), prov);
 	}
 
 	as_provided_add_item (prov, item);
@@ -1713,7 +2561,8 @@ void
 as_component_add_suggested (AsComponent *cpt, AsSuggested *suggested)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_ptr_array_add (priv->suggestions,
+	as_component_invalidate_content_hash (cpt);
+	g_ptr_array_add (as_component_ensure_array (&as_component_ensure_extra (cpt)->suggestions, g_object_unref),
 			 g_object_ref (suggested));
 }
 
@@ -1728,8 +2577,7 @@ as_component_add_suggested (AsComponent *cpt, AsSuggested *suggested)
 GPtrArray*
 as_component_get_suggested (AsComponent *cpt)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->suggestions;
+	return as_component_get_array (&as_component_get_extra (cpt)->suggestions, g_object_unref);
 }
 
 /**
@@ -1763,6 +2611,7 @@ void
 as_component_set_merge_kind (AsComponent *cpt, AsMergeKind kind)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_invalidate_content_hash (cpt);
 	priv->merge_kind = kind;
 }
 
@@ -1796,40 +2645,10 @@ void
 as_component_set_priority (AsComponent *cpt, gint priority)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_invalidate_content_hash (cpt);
 	priv->priority = priority;
 }
 
-/**
- * as_component_get_sort_score:
- * @cpt: a #AsComponent instance.
- *
- * Returns the sorting priority of this component.
- *
- * Since: 0.9.8
- */
-guint
-as_component_get_sort_score (AsComponent *cpt)
-{
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->sort_score;
-}
-
-/**
- * as_component_set_sort_score:
- * @cpt: a #AsComponent instance.
- * @score: the given sorting score
- *
- * Sets the sorting score of this component.
- *
- * Since: 0.9.8
- */
-void
-as_component_set_sort_score (AsComponent *cpt, guint score)
-{
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	priv->sort_score = score;
-}
-
 /**
  * as_component_add_language:
  * @cpt: an #AsComponent instance.
@@ -1845,8 +2664,10 @@ as_component_add_language (AsComponent *cpt, const gchar *locale, gint percentag
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	if (locale == NULL)
 		locale = "C";
+	as_component_ensure_table (&priv->languages, g_str_hash, g_str_equal, g_free, NULL);
 	g_hash_table_insert (priv->languages,
 				g_strdup (locale),
 				GINT_TO_POINTER (percentage));
@@ -1872,7 +2693,7 @@ as_component_get_language (AsComponent *cpt, const gchar *locale)
 
 	if (locale == NULL)
 		locale = "C";
-	ret = g_hash_table_lookup_extended (priv->languages,
+	ret = g_hash_table_lookup_extended (AS_CPT_TABLE (priv->languages),
 					    locale, NULL, &value);
 	if (!ret)
 		return -1;
@@ -1893,7 +2714,7 @@ GList*
 as_component_get_languages (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return g_hash_table_get_keys (priv->languages);
+	return g_hash_table_get_keys (AS_CPT_TABLE (priv->languages));
 }
 
 /**
@@ -1910,7 +2731,7 @@ GHashTable*
 as_component_get_languages_table (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->languages;
+	return as_component_get_table (&priv->languages, g_str_hash, g_str_equal, g_free, NULL);
 }
 
 /**
@@ -1930,10 +2751,7 @@ as_component_get_languages_table (AsComponent *cpt)
 GPtrArray*
 as_component_get_translations (AsComponent *cpt)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	if (priv->translations == NULL)
-		priv->translations = g_ptr_array_new_with_free_func (g_object_unref);
-	return priv->translations;
+	return as_component_get_array (&as_component_get_extra (cpt)->translations, g_object_unref);
 }
 
 /**
@@ -1949,10 +2767,9 @@ as_component_get_translations (AsComponent *cpt)
 void
 as_component_add_translation (AsComponent *cpt, AsTranslation *tr)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	if (priv->translations == NULL)
-		priv->translations = g_ptr_array_new_with_free_func (g_object_unref);
-	g_ptr_array_add (priv->translations, g_object_ref (tr));
+	as_component_invalidate_content_hash (cpt);
+	g_ptr_array_add (as_component_ensure_array (&as_component_ensure_extra (cpt)->translations, g_object_unref),
+			 g_object_ref (tr));
 }
 
 /**
@@ -1981,6 +2798,7 @@ void
 as_component_set_scope (AsComponent *cpt, AsComponentScope scope)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_invalidate_content_hash (cpt);
 	priv->scope = scope;
 }
 
@@ -2010,6 +2828,7 @@ void
 as_component_set_origin_kind (AsComponent *cpt, AsOriginKind okind)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_invalidate_content_hash (cpt);
 	priv->origin_kind = okind;
 }
 
@@ -2065,12 +2884,11 @@ as_component_refine_icons (AsComponent *cpt, GPtrArray *icon_paths)
 	g_autoptr(GPtrArray) icons = NULL;
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
-	if (priv->icons->len == 0)
+	if (priv->icons == NULL || priv->icons->len == 0)
 		return;
 
 	/* take control of the old icon list and rewrite it */
-	icons = priv->icons;
-	priv->icons = g_ptr_array_new_with_free_func (g_object_unref);
+	icons = g_steal_pointer (&priv->icons);
 
 	origin = as_component_get_origin (cpt);
 
@@ -2227,11 +3045,12 @@ as_component_complete (AsComponent *cpt, gchar *scr_service_url, GPtrArray *icon
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	/* improve icon paths */
 	as_component_refine_icons (cpt, icon_paths);
 
 	/* "fake" a launchable entry for desktop-apps that failed to include one. This is used for legacy compatibility */
-	if ((priv->kind == AS_COMPONENT_KIND_DESKTOP_APP) && (priv->launchables->len <= 0)) {
+	if ((priv->kind == AS_COMPONENT_KIND_DESKTOP_APP) && (priv->launchable_recs == NULL) && (AS_CPT_ARRAY (priv->launchables)->len <= 0)) {
 		if (g_str_has_suffix (priv->id, ".desktop")) {
 			g_autoptr(AsLaunchable) launchable = as_launchable_new ();
 			as_launchable_set_kind (launchable, AS_LAUNCHABLE_KIND_DESKTOP_ID);
@@ -2245,7 +3064,8 @@ as_component_complete (AsComponent *cpt, gchar *scr_service_url, GPtrArray *icon
 		return;
 
 	/* we want screenshot data from 3rd-party screenshot servers, if the component doesn't have screenshots defined already */
-	if ((priv->screenshots->len == 0) && (as_component_has_package (cpt))) {
+	as_component_use_heavy (cpt);
+	if ((AS_CPT_ARRAY (priv->screenshots)->len == 0) && (as_component_has_package (cpt))) {
 		gchar *url;
 		AsImage *img;
 		g_autoptr(AsScreenshot) sshot = NULL;
@@ -2291,18 +3111,126 @@ as_component_complete (AsComponent *cpt, gchar *scr_service_url, GPtrArray *icon
 	}
 }
 
+/**
+ * as_component_clear_tokens:
+ *
+ * Drop the search tokens of this component.
+ */
+static void
+as_component_clear_tokens (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	guint i;
+
+	for (i = 0; i < priv->n_tokens; i++)
+		as_intern_unref (priv->tokens[i]);
+	g_clear_pointer (&priv->tokens, g_free);
+	g_clear_pointer (&priv->token_flags, g_free);
+	priv->n_tokens = 0;
+}
+
+/**
+ * as_component_token_cmp:
+ */
+static gint
+as_component_token_cmp (gconstpointer a, gconstpointer b)
+{
+	return strcmp (*((const gchar **) a), *((const gchar **) b));
+}
+
+/**
+ * as_component_new_token_table:
+ *
+ * Create a table to collect search tokens in, prefilled with the
+ * tokens this component already has.
+ * Values are the #AsTokenMatch flags, stored with GUINT_TO_POINTER().
+ */
+static GHashTable*
+as_component_new_token_table (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	GHashTable *table;
+	guint i;
+
+	table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	for (i = 0; i < priv->n_tokens; i++)
+		g_hash_table_insert (table,
+				     g_strdup (priv->tokens[i]),
+				     GUINT_TO_POINTER (priv->token_flags[i]));
+	return table;
+}
+
+/**
+ * as_component_set_tokens_from_table:
+ *
+ * Replace the search tokens with the ones collected in @table, as a
+ * sorted array of shared strings, so they can be found by binary search.
+ */
+static void
+as_component_set_tokens_from_table (AsComponent *cpt, GHashTable *table)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	GHashTableIter iter;
+	gpointer key;
+	g_autoptr(GPtrArray) keys = NULL;
+	const gchar **tokens;
+	AsTokenType *flags;
+	guint i;
+
+	keys = g_ptr_array_sized_new (g_hash_table_size (table));
+	g_hash_table_iter_init (&iter, table);
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+		g_ptr_array_add (keys, key);
+	g_ptr_array_sort (keys, as_component_token_cmp);
+
+	tokens = g_new (const gchar*, keys->len);
+	flags = g_new (AsTokenType, keys->len);
+	for (i = 0; i < keys->len; i++) {
+		const gchar *token = g_ptr_array_index (keys, i);
+		tokens[i] = as_intern_ref (token);
+		flags[i] = GPOINTER_TO_UINT (g_hash_table_lookup (table, token));
+	}
+
+	as_component_clear_tokens (cpt);
+	priv->tokens = tokens;
+	priv->token_flags = flags;
+	priv->n_tokens = keys->len;
+}
+
+/**
+ * as_component_find_token:
+ *
+ * Find the position of the first token which is not smaller than @term.
+ */
+static guint
+as_component_find_token (AsComponent *cpt, const gchar *term)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	guint low = 0;
+	guint high = priv->n_tokens;
+
+	while (low < high) {
+		guint mid = low + (high - low) / 2;
+		if (strcmp (priv->tokens[mid], term) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
 /**
  * as_component_add_token_helper:
  */
 static void
-as_component_add_token_helper (AsComponent *cpt,
+as_component_add_token_helper (GHashTable *tokens,
 			   const gchar *value,
 			   AsTokenMatch match_flag,
 			   AsStemmer *stemmer)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	AsTokenType *match_pval;
-	g_autofree gchar *token_stemmed = NULL;
+	gchar *token_stemmed;
+	gpointer match_val;
 
 	/* invalid */
 	if (!as_utils_search_token_valid (value))
@@ -2311,26 +3239,18 @@ as_component_add_token_helper (AsComponent *cpt,
 	/* create a stemmed version of our token */
 	token_stemmed = as_stemmer_stem (stemmer, value);
 
-	/* does the token already exist */
-	match_pval = g_hash_table_lookup (priv->token_cache, token_stemmed);
-	if (match_pval != NULL) {
-		*match_pval |= match_flag;
-		return;
-	}
-
-	/* create and add */
-	match_pval = g_new0 (AsTokenType, 1);
-	*match_pval = match_flag;
-	g_hash_table_insert (priv->token_cache,
-			     g_steal_pointer (&token_stemmed),
-			     match_pval);
+	/* merge with the flags of an existing token */
+	match_val = g_hash_table_lookup (tokens, token_stemmed);
+	g_hash_table_insert (tokens,
+			     token_stemmed,
+			     GUINT_TO_POINTER (GPOINTER_TO_UINT (match_val) | match_flag));
 }
 
 /**
  * as_component_add_token:
  */
 static void
-as_component_add_token (AsComponent *cpt,
+as_component_add_token (GHashTable *tokens,
 		  const gchar *value,
 		  gboolean allow_split,
 		  AsTokenMatch match_flag)
@@ -2344,11 +3264,11 @@ as_component_add_token (AsComponent *cpt,
 		guint i;
 		g_auto(GStrv) split = g_strsplit (value, "-", -1);
 		for (i = 0; split[i] != NULL; i++)
-			as_component_add_token_helper (cpt, split[i], match_flag, stemmer);
+			as_component_add_token_helper (tokens, split[i], match_flag, stemmer);
 	}
 
 	/* add the whole token always, even when we split on hyphen */
-	as_component_add_token_helper (cpt, value, match_flag, stemmer);
+	as_component_add_token_helper (tokens, value, match_flag, stemmer);
 }
 
 /**
@@ -2386,6 +3306,7 @@ as_component_value_tokenize (AsComponent *cpt, const gchar *value, gchar ***toke
  */
 static void
 as_component_add_tokens (AsComponent *cpt,
+		   GHashTable *tokens,
 		   const gchar *value,
 		   gboolean allow_split,
 		   AsTokenMatch match_flag)
@@ -2407,55 +3328,57 @@ as_component_add_tokens (AsComponent *cpt,
 
 	/* add each token */
 	for (i = 0; values_utf8 != NULL && values_utf8[i] != NULL; i++)
-		as_component_add_token (cpt, values_utf8[i], allow_split, match_flag);
+		as_component_add_token (tokens, values_utf8[i], allow_split, match_flag);
 	for (i = 0; values_ascii != NULL && values_ascii[i] != NULL; i++)
-		as_component_add_token (cpt, values_ascii[i], allow_split, match_flag);
+		as_component_add_token (tokens, values_ascii[i], allow_split, match_flag);
 }
 
 /**
  * as_component_create_token_cache_target:
  */
 static void
-as_component_create_token_cache_target (AsComponent *cpt, AsComponent *donor)
+as_component_create_token_cache_target (AsComponent *cpt, GHashTable *tokens, AsComponent *donor)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (donor);
 	const gchar *tmp;
+	g_autofree gchar *desc = NULL;
 	gchar **keywords;
 	AsProvided *prov;
 	guint i;
 
 	/* tokenize all the data we have */
 	if (priv->id != NULL) {
-		as_component_add_token (cpt, priv->id, FALSE,
+		as_component_add_token (tokens, priv->id, FALSE,
 				  AS_TOKEN_MATCH_ID);
 	}
 
 	tmp = as_component_get_name (cpt);
 	if (tmp != NULL) {
-		as_component_add_tokens (cpt, tmp, TRUE, AS_TOKEN_MATCH_NAME);
+		as_component_add_tokens (cpt, tokens, tmp, TRUE, AS_TOKEN_MATCH_NAME);
 	}
 
 	tmp = as_component_get_summary (cpt);
 	if (tmp != NULL) {
-		as_component_add_tokens (cpt, tmp, TRUE, AS_TOKEN_MATCH_SUMMARY);
+		as_component_add_tokens (cpt, tokens, tmp, TRUE, AS_TOKEN_MATCH_SUMMARY);
 	}
 
-	tmp = as_component_get_description (cpt);
-	if (tmp != NULL) {
-		as_component_add_tokens (cpt, tmp, FALSE, AS_TOKEN_MATCH_DESCRIPTION);
+	/* we only need the description once, so don't keep it unpacked */
+	desc = as_component_dup_description (cpt);
+	if (desc != NULL) {
+		as_component_add_tokens (cpt, tokens, desc, FALSE, AS_TOKEN_MATCH_DESCRIPTION);
 	}
 
 	keywords = as_component_get_keywords (cpt);
 	if (keywords != NULL) {
 		for (i = 0; keywords[i] != NULL; i++)
-			as_component_add_tokens (cpt, keywords[i], FALSE, AS_TOKEN_MATCH_KEYWORD);
+			as_component_add_tokens (cpt, tokens, keywords[i], FALSE, AS_TOKEN_MATCH_KEYWORD);
 	}
 
 	prov = as_component_get_provided_for_kind (donor, AS_PROVIDED_KIND_MIMETYPE);
 	if (prov != NULL) {
 		GPtrArray *items = as_provided_get_items (prov);
 		for (i = 0; i < items->len; i++)
-			as_component_add_token (cpt,
+			as_component_add_token (tokens,
 						(const gchar*) g_ptr_array_index (items, i),
 						FALSE,
 						AS_TOKEN_MATCH_MIMETYPE);
@@ -2463,7 +3386,7 @@ as_component_create_token_cache_target (AsComponent *cpt, AsComponent *donor)
 
 	if (priv->pkgnames != NULL) {
 		for (i = 0; priv->pkgnames[i] != NULL; i++)
-			as_component_add_token (cpt, priv->pkgnames[i], FALSE, AS_TOKEN_MATCH_PKGNAME);
+			as_component_add_token (tokens, priv->pkgnames[i], FALSE, AS_TOKEN_MATCH_PKGNAME);
 	}
 }
 
@@ -2474,14 +3397,18 @@ void
 as_component_create_token_cache (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	g_autoptr(GHashTable) tokens = NULL;
 	guint i;
 
-	as_component_create_token_cache_target (cpt, cpt);
+	tokens = as_component_new_token_table (cpt);
+	as_component_create_token_cache_target (cpt, tokens, cpt);
 
-	for (i = 0; i < priv->addons->len; i++) {
+	for (i = 0; i < AS_CPT_ARRAY (priv->addons)->len; i++) {
 		AsComponent *donor = g_ptr_array_index (priv->addons, i);
-		as_component_create_token_cache_target (cpt, donor);
+		as_component_create_token_cache_target (cpt, tokens, donor);
 	}
+
+	as_component_set_tokens_from_table (cpt, tokens);
 }
 
 /**
@@ -2499,10 +3426,8 @@ guint
 as_component_search_matches (AsComponent *cpt, const gchar *term)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	AsTokenType *match_pval;
-	GList *l;
 	AsTokenMatch result = 0;
-	g_autoptr(GList) keys = NULL;
+	guint i;
 
 	/* nothing to do */
 	if (term == NULL)
@@ -2515,19 +3440,13 @@ as_component_search_matches (AsComponent *cpt, const gchar *term)
 	}
 
 	/* find the exact match (which is more awesome than a partial match) */
-	match_pval = g_hash_table_lookup (priv->token_cache, term);
-	if (match_pval != NULL)
-		return *match_pval << 2;
-
-	/* need to do partial match */
-	keys = g_hash_table_get_keys (priv->token_cache);
-	for (l = keys; l != NULL; l = l->next) {
-		const gchar *key = l->data;
-		if (g_str_has_prefix (key, term)) {
-			match_pval = g_hash_table_lookup (priv->token_cache, key);
-			result |= *match_pval;
-		}
-	}
+	i = as_component_find_token (cpt, term);
+	if ((i < priv->n_tokens) && (strcmp (priv->tokens[i], term) == 0))
+		return priv->token_flags[i] << 2;
+
+	/* tokens starting with the term follow it in sort order */
+	for (; (i < priv->n_tokens) && g_str_has_prefix (priv->tokens[i], term); i++)
+		result |= priv->token_flags[i];
 
 	return result;
 }
@@ -2538,6 +3457,8 @@ as_component_search_matches (AsComponent *cpt, const gchar *term)
  * @terms: the search terms.
  *
  * Searches component data for all the specific keywords.
+ * The score is only returned and not stored, so searches running
+ * in parallel on the same component don't affect each other.
  *
  * Returns: a match score, where 0 is no match and larger numbers are better
  * matches.
@@ -2547,20 +3468,17 @@ as_component_search_matches (AsComponent *cpt, const gchar *term)
 guint
 as_component_search_matches_all (AsComponent *cpt, gchar **terms)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	guint i;
 	guint matches_sum = 0;
 	guint tmp;
 
-	priv->sort_score = 0;
 	if (terms == NULL) {
 		/* if the terms list is NULL, we usually had a too short search term when
 		 * tokenizing the search string. In any case, we treat NULL as match-all
 		 * value.
 		 * (users will see a full list of all entries that way, which they will
 		 * recognize as hint to make their search more narrow) */
-		priv->sort_score = 1;
-		return priv->sort_score;
+		return 1;
 	}
 
 	/* do *all* search keywords match */
@@ -2571,8 +3489,7 @@ as_component_search_matches_all (AsComponent *cpt, gchar **terms)
 		matches_sum |= tmp;
 	}
 
-	priv->sort_score = matches_sum;
-	return priv->sort_score;
+	return matches_sum;
 }
 
 /**
@@ -2589,9 +3506,8 @@ GPtrArray*
 as_component_get_search_tokens (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	GList *l;
 	GPtrArray *array;
-	g_autoptr(GList) keys = NULL;
+	guint i;
 
 	/* ensure the token cache is created */
 	if (g_once_init_enter (&priv->token_cache_valid)) {
@@ -2600,29 +3516,13 @@ as_component_get_search_tokens (AsComponent *cpt)
 	}
 
 	/* return all the token cache */
-	keys = g_hash_table_get_keys (priv->token_cache);
-	array = g_ptr_array_new_with_free_func (g_free);
-	for (l = keys; l != NULL; l = l->next)
-		g_ptr_array_add (array, g_strdup (l->data));
+	array = g_ptr_array_new_full (priv->n_tokens, g_free);
+	for (i = 0; i < priv->n_tokens; i++)
+		g_ptr_array_add (array, g_strdup (priv->tokens[i]));
 
 	return array;
 }
 
-/**
- * as_component_get_token_cache_table:
- * @cpt: a #AsComponent instance.
- *
- * Get the raw token table.
- *
- * This is internal API.
- **/
-GHashTable*
-as_component_get_token_cache_table (AsComponent *cpt)
-{
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->token_cache;
-}
-
 /**
  * as_component_set_token_cache_valid:
  * @cpt: a #AsComponent instance.
@@ -2715,6 +3615,7 @@ void
 as_component_set_ignored (AsComponent *cpt, gboolean ignore)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_invalidate_content_hash (cpt);
 	priv->ignored = ignore;
 }
 
@@ -2733,6 +3634,25 @@ as_component_is_ignored (AsComponent *cpt)
 	return priv->ignored;
 }
 
+/**
+ * as_component_get_load_profile:
+ * @cpt: An #AsComponent.
+ *
+ * Get the parts of the component data which were loaded from metadata.
+ * If a part is missing from the profile, its data was skipped while loading,
+ * so e.g. an empty list of releases does not mean the component has no releases.
+ *
+ * Returns: The #AsLoadProfile the component was loaded with.
+ *
+ * Since: 0.12.1
+ */
+AsLoadProfile
+as_component_get_load_profile (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	return priv->load_profile;
+}
+
 /**
  * as_component_get_custom:
  * @cpt: An #AsComponent.
@@ -2744,8 +3664,7 @@ as_component_is_ignored (AsComponent *cpt)
 GHashTable*
 as_component_get_custom (AsComponent *cpt)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->custom;
+	return as_component_get_table (&as_component_get_extra (cpt)->custom, g_str_hash, g_str_equal, g_free, g_free);
 }
 
 /**
@@ -2763,7 +3682,7 @@ as_component_get_custom_value (AsComponent *cpt, const gchar *key)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	if (key == NULL)
 		return NULL;
-	return g_hash_table_lookup (priv->custom, key);
+	return g_hash_table_lookup (AS_CPT_TABLE (AS_CPT_EXTRA (priv, custom)), key);
 }
 
 /**
@@ -2781,10 +3700,13 @@ as_component_get_custom_value (AsComponent *cpt, const gchar *key)
 gboolean
 as_component_insert_custom_value (AsComponent *cpt, const gchar *key, const gchar *value)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	AsComponentExtra *extra;
+	as_component_invalidate_content_hash (cpt);
 	if (key == NULL)
 		return FALSE;
-	return g_hash_table_insert (priv->custom,
+	extra = as_component_ensure_extra (cpt);
+	as_component_ensure_table (&extra->custom, g_str_hash, g_str_equal, g_free, g_free);
+	return g_hash_table_insert (extra->custom,
 				    g_strdup (key),
 				    g_strdup (value));
 }
@@ -2803,7 +3725,7 @@ GPtrArray*
 as_component_get_content_ratings (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->content_ratings;
+	return as_component_get_array (&priv->content_ratings, g_object_unref);
 }
 
 /**
@@ -2823,6 +3745,8 @@ as_component_get_content_rating (AsComponent *cpt, const gchar *kind)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	guint i;
 
+	if (priv->content_ratings == NULL)
+		return NULL;
 	for (i = 0; i < priv->content_ratings->len; i++) {
 		AsContentRating *content_rating = AS_CONTENT_RATING (g_ptr_array_index (priv->content_ratings, i));
 		if (g_strcmp0 (as_content_rating_get_kind (content_rating), kind) == 0)
@@ -2844,7 +3768,8 @@ void
 as_component_add_content_rating (AsComponent *cpt, AsContentRating *content_rating)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_ptr_array_add (priv->content_ratings,
+	as_component_invalidate_content_hash (cpt);
+	g_ptr_array_add (as_component_ensure_array (&priv->content_ratings, g_object_unref),
 			 g_object_ref (content_rating));
 }
 
@@ -2866,6 +3791,9 @@ as_component_get_launchable (AsComponent *cpt, AsLaunchableKind kind)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	guint i;
 
+	as_component_unpack_records (cpt);
+	if (priv->launchables == NULL)
+		return NULL;
 	for (i = 0; i < priv->launchables->len; i++) {
 		AsLaunchable *launch = AS_LAUNCHABLE (g_ptr_array_index (priv->launchables, i));
 		if (as_launchable_get_kind (launch) == kind)
@@ -2886,7 +3814,8 @@ GPtrArray*
 as_component_get_launchables (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->launchables;
+	as_component_unpack_records (cpt);
+	return as_component_get_array (&priv->launchables, g_object_unref);
 }
 
 /**
@@ -2902,10 +3831,65 @@ void
 as_component_add_launchable (AsComponent *cpt, AsLaunchable *launchable)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	g_ptr_array_add (priv->launchables,
+	as_component_invalidate_content_hash (cpt);
+	as_component_unpack_records (cpt);
+	g_ptr_array_add (as_component_ensure_array (&priv->launchables, g_object_unref),
 			 g_object_ref (launchable));
 }
 
+/**
+ * as_component_has_launchable_entry:
+ * @cpt: a #AsComponent instance.
+ * @kind: the #AsLaunchableKind, or %AS_LAUNCHABLE_KIND_UNKNOWN to match any kind.
+ * @entry: the launchable entry to look for.
+ *
+ * Check whether this component has a launchable entry, without
+ * creating any #AsLaunchable objects for cached data.
+ *
+ * Returns: %TRUE if @entry was found.
+ **/
+gboolean
+as_component_has_launchable_entry (AsComponent *cpt, AsLaunchableKind kind, const gchar *entry)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	guint i;
+
+	if (g_atomic_pointer_get (&priv->launchable_recs) != NULL) {
+		g_mutex_lock (&records_mutex);
+		if (priv->launchable_recs != NULL) {
+			gboolean found = FALSE;
+			for (i = 0; i < priv->launchable_recs->len && !found; i++) {
+				AsLaunchableRecord *rec = &g_array_index (priv->launchable_recs, AsLaunchableRecord, i);
+				if (kind != AS_LAUNCHABLE_KIND_UNKNOWN && rec->kind != kind)
+					continue;
+				if (rec->entries != NULL)
+					found = g_strv_contains ((const gchar * const*) rec->entries, entry);
+			}
+			g_mutex_unlock (&records_mutex);
+			return found;
+		}
+		g_mutex_unlock (&records_mutex);
+	}
+
+	for (i = 0; i < AS_CPT_ARRAY (priv->launchables)->len; i++) {
+		guint j;
+		GPtrArray *entries;
+		AsLaunchable *launch = AS_LAUNCHABLE (g_ptr_array_index (priv->launchables, i));
+
+		/* an unknown kind matches all launchable types */
+		if (kind != AS_LAUNCHABLE_KIND_UNKNOWN && as_launchable_get_kind (launch) != kind)
+			continue;
+
+		entries = as_launchable_get_entries (launch);
+		for (j = 0; j < entries->len; j++) {
+			if (g_strcmp0 ((const gchar*) g_ptr_array_index (entries, j), entry) == 0)
+				return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
 /**
  * as_component_get_recommends:
  * @cpt: a #AsComponent instance.
@@ -2919,8 +3903,7 @@ as_component_add_launchable (AsComponent *cpt, AsLaunchable *launchable)
 GPtrArray*
 as_component_get_recommends (AsComponent *cpt)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->recommends;
+	return as_component_get_array (&as_component_get_extra (cpt)->recommends, g_object_unref);
 }
 
 /**
@@ -2935,36 +3918,93 @@ as_component_get_recommends (AsComponent *cpt)
  **/
 GPtrArray*
 as_component_get_requires (AsComponent *cpt)
+{
+	return as_component_get_array (&as_component_get_extra (cpt)->requires, g_object_unref);
+}
+
+/**
+ * as_component_add_relation:
+ * @cpt: a #AsComponent instance.
+ * @relation: a #AsRelation instance.
+ *
+ * Adds a #AsRelation to set a recommends or requires relation of
+ * component @cpt on the item mentioned in the #AsRelation.
+ *
+ * Since: 0.12.0
+ **/
+void
+as_component_add_relation (AsComponent *cpt, AsRelation *relation)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	return priv->requires;
+	AsRelationKind kind = as_relation_get_kind (relation);
+
+	as_component_invalidate_content_hash (cpt);
+	if (kind == AS_RELATION_KIND_RECOMMENDS) {
+		g_ptr_array_add (as_component_ensure_array (&as_component_ensure_extra (cpt)->recommends, g_object_unref),
+				g_object_ref (relation));
+	} else if (kind == AS_RELATION_KIND_REQUIRES) {
+		g_ptr_array_add (as_component_ensure_array (&as_component_ensure_extra (cpt)->requires, g_object_unref),
+				g_object_ref (relation));
+	} else {
+		g_warning ("Tried to add relation of unknown kind to component %s", priv->data_id);
+	}
+}
+
+/**
+ * as_component_reintern_l10n_keys:
+ *
+ * Helper for as_component_reintern_strings()
+ */
+static void
+as_component_reintern_l10n_keys (AsComponent *cpt, GHashTable *lht)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	guint i;
+	g_autoptr(GPtrArray) entries = NULL;
+
+	if (lht == NULL || g_hash_table_size (lht) == 0)
+		return;
+
+	entries = g_ptr_array_new ();
+	g_hash_table_iter_init (&iter, lht);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_ptr_array_add (entries, key);
+		g_ptr_array_add (entries, value);
+	}
+
+	/* keys are not owned by the table, and values are just moved */
+	g_hash_table_steal_all (lht);
+	for (i = 0; i < entries->len; i += 2) {
+		g_hash_table_insert (lht,
+				     (gpointer) as_component_intern (cpt, g_ptr_array_index (entries, i)),
+				     g_ptr_array_index (entries, i + 1));
+	}
 }
 
 /**
- * as_component_add_relation:
- * @cpt: a #AsComponent instance.
- * @relation: a #AsRelation instance.
- *
- * Adds a #AsRelation to set a recommends or requires relation of
- * component @cpt on the item mentioned in the #AsRelation.
+ * as_component_reintern_strings:
  *
- * Since: 0.12.0
- **/
-void
-as_component_add_relation (AsComponent *cpt, AsRelation *relation)
+ * Intern all shared strings again using the current context
+ * of this component.
+ */
+static void
+as_component_reintern_strings (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	AsRelationKind kind = as_relation_get_kind (relation);
+	guint i;
 
-	if (kind == AS_RELATION_KIND_RECOMMENDS) {
-		g_ptr_array_add (priv->recommends,
-				g_object_ref (relation));
-	} else if (kind == AS_RELATION_KIND_REQUIRES) {
-		g_ptr_array_add (priv->requires,
-				g_object_ref (relation));
-	} else {
-		g_warning ("Tried to add relation of unknown kind to component %s", priv->data_id);
-	}
+	/* the keys of shared tables must not change under the other components */
+	as_component_unshare_heavy (cpt);
+
+	as_component_reintern_l10n_keys (cpt, priv->name);
+	as_component_reintern_l10n_keys (cpt, priv->summary);
+	as_component_reintern_l10n_keys (cpt, priv->description);
+	as_component_reintern_l10n_keys (cpt, priv->developer_name);
+	as_component_reintern_l10n_keys (cpt, priv->keywords);
+
+	for (i = 0; i < AS_CPT_ARRAY (priv->categories)->len; i++)
+		priv->categories->pdata[i] = (gpointer) as_component_intern (cpt, g_ptr_array_index (priv->categories, i));
 }
 
 /**
@@ -2997,51 +4037,54 @@ void
 as_component_set_context (AsComponent *cpt, AsContext *context)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
-	if (priv->context != NULL)
-		g_object_unref (priv->context);
+	AsContext *old_context = priv->context;
+
+	as_component_invalidate_content_hash (cpt);
 	priv->context = g_object_ref (context);
+	if (old_context != NULL) {
+		/* move interned strings over, the old context may go away */
+		if (old_context != context)
+			as_component_reintern_strings (cpt);
+		g_object_unref (old_context);
+	}
 
 	/* reset individual properties, so the new context overrides them */
 	g_free (priv->active_locale_override);
 	priv->active_locale_override = NULL;
+	priv->locale_chain = NULL;
 
-	g_free (priv->origin);
+	as_intern_unref (priv->origin);
 	priv->origin = NULL;
 
-	g_free (priv->arch);
+	as_intern_unref (priv->arch);
 	priv->arch = NULL;
 }
 
-/**
- * as_copy_l10n_hashtable_hfunc:
- */
-static void
-as_copy_l10n_hashtable_hfunc (gpointer key, gpointer value, gpointer user_data)
-{
-	GHashTable *dest = (GHashTable*) user_data;
-
-	g_hash_table_insert (dest, g_strdup (key), g_strdup (value));
-}
-
 /**
  * as_copy_l10n_hashtable:
  *
  * Helper for as_component_merge_with_mode()
  */
 static void
-as_copy_l10n_hashtable (GHashTable *src, GHashTable *dest)
+as_copy_l10n_hashtable (AsComponent *dest_cpt, GHashTable *src, GHashTable **dest)
 {
+	GHashTableIter iter;
+	gpointer key, value;
+
 	/* don't copy if there is nothing to copy */
-	if (g_hash_table_size (src) <= 0)
+	if (src == NULL || g_hash_table_size (src) <= 0)
 		return;
 
 	/* clear our destination table */
-	g_hash_table_remove_all (dest);
+	g_hash_table_remove_all (as_component_ensure_l10n_table (dest));
 
-	/* copy */
-	g_hash_table_foreach (src,
-			      &as_copy_l10n_hashtable_hfunc,
-			      dest);
+	/* copy, the keys need to be interned for the destination */
+	g_hash_table_iter_init (&iter, src);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_hash_table_insert (*dest,
+				     (gpointer) as_component_intern (dest_cpt, key),
+				     g_strdup (value));
+	}
 }
 
 /**
@@ -3052,21 +4095,22 @@ as_copy_l10n_hashtable (GHashTable *src, GHashTable *dest)
  * NOTE: Only the object references are copied.
  */
 static void
-as_copy_gobject_array (GPtrArray *src, GPtrArray *dest)
+as_copy_gobject_array (GPtrArray *src, GPtrArray **dest)
 {
 	guint i;
 
 	/* don't copy if there is nothing to copy */
-	if (src->len <= 0)
+	if (src == NULL || src->len <= 0)
 		return;
 
 	/* clear our destination table */
-	g_ptr_array_remove_range (dest, 0, dest->len);
+	as_component_ensure_array (dest, g_object_unref);
+	g_ptr_array_remove_range (*dest, 0, (*dest)->len);
 
 	/* copy */
 	for (i = 0; i < src->len; i++) {
 		GObject *obj = G_OBJECT (g_ptr_array_index (src, i));
-		g_ptr_array_add (dest,
+		g_ptr_array_add (*dest,
 				 g_object_ref (obj));
 	}
 }
@@ -3089,6 +4133,7 @@ as_component_merge_with_mode (AsComponent *cpt, AsComponent *source, AsMergeKind
 	AsComponentPrivate *dest_priv = GET_PRIVATE (dest_cpt);
 	AsComponentPrivate *src_priv = GET_PRIVATE (src_cpt);
 
+	as_component_invalidate_content_hash (cpt);
 	/* FIXME/TODO: We need to merge more attributes */
 
 	/* merge stuff in append mode */
@@ -3101,36 +4146,40 @@ as_component_merge_with_mode (AsComponent *cpt, AsComponent *source, AsMergeKind
 		if (cats->len > 0) {
 			g_autoptr(GHashTable) cat_table = NULL;
 			GPtrArray *dest_categories;
+			GHashTableIter cat_iter;
+			gpointer cat_key;
 
-			cat_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+			/* the category strings are interned, so we can just borrow them */
+			cat_table = g_hash_table_new (g_str_hash, g_str_equal);
 			for (i = 0; i < cats->len; i++) {
 				const gchar *cat = (const gchar*) g_ptr_array_index (cats, i);
-				g_hash_table_add (cat_table, g_strdup (cat));
+				g_hash_table_add (cat_table, (gpointer) cat);
 			}
 
-			dest_categories = as_component_get_categories (dest_cpt);
+			dest_categories = as_component_ensure_array (&dest_priv->categories, NULL);
 			if (dest_categories->len > 0) {
 				for (i = 0; i < dest_categories->len; i++) {
 					const gchar *cat = (const gchar*) g_ptr_array_index (dest_categories, i);
-					g_hash_table_add (cat_table, g_strdup (cat));
+					g_hash_table_add (cat_table, (gpointer) cat);
 				}
 			}
 
 			g_ptr_array_set_size (dest_categories, 0);
-			as_hash_table_string_keys_to_array (cat_table, dest_categories);
+			g_hash_table_iter_init (&cat_iter, cat_table);
+			while (g_hash_table_iter_next (&cat_iter, &cat_key, NULL))
+				g_ptr_array_add (dest_categories,
+						 (gpointer) as_component_intern (dest_cpt, cat_key));
 		}
 
 		/* merge suggestions */
 		suggestions = as_component_get_suggested (src_cpt);
-		if (suggestions != NULL) {
-			for (i = 0; i < suggestions->len; i++) {
-				as_component_add_suggested (dest_cpt,
+		for (i = 0; i < suggestions->len; i++) {
+			as_component_add_suggested (dest_cpt,
 						    AS_SUGGESTED (g_ptr_array_index (suggestions, i)));
-			}
 		}
 
 		/* merge icons */
-		for (i = 0; i < src_priv->icons->len; i++) {
+		for (i = 0; i < AS_CPT_ARRAY (src_priv->icons)->len; i++) {
 			AsIcon *icon = AS_ICON (g_ptr_array_index (src_priv->icons, i));
 
 			/* this function will not replace existing icons */
@@ -3140,14 +4189,19 @@ as_component_merge_with_mode (AsComponent *cpt, AsComponent *source, AsMergeKind
 
 	/* merge stuff in replace mode */
 	if (merge_kind == AS_MERGE_KIND_REPLACE) {
+		g_autoptr(GHashTable) src_desc = NULL;
+
 		/* names */
-		as_copy_l10n_hashtable (src_priv->name, dest_priv->name);
+		as_copy_l10n_hashtable (dest_cpt, src_priv->name, &dest_priv->name);
 
 		/* summary */
-		as_copy_l10n_hashtable (src_priv->summary, dest_priv->summary);
+		as_copy_l10n_hashtable (dest_cpt, src_priv->summary, &dest_priv->summary);
 
 		/* description */
-		as_copy_l10n_hashtable (src_priv->description, dest_priv->description);
+		as_component_use_heavy (src_cpt);
+		as_component_detach_heavy (dest_cpt);
+		src_desc = as_packed_text_unpack_table (src_priv->description);
+		as_copy_l10n_hashtable (dest_cpt, src_desc, &dest_priv->description);
 
 		/* merge package names */
 		if ((src_priv->pkgnames != NULL) && (src_priv->pkgnames[0] != NULL))
@@ -3158,10 +4212,10 @@ as_component_merge_with_mode (AsComponent *cpt, AsComponent *source, AsMergeKind
 			as_component_set_bundles_array (dest_cpt, as_component_get_bundles (src_cpt));
 
 		/* merge icons */
-		as_copy_gobject_array (src_priv->icons, src_priv->icons);
+		as_copy_gobject_array (src_priv->icons, &dest_priv->icons);
 
 		/* merge provided items */
-		as_copy_gobject_array (src_priv->provided, src_priv->provided);
+		as_copy_gobject_array (src_priv->provided, &dest_priv->provided);
 	}
 
 	/* the resulting component gets the origin of the highet value of both */
@@ -3200,6 +4254,7 @@ as_component_set_kind_from_node (AsComponent *cpt, xmlNode *node)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	g_autofree gchar *cpttype = NULL;
 
+	as_component_invalidate_content_hash (cpt);
 	/* find out which kind of component we are dealing with */
 	cpttype = (gchar*) xmlGetProp (node, (xmlChar*) "type");
 	if ((cpttype == NULL) || (g_strcmp0 (cpttype, "generic") == 0)) {
@@ -3344,7 +4399,8 @@ as_component_xml_parse_custom_node (AsComponent *cpt, xmlNode *node)
 	xmlNode *iter;
 	GHashTable *custom;
 
-	custom = as_component_get_custom (cpt);
+	custom = as_component_ensure_table (&as_component_ensure_extra (cpt)->custom,
+					    g_str_hash, g_str_equal, g_free, g_free);
 	for (iter = node->children; iter != NULL; iter = iter->next) {
 		gchar *key_str = NULL;
 
@@ -3386,6 +4442,51 @@ as_component_load_relations_from_xml (AsComponent *cpt, AsContext *ctx, xmlNode
 	}
 }
 
+/* component data which is only loaded for some load profiles,
+ * mapped from XML tag and YAML key to the part it belongs to */
+static const struct {
+	const gchar	*xml_tag;
+	const gchar	*yaml_key;
+	AsLoadProfile	profile;
+} as_component_profile_fields[] = {
+	{ "description",	"Description",		AS_LOAD_PROFILE_WITH_SEARCH },
+	{ "keywords",		"Keywords",		AS_LOAD_PROFILE_WITH_SEARCH },
+	{ "screenshots",	"Screenshots",		AS_LOAD_PROFILE_WITH_MEDIA },
+	{ "releases",		"Releases",		AS_LOAD_PROFILE_WITH_DETAILS },
+	{ "content_rating",	"ContentRating",	AS_LOAD_PROFILE_WITH_DETAILS },
+	{ "recommends",		"Recommends",		AS_LOAD_PROFILE_WITH_DETAILS },
+	{ "requires",		"Requires",		AS_LOAD_PROFILE_WITH_DETAILS },
+	{ "suggests",		"Suggests",		AS_LOAD_PROFILE_WITH_DETAILS },
+	{ "translation",	NULL,			AS_LOAD_PROFILE_WITH_DETAILS },
+	{ "languages",		"Languages",		AS_LOAD_PROFILE_WITH_DETAILS },
+	{ "custom",		"Custom",		AS_LOAD_PROFILE_WITH_DETAILS },
+	{ NULL,			NULL,			AS_LOAD_PROFILE_MINIMAL }
+};
+
+/**
+ * as_component_field_wanted:
+ *
+ * Check whether data of the XML tag or YAML key @name should be loaded
+ * with the given load profile.
+ */
+static gboolean
+as_component_field_wanted (AsLoadProfile profile, const gchar *name, gboolean yaml)
+{
+	guint i;
+
+	if (profile == AS_LOAD_PROFILE_FULL)
+		return TRUE;
+
+	for (i = 0; as_component_profile_fields[i].profile != AS_LOAD_PROFILE_MINIMAL; i++) {
+		const gchar *field = yaml? as_component_profile_fields[i].yaml_key : as_component_profile_fields[i].xml_tag;
+
+		if (g_strcmp0 (field, name) == 0)
+			return as_flags_contains (profile, as_component_profile_fields[i].profile);
+	}
+
+	return TRUE;
+}
+
 /**
  * as_component_load_from_xml:
  * @cpt: An #AsComponent.
@@ -3435,16 +4536,22 @@ as_component_load_from_xml (AsComponent *cpt, AsContext *ctx, xmlNode *node, GEr
 
 	/* set context for this component */
 	as_component_set_context (cpt, ctx);
+	priv->load_profile = as_context_get_load_profile (ctx);
 
 	for (iter = node->children; iter != NULL; iter = iter->next) {
 		g_autofree gchar *content = NULL;
-		g_autofree gchar *lang = NULL;
+		const gchar *lang;
 
 		/* discard spaces */
 		if (iter->type != XML_ELEMENT_NODE)
 			continue;
 
 		node_name = (const gchar*) iter->name;
+
+		/* skip data we were not asked to load */
+		if (!as_component_field_wanted (priv->load_profile, node_name, FALSE))
+			continue;
+
 		content = as_xml_get_node_value (iter);
 		lang = as_xmldata_get_node_locale (ctx, iter);
 
@@ -3497,9 +4604,20 @@ as_component_load_from_xml (AsComponent *cpt, AsContext *ctx, xmlNode *node, GEr
 					as_component_add_url (cpt, url_kind, content);
 			}
 		} else if (g_strcmp0 (node_name, "categories") == 0) {
-			as_xml_add_children_values_to_array (iter,
-							     "category",
-							     priv->categories);
+			xmlNode *iter2;
+			for (iter2 = iter->children; iter2 != NULL; iter2 = iter2->next) {
+				g_autofree gchar *cat = NULL;
+
+				if (iter2->type != XML_ELEMENT_NODE)
+					continue;
+				if (g_strcmp0 ((const gchar*) iter2->name, "category") != 0)
+					continue;
+
+				cat = as_xml_get_node_value (iter2);
+				if (cat != NULL)
+					g_ptr_array_add (as_component_ensure_array (&priv->categories, NULL),
+							 (gpointer) as_component_intern (cpt, cat));
+			}
 		} else if (g_strcmp0 (node_name, "keywords") == 0) {
 			if (lang != NULL) {
 				g_auto(GStrv) kw_array = NULL;
@@ -3609,7 +4727,7 @@ as_component_xml_keywords_to_node (AsComponent *cpt, xmlNode *root)
 	GHashTableIter iter;
 	gpointer key, value;
 
-	g_hash_table_iter_init (&iter, priv->keywords);
+	g_hash_table_iter_init (&iter, AS_CPT_TABLE (priv->keywords));
 	while (g_hash_table_iter_next (&iter, &key, &value)) {
 		xmlNode *node;
 		const gchar *locale = (const gchar*) key;
@@ -3642,7 +4760,7 @@ as_component_xml_serialize_provides (AsComponent *cpt, xmlNode *cnode)
 	guint i;
 	AsProvided *prov_mime;
 
-	if (priv->provided->len == 0)
+	if (priv->provided == NULL || priv->provided->len == 0)
 		return;
 
 	prov_mime = as_component_get_provided_for_kind (cpt, AS_PROVIDED_KIND_MIMETYPE);
@@ -3766,7 +4884,7 @@ as_component_xml_serialize_languages (AsComponent *cpt, xmlNode *cptnode)
 	GHashTableIter iter;
 	gpointer key, value;
 
-	if (g_hash_table_size (priv->languages) == 0)
+	if (priv->languages == NULL || g_hash_table_size (priv->languages) == 0)
 		return;
 
 	node = xmlNewChild (cptnode, NULL, (xmlChar*) "languages", NULL);
@@ -3797,16 +4915,16 @@ as_component_xml_serialize_languages (AsComponent *cpt, xmlNode *cptnode)
 static void
 as_component_xml_serialize_custom (AsComponent *cpt, xmlNode *cptnode)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	GHashTable *custom = as_component_get_custom (cpt);
 	xmlNode *node;
 	GHashTableIter iter;
 	gpointer key, value;
 
-	if (g_hash_table_size (priv->custom) == 0)
+	if (g_hash_table_size (custom) == 0)
 		return;
 
 	node = xmlNewChild (cptnode, NULL, (xmlChar*) "custom", NULL);
-	g_hash_table_iter_init (&iter, priv->custom);
+	g_hash_table_iter_init (&iter, custom);
 	while (g_hash_table_iter_next (&iter, &key, &value)) {
 		xmlNode *snode;
 
@@ -3833,8 +4951,17 @@ as_component_to_xml_node (AsComponent *cpt, AsContext *ctx, xmlNode *root)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	xmlNode *cnode;
+	GPtrArray *translations;
+	GPtrArray *suggestions;
+	GPtrArray *recommends;
+	GPtrArray *requires;
+	g_autoptr(GHashTable) desc = NULL;
 	guint i;
 
+	/* we need the full objects to serialize them */
+	as_component_unpack_records (cpt);
+	as_component_use_heavy (cpt);
+
 	/* define component root node properties */
 	if (root == NULL)
 		cnode = xmlNewNode (NULL, (xmlChar*) "component");
@@ -3867,8 +4994,8 @@ as_component_to_xml_node (AsComponent *cpt, AsContext *ctx, xmlNode *root)
 	/* component tags */
 	as_xml_add_text_node (cnode, "id", as_component_get_id (cpt));
 
-	as_xml_add_localized_text_node (cnode, "name", priv->name);
-	as_xml_add_localized_text_node (cnode, "summary", priv->summary);
+	as_xml_add_localized_text_node (cnode, "name", AS_CPT_TABLE (priv->name));
+	as_xml_add_localized_text_node (cnode, "summary", AS_CPT_TABLE (priv->summary));
 
 	/* order license and project group after name/summary */
 	if (as_context_get_style (ctx) == AS_FORMAT_STYLE_METAINFO)
@@ -3878,16 +5005,17 @@ as_component_to_xml_node (AsComponent *cpt, AsContext *ctx, xmlNode *root)
 	as_xml_add_text_node (cnode, "project_group", priv->project_group);
 
 	/* developer name */
-	as_xml_add_localized_text_node (cnode, "developer_name", priv->developer_name);
+	as_xml_add_localized_text_node (cnode, "developer_name", AS_CPT_TABLE (priv->developer_name));
 
 	/* long description */
-	as_xml_add_description_node (ctx, cnode, priv->description);
+	desc = as_packed_text_unpack_table (priv->description);
+	as_xml_add_description_node (ctx, cnode, AS_CPT_TABLE (desc));
 
 	as_xml_add_node_list_strv (cnode, NULL, "pkgname", priv->pkgnames);
 
-	as_xml_add_node_list (cnode, NULL, "extends", priv->extends);
-	as_xml_add_node_list (cnode, NULL, "compulsory_for_desktop", priv->compulsory_for_desktops);
-	as_xml_add_node_list (cnode, "categories", "category", priv->categories);
+	as_xml_add_node_list (cnode, NULL, "extends", AS_CPT_ARRAY (priv->extends));
+	as_xml_add_node_list (cnode, NULL, "compulsory_for_desktop", as_component_get_compulsory_for_desktops (cpt));
+	as_xml_add_node_list (cnode, "categories", "category", AS_CPT_ARRAY (priv->categories));
 
 	/* keywords */
 	as_component_xml_keywords_to_node (cpt, cnode);
@@ -3906,33 +5034,32 @@ as_component_to_xml_node (AsComponent *cpt, AsContext *ctx, xmlNode *root)
 	}
 
 	/* icons */
-	for (i = 0; i < priv->icons->len; i++) {
+	for (i = 0; i < AS_CPT_ARRAY (priv->icons)->len; i++) {
 		AsIcon *icon = AS_ICON (g_ptr_array_index (priv->icons, i));
 		as_icon_to_xml_node (icon, ctx, cnode);
 	}
 
 	/* bundles */
-	for (i = 0; i < priv->bundles->len; i++) {
+	for (i = 0; i < AS_CPT_ARRAY (priv->bundles)->len; i++) {
 		AsBundle *bundle = AS_BUNDLE (g_ptr_array_index (priv->bundles, i));
 		as_bundle_to_xml_node (bundle, ctx, cnode);
 	}
 
 	/* launchables */
-	for (i = 0; i < priv->launchables->len; i++) {
+	for (i = 0; i < AS_CPT_ARRAY (priv->launchables)->len; i++) {
 		AsLaunchable *launchable = AS_LAUNCHABLE (g_ptr_array_index (priv->launchables, i));
 		as_launchable_to_xml_node (launchable, ctx, cnode);
 	}
 
 	/* translations */
-	if (priv->translations != NULL) {
-		for (i = 0; i < priv->translations->len; i++) {
-			AsTranslation *tr = AS_TRANSLATION (g_ptr_array_index (priv->translations, i));
-			as_translation_to_xml_node (tr, ctx, cnode);
-		}
+	translations = as_component_get_translations (cpt);
+	for (i = 0; i < translations->len; i++) {
+		AsTranslation *tr = AS_TRANSLATION (g_ptr_array_index (translations, i));
+		as_translation_to_xml_node (tr, ctx, cnode);
 	}
 
 	/* screenshots */
-	if (priv->screenshots->len > 0) {
+	if (AS_CPT_ARRAY (priv->screenshots)->len > 0) {
 		xmlNode *rnode = xmlNewChild (cnode, NULL, (xmlChar*) "screenshots", NULL);
 
 		for (i = 0; i < priv->screenshots->len; i++) {
@@ -3942,7 +5069,7 @@ as_component_to_xml_node (AsComponent *cpt, AsContext *ctx, xmlNode *root)
 	}
 
 	/* releases */
-	if (priv->releases->len > 0) {
+	if (AS_CPT_ARRAY (priv->releases)->len > 0) {
 		xmlNode *rnode = xmlNewChild (cnode, NULL, (xmlChar*) "releases", NULL);
 
 		for (i = 0; i < priv->releases->len; i++) {
@@ -3958,33 +5085,36 @@ as_component_to_xml_node (AsComponent *cpt, AsContext *ctx, xmlNode *root)
 	as_component_xml_serialize_languages (cpt, cnode);
 
 	/* suggests nodes */
-	for (i = 0; i < priv->suggestions->len; i++) {
-		AsSuggested *suggested = AS_SUGGESTED (g_ptr_array_index (priv->suggestions, i));
+	suggestions = as_component_get_suggested (cpt);
+	for (i = 0; i < suggestions->len; i++) {
+		AsSuggested *suggested = AS_SUGGESTED (g_ptr_array_index (suggestions, i));
 		as_suggested_to_xml_node (suggested, ctx, cnode);
 	}
 
 	/* content_rating nodes */
-	for (i = 0; i < priv->content_ratings->len; i++) {
+	for (i = 0; i < AS_CPT_ARRAY (priv->content_ratings)->len; i++) {
 		AsContentRating *ctrating = AS_CONTENT_RATING (g_ptr_array_index (priv->content_ratings, i));
 		as_content_rating_to_xml_node (ctrating, ctx, cnode);
 	}
 
 	/* recommends */
-	if (priv->recommends->len > 0) {
+	recommends = as_component_get_recommends (cpt);
+	if (recommends->len > 0) {
 		xmlNode *rcnode = xmlNewChild (cnode, NULL, (xmlChar*) "recommends", NULL);
 
-		for (i = 0; i < priv->recommends->len; i++) {
-			AsRelation *relation = AS_RELATION (g_ptr_array_index (priv->recommends, i));
+		for (i = 0; i < recommends->len; i++) {
+			AsRelation *relation = AS_RELATION (g_ptr_array_index (recommends, i));
 			as_relation_to_xml_node (relation, ctx, rcnode);
 		}
 	}
 
 	/* requires */
-	if (priv->requires->len > 0) {
+	requires = as_component_get_requires (cpt);
+	if (requires->len > 0) {
 		xmlNode *rqnode = xmlNewChild (cnode, NULL, (xmlChar*) "requires", NULL);
 
-		for (i = 0; i < priv->requires->len; i++) {
-			AsRelation *relation = AS_RELATION (g_ptr_array_index (priv->requires, i));
+		for (i = 0; i < requires->len; i++) {
+			AsRelation *relation = AS_RELATION (g_ptr_array_index (requires, i));
 			as_relation_to_xml_node (relation, ctx, rqnode);
 		}
 	}
@@ -4323,6 +5453,7 @@ as_component_load_from_yaml (AsComponent *cpt, AsContext *ctx, GNode *root, GErr
 
 	/* set component default priority */
 	priv->priority = as_context_get_priority (ctx);
+	priv->load_profile = as_context_get_load_profile (ctx);
 
 	for (node = root->children; node != NULL; node = node->next) {
 		const gchar *key;
@@ -4333,6 +5464,8 @@ as_component_load_from_yaml (AsComponent *cpt, AsContext *ctx, GNode *root, GErr
 			continue;
 
 		key = as_yaml_node_get_key (node);
+		if (!as_component_field_wanted (priv->load_profile, key, TRUE))
+			continue;
 		value = as_yaml_node_get_value (node);
 
 		if (g_strcmp0 (key, "Type") == 0) {
@@ -4381,11 +5514,17 @@ as_component_load_from_yaml (AsComponent *cpt, AsContext *ctx, GNode *root, GErr
 		} else if (g_strcmp0 (key, "ProjectGroup") == 0) {
 			as_component_set_project_group (cpt, value);
 		} else if (g_strcmp0 (key, "Categories") == 0) {
-			as_yaml_list_to_str_array (node, priv->categories);
+			GNode *n;
+			for (n = node->children; n != NULL; n = n->next) {
+				const gchar *cat = as_yaml_node_get_key (n);
+				if (cat != NULL)
+					g_ptr_array_add (as_component_ensure_array (&priv->categories, NULL),
+							 (gpointer) as_component_intern (cpt, cat));
+			}
 		} else if (g_strcmp0 (key, "CompulsoryForDesktops") == 0) {
-			as_yaml_list_to_str_array (node, priv->compulsory_for_desktops);
+			as_yaml_list_to_str_array (node, as_component_ensure_array (&as_component_ensure_extra (cpt)->compulsory_for_desktops, g_free));
 		} else if (g_strcmp0 (key, "Extends") == 0) {
-			as_yaml_list_to_str_array (node, priv->extends);
+			as_yaml_list_to_str_array (node, as_component_ensure_array (&priv->extends, g_free));
 		} else if (g_strcmp0 (key, "Keywords") == 0) {
 			as_component_yaml_parse_keywords (cpt, ctx, node);
 		} else if (g_strcmp0 (key, "Url") == 0) {
@@ -4556,7 +5695,7 @@ as_component_yaml_emit_provides (AsComponent *cpt, yaml_emitter_t *emitter)
 	g_autoptr(GPtrArray) fw_runtime = NULL;
 	g_autoptr(GPtrArray) fw_flashed = NULL;
 
-	if (priv->provided->len == 0)
+	if (priv->provided == NULL || priv->provided->len == 0)
 		return;
 
 	as_yaml_emit_scalar (emitter, "Provides");
@@ -4728,7 +5867,7 @@ as_component_yaml_emit_languages (AsComponent *cpt, yaml_emitter_t *emitter)
 	GHashTableIter iter;
 	gpointer key, value;
 
-	if (g_hash_table_size (priv->languages) == 0)
+	if (priv->languages == NULL || g_hash_table_size (priv->languages) == 0)
 		return;
 
 	as_yaml_emit_scalar (emitter, "Languages");
@@ -4757,17 +5896,17 @@ as_component_yaml_emit_languages (AsComponent *cpt, yaml_emitter_t *emitter)
 static void
 as_component_yaml_emit_custom (AsComponent *cpt, yaml_emitter_t *emitter)
 {
-	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	GHashTable *custom = as_component_get_custom (cpt);
 	GHashTableIter iter;
 	gpointer key, value;
 
-	if (g_hash_table_size (priv->custom) == 0)
+	if (g_hash_table_size (custom) == 0)
 		return;
 
 	as_yaml_emit_scalar (emitter, "Custom");
 	as_yaml_mapping_start (emitter);
 
-	g_hash_table_iter_init (&iter, priv->custom);
+	g_hash_table_iter_init (&iter, custom);
 	while (g_hash_table_iter_next (&iter, &key, &value)) {
 		as_yaml_emit_entry (emitter,
 				    (const gchar*) key,
@@ -4793,6 +5932,14 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	gint res;
 	const gchar *cstr;
 	yaml_event_t event;
+	GPtrArray *suggestions;
+	GPtrArray *recommends;
+	GPtrArray *requires;
+	g_autoptr(GHashTable) desc = NULL;
+
+	/* we need the full objects to serialize them */
+	as_component_unpack_records (cpt);
+	as_component_use_heavy (cpt);
 
 	/* new document for this component */
 	yaml_document_start_event_initialize (&event, NULL, NULL, NULL, FALSE);
@@ -4836,19 +5983,20 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 		as_yaml_emit_entry (emitter, "Package", priv->pkgnames[0]);
 
 	/* Extends */
-	as_yaml_emit_sequence (emitter, "Extends", priv->extends);
+	as_yaml_emit_sequence (emitter, "Extends", AS_CPT_ARRAY (priv->extends));
 
 	/* Name */
-	as_yaml_emit_localized_entry (emitter, "Name", priv->name);
+	as_yaml_emit_localized_entry (emitter, "Name", AS_CPT_TABLE (priv->name));
 
 	/* Summary */
-	as_yaml_emit_localized_entry (emitter, "Summary", priv->summary);
+	as_yaml_emit_localized_entry (emitter, "Summary", AS_CPT_TABLE (priv->summary));
 
 	/* Description */
-	as_yaml_emit_long_localized_entry (emitter, "Description", priv->description);
+	desc = as_packed_text_unpack_table (priv->description);
+	as_yaml_emit_long_localized_entry (emitter, "Description", AS_CPT_TABLE (desc));
 
 	/* DeveloperName */
-	as_yaml_emit_localized_entry (emitter, "DeveloperName", priv->developer_name);
+	as_yaml_emit_localized_entry (emitter, "DeveloperName", AS_CPT_TABLE (priv->developer_name));
 
 	/* ProjectGroup */
 	as_yaml_emit_entry (emitter, "ProjectGroup", priv->project_group);
@@ -4857,16 +6005,16 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	as_yaml_emit_entry (emitter, "ProjectLicense", priv->project_license);
 
 	/* CompulsoryForDesktops */
-	as_yaml_emit_sequence_from_str_array (emitter, "CompulsoryForDesktops", priv->compulsory_for_desktops);
+	as_yaml_emit_sequence_from_str_array (emitter, "CompulsoryForDesktops", as_component_get_compulsory_for_desktops (cpt));
 
 	/* Categories */
-	as_yaml_emit_sequence_from_str_array (emitter, "Categories", priv->categories);
+	as_yaml_emit_sequence_from_str_array (emitter, "Categories", AS_CPT_ARRAY (priv->categories));
 
 	/* Keywords */
-	as_yaml_emit_localized_strv (emitter, "Keywords", priv->keywords);
+	as_yaml_emit_localized_strv (emitter, "Keywords", AS_CPT_TABLE (priv->keywords));
 
 	/* Urls */
-	if (g_hash_table_size (priv->urls) > 0) {
+	if (priv->urls != NULL && g_hash_table_size (priv->urls) > 0) {
 		GHashTableIter iter;
 		gpointer key, value;
 
@@ -4881,7 +6029,7 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	}
 
 	/* Icons */
-	if (priv->icons->len > 0) {
+	if (AS_CPT_ARRAY (priv->icons)->len > 0) {
 		as_yaml_emit_scalar (emitter, "Icon");
 		as_yaml_mapping_start (emitter);
 		as_component_yaml_emit_icons (cpt, emitter, priv->icons);
@@ -4889,7 +6037,7 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	}
 
 	/* Bundles */
-	if (priv->bundles->len > 0) {
+	if (AS_CPT_ARRAY (priv->bundles)->len > 0) {
 		as_yaml_emit_scalar (emitter, "Bundles");
 		as_yaml_sequence_start (emitter);
 
@@ -4902,7 +6050,7 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	}
 
 	/* Launchable */
-	if (priv->launchables->len > 0) {
+	if (AS_CPT_ARRAY (priv->launchables)->len > 0) {
 		as_yaml_emit_scalar (emitter, "Launchable");
 		as_yaml_mapping_start (emitter);
 
@@ -4918,7 +6066,7 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	as_component_yaml_emit_provides (cpt, emitter);
 
 	/* Screenshots */
-	if (priv->screenshots->len > 0) {
+	if (AS_CPT_ARRAY (priv->screenshots)->len > 0) {
 		as_yaml_emit_scalar (emitter, "Screenshots");
 		as_yaml_sequence_start (emitter);
 
@@ -4934,7 +6082,7 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	as_component_yaml_emit_languages (cpt, emitter);
 
 	/* Releases */
-	if (priv->releases->len > 0) {
+	if (AS_CPT_ARRAY (priv->releases)->len > 0) {
 		as_yaml_emit_scalar (emitter, "Releases");
 		as_yaml_sequence_start (emitter);
 
@@ -4947,12 +6095,13 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	}
 
 	/* Suggests */
-	if (priv->suggestions->len > 0) {
+	suggestions = as_component_get_suggested (cpt);
+	if (suggestions->len > 0) {
 		as_yaml_emit_scalar (emitter, "Suggests");
 		as_yaml_sequence_start (emitter);
 
-		for (i = 0; i < priv->suggestions->len; i++) {
-			AsSuggested *suggested = AS_SUGGESTED (g_ptr_array_index (priv->suggestions, i));
+		for (i = 0; i < suggestions->len; i++) {
+			AsSuggested *suggested = AS_SUGGESTED (g_ptr_array_index (suggestions, i));
 			as_suggested_emit_yaml (suggested, ctx, emitter);
 		}
 
@@ -4960,7 +6109,7 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	}
 
 	/* ContentRating */
-	if (priv->content_ratings->len > 0) {
+	if (AS_CPT_ARRAY (priv->content_ratings)->len > 0) {
 		as_yaml_emit_scalar (emitter, "ContentRating");
 		as_yaml_mapping_start (emitter);
 
@@ -4973,12 +6122,13 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	}
 
 	/* Recommends */
-	if (priv->recommends->len > 0) {
+	recommends = as_component_get_recommends (cpt);
+	if (recommends->len > 0) {
 		as_yaml_emit_scalar (emitter, "Recommends");
 		as_yaml_sequence_start (emitter);
 
-		for (i = 0; i < priv->recommends->len; i++) {
-			AsRelation *relation = AS_RELATION (g_ptr_array_index (priv->recommends, i));
+		for (i = 0; i < recommends->len; i++) {
+			AsRelation *relation = AS_RELATION (g_ptr_array_index (recommends, i));
 			as_relation_emit_yaml (relation, ctx, emitter);
 		}
 
@@ -4986,12 +6136,13 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	}
 
 	/* Requires */
-	if (priv->requires->len > 0) {
+	requires = as_component_get_requires (cpt);
+	if (requires->len > 0) {
 		as_yaml_emit_scalar (emitter, "Requires");
 		as_yaml_sequence_start (emitter);
 
-		for (i = 0; i < priv->requires->len; i++) {
-			AsRelation *relation = AS_RELATION (g_ptr_array_index (priv->requires, i));
+		for (i = 0; i < requires->len; i++) {
+			AsRelation *relation = AS_RELATION (g_ptr_array_index (requires, i));
 			as_relation_emit_yaml (relation, ctx, emitter);
 		}
 
@@ -5011,20 +6162,115 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 }
 
 /**
- * as_component_to_variant:
- * @cpt: an #AsComponent.
- * @builder: A #GVariantBuilder
+ * as_component_hash_variant:
+ * @cptv: a component serialization, as created by as_component_to_variant().
  *
- * Serialize the current active state of this object to a GVariant
- * for use in the on-disk binary cache.
+ * Compute the content hash of a component serialization.
+ * The origin differs between repositories shipping the same data, and the
+ * search tokens and the hash itself are derived data, so they are skipped.
+ *
+ * Returns: (transfer full): the content hash.
  */
-void
-as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
+gchar*
+as_component_hash_variant (GVariant *cptv)
+{
+	GVariantBuilder cb;
+	GVariantIter iter;
+	const gchar *key;
+	GVariant *value;
+	g_autoptr(GVariant) fields = NULL;
+	g_autoptr(GVariant) normalized = NULL;
+
+	g_variant_builder_init (&cb, G_VARIANT_TYPE_VARDICT);
+	g_variant_iter_init (&iter, cptv);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		if ((g_strcmp0 (key, "origin") != 0) &&
+		    (g_strcmp0 (key, "tokens") != 0) &&
+		    (g_strcmp0 (key, "content_hash") != 0))
+			g_variant_builder_add (&cb, "{sv}", key, value);
+		g_variant_unref (value);
+	}
+	fields = g_variant_ref_sink (g_variant_builder_end (&cb));
+
+	/* dictionaries are filled from hash tables, so their order is random */
+	normalized = as_variant_normalize (fields);
+
+	return g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+					    g_variant_get_data (normalized),
+					    g_variant_get_size (normalized));
+}
+
+/**
+ * as_component_ensure_content_hash:
+ *
+ * Set the content hash from the serialization @cptv, if we don't have one yet.
+ */
+static const gchar*
+as_component_ensure_content_hash (AsComponent *cpt, GVariant *cptv)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	gchar *hash;
+
+	if (g_atomic_pointer_get (&priv->content_hash) != NULL)
+		return priv->content_hash;
+
+	hash = as_component_hash_variant (cptv);
+	if (!g_atomic_pointer_compare_and_exchange (&priv->content_hash, NULL, hash))
+		g_free (hash);
+	return priv->content_hash;
+}
+
+/**
+ * as_component_refresh_content_hash:
+ *
+ * Compute the content hash from the serialization @cptv again, even if we
+ * have one already, so changes made in place to objects owned by this
+ * component (e.g. its releases) are not missed.
+ */
+static const gchar*
+as_component_refresh_content_hash (AsComponent *cpt, GVariant *cptv)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	g_autofree gchar *hash = NULL;
+	gchar *old_hash;
+
+	hash = as_component_hash_variant (cptv);
+	old_hash = g_atomic_pointer_get (&priv->content_hash);
+	if (g_strcmp0 (old_hash, hash) == 0)
+		return old_hash;
+
+	/* the data was changed, so nobody may rely on the old hash anymore */
+	g_atomic_pointer_set (&priv->content_hash, g_steal_pointer (&hash));
+	g_free (old_hash);
+	return priv->content_hash;
+}
+
+/**
+ * as_component_build_variant:
+ * @for_cache: %TRUE to include derived data for the cache.
+ *
+ * Serialize the current active state of this object.
+ *
+ * Returns: (transfer full): a vardict with the component data.
+ */
+static GVariant*
+as_component_build_variant (AsComponent *cpt, gboolean for_cache)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	GVariantBuilder cb;
+	GPtrArray *suggestions;
+	GPtrArray *recommends;
+	GPtrArray *requires;
+	GHashTable *custom;
+	g_autofree gchar *desc = NULL;
+	g_autoptr(GVariant) fields = NULL;
+	GVariantIter fields_iter;
+	GVariant *field;
 	guint i;
 
+	/* read evicted data back before serializing it */
+	as_component_use_heavy (cpt);
+
 	/* start serializing our component */
 	g_variant_builder_init (&cb, G_VARIANT_TYPE_VARDICT);
 
@@ -5057,36 +6303,45 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	as_variant_builder_add_kv (&cb, "origin",
 				as_variant_mstring_new (as_component_get_origin (cpt)));
 
-	/* bundles */
-	if (priv->bundles->len > 0) {
+	/* bundles and launchables, which are still plain records if we were loaded from a cache */
+	g_mutex_lock (&records_mutex);
+	if (priv->bundle_recs != NULL || AS_CPT_ARRAY (priv->bundles)->len > 0) {
 		GVariantBuilder array_b;
 		g_variant_builder_init (&array_b, G_VARIANT_TYPE_ARRAY);
 
-		for (i = 0; i < priv->bundles->len; i++) {
-			as_bundle_to_variant (AS_BUNDLE (g_ptr_array_index (priv->bundles, i)), &array_b);
+		if (priv->bundle_recs != NULL) {
+			for (i = 0; i < priv->bundle_recs->len; i++)
+				as_bundle_record_to_variant (&g_array_index (priv->bundle_recs, AsBundleRecord, i), &array_b);
+		} else {
+			for (i = 0; i < priv->bundles->len; i++)
+				as_bundle_to_variant (AS_BUNDLE (g_ptr_array_index (priv->bundles, i)), &array_b);
 		}
 
 		as_variant_builder_add_kv (&cb, "bundles", g_variant_builder_end (&array_b));
 	}
 
-	/* launchables */
-	if (priv->launchables->len > 0) {
+	if (priv->launchable_recs != NULL || AS_CPT_ARRAY (priv->launchables)->len > 0) {
 		GVariantBuilder array_b;
 		g_variant_builder_init (&array_b, G_VARIANT_TYPE_ARRAY);
 
-		for (i = 0; i < priv->launchables->len; i++) {
-			as_launchable_to_variant (AS_LAUNCHABLE (g_ptr_array_index (priv->launchables, i)), &array_b);
+		if (priv->launchable_recs != NULL) {
+			for (i = 0; i < priv->launchable_recs->len; i++)
+				as_launchable_record_to_variant (&g_array_index (priv->launchable_recs, AsLaunchableRecord, i), &array_b);
+		} else {
+			for (i = 0; i < priv->launchables->len; i++)
+				as_launchable_to_variant (AS_LAUNCHABLE (g_ptr_array_index (priv->launchables, i)), &array_b);
 		}
 
 		as_variant_builder_add_kv (&cb, "launchables", g_variant_builder_end (&array_b));
 	}
+	g_mutex_unlock (&records_mutex);
 
 	/* extends */
 	as_variant_builder_add_kv (&cb, "extends",
-					as_variant_from_string_ptrarray (priv->extends));
+					as_variant_from_string_ptrarray (AS_CPT_ARRAY (priv->extends)));
 
 	/* URLs */
-	if (g_hash_table_size (priv->urls) > 0) {
+	if (priv->urls != NULL && g_hash_table_size (priv->urls) > 0) {
 		GHashTableIter iter;
 		gpointer key, value;
 		GVariantBuilder dict_b;
@@ -5105,7 +6360,7 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	}
 
 	/* icons */
-	if (priv->icons->len > 0) {
+	if (AS_CPT_ARRAY (priv->icons)->len > 0) {
 		GVariantBuilder array_b;
 		g_variant_builder_init (&array_b, G_VARIANT_TYPE_ARRAY);
 		for (i = 0; i < priv->icons->len; i++) {
@@ -5118,17 +6373,18 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	}
 
 	/* long description */
+	desc = as_component_dup_description (cpt);
 	as_variant_builder_add_kv (&cb, "description",
-				as_variant_mstring_new (as_component_get_description (cpt)));
+				as_variant_mstring_new (desc));
 
 	/* categories */
 	as_variant_builder_add_kv (&cb, "categories",
-					as_variant_from_string_ptrarray (priv->categories));
+					as_variant_from_string_ptrarray (AS_CPT_ARRAY (priv->categories)));
 
 
 	/* compulsory-for-desktop */
 	as_variant_builder_add_kv (&cb, "compulsory_for",
-					as_variant_from_string_ptrarray (priv->compulsory_for_desktops));
+					as_variant_from_string_ptrarray (as_component_get_compulsory_for_desktops (cpt)));
 
 	/* project license */
 	as_variant_builder_add_kv (&cb, "project_license",
@@ -5143,7 +6399,7 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 				as_variant_mstring_new (as_component_get_developer_name (cpt)));
 
 	/* provided items */
-	if (priv->provided->len > 0) {
+	if (AS_CPT_ARRAY (priv->provided)->len > 0) {
 		GVariantBuilder array_b;
 		g_variant_builder_init (&array_b, G_VARIANT_TYPE_ARRAY);
 		for (i = 0; i < priv->provided->len; i++) {
@@ -5156,7 +6412,7 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	}
 
 	/* screenshots */
-	if (priv->screenshots->len > 0) {
+	if (AS_CPT_ARRAY (priv->screenshots)->len > 0) {
 		GVariantBuilder array_b;
 		gboolean screenshot_added = FALSE;
 		g_variant_builder_init (&array_b, G_VARIANT_TYPE_ARRAY);
@@ -5172,7 +6428,7 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	}
 
 	/* releases */
-	if (priv->releases->len > 0) {
+	if (AS_CPT_ARRAY (priv->releases)->len > 0) {
 		GVariantBuilder array_b;
 		g_variant_builder_init (&array_b, G_VARIANT_TYPE_ARRAY);
 		for (i = 0; i < priv->releases->len; i++) {
@@ -5185,7 +6441,7 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	}
 
 	/* languages */
-	if (g_hash_table_size (priv->languages) > 0) {
+	if (priv->languages != NULL && g_hash_table_size (priv->languages) > 0) {
 		GHashTableIter iter;
 		gpointer key, value;
 		GVariantBuilder dict_b;
@@ -5204,11 +6460,12 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	}
 
 	/* suggestions */
-	if (priv->suggestions->len > 0) {
+	suggestions = as_component_get_suggested (cpt);
+	if (suggestions->len > 0) {
 		GVariantBuilder array_b;
 		g_variant_builder_init (&array_b, G_VARIANT_TYPE_ARRAY);
-		for (i = 0; i < priv->suggestions->len; i++) {
-			AsSuggested *suggested = AS_SUGGESTED (g_ptr_array_index (priv->suggestions, i));
+		for (i = 0; i < suggestions->len; i++) {
+			AsSuggested *suggested = AS_SUGGESTED (g_ptr_array_index (suggestions, i));
 			as_suggested_to_variant (suggested, &array_b);
 		}
 
@@ -5217,7 +6474,7 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	}
 
 	/* content ratings */
-	if (priv->content_ratings->len > 0) {
+	if (AS_CPT_ARRAY (priv->content_ratings)->len > 0) {
 		GVariantBuilder array_b;
 		g_variant_builder_init (&array_b, G_VARIANT_TYPE_ARRAY);
 		for (i = 0; i < priv->content_ratings->len; i++) {
@@ -5231,16 +6488,18 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	}
 
 	/* requires / recommends */
-	if (priv->requires->len > 0 || priv->recommends->len > 0) {
+	requires = as_component_get_requires (cpt);
+	recommends = as_component_get_recommends (cpt);
+	if (requires->len > 0 || recommends->len > 0) {
 		GVariantBuilder array_b;
 		g_variant_builder_init (&array_b, G_VARIANT_TYPE_ARRAY);
 
-		for (i = 0; i < priv->requires->len; i++) {
-			AsRelation *relation = AS_RELATION (g_ptr_array_index (priv->requires, i));
+		for (i = 0; i < requires->len; i++) {
+			AsRelation *relation = AS_RELATION (g_ptr_array_index (requires, i));
 			as_relation_to_variant (relation, &array_b);
 		}
-		for (i = 0; i < priv->recommends->len; i++) {
-			AsRelation *relation = AS_RELATION (g_ptr_array_index (priv->recommends, i));
+		for (i = 0; i < recommends->len; i++) {
+			AsRelation *relation = AS_RELATION (g_ptr_array_index (recommends, i));
 			as_relation_to_variant (relation, &array_b);
 		}
 
@@ -5250,13 +6509,14 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	}
 
 	/* custom data */
-	if (g_hash_table_size (priv->custom) > 0) {
+	custom = as_component_get_custom (cpt);
+	if (g_hash_table_size (custom) > 0) {
 		GHashTableIter iter;
 		gpointer key, value;
 		GVariantBuilder dict_b;
 
 		g_variant_builder_init (&dict_b, G_VARIANT_TYPE_DICTIONARY);
-		g_hash_table_iter_init (&iter, priv->custom);
+		g_hash_table_iter_init (&iter, custom);
 		while (g_hash_table_iter_next (&iter, &key, &value)) {
 			if ((key == NULL) || (value == NULL))
 				continue;
@@ -5270,29 +6530,88 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 						g_variant_builder_end (&dict_b));
 	}
 
+	fields = g_variant_ref_sink (g_variant_builder_end (&cb));
+	if (!for_cache)
+		return g_steal_pointer (&fields);
+
+	g_variant_builder_init (&cb, G_VARIANT_TYPE_VARDICT);
+	g_variant_iter_init (&fields_iter, fields);
+	while ((field = g_variant_iter_next_value (&fields_iter))) {
+		g_variant_builder_add_value (&cb, field);
+		g_variant_unref (field);
+	}
+
+	/* content hash of the final data, so it doesn't need to be computed again when loading */
+	as_variant_builder_add_kv (&cb, "content_hash",
+				g_variant_new_string (as_component_refresh_content_hash (cpt, fields)));
+
 	/* search tokens */
 	as_component_create_token_cache (cpt);
-	if (g_hash_table_size (priv->token_cache) > 0) {
-		GHashTableIter iter;
-		gpointer key, value;
+	if (priv->n_tokens > 0) {
 		GVariantBuilder dict_b;
 
 		g_variant_builder_init (&dict_b, G_VARIANT_TYPE_DICTIONARY);
-		g_hash_table_iter_init (&iter, priv->token_cache);
-		while (g_hash_table_iter_next (&iter, &key, &value)) {
-			if (value == NULL)
-				continue;
-
+		for (i = 0; i < priv->n_tokens; i++)
 			g_variant_builder_add (&dict_b, "{su}",
-						(const gchar*) key, *((AsTokenType*) value));
-		}
+						priv->tokens[i], (guint32) priv->token_flags[i]);
 
 		as_variant_builder_add_kv (&cb, "tokens",
 						g_variant_builder_end (&dict_b));
 	}
 
+	return g_variant_ref_sink (g_variant_builder_end (&cb));
+}
+
+/**
+ * as_component_to_variant:
+ * @cpt: an #AsComponent.
+ * @builder: A #GVariantBuilder
+ *
+ * Serialize the current active state of this object to a GVariant
+ * for use in the on-disk binary cache.
+ */
+void
+as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
+{
+	g_autoptr(GVariant) cptv = as_component_build_variant (cpt, TRUE);
+
 	/* add to component list */
-	g_variant_builder_add_value (builder, g_variant_builder_end (&cb));
+	g_variant_builder_add_value (builder, cptv);
+}
+
+/**
+ * as_component_get_content_hash:
+ * @cpt: an #AsComponent.
+ *
+ * Get a checksum of the data of this component in its active locale,
+ * which is equal for components with identical data.
+ * The origin of the component is not part of the hash, so the same
+ * component shipped by several repositories has the same hash.
+ *
+ * The hash is computed when it is first requested, or read from the cache,
+ * and can be used as a cheap way to detect changes between two versions
+ * of the metadata. It is reset by every method of #AsComponent which
+ * modifies the component, including merges, and computed again from the
+ * final data when the component is written to the cache.
+ * Changes made directly to objects returned by this component, like a
+ * #AsRelease from as_component_get_releases(), are not noticed, call
+ * this function only after such changes are complete.
+ *
+ * Returns: the SHA-256 checksum as hexadecimal string.
+ *
+ * Since: 0.12.1
+ */
+const gchar*
+as_component_get_content_hash (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	g_autoptr(GVariant) cptv = NULL;
+
+	if (g_atomic_pointer_get (&priv->content_hash) != NULL)
+		return priv->content_hash;
+
+	cptv = as_component_build_variant (cpt, FALSE);
+	return as_component_ensure_content_hash (cpt, cptv);
 }
 
 /**
@@ -5352,40 +6671,69 @@ as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar
 	as_component_set_origin (cpt, as_variant_get_dict_mstr (&dict, "origin", &var));
 	g_variant_unref (var);
 
-	/* bundles */
+	/* bundles and launchables, kept as plain records until someone asks for the objects */
 	var = g_variant_dict_lookup_value (&dict, "bundles", G_VARIANT_TYPE_ARRAY);
 	if (var != NULL) {
-		GVariant *child;
+		gsize n_children = g_variant_n_children (var);
+
+		if (n_children > 0) {
+			GArray *recs = g_array_sized_new (FALSE, TRUE, sizeof (AsBundleRecord), n_children);
+			GVariant *child;
+
+			g_array_set_clear_func (recs, (GDestroyNotify) as_bundle_record_clear);
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				AsBundleRecord rec = { AS_BUNDLE_KIND_UNKNOWN, NULL };
+				if (as_bundle_record_set_from_variant (&rec, child))
+					g_array_append_val (recs, rec);
+				else
+					as_bundle_record_clear (&rec);
+				g_variant_unref (child);
+			}
 
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsBundle) bundle = as_bundle_new ();
-			if (as_bundle_set_from_variant (bundle, child))
-				as_component_add_bundle (cpt, bundle);
-			g_variant_unref (child);
+			as_component_unpack_records (cpt);
+			g_clear_pointer (&priv->bundles, g_ptr_array_unref);
+			priv->bundle_recs = recs;
+			as_component_invalidate_data_id (cpt);
 		}
 		g_variant_unref (var);
 	}
 
-	/* launchables */
 	var = g_variant_dict_lookup_value (&dict, "launchables", G_VARIANT_TYPE_ARRAY);
 	if (var != NULL) {
-		GVariant *child;
+		gsize n_children = g_variant_n_children (var);
+
+		if (n_children > 0) {
+			GArray *recs = g_array_sized_new (FALSE, TRUE, sizeof (AsLaunchableRecord), n_children);
+			GVariant *child;
+
+			g_array_set_clear_func (recs, (GDestroyNotify) as_launchable_record_clear);
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				AsLaunchableRecord rec = { AS_LAUNCHABLE_KIND_UNKNOWN, NULL };
+				if (as_launchable_record_set_from_variant (&rec, child))
+					g_array_append_val (recs, rec);
+				else
+					as_launchable_record_clear (&rec);
+				g_variant_unref (child);
+			}
 
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsLaunchable) launch = as_launchable_new ();
-			if (as_launchable_set_from_variant (launch, child))
-				as_component_add_launchable (cpt, launch);
-			g_variant_unref (child);
+			as_component_unpack_records (cpt);
+			g_clear_pointer (&priv->launchables, g_ptr_array_unref);
+			priv->launchable_recs = recs;
 		}
 		g_variant_unref (var);
 	}
 
 	/* extends */
-	as_variant_to_string_ptrarray_by_dict (&dict,
-						"extends",
-						priv->extends);
+	var = g_variant_dict_lookup_value (&dict,
+					   "extends",
+					   G_VARIANT_TYPE_STRING_ARRAY);
+	if (var != NULL) {
+		if (g_variant_n_children (var) > 0)
+			as_variant_to_string_ptrarray (var, as_component_ensure_array (&priv->extends, g_free));
+		g_variant_unref (var);
+	}
 
 	/* URLs */
 	var = g_variant_dict_lookup_value (&dict,
@@ -5425,21 +6773,29 @@ as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar
 		g_variant_unref (var);
 	}
 
-	/* long description */
-	as_component_set_description (cpt,
-					as_variant_get_dict_mstr (&dict, "description", &var),
-					locale);
-	g_variant_unref (var);
-
 	/* categories */
-	as_variant_to_string_ptrarray_by_dict (&dict,
-						"categories",
-						priv->categories);
+	var = g_variant_dict_lookup_value (&dict,
+					   "categories",
+					   G_VARIANT_TYPE_STRING_ARRAY);
+	if (var != NULL) {
+		const gchar *cat;
+
+		g_variant_iter_init (&gvi, var);
+		while (g_variant_iter_next (&gvi, "&s", &cat))
+			g_ptr_array_add (as_component_ensure_array (&priv->categories, NULL),
+					 (gpointer) as_component_intern (cpt, cat));
+		g_variant_unref (var);
+	}
 
 	/* compulsory-for-desktop */
-	as_variant_to_string_ptrarray_by_dict (&dict,
-						"compulsory_for",
-						priv->compulsory_for_desktops);
+	var = g_variant_dict_lookup_value (&dict,
+					   "compulsory_for",
+					   G_VARIANT_TYPE_STRING_ARRAY);
+	if (var != NULL) {
+		if (g_variant_n_children (var) > 0)
+			as_variant_to_string_ptrarray (var, as_component_ensure_array (&as_component_ensure_extra (cpt)->compulsory_for_desktops, g_free));
+		g_variant_unref (var);
+	}
 
 	/* project license */
 	as_component_set_project_license (cpt, as_variant_get_dict_mstr (&dict, "project_license", &var));
@@ -5474,41 +6830,8 @@ as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar
 		g_variant_unref (var);
 	}
 
-	/* screenshots */
-	var = g_variant_dict_lookup_value (&dict,
-						"screenshots",
-						G_VARIANT_TYPE_ARRAY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsScreenshot) scr = as_screenshot_new ();
-			if (as_screenshot_set_from_variant (scr, child, locale))
-				as_component_add_screenshot (cpt, scr);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
-	}
-
-	/* releases */
-	var = g_variant_dict_lookup_value (&dict,
-						"releases",
-						G_VARIANT_TYPE_ARRAY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsRelease) rel = as_release_new ();
-			if (as_release_set_from_variant (rel, child, locale))
-				as_component_add_release (cpt, rel);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
-	}
+	/* long description, screenshots and releases */
+	priv->heavy_size = as_component_load_heavy_data (cpt, &dict, locale);
 
 	/* languages */
 	var = g_variant_dict_lookup_value (&dict,
@@ -5609,33 +6932,34 @@ as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar
 					   "tokens",
 					   G_VARIANT_TYPE_DICTIONARY);
 	if (var != NULL) {
-		GVariant *child;
-		gboolean tokens_added = FALSE;
+		g_autoptr(GHashTable) tokens = NULL;
+		const gchar *token;
+		guint32 score;
 
+		tokens = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			guint score;
-			gchar *token;
-			AsTokenType *match_pval;
-
-			g_variant_get (child, "{su}", &token, &score);
-
-			match_pval = g_new0 (AsTokenType, 1);
-			*match_pval = score;
-
-			g_hash_table_insert (priv->token_cache,
-						token,
-						match_pval);
-			tokens_added = TRUE;
-
-			g_variant_unref (child);
-		}
+		while (g_variant_iter_next (&gvi, "{&su}", &token, &score))
+			g_hash_table_insert (tokens, g_strdup (token), GUINT_TO_POINTER (score));
 
 		/* we added things to the token cache, so we just assume it's valid */
-		if (tokens_added)
+		if (g_hash_table_size (tokens) > 0) {
+			as_component_set_tokens_from_table (cpt, tokens);
 			as_component_set_token_cache_valid (cpt, TRUE);
+		}
+
+		g_variant_unref (var);
+	}
 
+	/* content hash, older caches don't have it yet */
+	g_clear_pointer (&priv->content_hash, g_free);
+	var = g_variant_dict_lookup_value (&dict,
+					   "content_hash",
+					   G_VARIANT_TYPE_STRING);
+	if (var != NULL) {
+		priv->content_hash = g_variant_dup_string (var, NULL);
 		g_variant_unref (var);
+	} else {
+		as_component_ensure_content_hash (cpt, variant);
 	}
 
 	return TRUE;
@@ -5711,7 +7035,7 @@ as_component_get_property (GObject * object, guint property_id, GValue * value,
 			g_value_set_pointer (value, as_component_get_icons (cpt));
 			break;
 		case AS_COMPONENT_URLS:
-			g_value_set_boxed (value, priv->urls);
+			g_value_set_boxed (value, as_component_get_table (&priv->urls, g_direct_hash, g_direct_equal, NULL, g_free));
 			break;
 		case AS_COMPONENT_CATEGORIES:
 			g_value_set_boxed (value, as_component_get_categories (cpt));
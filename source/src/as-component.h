@@ -312,6 +312,10 @@ gboolean		as_component_is_ignored (AsComponent *cpt);
 gboolean		as_component_is_valid (AsComponent *cpt);
 gchar			*as_component_to_string (AsComponent *cpt);
 
+const gchar		*as_component_get_content_hash (AsComponent *cpt);
+
+AsLoadProfile		as_component_get_load_profile (AsComponent *cpt);
+
 GHashTable		*as_component_get_custom (AsComponent *cpt);
 gchar			*as_component_get_custom_value (AsComponent *cpt,
 							const gchar *key);
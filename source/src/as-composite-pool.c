@@ -0,0 +1,607 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:as-composite-pool
+ * @short_description: Query several metadata pools as one.
+ * @include: appstream.h
+ *
+ * An #AsCompositePool stacks several #AsPool instances, for example the system pool,
+ * a pool for per-user installations and pools for individual repositories.
+ * Every layer has a priority, and is loaded and reloaded on its own using the #AsPool API.
+ *
+ * Queries run against all layers in parallel. If several layers contain a component
+ * with the same data-ID, the same rules are applied as when adding components to
+ * a single #AsPool, with data from layers of higher priority being preferred if these
+ * rules don't decide. Components are never copied or modified by this.
+ *
+ * See also: #AsPool
+ */
+
+#include "config.h"
+#include "as-composite-pool.h"
+
+#include <glib.h>
+
+#include "as-utils-private.h"
+#include "as-pool-private.h"
+
+typedef struct
+{
+	AsPool		*pool;
+	gint		priority;
+} AsCompositeLayer;
+
+typedef struct
+{
+	GMutex		mutex;
+	GPtrArray	*layers; /* of AsCompositeLayer, highest priority first */
+	gchar		*current_arch;
+} AsCompositePoolPrivate;
+
+typedef enum {
+	AS_COMPOSITE_QUERY_ALL,
+	AS_COMPOSITE_QUERY_BY_ID,
+	AS_COMPOSITE_QUERY_BY_PROVIDED_ITEM,
+	AS_COMPOSITE_QUERY_BY_KIND,
+	AS_COMPOSITE_QUERY_BY_CATEGORIES,
+	AS_COMPOSITE_QUERY_BY_LAUNCHABLE,
+	AS_COMPOSITE_QUERY_SEARCH
+} AsCompositeQueryKind;
+
+typedef struct
+{
+	AsCompositeQueryKind	kind;
+	gint			item_kind; /* the provided, component or launchable kind */
+	const gchar		*value;
+	gchar			**categories;
+} AsCompositeQuery;
+
+typedef struct
+{
+	const AsCompositeQuery	*query;
+	AsPool			*pool;
+	GPtrArray		*result;
+} AsCompositeJob;
+
+typedef struct
+{
+	AsComponent		*cpt;
+	guint			score;
+} AsCompositeMatch;
+
+G_DEFINE_TYPE_WITH_PRIVATE (AsCompositePool, as_composite_pool, G_TYPE_OBJECT)
+#define GET_PRIVATE(o) (as_composite_pool_get_instance_private (o))
+
+/**
+ * as_composite_layer_free:
+ */
+static void
+as_composite_layer_free (AsCompositeLayer *layer)
+{
+	g_object_unref (layer->pool);
+	g_slice_free (AsCompositeLayer, layer);
+}
+
+/**
+ * as_composite_pool_finalize:
+ **/
+static void
+as_composite_pool_finalize (GObject *object)
+{
+	AsCompositePool *cpool = AS_COMPOSITE_POOL (object);
+	AsCompositePoolPrivate *priv = GET_PRIVATE (cpool);
+
+	g_ptr_array_unref (priv->layers);
+	g_free (priv->current_arch);
+	g_mutex_clear (&priv->mutex);
+
+	G_OBJECT_CLASS (as_composite_pool_parent_class)->finalize (object);
+}
+
+/**
+ * as_composite_pool_init:
+ **/
+static void
+as_composite_pool_init (AsCompositePool *cpool)
+{
+	AsCompositePoolPrivate *priv = GET_PRIVATE (cpool);
+
+	g_mutex_init (&priv->mutex);
+	priv->layers = g_ptr_array_new_with_free_func ((GDestroyNotify) as_composite_layer_free);
+	priv->current_arch = as_get_current_arch ();
+}
+
+/**
+ * as_composite_pool_class_init:
+ **/
+static void
+as_composite_pool_class_init (AsCompositePoolClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = as_composite_pool_finalize;
+}
+
+/**
+ * as_composite_pool_find_layer:
+ *
+ * Returns: the index of the layer for @pool, or -1 if @pool is no layer.
+ */
+static gint
+as_composite_pool_find_layer (AsCompositePool *cpool, AsPool *pool)
+{
+	guint i;
+	AsCompositePoolPrivate *priv = GET_PRIVATE (cpool);
+
+	for (i = 0; i < priv->layers->len; i++) {
+		AsCompositeLayer *layer = (AsCompositeLayer*) g_ptr_array_index (priv->layers, i);
+		if (layer->pool == pool)
+			return i;
+	}
+
+	return -1;
+}
+
+/**
+ * as_composite_pool_add_layer:
+ * @cpool: An instance of #AsCompositePool.
+ * @pool: The #AsPool to add as a layer.
+ * @priority: The priority of the new layer.
+ *
+ * Add a pool as a new layer. If @pool is a layer already, its priority is
+ * changed to @priority.
+ * Of layers with the same priority, the one added first is preferred.
+ *
+ * Since: 0.12.1
+ */
+void
+as_composite_pool_add_layer (AsCompositePool *cpool, AsPool *pool, gint priority)
+{
+	AsCompositeLayer *layer;
+	gint idx;
+	guint i;
+	AsCompositePoolPrivate *priv = GET_PRIVATE (cpool);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->mutex);
+
+	g_return_if_fail (AS_IS_POOL (pool));
+
+	idx = as_composite_pool_find_layer (cpool, pool);
+	if (idx >= 0)
+		g_ptr_array_remove_index (priv->layers, idx);
+
+	layer = g_slice_new0 (AsCompositeLayer);
+	layer->pool = g_object_ref (pool);
+	layer->priority = priority;
+
+	for (i = 0; i < priv->layers->len; i++) {
+		AsCompositeLayer *l = (AsCompositeLayer*) g_ptr_array_index (priv->layers, i);
+		if (l->priority < priority)
+			break;
+	}
+	g_ptr_array_insert (priv->layers, i, layer);
+}
+
+/**
+ * as_composite_pool_remove_layer:
+ * @cpool: An instance of #AsCompositePool.
+ * @pool: The #AsPool to remove.
+ *
+ * Remove a layer from the composite pool.
+ *
+ * Returns: %TRUE if @pool was a layer of @cpool.
+ *
+ * Since: 0.12.1
+ */
+gboolean
+as_composite_pool_remove_layer (AsCompositePool *cpool, AsPool *pool)
+{
+	gint idx;
+	AsCompositePoolPrivate *priv = GET_PRIVATE (cpool);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->mutex);
+
+	idx = as_composite_pool_find_layer (cpool, pool);
+	if (idx < 0)
+		return FALSE;
+	g_ptr_array_remove_index (priv->layers, idx);
+
+	return TRUE;
+}
+
+/**
+ * as_composite_pool_get_layers:
+ * @cpool: An instance of #AsCompositePool.
+ *
+ * Get the pools stacked in this composite pool.
+ *
+ * Returns: (transfer container) (element-type AsPool): the layers, highest priority first.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_composite_pool_get_layers (AsCompositePool *cpool)
+{
+	GPtrArray *pools;
+	guint i;
+	AsCompositePoolPrivate *priv = GET_PRIVATE (cpool);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->mutex);
+
+	pools = g_ptr_array_new_full (priv->layers->len, g_object_unref);
+	for (i = 0; i < priv->layers->len; i++) {
+		AsCompositeLayer *layer = (AsCompositeLayer*) g_ptr_array_index (priv->layers, i);
+		g_ptr_array_add (pools, g_object_ref (layer->pool));
+	}
+
+	return pools;
+}
+
+/**
+ * as_composite_pool_job_run:
+ *
+ * Run a query against one layer.
+ */
+static void
+as_composite_pool_job_run (gpointer data, gpointer user_data)
+{
+	AsCompositeJob *job = (AsCompositeJob*) data;
+	const AsCompositeQuery *query = job->query;
+
+	switch (query->kind) {
+	case AS_COMPOSITE_QUERY_ALL:
+		job->result = as_pool_get_components (job->pool);
+		break;
+	case AS_COMPOSITE_QUERY_BY_ID:
+		job->result = as_pool_get_components_by_id (job->pool, query->value);
+		break;
+	case AS_COMPOSITE_QUERY_BY_PROVIDED_ITEM:
+		job->result = as_pool_get_components_by_provided_item (job->pool,
+									(AsProvidedKind) query->item_kind,
+									query->value);
+		break;
+	case AS_COMPOSITE_QUERY_BY_KIND:
+		job->result = as_pool_get_components_by_kind (job->pool, (AsComponentKind) query->item_kind);
+		break;
+	case AS_COMPOSITE_QUERY_BY_CATEGORIES:
+		job->result = as_pool_get_components_by_categories (job->pool, query->categories);
+		break;
+	case AS_COMPOSITE_QUERY_BY_LAUNCHABLE:
+		job->result = as_pool_get_components_by_launchable (job->pool,
+								     (AsLaunchableKind) query->item_kind,
+								     query->value);
+		break;
+	case AS_COMPOSITE_QUERY_SEARCH:
+		job->result = as_pool_search (job->pool, query->value);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+}
+
+/**
+ * as_composite_pool_merge_result:
+ *
+ * Add the components of one layer to the merged result,
+ * resolving components with the same data-ID.
+ */
+static void
+as_composite_pool_merge_result (AsCompositePool *cpool, GPtrArray *merged, GHashTable *slots, GPtrArray *cpts)
+{
+	guint i;
+	AsCompositePoolPrivate *priv = GET_PRIVATE (cpool);
+
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+		AsComponent *existing;
+		const gchar *cdid = as_component_get_data_id (cpt);
+		gpointer slot;
+		gboolean found;
+
+		found = g_hash_table_lookup_extended (slots, cdid, NULL, &slot);
+		if (!found && (as_component_get_origin_kind (cpt) == AS_ORIGIN_KIND_DESKTOP_ENTRY)) {
+			/* .desktop entries may describe data which has the .desktop suffix in its ID */
+			g_autofree gchar *tmp_cdid = g_strdup_printf ("%s.desktop", cdid);
+			found = g_hash_table_lookup_extended (slots, tmp_cdid, NULL, &slot);
+		}
+		if (!found) {
+			g_hash_table_insert (slots, (gpointer) cdid, GUINT_TO_POINTER (merged->len));
+			g_ptr_array_add (merged, g_object_ref (cpt));
+			continue;
+		}
+
+		existing = AS_COMPONENT (g_ptr_array_index (merged, GPOINTER_TO_UINT (slot)));
+		if (existing == cpt)
+			continue;
+		if (!as_pool_component_replaces (existing, cpt, priv->current_arch))
+			continue;
+
+		g_object_unref (existing);
+		merged->pdata[GPOINTER_TO_UINT (slot)] = g_object_ref (cpt);
+	}
+}
+
+/**
+ * as_sort_matches_by_score_cb:
+ *
+ * Helper method to sort search matches by their score, highest first.
+ */
+static gint
+as_sort_matches_by_score_cb (gconstpointer a, gconstpointer b)
+{
+	guint s1 = ((const AsCompositeMatch*) a)->score;
+	guint s2 = ((const AsCompositeMatch*) b)->score;
+
+	if (s1 > s2)
+		return -1;
+	if (s1 < s2)
+		return 1;
+	return 0;
+}
+
+/**
+ * as_composite_pool_sort_by_score:
+ *
+ * Order merged search results of several layers by their match score.
+ */
+static void
+as_composite_pool_sort_by_score (GPtrArray *cpts, AsPool *pool, const gchar *search)
+{
+	g_auto(GStrv) terms = NULL;
+	g_autoptr(GArray) matches = NULL;
+	guint i;
+
+	terms = as_pool_build_search_terms (pool, search);
+	matches = g_array_sized_new (FALSE, FALSE, sizeof (AsCompositeMatch), cpts->len);
+	for (i = 0; i < cpts->len; i++) {
+		AsCompositeMatch match;
+
+		match.cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+		match.score = as_component_search_matches_all (match.cpt, terms);
+		g_array_append_val (matches, match);
+	}
+	g_array_sort (matches, as_sort_matches_by_score_cb);
+
+	/* the array keeps owning its references, we only reorder them */
+	for (i = 0; i < matches->len; i++)
+		cpts->pdata[i] = g_array_index (matches, AsCompositeMatch, i).cpt;
+}
+
+/**
+ * as_composite_pool_query:
+ *
+ * Run @query against all layers in parallel, and merge the results.
+ *
+ * Returns: (transfer container): the merged results.
+ */
+static GPtrArray*
+as_composite_pool_query (AsCompositePool *cpool, const AsCompositeQuery *query)
+{
+	g_autoptr(GPtrArray) pools = NULL;
+	g_autoptr(GHashTable) slots = NULL;
+	g_autofree AsCompositeJob *jobs = NULL;
+	GPtrArray *merged;
+	guint i;
+
+	/* the layers might change while we query them */
+	pools = as_composite_pool_get_layers (cpool);
+	merged = g_ptr_array_new_with_free_func (g_object_unref);
+	if (pools->len == 0)
+		return merged;
+
+	jobs = g_new0 (AsCompositeJob, pools->len);
+	for (i = 0; i < pools->len; i++) {
+		jobs[i].query = query;
+		jobs[i].pool = AS_POOL (g_ptr_array_index (pools, i));
+	}
+
+	if (pools->len > 1) {
+		GThreadPool *tpool;
+
+		/* the calling thread queries the first layer itself */
+		tpool = g_thread_pool_new (as_composite_pool_job_run,
+					   NULL,
+					   MIN (g_get_num_processors (), pools->len - 1),
+					   FALSE,
+					   NULL);
+		for (i = 1; i < pools->len; i++)
+			g_thread_pool_push (tpool, &jobs[i], NULL);
+		as_composite_pool_job_run (&jobs[0], NULL);
+		g_thread_pool_free (tpool, FALSE, TRUE);
+	} else {
+		as_composite_pool_job_run (&jobs[0], NULL);
+	}
+
+	/* merge, starting with the layer of highest priority */
+	slots = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < pools->len; i++) {
+		if (jobs[i].result == NULL)
+			continue;
+		as_composite_pool_merge_result (cpool, merged, slots, jobs[i].result);
+	}
+
+	if ((query->kind == AS_COMPOSITE_QUERY_SEARCH) && (pools->len > 1))
+		as_composite_pool_sort_by_score (merged, AS_POOL (g_ptr_array_index (pools, 0)), query->value);
+
+	/* the data-IDs used as keys belong to the components in the layer results */
+	g_clear_pointer (&slots, g_hash_table_unref);
+	for (i = 0; i < pools->len; i++) {
+		if (jobs[i].result != NULL)
+			g_ptr_array_unref (jobs[i].result);
+	}
+
+	return merged;
+}
+
+/**
+ * as_composite_pool_get_components:
+ * @cpool: An instance of #AsCompositePool.
+ *
+ * Get the components of all layers.
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of #AsComponent instances.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_composite_pool_get_components (AsCompositePool *cpool)
+{
+	AsCompositeQuery query = { AS_COMPOSITE_QUERY_ALL, 0, NULL, NULL };
+	return as_composite_pool_query (cpool, &query);
+}
+
+/**
+ * as_composite_pool_get_components_by_id:
+ * @cpool: An instance of #AsCompositePool.
+ * @cid: The AppStream-ID to look for.
+ *
+ * Get components by their ID from all layers.
+ * See as_pool_get_components_by_id() for details.
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of #AsComponent instances.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_composite_pool_get_components_by_id (AsCompositePool *cpool, const gchar *cid)
+{
+	AsCompositeQuery query = { AS_COMPOSITE_QUERY_BY_ID, 0, cid, NULL };
+
+	if (cid == NULL)
+		return g_ptr_array_new_with_free_func (g_object_unref);
+	return as_composite_pool_query (cpool, &query);
+}
+
+/**
+ * as_composite_pool_get_components_by_provided_item:
+ * @cpool: An instance of #AsCompositePool.
+ * @kind: An #AsProvidesKind
+ * @item: The value of the provided item.
+ *
+ * Find components in all layers which provide a certain item.
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of #AsComponent objects which have been found.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_composite_pool_get_components_by_provided_item (AsCompositePool *cpool,
+						    AsProvidedKind kind,
+						    const gchar *item)
+{
+	AsCompositeQuery query = { AS_COMPOSITE_QUERY_BY_PROVIDED_ITEM, kind, item, NULL };
+
+	g_return_val_if_fail (item != NULL, NULL);
+	return as_composite_pool_query (cpool, &query);
+}
+
+/**
+ * as_composite_pool_get_components_by_kind:
+ * @cpool: An instance of #AsCompositePool.
+ * @kind: An #AsComponentKind.
+ *
+ * Return a list of all components in all layers which are of a certain kind.
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of #AsComponent objects which have been found.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_composite_pool_get_components_by_kind (AsCompositePool *cpool, AsComponentKind kind)
+{
+	AsCompositeQuery query = { AS_COMPOSITE_QUERY_BY_KIND, kind, NULL, NULL };
+
+	g_return_val_if_fail ((kind < AS_COMPONENT_KIND_LAST) && (kind > AS_COMPONENT_KIND_UNKNOWN), NULL);
+	return as_composite_pool_query (cpool, &query);
+}
+
+/**
+ * as_composite_pool_get_components_by_categories:
+ * @cpool: An instance of #AsCompositePool.
+ * @categories: An array of XDG categories to include.
+ *
+ * Return a list of components in all layers which are in one of the categories.
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of #AsComponent objects which have been found.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_composite_pool_get_components_by_categories (AsCompositePool *cpool, gchar **categories)
+{
+	AsCompositeQuery query = { AS_COMPOSITE_QUERY_BY_CATEGORIES, 0, NULL, categories };
+	return as_composite_pool_query (cpool, &query);
+}
+
+/**
+ * as_composite_pool_get_components_by_launchable:
+ * @cpool: An instance of #AsCompositePool.
+ * @kind: An #AsLaunchableKind
+ * @id: The ID of the launchable.
+ *
+ * Find components in all layers which provide a specific launchable.
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of #AsComponent objects which have been found.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_composite_pool_get_components_by_launchable (AsCompositePool *cpool,
+						 AsLaunchableKind kind,
+						 const gchar *id)
+{
+	AsCompositeQuery query = { AS_COMPOSITE_QUERY_BY_LAUNCHABLE, kind, id, NULL };
+
+	g_return_val_if_fail (id != NULL, NULL);
+	return as_composite_pool_query (cpool, &query);
+}
+
+/**
+ * as_composite_pool_search:
+ * @cpool: An instance of #AsCompositePool.
+ * @search: A search string
+ *
+ * Search all layers for components matching the search terms.
+ * The list will be ordered by match score.
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of the found #AsComponent objects.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_composite_pool_search (AsCompositePool *cpool, const gchar *search)
+{
+	AsCompositeQuery query = { AS_COMPOSITE_QUERY_SEARCH, 0, search, NULL };
+	return as_composite_pool_query (cpool, &query);
+}
+
+/**
+ * as_composite_pool_new:
+ *
+ * Creates a new #AsCompositePool without any layers.
+ *
+ * Returns: (transfer full): a #AsCompositePool
+ *
+ * Since: 0.12.1
+ */
+AsCompositePool*
+as_composite_pool_new (void)
+{
+	AsCompositePool *cpool;
+	cpool = g_object_new (AS_TYPE_COMPOSITE_POOL, NULL);
+	return AS_COMPOSITE_POOL (cpool);
+}
@@ -0,0 +1,75 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_COMPOSITE_POOL_H
+#define __AS_COMPOSITE_POOL_H
+
+#include <glib-object.h>
+#include "as-pool.h"
+
+G_BEGIN_DECLS
+
+#define AS_TYPE_COMPOSITE_POOL (as_composite_pool_get_type ())
+G_DECLARE_DERIVABLE_TYPE (AsCompositePool, as_composite_pool, AS, COMPOSITE_POOL, GObject)
+
+struct _AsCompositePoolClass
+{
+	GObjectClass		parent_class;
+	/*< private >*/
+	void (*_as_reserved1)	(void);
+	void (*_as_reserved2)	(void);
+	void (*_as_reserved3)	(void);
+	void (*_as_reserved4)	(void);
+	void (*_as_reserved5)	(void);
+	void (*_as_reserved6)	(void);
+};
+
+AsCompositePool		*as_composite_pool_new (void);
+
+void			as_composite_pool_add_layer (AsCompositePool *cpool,
+						     AsPool *pool,
+						     gint priority);
+gboolean		as_composite_pool_remove_layer (AsCompositePool *cpool,
+							AsPool *pool);
+GPtrArray		*as_composite_pool_get_layers (AsCompositePool *cpool);
+
+GPtrArray		*as_composite_pool_get_components (AsCompositePool *cpool);
+GPtrArray		*as_composite_pool_get_components_by_id (AsCompositePool *cpool,
+								 const gchar *cid);
+GPtrArray		*as_composite_pool_get_components_by_provided_item (AsCompositePool *cpool,
+									    AsProvidedKind kind,
+									    const gchar *item);
+GPtrArray		*as_composite_pool_get_components_by_kind (AsCompositePool *cpool,
+								   AsComponentKind kind);
+GPtrArray		*as_composite_pool_get_components_by_categories (AsCompositePool *cpool,
+									 gchar **categories);
+GPtrArray		*as_composite_pool_get_components_by_launchable (AsCompositePool *cpool,
+									 AsLaunchableKind kind,
+									 const gchar *id);
+GPtrArray		*as_composite_pool_search (AsCompositePool *cpool,
+						   const gchar *search);
+
+G_END_DECLS
+
+#endif /* __AS_COMPOSITE_POOL_H */
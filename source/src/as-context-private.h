@@ -0,0 +1,45 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2012-2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_CONTEXT_PRIVATE_H
+#define __AS_CONTEXT_PRIVATE_H
+
+#include "as-context.h"
+#include "as-settings-private.h"
+
+G_BEGIN_DECLS
+#pragma GCC visibility push(hidden)
+
+const gchar		*as_context_intern (AsContext *ctx,
+					    const gchar *str);
+AS_INTERNAL_VISIBLE
+void			as_context_get_intern_stats (AsContext *ctx,
+						     guint *n_requests,
+						     guint *n_unique,
+						     gsize *saved_bytes);
+
+#pragma GCC visibility pop
+G_END_DECLS
+
+#endif /* __AS_CONTEXT_PRIVATE_H */
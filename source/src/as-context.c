@@ -30,21 +30,31 @@
 
 #include "config.h"
 #include "as-context.h"
+#include "as-context-private.h"
+
+#include <string.h>
 
 #include "as-utils-private.h"
+#include "as-intern.h"
 
 typedef struct
 {
 	AsFormatVersion		format_version;
 	AsFormatStyle		style;
 	gchar 			*locale;
-	gchar 			*origin;
+	const AsLocaleChain	*locale_chain; /* fallbacks for @locale, %NULL if unset */
+	const gchar		*origin;
 	gchar 			*media_baseurl;
-	gchar 			*arch;
+	const gchar		*arch;
 	gchar			*fname;
 	gint 			priority;
+	AsLoadProfile		load_profile;
 
 	gboolean		all_locale;
+
+	GHashTable		*interned; /* set of utf8, we hold a reference on each in the global string table */
+	guint			intern_requests;
+	gsize			intern_saved_bytes;
 } AsContextPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsContext, as_context, G_TYPE_OBJECT)
@@ -58,11 +68,12 @@ as_context_finalize (GObject *object)
 	AsContextPrivate *priv = GET_PRIVATE (ctx);
 
 	g_free (priv->locale);
-	g_free (priv->origin);
 	g_free (priv->media_baseurl);
-	g_free (priv->arch);
 	g_free (priv->fname);
 
+	/* origin and arch are interned, and released with the set */
+	g_hash_table_unref (priv->interned);
+
 	G_OBJECT_CLASS (as_context_parent_class)->finalize (object);
 }
 
@@ -75,6 +86,11 @@ as_context_init (AsContext *ctx)
 	priv->style = AS_FORMAT_STYLE_UNKNOWN;
 	priv->fname = g_strdup (":memory:");
 	priv->priority = 0;
+	priv->load_profile = AS_LOAD_PROFILE_FULL;
+
+	priv->interned = g_hash_table_new_full (g_str_hash, g_str_equal,
+						(GDestroyNotify) as_intern_unref,
+						NULL);
 }
 
 static void
@@ -138,6 +154,33 @@ as_context_set_style (AsContext *ctx, AsFormatStyle style)
 	priv->style = style;
 }
 
+/**
+ * as_context_get_load_profile:
+ * @ctx: a #AsContext instance.
+ *
+ * Returns: The parts of the component data which are loaded.
+ **/
+AsLoadProfile
+as_context_get_load_profile (AsContext *ctx)
+{
+	AsContextPrivate *priv = GET_PRIVATE (ctx);
+	return priv->load_profile;
+}
+
+/**
+ * as_context_set_load_profile:
+ * @ctx: a #AsContext instance.
+ * @profile: the new #AsLoadProfile.
+ *
+ * Sets which parts of the component data should be loaded.
+ **/
+void
+as_context_set_load_profile (AsContext *ctx, AsLoadProfile profile)
+{
+	AsContextPrivate *priv = GET_PRIVATE (ctx);
+	priv->load_profile = profile;
+}
+
 /**
  * as_context_get_priority:
  * @ctx: a #AsContext instance.
@@ -189,8 +232,7 @@ void
 as_context_set_origin (AsContext *ctx, const gchar *value)
 {
 	AsContextPrivate *priv = GET_PRIVATE (ctx);
-	g_free (priv->origin);
-	priv->origin = g_strdup (value);
+	priv->origin = as_context_intern (ctx, value);
 }
 
 /**
@@ -226,6 +268,20 @@ as_context_set_locale (AsContext *ctx, const gchar *value)
 	} else {
 		priv->locale = g_strdup (value);
 	}
+	priv->locale_chain = (priv->locale != NULL)? as_locale_chain_get (priv->locale) : NULL;
+}
+
+/**
+ * as_context_get_locale_chain:
+ * @ctx: a #AsContext instance.
+ *
+ * Returns: (nullable): The fallback chain of the active locale, or %NULL if no locale is set.
+ **/
+const AsLocaleChain*
+as_context_get_locale_chain (AsContext *ctx)
+{
+	AsContextPrivate *priv = GET_PRIVATE (ctx);
+	return priv->locale_chain;
 }
 
 /**
@@ -306,8 +362,7 @@ void
 as_context_set_architecture (AsContext *ctx, const gchar *value)
 {
 	AsContextPrivate *priv = GET_PRIVATE (ctx);
-	g_free (priv->arch);
-	priv->arch = g_strdup (value);
+	priv->arch = as_context_intern (ctx, value);
 }
 
 /**
@@ -338,6 +393,68 @@ as_context_set_filename (AsContext *ctx, const gchar *fname)
 	priv->fname = g_strdup (fname);
 }
 
+/**
+ * as_context_intern:
+ * @ctx: a #AsContext instance.
+ * @str: (nullable): the string to intern.
+ *
+ * Returns a canonical copy of @str which stays valid for as long as
+ * the context is alive. The copy is taken from the process-wide string
+ * table, so data loaded with different contexts shares it as well.
+ * Short strings which repeat a lot in AppStream metadata (locale names,
+ * categories, origin and architecture) should be interned, so data loaded
+ * with the same context can share them instead of holding private copies.
+ *
+ * Returns: (transfer none): the interned string, or %NULL if @str was %NULL.
+ **/
+const gchar*
+as_context_intern (AsContext *ctx, const gchar *str)
+{
+	AsContextPrivate *priv = GET_PRIVATE (ctx);
+	const gchar *istr;
+
+	if (str == NULL)
+		return NULL;
+
+	priv->intern_requests++;
+	istr = g_hash_table_lookup (priv->interned, str);
+	if (istr != NULL) {
+		priv->intern_saved_bytes += strlen (istr) + 1;
+		return istr;
+	}
+
+	/* take a single reference per context, so lookups of strings we
+	 * already know never need to touch the global lock */
+	istr = as_intern_ref (str);
+	g_hash_table_add (priv->interned, (gpointer) istr);
+
+	return istr;
+}
+
+/**
+ * as_context_get_intern_stats:
+ * @ctx: a #AsContext instance.
+ * @n_requests: (out) (optional): number of strings which were requested to be interned.
+ * @n_unique: (out) (optional): number of unique strings used by this context.
+ * @saved_bytes: (out) (optional): number of bytes which did not need to be allocated.
+ *
+ * Report how effective string interning was for data loaded with this context.
+ * Every request which is not a unique string is a heap allocation that
+ * has been avoided.
+ **/
+void
+as_context_get_intern_stats (AsContext *ctx, guint *n_requests, guint *n_unique, gsize *saved_bytes)
+{
+	AsContextPrivate *priv = GET_PRIVATE (ctx);
+
+	if (n_requests != NULL)
+		*n_requests = priv->intern_requests;
+	if (n_unique != NULL)
+		*n_unique = g_hash_table_size (priv->interned);
+	if (saved_bytes != NULL)
+		*saved_bytes = priv->intern_saved_bytes;
+}
+
 /**
  * as_context_new:
  *
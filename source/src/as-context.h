@@ -27,6 +27,7 @@
 
 #include <glib-object.h>
 #include "as-metadata.h"
+#include "as-locale.h"
 
 G_BEGIN_DECLS
 
@@ -55,6 +56,10 @@ AsFormatStyle		as_context_get_style (AsContext *ctx);
 void			as_context_set_style (AsContext *ctx,
 						AsFormatStyle style);
 
+AsLoadProfile		as_context_get_load_profile (AsContext *ctx);
+void			as_context_set_load_profile (AsContext *ctx,
+						     AsLoadProfile profile);
+
 gint			as_context_get_priority (AsContext *ctx);
 void			as_context_set_priority (AsContext *ctx,
 						 gint priority);
@@ -66,6 +71,7 @@ void			as_context_set_origin (AsContext *ctx,
 const gchar		*as_context_get_locale (AsContext *ctx);
 void			as_context_set_locale (AsContext *ctx,
 					       const gchar *value);
+const AsLocaleChain	*as_context_get_locale_chain (AsContext *ctx);
 
 gboolean		as_context_has_media_baseurl (AsContext *ctx);
 const gchar		*as_context_get_media_baseurl (AsContext *ctx);
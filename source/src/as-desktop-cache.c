@@ -0,0 +1,350 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:as-desktop-cache
+ * @short_description: Cache for components read from .desktop files
+ * @include: appstream.h
+ *
+ * Stores the components generated from .desktop files, keyed by the path,
+ * modification time, status change time and size of the file they were read
+ * from, so only new or modified files need to be parsed again.
+ * The status change time has nanosecond resolution, so a file rewritten with
+ * the same size within the same second is noticed as well.
+ * The cache file is an uncompressed GVariant, which is mapped into memory
+ * when loading it.
+ * This is a private/internal API.
+ */
+
+#include "config.h"
+#include "as-desktop-cache.h"
+
+#include <glib/gstdio.h>
+
+#include "as-variant-cache.h"
+#include "as-component.h"
+#include "as-component-private.h"
+
+/* type of the serialized cache entries: path, mtime, ctime in ns, size, components */
+#define AS_DESKTOP_CACHE_ENTRY_TYPE	"(sxxtaa{sv})"
+
+typedef struct {
+	gint64		mtime;
+	gint64		ctime_ns;
+	guint64		size;
+	GVariant	*cpts; /* aa{sv} */
+} AsDesktopCacheEntry;
+
+struct _AsDesktopCache {
+	gchar		*locale;
+	GHashTable	*entries; /* path -> AsDesktopCacheEntry */
+	gboolean	dirty;
+};
+
+/**
+ * as_desktop_cache_entry_free:
+ */
+static void
+as_desktop_cache_entry_free (AsDesktopCacheEntry *entry)
+{
+	g_variant_unref (entry->cpts);
+	g_slice_free (AsDesktopCacheEntry, entry);
+}
+
+/**
+ * as_desktop_cache_new:
+ * @locale: the locale the cached components are for.
+ *
+ * Returns: (transfer full): a new, empty #AsDesktopCache
+ */
+AsDesktopCache*
+as_desktop_cache_new (const gchar *locale)
+{
+	AsDesktopCache *dcache;
+
+	dcache = g_new0 (AsDesktopCache, 1);
+	dcache->locale = g_strdup (locale);
+	dcache->entries = g_hash_table_new_full (g_str_hash,
+						 g_str_equal,
+						 g_free,
+						 (GDestroyNotify) as_desktop_cache_entry_free);
+	return dcache;
+}
+
+/**
+ * as_desktop_cache_free:
+ * @dcache: an #AsDesktopCache
+ */
+void
+as_desktop_cache_free (AsDesktopCache *dcache)
+{
+	if (dcache == NULL)
+		return;
+	g_hash_table_unref (dcache->entries);
+	g_free (dcache->locale);
+	g_free (dcache);
+}
+
+/**
+ * as_desktop_cache_load:
+ * @dcache: an #AsDesktopCache
+ * @fname: the cache file.
+ * @error: a #GError
+ *
+ * Load the cache entries from @fname. A missing cache file, or one
+ * for a different locale or format version, just results in an empty cache.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+as_desktop_cache_load (AsDesktopCache *dcache, const gchar *fname, GError **error)
+{
+	g_autoptr(GMappedFile) mfile = NULL;
+	g_autoptr(GBytes) bytes = NULL;
+	g_autoptr(GVariant) main_gv = NULL;
+	g_autoptr(GVariant) gmvar = NULL;
+	g_autoptr(GVariant) entries_var = NULL;
+	GVariantIter iter;
+	const gchar *path;
+	gint64 mtime;
+	gint64 ctime_ns;
+	guint64 size;
+	GVariant *cpts;
+	GError *tmp_error = NULL;
+
+	g_hash_table_remove_all (dcache->entries);
+	dcache->dirty = FALSE;
+
+	mfile = g_mapped_file_new (fname, FALSE, &tmp_error);
+	if (mfile == NULL) {
+		if (g_error_matches (tmp_error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+			g_error_free (tmp_error);
+			return TRUE;
+		}
+		g_propagate_error (error, tmp_error);
+		return FALSE;
+	}
+
+	bytes = g_mapped_file_get_bytes (mfile);
+	main_gv = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE_VARDICT, bytes, FALSE));
+
+	/* don't try to load incompatible cache versions */
+	gmvar = g_variant_lookup_value (main_gv, "format_version", G_VARIANT_TYPE_UINT32);
+	if ((gmvar == NULL) || (g_variant_get_uint32 (gmvar) != CACHE_FORMAT_VERSION)) {
+		g_debug ("Ignored incompatible desktop-entry cache '%s'.", fname);
+		return TRUE;
+	}
+	g_variant_unref (gmvar);
+
+	/* the components only contain data for one locale */
+	gmvar = g_variant_lookup_value (main_gv, "locale", G_VARIANT_TYPE_MAYBE);
+	if (g_strcmp0 (as_variant_get_mstring (&gmvar), dcache->locale) != 0) {
+		g_debug ("Ignored desktop-entry cache '%s': Locale does not match.", fname);
+		return TRUE;
+	}
+
+	entries_var = g_variant_lookup_value (main_gv, "entries", G_VARIANT_TYPE ("a" AS_DESKTOP_CACHE_ENTRY_TYPE));
+	if (entries_var == NULL)
+		return TRUE;
+
+	g_variant_iter_init (&iter, entries_var);
+	while (g_variant_iter_next (&iter, "(&sxxt@aa{sv})", &path, &mtime, &ctime_ns, &size, &cpts)) {
+		AsDesktopCacheEntry *entry;
+
+		entry = g_slice_new0 (AsDesktopCacheEntry);
+		entry->mtime = mtime;
+		entry->ctime_ns = ctime_ns;
+		entry->size = size;
+		entry->cpts = cpts;
+		g_hash_table_insert (dcache->entries, g_strdup (path), entry);
+	}
+
+	return TRUE;
+}
+
+/**
+ * as_desktop_cache_save:
+ * @dcache: an #AsDesktopCache
+ * @fname: the cache file.
+ * @error: a #GError
+ *
+ * Write the cache to @fname, replacing it atomically.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+as_desktop_cache_save (AsDesktopCache *dcache, const gchar *fname, GError **error)
+{
+	GVariantBuilder main_builder;
+	GVariantBuilder entries_builder;
+	g_autoptr(GVariant) main_gv = NULL;
+	GHashTableIter ht_iter;
+	gpointer key, value;
+
+	g_variant_builder_init (&entries_builder, G_VARIANT_TYPE ("a" AS_DESKTOP_CACHE_ENTRY_TYPE));
+	g_hash_table_iter_init (&ht_iter, dcache->entries);
+	while (g_hash_table_iter_next (&ht_iter, &key, &value)) {
+		AsDesktopCacheEntry *entry = (AsDesktopCacheEntry*) value;
+
+		g_variant_builder_add (&entries_builder, "(sxxt@aa{sv})",
+				       (const gchar*) key,
+				       entry->mtime,
+				       entry->ctime_ns,
+				       entry->size,
+				       entry->cpts);
+	}
+
+	g_variant_builder_init (&main_builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&main_builder, "{sv}",
+				"format_version",
+				g_variant_new_uint32 (CACHE_FORMAT_VERSION));
+	g_variant_builder_add (&main_builder, "{sv}",
+				"locale",
+				as_variant_mstring_new (dcache->locale));
+	g_variant_builder_add (&main_builder, "{sv}",
+				"entries",
+				g_variant_builder_end (&entries_builder));
+	main_gv = g_variant_ref_sink (g_variant_builder_end (&main_builder));
+
+	if (!g_file_set_contents (fname,
+				  g_variant_get_data (main_gv),
+				  g_variant_get_size (main_gv),
+				  error))
+		return FALSE;
+
+	dcache->dirty = FALSE;
+	return TRUE;
+}
+
+/**
+ * as_desktop_cache_lookup:
+ * @dcache: an #AsDesktopCache
+ * @sfile: the .desktop file, with stat data.
+ *
+ * Get the components for @sfile, if they were cached for a file
+ * with the same modification time, status change time and size.
+ *
+ * Returns: (transfer container) (element-type AsComponent): the cached components,
+ *          which may be none at all, or %NULL if the file needs to be parsed.
+ */
+GPtrArray*
+as_desktop_cache_lookup (AsDesktopCache *dcache, AsScannedFile *sfile)
+{
+	AsDesktopCacheEntry *entry;
+	GPtrArray *cpts;
+	GVariantIter iter;
+	GVariant *cptv;
+
+	entry = g_hash_table_lookup (dcache->entries, sfile->path);
+	if (entry == NULL)
+		return NULL;
+	if ((entry->mtime != sfile->mtime) ||
+	    (entry->ctime_ns != sfile->ctime_ns) ||
+	    (entry->size != sfile->size))
+		return NULL;
+
+	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	g_variant_iter_init (&iter, entry->cpts);
+	while ((cptv = g_variant_iter_next_value (&iter)) != NULL) {
+		AsComponent *cpt = as_component_new ();
+
+		/* the origin kind isn't serialized, but the pool treats .desktop data specially */
+		if (as_component_set_from_variant (cpt, cptv, dcache->locale)) {
+			as_component_set_origin_kind (cpt, AS_ORIGIN_KIND_DESKTOP_ENTRY);
+			g_ptr_array_add (cpts, cpt);
+		} else
+			g_object_unref (cpt);
+		g_variant_unref (cptv);
+	}
+
+	return cpts;
+}
+
+/**
+ * as_desktop_cache_insert:
+ * @dcache: an #AsDesktopCache
+ * @sfile: the .desktop file, with stat data.
+ * @cpts: (element-type AsComponent): the components read from @sfile.
+ *
+ * Add the components generated from @sfile to the cache,
+ * replacing any older entry for the same file.
+ */
+void
+as_desktop_cache_insert (AsDesktopCache *dcache, AsScannedFile *sfile, GPtrArray *cpts)
+{
+	AsDesktopCacheEntry *entry;
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+	for (i = 0; i < cpts->len; i++)
+		as_component_to_variant (AS_COMPONENT (g_ptr_array_index (cpts, i)), &builder);
+
+	entry = g_slice_new0 (AsDesktopCacheEntry);
+	entry->mtime = sfile->mtime;
+	entry->ctime_ns = sfile->ctime_ns;
+	entry->size = sfile->size;
+	entry->cpts = g_variant_ref_sink (g_variant_builder_end (&builder));
+	g_hash_table_insert (dcache->entries, g_strdup (sfile->path), entry);
+
+	dcache->dirty = TRUE;
+}
+
+/**
+ * as_desktop_cache_retain:
+ * @dcache: an #AsDesktopCache
+ * @sfiles: (element-type AsScannedFile): the files which currently exist.
+ *
+ * Drop the entries of files which do not exist anymore.
+ */
+void
+as_desktop_cache_retain (AsDesktopCache *dcache, GPtrArray *sfiles)
+{
+	g_autoptr(GHashTable) existing = NULL;
+	GHashTableIter iter;
+	gpointer key;
+	guint i;
+
+	existing = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < sfiles->len; i++) {
+		AsScannedFile *sfile = (AsScannedFile*) g_ptr_array_index (sfiles, i);
+		g_hash_table_add (existing, sfile->path);
+	}
+
+	g_hash_table_iter_init (&iter, dcache->entries);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if (g_hash_table_contains (existing, key))
+			continue;
+		g_hash_table_iter_remove (&iter);
+		dcache->dirty = TRUE;
+	}
+}
+
+/**
+ * as_desktop_cache_is_dirty:
+ * @dcache: an #AsDesktopCache
+ *
+ * Returns: %TRUE if the cache was modified since it was loaded or saved.
+ */
+gboolean
+as_desktop_cache_is_dirty (AsDesktopCache *dcache)
+{
+	return dcache->dirty;
+}
@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_DESKTOP_CACHE_H
+#define __AS_DESKTOP_CACHE_H
+
+#include <glib-object.h>
+#include "as-dir-scanner.h"
+#include "as-settings-private.h"
+
+G_BEGIN_DECLS
+#pragma GCC visibility push(hidden)
+
+typedef struct _AsDesktopCache AsDesktopCache;
+
+AS_INTERNAL_VISIBLE
+AsDesktopCache		*as_desktop_cache_new (const gchar *locale);
+AS_INTERNAL_VISIBLE
+void			as_desktop_cache_free (AsDesktopCache *dcache);
+
+AS_INTERNAL_VISIBLE
+gboolean		as_desktop_cache_load (AsDesktopCache *dcache,
+					       const gchar *fname,
+					       GError **error);
+AS_INTERNAL_VISIBLE
+gboolean		as_desktop_cache_save (AsDesktopCache *dcache,
+					       const gchar *fname,
+					       GError **error);
+
+AS_INTERNAL_VISIBLE
+GPtrArray		*as_desktop_cache_lookup (AsDesktopCache *dcache,
+						  AsScannedFile *sfile);
+AS_INTERNAL_VISIBLE
+void			as_desktop_cache_insert (AsDesktopCache *dcache,
+						 AsScannedFile *sfile,
+						 GPtrArray *cpts);
+AS_INTERNAL_VISIBLE
+void			as_desktop_cache_retain (AsDesktopCache *dcache,
+						 GPtrArray *sfiles);
+AS_INTERNAL_VISIBLE
+gboolean		as_desktop_cache_is_dirty (AsDesktopCache *dcache);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AsDesktopCache, as_desktop_cache_free)
+
+#pragma GCC visibility pop
+G_END_DECLS
+
+#endif /* __AS_DESKTOP_CACHE_H */
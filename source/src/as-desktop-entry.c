@@ -34,6 +34,7 @@
 #include "as-metadata.h"
 #include "as-component.h"
 #include "as-component-private.h"
+#include "as-locale.h"
 
 #define DESKTOP_GROUP G_KEY_FILE_DESKTOP_GROUP
 
@@ -146,66 +147,94 @@ as_add_filtered_categories (gchar **cats, AsComponent *cpt)
 
 
 /**
- * as_desktop_entry_parse_data:
+ * as_desktop_entry_locale_wanted:
+ *
+ * Check if values for @key_locale should be read, if only
+ * data for @locale is requested.
  */
-AsComponent*
-as_desktop_entry_parse_data (const gchar *data, const gchar *cid, AsFormatVersion fversion, GError **error)
+static gboolean
+as_desktop_entry_locale_wanted (const gchar *locale, const gchar *key_locale)
+{
+	/* no filter, we read everything */
+	if (locale == NULL)
+		return TRUE;
+	if (g_strcmp0 (key_locale, "C") == 0)
+		return TRUE;
+	return as_locale_chain_accepts (as_locale_chain_get (locale), key_locale);
+}
+
+/**
+ * as_desktop_entry_key_wanted:
+ *
+ * Check if we need the value of a key in the [Desktop Entry] group to
+ * create a component. Keys which are matched by prefix may be localized.
+ */
+static gboolean
+as_desktop_entry_key_wanted (const gchar *key, gsize key_len)
+{
+	switch (key[0]) {
+	case 'C':
+		return ((key_len >= 7) && (strncmp (key, "Comment", 7) == 0)) ||
+			((key_len == 10) && (strncmp (key, "Categories", 10) == 0));
+	case 'I':
+		return (key_len == 4) && (strncmp (key, "Icon", 4) == 0);
+	case 'K':
+		return (key_len >= 8) && (strncmp (key, "Keywords", 8) == 0);
+	case 'M':
+		return (key_len == 8) && (strncmp (key, "MimeType", 8) == 0);
+	case 'N':
+		return ((key_len >= 4) && (strncmp (key, "Name", 4) == 0)) ||
+			((key_len == 9) && (strncmp (key, "NoDisplay", 9) == 0));
+	case 'T':
+		return (key_len == 4) && (strncmp (key, "Type", 4) == 0);
+	case 'X':
+		return (key_len >= 11) && (strncmp (key, "X-AppStream", 11) == 0);
+	default:
+		return FALSE;
+	}
+}
+
+/**
+ * as_desktop_entry_create_component:
+ * @keys: (element-type utf8) (nullable): the keys of the [Desktop Entry] group,
+ *        in file order, or %NULL if the group is missing.
+ * @values: the values of the keys.
+ * @locale: (nullable): the locale to read, or %NULL to read all of them.
+ *
+ * Create a component from the data of a [Desktop Entry] group.
+ */
+static AsComponent*
+as_desktop_entry_create_component (GPtrArray *keys,
+				   GHashTable *values,
+				   const gchar *cid,
+				   AsFormatVersion fversion,
+				   const gchar *locale,
+				   GError **error)
 {
 	g_autoptr(AsComponent) cpt = NULL;
-	g_autoptr(GKeyFile) df = NULL;
-	gchar *tmp;
 	gboolean ignore_cpt = FALSE;
-	g_auto(GStrv) keys = NULL;
 	guint i;
 
-	g_assert (cid != NULL);
-
-	df = g_key_file_new ();
-	g_key_file_load_from_data (df,
-				   data,
-				   -1,
-				   G_KEY_FILE_KEEP_TRANSLATIONS,
-				   error);
-	if (*error != NULL)
-		return NULL;
-
 	/* Type */
-	tmp = g_key_file_get_string (df,
-				     DESKTOP_GROUP,
-				     "Type",
-				     NULL);
-	if (!as_strequal_casefold (tmp, "application")) {
-		g_free (tmp);
+	if (!as_strequal_casefold (g_hash_table_lookup (values, "Type"), "application")) {
 		/* not an application, so we can't proceed, but also no error */
 		return NULL;
 	}
-	g_free (tmp);
 
 	/* NoDisplay */
-	tmp = g_key_file_get_string (df,
-				     DESKTOP_GROUP,
-				     "NoDisplay",
-				     NULL);
-	if (as_strequal_casefold (tmp, "true")) {
+	if (as_strequal_casefold (g_hash_table_lookup (values, "NoDisplay"), "true")) {
 		/* we will read the application data, but it will be ignored in its current form */
 		ignore_cpt = TRUE;
 	}
-	g_free (tmp);
 
 	/* X-AppStream-Ignore */
-	tmp = g_key_file_get_string (df,
-				     DESKTOP_GROUP,
-				     "X-AppStream-Ignore",
-				     NULL);
-	if (as_strequal_casefold (tmp, "true")) {
-		g_free (tmp);
+	if (as_strequal_casefold (g_hash_table_lookup (values, "X-AppStream-Ignore"), "true")) {
 		/* this file should be ignored, we can't return a component (but this is also no error) */
 		return NULL;
 	}
-	g_free (tmp);
 
 	/* check this is a valid desktop file */
-	if (!g_key_file_has_group (df, DESKTOP_GROUP)) {
+	if (keys == NULL) {
 		g_set_error (error,
 				AS_METADATA_ERROR,
 				AS_METADATA_ERROR_PARSE,
@@ -236,24 +265,25 @@ as_desktop_entry_parse_data (const gchar *data, const gchar *cid, AsFormatVersio
 		}
 	}
 
-	keys = g_key_file_get_keys (df, DESKTOP_GROUP, NULL, NULL);
-	for (i = 0; keys[i] != NULL; i++) {
-		g_autofree gchar *locale = NULL;
+	for (i = 0; i < keys->len; i++) {
+		g_autofree gchar *key_locale = NULL;
 		g_autofree gchar *val = NULL;
-		gchar *key = keys[i];
+		const gchar *key = (const gchar*) g_ptr_array_index (keys, i);
 
-		g_strstrip (key);
-		locale = as_get_locale_from_key (key);
+		key_locale = as_get_locale_from_key (key);
 
 		/* skip invalid stuff */
-		if (locale == NULL)
+		if (key_locale == NULL)
+			continue;
+		/* skip translations we don't need */
+		if (!as_desktop_entry_locale_wanted (locale, key_locale))
 			continue;
 
-		val = g_key_file_get_string (df, DESKTOP_GROUP, key, NULL);
+		val = g_strdup (g_hash_table_lookup (values, key));
 		if (g_str_has_prefix (key, "Name")) {
-			as_component_set_name (cpt, val, locale);
+			as_component_set_name (cpt, val, key_locale);
 		} else if (g_str_has_prefix (key, "Comment")) {
-			as_component_set_summary (cpt, val, locale);
+			as_component_set_summary (cpt, val, key_locale);
 		} else if (g_strcmp0 (key, "Categories") == 0) {
 			g_auto(GStrv) cats = NULL;
 
@@ -267,7 +297,7 @@ as_desktop_entry_parse_data (const gchar *data, const gchar *cid, AsFormatVersio
 				val[strlen (val) -1] = '\0';
 
 			kws = g_strsplit (val, ";", -1);
-			as_component_set_keywords (cpt, kws, locale);
+			as_component_set_keywords (cpt, kws, key_locale);
 		} else if (g_strcmp0 (key, "MimeType") == 0) {
 			g_auto(GStrv) mts = NULL;
 			g_autoptr(AsProvided) prov = NULL;
@@ -325,6 +355,303 @@ as_desktop_entry_parse_data (const gchar *data, const gchar *cid, AsFormatVersio
 	return g_object_ref (cpt);
 }
 
+/**
+ * as_desktop_entry_parse_data_keyfile:
+ * @locale: (nullable): the locale to read, or %NULL to read all of them.
+ *
+ * Parse desktop-entry data using #GKeyFile. This validates the whole
+ * file and reports errors properly, but is slower and keeps all
+ * translations in memory.
+ */
+AsComponent*
+as_desktop_entry_parse_data_keyfile (const gchar *data,
+				     const gchar *cid,
+				     AsFormatVersion fversion,
+				     const gchar *locale,
+				     GError **error)
+{
+	g_autoptr(GKeyFile) df = NULL;
+	g_autoptr(GPtrArray) keys = NULL;
+	g_autoptr(GHashTable) values = NULL;
+	GError *tmp_error = NULL;
+
+	g_assert (cid != NULL);
+
+	df = g_key_file_new ();
+	g_key_file_load_from_data (df,
+				   data,
+				   -1,
+				   G_KEY_FILE_KEEP_TRANSLATIONS,
+				   &tmp_error);
+	if (tmp_error != NULL) {
+		g_propagate_error (error, tmp_error);
+		return NULL;
+	}
+
+	values = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	if (g_key_file_has_group (df, DESKTOP_GROUP)) {
+		g_auto(GStrv) key_strv = NULL;
+		guint i;
+
+		keys = g_ptr_array_new ();
+		key_strv = g_key_file_get_keys (df, DESKTOP_GROUP, NULL, NULL);
+		for (i = 0; key_strv[i] != NULL; i++) {
+			gchar *key = g_strstrip (key_strv[i]);
+			gchar *stored_key;
+			gchar *val;
+
+			val = g_key_file_get_string (df, DESKTOP_GROUP, key, NULL);
+			if (val == NULL)
+				continue;
+
+			/* duplicate keys all have the value of the last one */
+			if (!g_hash_table_lookup_extended (values, key, (gpointer*) &stored_key, NULL)) {
+				stored_key = g_strdup (key);
+				g_hash_table_insert (values, stored_key, val);
+			} else {
+				g_free (val);
+			}
+			g_ptr_array_add (keys, stored_key);
+		}
+	}
+
+	return as_desktop_entry_create_component (keys, values, cid, fversion, locale, error);
+}
+
+/**
+ * as_desktop_entry_is_key_name:
+ *
+ * Check if @key is a valid key name, using the same rules as #GKeyFile.
+ */
+static gboolean
+as_desktop_entry_is_key_name (const gchar *key, gsize len)
+{
+	const gchar *end = key + len;
+	const gchar *q = key;
+
+	while ((q < end) && (*q != '=') && (*q != '[') && (*q != ']'))
+		q++;
+
+	/* no empty keys, and no leading or trailing spaces */
+	if (q == key)
+		return FALSE;
+	if ((key[0] == ' ') || (q[-1] == ' '))
+		return FALSE;
+
+	if ((q < end) && (*q == '[')) {
+		q++;
+		while ((q < end) && (g_ascii_isalnum (*q) || *q == '-' || *q == '_' || *q == '.' || *q == '@'))
+			q++;
+		if ((q >= end) || (*q != ']'))
+			return FALSE;
+		q++;
+	}
+
+	return q == end;
+}
+
+/**
+ * as_desktop_entry_unescape:
+ *
+ * Unescape a value like g_key_file_get_string() does.
+ *
+ * Returns: (transfer full): the value, or %NULL if it can not be
+ * handled by us.
+ */
+static gchar*
+as_desktop_entry_unescape (const gchar *value, gsize len)
+{
+	gchar *res;
+	gchar *q;
+	gsize i;
+
+	if (!g_utf8_validate (value, len, NULL))
+		return NULL;
+	if (memchr (value, '\\', len) == NULL)
+		return g_strndup (value, len);
+
+	res = g_malloc (len + 1);
+	q = res;
+	for (i = 0; i < len; i++) {
+		if (value[i] != '\\') {
+			*q++ = value[i];
+			continue;
+		}
+
+		i++;
+		if (i >= len)
+			goto fail;
+		switch (value[i]) {
+		case 's':
+			*q++ = ' ';
+			break;
+		case 'n':
+			*q++ = '\n';
+			break;
+		case 't':
+			*q++ = '\t';
+			break;
+		case 'r':
+			*q++ = '\r';
+			break;
+		case '\\':
+			*q++ = '\\';
+			break;
+		default:
+			/* GKeyFile rejects the whole value */
+			goto fail;
+		}
+	}
+	*q = '\0';
+	return res;
+
+fail:
+	g_free (res);
+	return NULL;
+}
+
+/**
+ * as_desktop_entry_scan_group:
+ * @keys: (out): the keys of the group, or %NULL if there is no [Desktop Entry] group.
+ * @values: table to store the values in.
+ *
+ * Read the keys we need from the [Desktop Entry] group, in a single pass
+ * over the data and without looking at any other group.
+ *
+ * Returns: %FALSE if the data contains anything we can not handle, in which
+ * case it should be parsed by #GKeyFile.
+ */
+static gboolean
+as_desktop_entry_scan_group (const gchar *data,
+			     const gchar *locale,
+			     GPtrArray **keys,
+			     GHashTable *values)
+{
+	const gchar *line = data;
+	gboolean seen_group = FALSE;
+
+	*keys = NULL;
+	while (*line != '\0') {
+		const gchar *line_end;
+		const gchar *key_end;
+		const gchar *value;
+		gsize line_len;
+		gsize key_len;
+
+		line_end = strchr (line, '\n');
+		if (line_end == NULL)
+			line_end = line + strlen (line);
+		line_len = line_end - line;
+		if ((line_len > 0) && (line[line_len - 1] == '\r'))
+			line_len--;
+
+		/* skip leading whitespace */
+		while ((line_len > 0) && g_ascii_isspace (*line)) {
+			line++;
+			line_len--;
+		}
+
+		if ((line_len == 0) || (line[0] == '#')) {
+			/* empty line or comment */
+		} else if (line[0] == '[') {
+			const gchar *group_end;
+			const gchar *p;
+
+			/* we only read the first group, and it has to be [Desktop Entry] */
+			if (seen_group)
+				break;
+			seen_group = TRUE;
+
+			group_end = memchr (line, ']', line_len);
+			if (group_end == NULL)
+				return FALSE;
+			for (p = group_end + 1; p < line + line_len; p++) {
+				if ((*p != ' ') && (*p != '\t'))
+					return FALSE;
+			}
+
+			/* the spec requires [Desktop Entry] to be the first group, let GKeyFile find it otherwise */
+			if (((gsize) (group_end - line - 1) != strlen (DESKTOP_GROUP)) ||
+			    (strncmp (line + 1, DESKTOP_GROUP, group_end - line - 1) != 0))
+				return FALSE;
+			*keys = g_ptr_array_new ();
+		} else {
+			key_end = memchr (line, '=', line_len);
+			if ((key_end == NULL) || (key_end == line) || !seen_group)
+				return FALSE;
+
+			key_len = key_end - line;
+			while ((key_len > 0) && g_ascii_isspace (line[key_len - 1]))
+				key_len--;
+			if (!as_desktop_entry_is_key_name (line, key_len))
+				return FALSE;
+
+			if (as_desktop_entry_key_wanted (line, key_len)) {
+				g_autofree gchar *key = g_strndup (line, key_len);
+				g_autofree gchar *key_locale = as_get_locale_from_key (key);
+
+				/* only store the translations we actually need */
+				if ((key_locale != NULL) && as_desktop_entry_locale_wanted (locale, key_locale)) {
+					gchar *stored_key;
+					gchar *val;
+
+					value = key_end + 1;
+					while ((value < line + line_len) && g_ascii_isspace (*value))
+						value++;
+					val = as_desktop_entry_unescape (value, line + line_len - value);
+					if (val == NULL)
+						return FALSE;
+
+					/* later values override earlier ones, like with GKeyFile */
+					if (!g_hash_table_lookup_extended (values, key, (gpointer*) &stored_key, NULL))
+						stored_key = key;
+					g_hash_table_insert (values, g_steal_pointer (&key), val);
+					g_ptr_array_add (*keys, stored_key);
+				}
+			}
+		}
+
+		if (*line_end == '\0')
+			break;
+		line = line_end + 1;
+	}
+
+	return TRUE;
+}
+
+/**
+ * as_desktop_entry_parse_data:
+ * @data: the desktop-entry data.
+ * @cid: the component-ID for the new component.
+ * @fversion: the AppStream format version to use.
+ * @locale: (nullable): the locale to read, or %NULL to read all of them.
+ * @error: a #GError
+ *
+ * Create a component from desktop-entry data. Only the [Desktop Entry]
+ * group is read, in a single pass, and only the translations for @locale
+ * are kept. Data we can not handle ourselves is passed to #GKeyFile.
+ */
+AsComponent*
+as_desktop_entry_parse_data (const gchar *data,
+			     const gchar *cid,
+			     AsFormatVersion fversion,
+			     const gchar *locale,
+			     GError **error)
+{
+	g_autoptr(GPtrArray) keys = NULL;
+	g_autoptr(GHashTable) values = NULL;
+
+	g_assert (cid != NULL);
+
+	values = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	if (!as_desktop_entry_scan_group (data, locale, &keys, values)) {
+		/* let GKeyFile deal with the odd cases, and report errors */
+		return as_desktop_entry_parse_data_keyfile (data, cid, fversion, locale, error);
+	}
+
+	return as_desktop_entry_create_component (keys, values, cid, fversion, locale, error);
+}
+
 /**
  * as_desktop_entry_parse_file:
  *
@@ -358,5 +685,6 @@ as_desktop_entry_parse_file (GFile *file, AsFormatVersion fversion, GError **err
 	return as_desktop_entry_parse_data (dedata->str,
 					    file_basename,
 					    fversion,
+					    NULL,
 					    error);
 }
@@ -25,14 +25,23 @@
 
 #include "as-component.h"
 #include "as-metadata.h"
+#include "as-settings-private.h"
 
 G_BEGIN_DECLS
 #pragma GCC visibility push(hidden)
 
+AS_INTERNAL_VISIBLE
 AsComponent	*as_desktop_entry_parse_data (const gchar *data,
 					      const gchar *cid,
 					      AsFormatVersion fversion,
+					      const gchar *locale,
 					      GError **error);
+AS_INTERNAL_VISIBLE
+AsComponent	*as_desktop_entry_parse_data_keyfile (const gchar *data,
+						      const gchar *cid,
+						      AsFormatVersion fversion,
+						      const gchar *locale,
+						      GError **error);
 
 AsComponent	*as_desktop_entry_parse_file (GFile *file,
 					      AsFormatVersion fversion,
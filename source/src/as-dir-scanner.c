@@ -0,0 +1,367 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:as-dir-scanner
+ * @short_description: Fast scanner for metadata directories
+ * @include: appstream.h
+ *
+ * Lists the files in a directory tree, using the file type the kernel
+ * reports with each directory entry, so no file needs to be stat'ed
+ * unless its metadata was explicitly requested. Paths are only allocated
+ * for files matching the pattern.
+ * This is a private/internal API.
+ */
+
+#include "config.h"
+#include "as-dir-scanner.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <gio/gio.h>
+
+/* a recursive scan only uses worker threads if there are at least this many subdirectories */
+#define AS_DIR_SCANNER_PARALLEL_MIN	8
+
+typedef struct {
+	gchar		*path;
+	const gchar	*pattern;
+	AsDirScanFlags	flags;
+	GPtrArray	*result;
+	GError		*error;
+} AsDirScanJob;
+
+/**
+ * as_scanned_file_free:
+ * @sfile: an #AsScannedFile
+ *
+ * Free a scanned file entry.
+ */
+void
+as_scanned_file_free (AsScannedFile *sfile)
+{
+	if (sfile == NULL)
+		return;
+	g_free (sfile->path);
+	g_slice_free (AsScannedFile, sfile);
+}
+
+/**
+ * as_dir_scanner_match:
+ * @pattern: a glob-style pattern, supporting "*" and "?"
+ * @name: the filename to test
+ *
+ * Match @name against @pattern, with the same semantics as
+ * g_pattern_match_simple(), but without compiling the pattern.
+ * An empty or %NULL pattern matches everything.
+ *
+ * Returns: %TRUE if @name matches.
+ */
+gboolean
+as_dir_scanner_match (const gchar *pattern, const gchar *name)
+{
+	const gchar *p_star = NULL;
+	const gchar *n_star = NULL;
+
+	if ((pattern == NULL) || (pattern[0] == '\0'))
+		return TRUE;
+
+	while (*name != '\0') {
+		if (*pattern == '*') {
+			/* remember the position, so we can backtrack to here */
+			p_star = ++pattern;
+			n_star = name;
+		} else if ((*pattern == '?') || (*pattern == *name)) {
+			pattern++;
+			name++;
+		} else if (p_star != NULL) {
+			/* let the last star consume one more character */
+			pattern = p_star;
+			name = ++n_star;
+		} else {
+			return FALSE;
+		}
+	}
+
+	while (*pattern == '*')
+		pattern++;
+	return *pattern == '\0';
+}
+
+/**
+ * as_dir_scanner_set_error:
+ */
+static void
+as_dir_scanner_set_error (GError **error, const gchar *path, gint err_no)
+{
+	g_set_error (error,
+		     G_IO_ERROR,
+		     g_io_error_from_errno (err_no),
+		     "Unable to scan '%s': %s",
+		     path, g_strerror (err_no));
+}
+
+/**
+ * as_dir_scanner_scan_fd:
+ * @dfd: the directory file descriptor, which is consumed.
+ * @path: the path of the directory, used as scratch buffer for entry paths.
+ * @subdirs: (nullable): collect subdirectories here instead of descending into them.
+ *
+ * Scan an opened directory.
+ */
+static gboolean
+as_dir_scanner_scan_fd (gint dfd,
+			GString *path,
+			const gchar *pattern,
+			AsDirScanFlags flags,
+			GPtrArray *result,
+			GPtrArray *subdirs,
+			GError **error)
+{
+	DIR *dir;
+	struct dirent *de;
+	gsize path_len = path->len;
+	gboolean ret = TRUE;
+
+	dir = fdopendir (dfd);
+	if (dir == NULL) {
+		as_dir_scanner_set_error (error, path->str, errno);
+		close (dfd);
+		return FALSE;
+	}
+
+	while (TRUE) {
+		AsScannedFile *sfile;
+		struct stat st;
+		gboolean have_stat = FALSE;
+		guchar type;
+
+		errno = 0;
+		de = readdir (dir);
+		if (de == NULL) {
+			if (errno != 0) {
+				as_dir_scanner_set_error (error, path->str, errno);
+				ret = FALSE;
+			}
+			break;
+		}
+
+		/* skip hidden files, as well as "." and ".." */
+		if (de->d_name[0] == '.')
+			continue;
+
+		type = de->d_type;
+		if ((type == DT_UNKNOWN) || (type == DT_LNK) || (flags & AS_DIR_SCAN_FLAG_WITH_STAT)) {
+			/* the filesystem didn't tell us, or we need the metadata anyway */
+			if (fstatat (dirfd (dir), de->d_name, &st, 0) == 0) {
+				have_stat = TRUE;
+				if (S_ISDIR (st.st_mode))
+					type = DT_DIR;
+				else if (S_ISREG (st.st_mode))
+					type = DT_REG;
+			}
+		}
+
+		g_string_truncate (path, path_len);
+		g_string_append_c (path, '/');
+		g_string_append (path, de->d_name);
+
+		if ((type == DT_DIR) && (flags & AS_DIR_SCAN_FLAG_RECURSIVE)) {
+			gint fd;
+
+			if (subdirs != NULL) {
+				g_ptr_array_add (subdirs, g_strndup (path->str, path->len));
+				continue;
+			}
+
+			fd = openat (dirfd (dir), de->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if (fd < 0) {
+				as_dir_scanner_set_error (error, path->str, errno);
+				ret = FALSE;
+				break;
+			}
+			if (!as_dir_scanner_scan_fd (fd, path, pattern, flags, result, NULL, error)) {
+				ret = FALSE;
+				break;
+			}
+			continue;
+		}
+
+		if (!as_dir_scanner_match (pattern, de->d_name))
+			continue;
+
+		sfile = g_slice_new0 (AsScannedFile);
+		sfile->path = g_strndup (path->str, path->len);
+		if (have_stat) {
+			sfile->mtime = st.st_mtime;
+			sfile->ctime_ns = (gint64) st.st_ctim.tv_sec * G_GINT64_CONSTANT (1000000000) + st.st_ctim.tv_nsec;
+			sfile->size = st.st_size;
+			sfile->inode = st.st_ino;
+		} else {
+			sfile->inode = de->d_ino;
+		}
+		g_ptr_array_add (result, sfile);
+	}
+
+	g_string_truncate (path, path_len);
+	closedir (dir);
+	return ret;
+}
+
+/**
+ * as_dir_scanner_scan_path:
+ *
+ * Scan the directory at @dir.
+ */
+static gboolean
+as_dir_scanner_scan_path (const gchar *dir,
+			  const gchar *pattern,
+			  AsDirScanFlags flags,
+			  GPtrArray *result,
+			  GPtrArray *subdirs,
+			  GError **error)
+{
+	g_autoptr(GString) path = NULL;
+	gint fd;
+
+	/* we add the separator ourselves */
+	path = g_string_new (dir);
+	while ((path->len > 1) && (path->str[path->len - 1] == '/'))
+		g_string_truncate (path, path->len - 1);
+	if (g_strcmp0 (path->str, "/") == 0)
+		g_string_truncate (path, 0);
+
+	fd = open (dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		as_dir_scanner_set_error (error, dir, errno);
+		return FALSE;
+	}
+
+	return as_dir_scanner_scan_fd (fd, path, pattern, flags, result, subdirs, error);
+}
+
+/**
+ * as_dir_scanner_job_run:
+ *
+ * Scan a subdirectory in a worker thread.
+ */
+static void
+as_dir_scanner_job_run (gpointer data, gpointer user_data)
+{
+	AsDirScanJob *job = (AsDirScanJob*) data;
+
+	as_dir_scanner_scan_path (job->path,
+				  job->pattern,
+				  job->flags,
+				  job->result,
+				  NULL,
+				  &job->error);
+}
+
+/**
+ * as_dir_scanner_scan:
+ * @dir: the directory to scan.
+ * @pattern: (nullable): a glob-style pattern the filenames must match.
+ * @flags: #AsDirScanFlags
+ * @error: a #GError
+ *
+ * Find all files in @dir whose name matches @pattern. Hidden files (whose
+ * name starts with a dot) are ignored.
+ * Without %AS_DIR_SCAN_FLAG_RECURSIVE, matching subdirectories are returned as well.
+ * Modification time and size are only set if %AS_DIR_SCAN_FLAG_WITH_STAT is passed.
+ *
+ * Returns: (transfer container) (element-type AsScannedFile): the files found, or %NULL on error.
+ */
+GPtrArray*
+as_dir_scanner_scan (const gchar *dir, const gchar *pattern, AsDirScanFlags flags, GError **error)
+{
+	GPtrArray *result;
+	g_autoptr(GPtrArray) subdirs = NULL;
+	g_autofree AsDirScanJob *jobs = NULL;
+	GThreadPool *tpool;
+	GError *tmp_error = NULL;
+	guint i;
+
+	g_return_val_if_fail (dir != NULL, NULL);
+
+	result = g_ptr_array_new_with_free_func ((GDestroyNotify) as_scanned_file_free);
+	if ((flags & AS_DIR_SCAN_FLAG_RECURSIVE) && (flags & AS_DIR_SCAN_FLAG_PARALLEL))
+		subdirs = g_ptr_array_new_with_free_func (g_free);
+
+	if (!as_dir_scanner_scan_path (dir, pattern, flags, result, subdirs, error)) {
+		g_ptr_array_unref (result);
+		return NULL;
+	}
+	if ((subdirs == NULL) || (subdirs->len == 0))
+		return result;
+
+	/* starting threads costs more than scanning a few small directories */
+	if (subdirs->len < AS_DIR_SCANNER_PARALLEL_MIN) {
+		for (i = 0; i < subdirs->len; i++) {
+			if (!as_dir_scanner_scan_path (g_ptr_array_index (subdirs, i), pattern, flags, result, NULL, error)) {
+				g_ptr_array_unref (result);
+				return NULL;
+			}
+		}
+		return result;
+	}
+
+	/* scan the subdirectories in parallel, each one into its own array to keep the order stable */
+	jobs = g_new0 (AsDirScanJob, subdirs->len);
+	tpool = g_thread_pool_new (as_dir_scanner_job_run,
+				   NULL,
+				   MIN (g_get_num_processors (), subdirs->len),
+				   FALSE,
+				   NULL);
+	for (i = 0; i < subdirs->len; i++) {
+		jobs[i].path = (gchar*) g_ptr_array_index (subdirs, i);
+		jobs[i].pattern = pattern;
+		jobs[i].flags = flags;
+		jobs[i].result = g_ptr_array_new_with_free_func ((GDestroyNotify) as_scanned_file_free);
+		g_thread_pool_push (tpool, &jobs[i], NULL);
+	}
+	g_thread_pool_free (tpool, FALSE, TRUE);
+
+	for (i = 0; i < subdirs->len; i++) {
+		guint j;
+
+		if ((jobs[i].error != NULL) && (tmp_error == NULL))
+			tmp_error = g_steal_pointer (&jobs[i].error);
+		g_clear_error (&jobs[i].error);
+
+		/* move the entries over */
+		for (j = 0; j < jobs[i].result->len; j++)
+			g_ptr_array_add (result, g_ptr_array_index (jobs[i].result, j));
+		g_ptr_array_set_free_func (jobs[i].result, NULL);
+		g_ptr_array_unref (jobs[i].result);
+	}
+
+	if (tmp_error != NULL) {
+		g_propagate_error (error, tmp_error);
+		g_ptr_array_unref (result);
+		return NULL;
+	}
+
+	return result;
+}
@@ -0,0 +1,82 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_DIR_SCANNER_H
+#define __AS_DIR_SCANNER_H
+
+#include <glib.h>
+#include "as-settings-private.h"
+
+G_BEGIN_DECLS
+#pragma GCC visibility push(hidden)
+
+/**
+ * AsDirScanFlags:
+ * @AS_DIR_SCAN_FLAG_NONE:		No flags.
+ * @AS_DIR_SCAN_FLAG_RECURSIVE:		Descend into subdirectories.
+ * @AS_DIR_SCAN_FLAG_PARALLEL:		Scan the subdirectories of a recursive scan in parallel, if there are enough of them.
+ * @AS_DIR_SCAN_FLAG_WITH_STAT:		Fill in modification time and size of every file.
+ *
+ * Flags for as_dir_scanner_scan().
+ **/
+typedef enum {
+	AS_DIR_SCAN_FLAG_NONE		= 0,
+	AS_DIR_SCAN_FLAG_RECURSIVE	= 1 << 0,
+	AS_DIR_SCAN_FLAG_PARALLEL	= 1 << 1,
+	AS_DIR_SCAN_FLAG_WITH_STAT	= 1 << 2,
+} AsDirScanFlags;
+
+/**
+ * AsScannedFile:
+ * @path:	Full path of the file.
+ * @mtime:	Modification time in seconds since the epoch, if stat data was requested.
+ * @ctime_ns:	Status change time in nanoseconds since the epoch, if stat data was requested.
+ * @size:	Size of the file in bytes, if stat data was requested.
+ * @inode:	Inode number of the file.
+ *
+ * A file found by as_dir_scanner_scan().
+ **/
+typedef struct {
+	gchar	*path;
+	gint64	mtime;
+	gint64	ctime_ns;
+	guint64	size;
+	guint64	inode;
+} AsScannedFile;
+
+AS_INTERNAL_VISIBLE
+GPtrArray		*as_dir_scanner_scan (const gchar *dir,
+					      const gchar *pattern,
+					      AsDirScanFlags flags,
+					      GError **error);
+void			as_scanned_file_free (AsScannedFile *sfile);
+
+AS_INTERNAL_VISIBLE
+gboolean		as_dir_scanner_match (const gchar *pattern,
+					      const gchar *name);
+
+#pragma GCC visibility pop
+G_END_DECLS
+
+#endif /* __AS_DIR_SCANNER_H */
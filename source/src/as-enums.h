@@ -85,6 +85,30 @@ typedef enum {
 const gchar	*as_urgency_kind_to_string (AsUrgencyKind urgency_kind);
 AsUrgencyKind	 as_urgency_kind_from_string (const gchar *urgency_kind);
 
+/**
+ * AsLoadProfile:
+ * @AS_LOAD_PROFILE_MINIMAL:		Only load the basic component data: IDs, names, summaries, icons, categories, packages, bundles, launchables, provided items and URLs.
+ * @AS_LOAD_PROFILE_WITH_SEARCH:	Load long descriptions and keywords, which are needed for full-text searches.
+ * @AS_LOAD_PROFILE_WITH_MEDIA:		Load screenshots.
+ * @AS_LOAD_PROFILE_WITH_DETAILS:	Load releases, content ratings, relations, suggestions, translation and language information and custom data.
+ * @AS_LOAD_PROFILE_FULL:		Load all data.
+ *
+ * The parts of the component data which should be loaded from
+ * metadata. Data which is not part of the profile is skipped
+ * entirely by the parsers.
+ *
+ * Since: 0.12.1
+ **/
+typedef enum {
+	AS_LOAD_PROFILE_MINIMAL		= 0,
+	AS_LOAD_PROFILE_WITH_SEARCH	= 1 << 0,
+	AS_LOAD_PROFILE_WITH_MEDIA	= 1 << 1,
+	AS_LOAD_PROFILE_WITH_DETAILS	= 1 << 2,
+	AS_LOAD_PROFILE_FULL		= AS_LOAD_PROFILE_WITH_SEARCH |
+					  AS_LOAD_PROFILE_WITH_MEDIA |
+					  AS_LOAD_PROFILE_WITH_DETAILS
+} AsLoadProfile;
+
 G_END_DECLS
 
 #endif /* __AS_ENUMS_H */
@@ -0,0 +1,805 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:as-file-reader
+ * @short_description: Pipelined reader for metadata files
+ * @include: appstream.h
+ *
+ * Reads (and decompresses, if necessary) a metadata file in a separate
+ * thread, and hands the data to the parser in chunks as soon as they become
+ * available. This way, I/O and decompression overlap with parsing, and
+ * a new reader can already be started for the next file while the current
+ * one is still being parsed.
+ *
+ * The reader thread and the parser share a small ring of buffers, so memory
+ * usage is bounded no matter how large the file is.
+ *
+ * Uncompressed local files up to a few megabytes do not need a reader thread,
+ * they are read with a single read() call and parsed in place. Larger ones
+ * go through the reader thread as well. Files are never mapped into memory,
+ * as a package update truncating a mapped file while we parse it would crash
+ * us with SIGBUS. Compression is detected from the magic bytes of the file,
+ * so no content-type sniffing via GIO is needed.
+ *
+ * Many small files can be read at once with an #AsFileBatch.
+ * This is a private/internal API.
+ */
+
+#include "config.h"
+#include "as-file-reader.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <gio/gunixinputstream.h>
+
+/* size of an individual buffer */
+#define AS_FILE_READER_CHUNK_SIZE	(64 * 1024)
+/* number of buffers in the ring */
+#define AS_FILE_READER_N_CHUNKS		4
+/* uncompressed files larger than this are read in chunks by the reader thread */
+#define AS_FILE_READER_READ_MAX		(8 * 1024 * 1024)
+/* maximum number of files a batch reads ahead of the parser */
+#define AS_FILE_BATCH_WINDOW		64
+
+typedef enum {
+	AS_FILE_COMPRESSION_UNKNOWN,
+	AS_FILE_COMPRESSION_NONE,
+	AS_FILE_COMPRESSION_GZIP,
+	AS_FILE_COMPRESSION_ZSTD
+} AsFileCompression;
+
+typedef struct {
+	gchar	*data;
+	gsize	len;
+} AsReaderChunk;
+
+struct _AsFileReader {
+	GFile		*file; /* only set for non-local files */
+	gchar		*basename;
+	AsFileCompression compression;
+
+	/* uncompressed local data, which is completely in memory */
+	gchar		*buffer;
+	AsReaderChunk	memchunk;
+
+	/* pipeline for compressed and non-local data */
+	GInputStream	*stream;
+	GThread		*thread;
+	GAsyncQueue	*filled; /* of AsReaderChunk, for the parser */
+	GAsyncQueue	*empty; /* of AsReaderChunk, for the reader thread */
+	AsReaderChunk	chunks[AS_FILE_READER_N_CHUNKS];
+	AsReaderChunk	eos; /* marks the end of the data */
+	gint		cancelled; /* atomic */
+	GError		*error; /* set by the reader thread before it pushes EOS */
+
+	/* parser state */
+	AsReaderChunk	*pending;
+	AsReaderChunk	*current;
+	gsize		current_pos;
+	gboolean	eof;
+};
+
+struct _AsFileBatch {
+	GPtrArray	*fnames;
+	AsFileReader	**readers;
+	gboolean	*done;
+	GThreadPool	*tpool;
+	GMutex		mutex;
+	GCond		cond;
+
+	/* only used by the consumer */
+	guint		next_job;
+	guint		pos;
+};
+
+/**
+ * as_file_reader_detect_compression:
+ *
+ * Detect the compression of a file from its magic bytes.
+ */
+static AsFileCompression
+as_file_reader_detect_compression (const guint8 *magic, gsize len)
+{
+	if ((len >= 2) && (magic[0] == 0x1f) && (magic[1] == 0x8b))
+		return AS_FILE_COMPRESSION_GZIP;
+	if ((len >= 4) && (magic[0] == 0x28) && (magic[1] == 0xb5) && (magic[2] == 0x2f) && (magic[3] == 0xfd))
+		return AS_FILE_COMPRESSION_ZSTD;
+	return AS_FILE_COMPRESSION_NONE;
+}
+
+/**
+ * as_file_reader_set_zstd_error:
+ */
+static void
+as_file_reader_set_zstd_error (GError **error, const gchar *basename)
+{
+	g_set_error (error,
+		     G_IO_ERROR,
+		     G_IO_ERROR_NOT_SUPPORTED,
+		     "Unable to read '%s': Zstandard-compressed metadata is not supported.",
+		     basename);
+}
+
+/**
+ * as_file_reader_thread:
+ *
+ * Read and decompress the file, filling the buffer ring.
+ */
+static gpointer
+as_file_reader_thread (gpointer user_data)
+{
+	AsFileReader *reader = (AsFileReader*) user_data;
+	g_autoptr(GInputStream) stream_data = NULL;
+	GError *tmp_error = NULL;
+
+	if (reader->stream == NULL) {
+		/* non-local file, open it here so this doesn't block the parser */
+		reader->stream = G_INPUT_STREAM (g_file_read (reader->file, NULL, &tmp_error));
+		if (reader->stream == NULL)
+			goto out;
+	}
+
+	if (reader->compression == AS_FILE_COMPRESSION_UNKNOWN) {
+		GInputStream *buffered;
+		const guint8 *magic;
+		gsize magic_len;
+
+		/* check the magic bytes */
+		buffered = g_buffered_input_stream_new (reader->stream);
+		g_object_unref (reader->stream);
+		reader->stream = buffered;
+
+		if (g_buffered_input_stream_fill (G_BUFFERED_INPUT_STREAM (buffered), 4, NULL, &tmp_error) < 0)
+			goto out;
+		magic = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM (buffered), &magic_len);
+		reader->compression = as_file_reader_detect_compression (magic, magic_len);
+	}
+
+	if (reader->compression == AS_FILE_COMPRESSION_GZIP) {
+		g_autoptr(GConverter) conv = NULL;
+
+		/* decompress the GZip stream */
+		conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+		stream_data = g_converter_input_stream_new (reader->stream, conv);
+	} else if (reader->compression == AS_FILE_COMPRESSION_ZSTD) {
+		as_file_reader_set_zstd_error (&tmp_error, reader->basename);
+		goto out;
+	} else {
+		stream_data = g_object_ref (reader->stream);
+	}
+
+	while (!g_atomic_int_get (&reader->cancelled)) {
+		AsReaderChunk *chunk;
+		gssize len = 0;
+
+		chunk = g_async_queue_pop (reader->empty);
+		if (chunk->data == NULL)
+			chunk->data = g_malloc (AS_FILE_READER_CHUNK_SIZE);
+
+		/* fill the whole buffer, so the parser gets large blocks of data */
+		chunk->len = 0;
+		while (chunk->len < AS_FILE_READER_CHUNK_SIZE) {
+			len = g_input_stream_read (stream_data,
+						   chunk->data + chunk->len,
+						   AS_FILE_READER_CHUNK_SIZE - chunk->len,
+						   NULL,
+						   &tmp_error);
+			if (len <= 0)
+				break;
+			chunk->len += len;
+		}
+
+		if (chunk->len > 0)
+			g_async_queue_push (reader->filled, chunk);
+		else
+			g_async_queue_push (reader->empty, chunk);
+
+		/* end of file, or error */
+		if (len <= 0)
+			break;
+	}
+
+out:
+	reader->error = tmp_error;
+	g_async_queue_push (reader->filled, &reader->eos);
+	return NULL;
+}
+
+/**
+ * as_file_reader_start_thread:
+ *
+ * Start reading the data in the background.
+ */
+static void
+as_file_reader_start_thread (AsFileReader *reader)
+{
+	guint i;
+
+	reader->filled = g_async_queue_new ();
+	reader->empty = g_async_queue_new ();
+	for (i = 0; i < AS_FILE_READER_N_CHUNKS; i++)
+		g_async_queue_push (reader->empty, &reader->chunks[i]);
+
+	reader->thread = g_thread_new ("as-file-reader", as_file_reader_thread, reader);
+}
+
+/**
+ * as_file_reader_set_errno_error:
+ *
+ * Finish the reader with an error for @err_no, which
+ * will be reported once data is requested.
+ */
+static void
+as_file_reader_set_errno_error (AsFileReader *reader, const gchar *fname, gint err_no)
+{
+	g_set_error (&reader->error,
+		     G_IO_ERROR,
+		     g_io_error_from_errno (err_no),
+		     "Unable to read '%s': %s",
+		     fname, g_strerror (err_no));
+	reader->eof = TRUE;
+}
+
+/**
+ * as_file_reader_new_for_path:
+ * @fname: the local file to read.
+ *
+ * Read a local file. Uncompressed data is made available
+ * directly, compressed data is decompressed in the background.
+ * Errors are reported once the data is requested.
+ *
+ * Returns: (transfer full): a new #AsFileReader
+ */
+AsFileReader*
+as_file_reader_new_for_path (const gchar *fname)
+{
+	AsFileReader *reader;
+	struct stat st;
+	guint8 magic[4];
+	gssize magic_len;
+	gsize len;
+	gint fd;
+
+	reader = g_new0 (AsFileReader, 1);
+	reader->basename = g_path_get_basename (fname);
+
+	fd = open (fname, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		as_file_reader_set_errno_error (reader, fname, errno);
+		return reader;
+	}
+	if (fstat (fd, &st) != 0) {
+		as_file_reader_set_errno_error (reader, fname, errno);
+		close (fd);
+		return reader;
+	}
+	if (!S_ISREG (st.st_mode)) {
+		as_file_reader_set_errno_error (reader, fname, S_ISDIR (st.st_mode)? EISDIR : EINVAL);
+		close (fd);
+		return reader;
+	}
+
+	magic_len = pread (fd, magic, sizeof (magic), 0);
+	if (magic_len < 0) {
+		as_file_reader_set_errno_error (reader, fname, errno);
+		close (fd);
+		return reader;
+	}
+	reader->compression = as_file_reader_detect_compression (magic, magic_len);
+
+	if (reader->compression == AS_FILE_COMPRESSION_GZIP || st.st_size > AS_FILE_READER_READ_MAX) {
+		/* the thread takes ownership of the file descriptor */
+		reader->stream = g_unix_input_stream_new (fd, TRUE);
+		as_file_reader_start_thread (reader);
+		return reader;
+	}
+	if (reader->compression == AS_FILE_COMPRESSION_ZSTD) {
+		as_file_reader_set_zstd_error (&reader->error, reader->basename);
+		reader->eof = TRUE;
+		close (fd);
+		return reader;
+	}
+
+	/* uncompressed data is parsed directly from memory */
+	reader->eof = TRUE;
+	if (st.st_size == 0) {
+		close (fd);
+		return reader;
+	}
+
+	/* read the whole file at once, it might have been truncated since we checked its size */
+	reader->buffer = g_malloc (st.st_size + 1);
+	len = 0;
+	while (len < (gsize) st.st_size) {
+		gssize res = read (fd, reader->buffer + len, st.st_size - len);
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+			as_file_reader_set_errno_error (reader, fname, errno);
+			close (fd);
+			return reader;
+		}
+		if (res == 0)
+			break;
+		len += res;
+	}
+	reader->buffer[len] = '\0';
+
+	reader->memchunk.data = reader->buffer;
+	reader->memchunk.len = len;
+	close (fd);
+
+	reader->pending = &reader->memchunk;
+	return reader;
+}
+
+/**
+ * as_file_reader_new:
+ * @file: the #GFile to read.
+ *
+ * Start reading @file. Local files take the same fast path as
+ * with as_file_reader_new_for_path(), other files are read
+ * in the background.
+ * Errors are reported once the data is requested.
+ *
+ * Returns: (transfer full): a new #AsFileReader
+ */
+AsFileReader*
+as_file_reader_new (GFile *file)
+{
+	AsFileReader *reader;
+	g_autofree gchar *fname = NULL;
+
+	fname = g_file_get_path (file);
+	if (fname != NULL)
+		return as_file_reader_new_for_path (fname);
+
+	reader = g_new0 (AsFileReader, 1);
+	reader->file = g_object_ref (file);
+	reader->basename = g_file_get_basename (file);
+	as_file_reader_start_thread (reader);
+
+	return reader;
+}
+
+/**
+ * as_file_reader_release_current:
+ *
+ * Hand the buffers the parser is done with back to the reader thread.
+ */
+static void
+as_file_reader_release_current (AsFileReader *reader)
+{
+	if (reader->current == NULL)
+		return;
+
+	if (reader->current != &reader->memchunk)
+		g_async_queue_push (reader->empty, reader->current);
+	reader->current = NULL;
+}
+
+/**
+ * as_file_reader_free:
+ * @reader: an #AsFileReader
+ *
+ * Stop the reader thread and free all resources.
+ */
+void
+as_file_reader_free (AsFileReader *reader)
+{
+	guint i;
+
+	if (reader == NULL)
+		return;
+
+	if (reader->thread != NULL) {
+		/* stop reading, and drain the ring so the thread can finish */
+		g_atomic_int_set (&reader->cancelled, TRUE);
+		as_file_reader_release_current (reader);
+		if (reader->pending != NULL) {
+			g_async_queue_push (reader->empty, reader->pending);
+			reader->pending = NULL;
+		}
+		while (!reader->eof) {
+			AsReaderChunk *chunk = g_async_queue_pop (reader->filled);
+			if (chunk == &reader->eos)
+				reader->eof = TRUE;
+			else
+				g_async_queue_push (reader->empty, chunk);
+		}
+		g_thread_join (reader->thread);
+
+		for (i = 0; i < AS_FILE_READER_N_CHUNKS; i++)
+			g_free (reader->chunks[i].data);
+		g_async_queue_unref (reader->filled);
+		g_async_queue_unref (reader->empty);
+	}
+	g_clear_error (&reader->error);
+
+	if (reader->stream != NULL)
+		g_object_unref (reader->stream);
+	if (reader->file != NULL)
+		g_object_unref (reader->file);
+	g_free (reader->buffer);
+	g_free (reader->basename);
+	g_free (reader);
+}
+
+/**
+ * as_file_reader_get_basename:
+ * @reader: an #AsFileReader
+ *
+ * Returns: The basename of the file being read.
+ */
+const gchar*
+as_file_reader_get_basename (AsFileReader *reader)
+{
+	return reader->basename;
+}
+
+/**
+ * as_file_reader_pop:
+ *
+ * Wait for the next filled buffer.
+ *
+ * Returns: The next buffer, or %NULL at the end of the file.
+ */
+static AsReaderChunk*
+as_file_reader_pop (AsFileReader *reader)
+{
+	AsReaderChunk *chunk;
+
+	if (reader->pending != NULL) {
+		chunk = reader->pending;
+		reader->pending = NULL;
+		return chunk;
+	}
+
+	if (reader->eof)
+		return NULL;
+
+	chunk = g_async_queue_pop (reader->filled);
+	if (chunk == &reader->eos) {
+		reader->eof = TRUE;
+		return NULL;
+	}
+
+	return chunk;
+}
+
+/**
+ * as_file_reader_guess_format:
+ * @reader: an #AsFileReader
+ *
+ * Guess the format of the data from the file name, and
+ * if that is inconclusive, from the first bytes of the (decompressed) data.
+ * This will wait until the first data is available, but does not consume it.
+ *
+ * Returns: The #AsFormatKind of the data, %AS_FORMAT_KIND_XML if unsure.
+ */
+AsFormatKind
+as_file_reader_guess_format (AsFileReader *reader)
+{
+	const gchar *bname = reader->basename;
+	const gchar *data;
+	gsize i;
+
+	if (g_str_has_suffix (bname, ".desktop"))
+		return AS_FORMAT_KIND_DESKTOP_ENTRY;
+	if ((g_str_has_suffix (bname, ".yml.gz")) ||
+	    (g_str_has_suffix (bname, ".yaml.gz")) ||
+	    (g_str_has_suffix (bname, ".yml")) ||
+	    (g_str_has_suffix (bname, ".yaml")))
+		return AS_FORMAT_KIND_YAML;
+	if ((g_str_has_suffix (bname, ".xml.gz")) ||
+	    (g_str_has_suffix (bname, ".xml")))
+		return AS_FORMAT_KIND_XML;
+
+	/* peek at the data */
+	if ((reader->pending == NULL) && (reader->current == NULL))
+		reader->pending = as_file_reader_pop (reader);
+	if (reader->pending == NULL)
+		return AS_FORMAT_KIND_XML;
+
+	data = reader->pending->data;
+	i = 0;
+	/* skip an UTF-8 BOM and leading whitespace */
+	if ((reader->pending->len >= 3) && (memcmp (data, "\xef\xbb\xbf", 3) == 0))
+		i = 3;
+	while ((i < reader->pending->len) && g_ascii_isspace (data[i]))
+		i++;
+
+	if ((i < reader->pending->len) && (data[i] == '<'))
+		return AS_FORMAT_KIND_XML;
+	if ((reader->pending->len - i >= 3) && ((memcmp (data + i, "---", 3) == 0) || (memcmp (data + i, "%YA", 3) == 0)))
+		return AS_FORMAT_KIND_YAML;
+
+	return AS_FORMAT_KIND_XML;
+}
+
+/**
+ * as_file_reader_get_contents:
+ * @reader: an #AsFileReader
+ * @data: (out): the file contents.
+ * @len: (out): the length of @data.
+ *
+ * Get the complete file contents without any copying, if the
+ * file was read directly into memory and nothing was consumed yet.
+ * If this succeeds, the reader is at the end of the file afterwards.
+ * The data stays valid for the lifetime of the reader.
+ *
+ * Returns: %TRUE if the complete data was returned.
+ */
+gboolean
+as_file_reader_get_contents (AsFileReader *reader, const gchar **data, gsize *len)
+{
+	if (reader->pending != &reader->memchunk)
+		return FALSE;
+
+	reader->pending = NULL;
+	*data = reader->memchunk.data;
+	*len = reader->memchunk.len;
+	return TRUE;
+}
+
+/**
+ * as_file_reader_next:
+ * @reader: an #AsFileReader
+ * @data: (out): the data of the next chunk.
+ * @len: (out): the length of @data.
+ * @error: a #GError
+ *
+ * Get the next chunk of data. The data stays valid until the next
+ * call on this reader.
+ *
+ * Returns: %TRUE if data was returned, %FALSE at the end of the file or on error.
+ */
+gboolean
+as_file_reader_next (AsFileReader *reader, const gchar **data, gsize *len, GError **error)
+{
+	as_file_reader_release_current (reader);
+
+	reader->current = as_file_reader_pop (reader);
+	if (reader->current == NULL) {
+		if (reader->error != NULL) {
+			g_propagate_error (error, reader->error);
+			reader->error = NULL;
+		}
+		return FALSE;
+	}
+
+	/* the whole chunk is handed out */
+	reader->current_pos = reader->current->len;
+
+	*data = reader->current->data;
+	*len = reader->current->len;
+	return TRUE;
+}
+
+/**
+ * as_file_reader_read:
+ * @reader: an #AsFileReader
+ * @buffer: the buffer to fill.
+ * @count: the size of @buffer.
+ * @error: a #GError
+ *
+ * Copy up to @count bytes of data into @buffer.
+ *
+ * Returns: The number of bytes read, 0 at the end of the file, -1 on error.
+ */
+gssize
+as_file_reader_read (AsFileReader *reader, gchar *buffer, gsize count, GError **error)
+{
+	gsize n;
+
+	if ((reader->current == NULL) || (reader->current_pos >= reader->current->len)) {
+		const gchar *data;
+		gsize len;
+		GError *tmp_error = NULL;
+
+		if (!as_file_reader_next (reader, &data, &len, &tmp_error)) {
+			if (tmp_error != NULL) {
+				g_propagate_error (error, tmp_error);
+				return -1;
+			}
+			return 0;
+		}
+		reader->current_pos = 0;
+	}
+
+	n = MIN (count, reader->current->len - reader->current_pos);
+	memcpy (buffer, reader->current->data + reader->current_pos, n);
+	reader->current_pos += n;
+
+	return n;
+}
+
+/**
+ * as_file_reader_read_all:
+ * @reader: an #AsFileReader
+ * @error: a #GError
+ *
+ * Read all remaining data into memory.
+ *
+ * Returns: (transfer full): the data, or %NULL on error.
+ */
+gchar*
+as_file_reader_read_all (AsFileReader *reader, GError **error)
+{
+	GString *str;
+	const gchar *data;
+	gsize len;
+	GError *tmp_error = NULL;
+
+	/* small files already are in a NUL-terminated buffer that we can hand over */
+	if ((reader->buffer != NULL) && (reader->pending == &reader->memchunk)) {
+		gchar *buffer = reader->buffer;
+
+		reader->pending = NULL;
+		reader->buffer = NULL;
+		return buffer;
+	}
+
+	str = g_string_new ("");
+	while (as_file_reader_next (reader, &data, &len, &tmp_error))
+		g_string_append_len (str, data, len);
+
+	if (tmp_error != NULL) {
+		g_propagate_error (error, tmp_error);
+		g_string_free (str, TRUE);
+		return NULL;
+	}
+
+	return g_string_free (str, FALSE);
+}
+
+/**
+ * as_file_batch_job_run:
+ *
+ * Open and read a file of the batch in a worker thread.
+ */
+static void
+as_file_batch_job_run (gpointer data, gpointer user_data)
+{
+	AsFileBatch *batch = (AsFileBatch*) user_data;
+	guint idx = GPOINTER_TO_UINT (data) - 1;
+	AsFileReader *reader;
+
+	reader = as_file_reader_new_for_path ((const gchar*) g_ptr_array_index (batch->fnames, idx));
+
+	g_mutex_lock (&batch->mutex);
+	batch->readers[idx] = reader;
+	batch->done[idx] = TRUE;
+	g_cond_broadcast (&batch->cond);
+	g_mutex_unlock (&batch->mutex);
+}
+
+/**
+ * as_file_batch_queue_jobs:
+ *
+ * Keep the read-ahead window filled.
+ */
+static void
+as_file_batch_queue_jobs (AsFileBatch *batch)
+{
+	while ((batch->next_job < batch->fnames->len) &&
+	       (batch->next_job < batch->pos + AS_FILE_BATCH_WINDOW)) {
+		/* the index is offset by one, as NULL can not be pushed */
+		g_thread_pool_push (batch->tpool, GUINT_TO_POINTER (batch->next_job + 1), NULL);
+		batch->next_job++;
+	}
+}
+
+/**
+ * as_file_batch_new:
+ * @fnames: (element-type filename): the local files to read.
+ *
+ * Start reading a whole batch of small files, using a pool of threads
+ * so the latency of opening and reading the individual files overlaps.
+ * Only a limited number of files is read ahead of the consumer.
+ *
+ * Returns: (transfer full): a new #AsFileBatch
+ */
+AsFileBatch*
+as_file_batch_new (GPtrArray *fnames)
+{
+	AsFileBatch *batch;
+
+	batch = g_new0 (AsFileBatch, 1);
+	batch->fnames = g_ptr_array_ref (fnames);
+	batch->readers = g_new0 (AsFileReader*, fnames->len);
+	batch->done = g_new0 (gboolean, fnames->len);
+	g_mutex_init (&batch->mutex);
+	g_cond_init (&batch->cond);
+
+	/* reading is bound by I/O latency, so we use more threads than we have CPUs */
+	batch->tpool = g_thread_pool_new (as_file_batch_job_run,
+					  batch,
+					  MIN (g_get_num_processors () * 2, AS_FILE_BATCH_WINDOW),
+					  FALSE,
+					  NULL);
+	as_file_batch_queue_jobs (batch);
+
+	return batch;
+}
+
+/**
+ * as_file_batch_next:
+ * @batch: an #AsFileBatch
+ * @fname: (out) (optional): the name of the file.
+ *
+ * Get the reader for the next file of the batch, in the order the
+ * files were passed in. Waits until the file has been read.
+ *
+ * Returns: (transfer full): an #AsFileReader, or %NULL if all files were processed.
+ */
+AsFileReader*
+as_file_batch_next (AsFileBatch *batch, const gchar **fname)
+{
+	AsFileReader *reader;
+
+	if (batch->pos >= batch->fnames->len)
+		return NULL;
+
+	g_mutex_lock (&batch->mutex);
+	while (!batch->done[batch->pos])
+		g_cond_wait (&batch->cond, &batch->mutex);
+	reader = batch->readers[batch->pos];
+	batch->readers[batch->pos] = NULL;
+	g_mutex_unlock (&batch->mutex);
+
+	if (fname != NULL)
+		*fname = (const gchar*) g_ptr_array_index (batch->fnames, batch->pos);
+	batch->pos++;
+	as_file_batch_queue_jobs (batch);
+
+	return reader;
+}
+
+/**
+ * as_file_batch_free:
+ * @batch: an #AsFileBatch
+ *
+ * Stop reading, and free all resources.
+ */
+void
+as_file_batch_free (AsFileBatch *batch)
+{
+	guint i;
+
+	if (batch == NULL)
+		return;
+
+	/* drop the files that were not read yet, and wait for the running jobs */
+	g_thread_pool_free (batch->tpool, TRUE, TRUE);
+	for (i = 0; i < batch->fnames->len; i++)
+		as_file_reader_free (batch->readers[i]);
+
+	g_mutex_clear (&batch->mutex);
+	g_cond_clear (&batch->cond);
+	g_free (batch->readers);
+	g_free (batch->done);
+	g_ptr_array_unref (batch->fnames);
+	g_free (batch);
+}
@@ -0,0 +1,80 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_FILE_READER_H
+#define __AS_FILE_READER_H
+
+#include <gio/gio.h>
+#include "as-metadata.h"
+#include "as-settings-private.h"
+
+G_BEGIN_DECLS
+#pragma GCC visibility push(hidden)
+
+typedef struct _AsFileReader AsFileReader;
+typedef struct _AsFileBatch AsFileBatch;
+
+AS_INTERNAL_VISIBLE
+AsFileReader		*as_file_reader_new (GFile *file);
+AS_INTERNAL_VISIBLE
+AsFileReader		*as_file_reader_new_for_path (const gchar *fname);
+AS_INTERNAL_VISIBLE
+void			as_file_reader_free (AsFileReader *reader);
+
+const gchar		*as_file_reader_get_basename (AsFileReader *reader);
+AS_INTERNAL_VISIBLE
+AsFormatKind		as_file_reader_guess_format (AsFileReader *reader);
+
+gboolean		as_file_reader_get_contents (AsFileReader *reader,
+						     const gchar **data,
+						     gsize *len);
+
+AS_INTERNAL_VISIBLE
+gboolean		as_file_reader_next (AsFileReader *reader,
+					     const gchar **data,
+					     gsize *len,
+					     GError **error);
+gssize			as_file_reader_read (AsFileReader *reader,
+					     gchar *buffer,
+					     gsize count,
+					     GError **error);
+AS_INTERNAL_VISIBLE
+gchar			*as_file_reader_read_all (AsFileReader *reader,
+						  GError **error);
+
+AS_INTERNAL_VISIBLE
+AsFileBatch		*as_file_batch_new (GPtrArray *fnames);
+AS_INTERNAL_VISIBLE
+AsFileReader		*as_file_batch_next (AsFileBatch *batch,
+					     const gchar **fname);
+AS_INTERNAL_VISIBLE
+void			as_file_batch_free (AsFileBatch *batch);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AsFileReader, as_file_reader_free)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AsFileBatch, as_file_batch_free)
+
+#pragma GCC visibility pop
+G_END_DECLS
+
+#endif /* __AS_FILE_READER_H */
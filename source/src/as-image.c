@@ -282,7 +282,7 @@ as_image_load_from_xml (AsImage *image, AsContext *ctx, xmlNode *node, GError **
 	AsImagePrivate *priv = GET_PRIVATE (image);
 	g_autofree gchar *content = NULL;
 	g_autofree gchar *stype = NULL;
-	g_autofree gchar *lang = NULL;
+	const gchar *lang;
 	gchar *str;
 
 	content = as_xml_get_node_value (node);
@@ -0,0 +1,169 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:as-intern
+ * @short_description: Process-wide table of shared strings.
+ * @include: appstream.h
+ *
+ * Many strings in AppStream metadata are repeated for a lot of components,
+ * like locale names, categories, licenses, origins and architectures.
+ * The component-IDs and data-IDs are used as keys in the pool tables as well.
+ * All of these are kept only once in a reference-counted table which is
+ * shared by all parsers, caches and pools of the process, and can be used
+ * from any thread.
+ */
+
+#include "config.h"
+#include "as-intern.h"
+
+#include <string.h>
+
+typedef struct
+{
+	guint		ref_count;
+	gchar		str[];
+} AsInternEntry;
+
+/* the table is split into shards with their own lock, so threads
+ * which parse or load data at the same time rarely wait for each other */
+#define AS_INTERN_N_SHARDS 32
+
+typedef struct
+{
+	GMutex		mutex;
+	GHashTable	*table; /* utf8 -> AsInternEntry, the key is part of the entry */
+	gsize		saved_bytes;
+} AsInternShard;
+
+static AsInternShard intern_shards[AS_INTERN_N_SHARDS];
+
+/**
+ * as_intern_get_shard:
+ *
+ * Get the shard which holds @str, if it was interned.
+ */
+static inline AsInternShard*
+as_intern_get_shard (const gchar *str)
+{
+	return &intern_shards[g_str_hash (str) % AS_INTERN_N_SHARDS];
+}
+
+/**
+ * as_intern_ref:
+ * @str: (nullable): The string to intern.
+ *
+ * Get the shared copy of @str, and take a reference on it.
+ *
+ * Returns: (transfer full): the interned string, release it with as_intern_unref(),
+ * or %NULL if @str was %NULL.
+ */
+const gchar*
+as_intern_ref (const gchar *str)
+{
+	AsInternShard *shard;
+	AsInternEntry *entry;
+	gsize len;
+
+	if (str == NULL)
+		return NULL;
+
+	shard = as_intern_get_shard (str);
+	len = strlen (str) + 1;
+
+	g_mutex_lock (&shard->mutex);
+	if (G_UNLIKELY (shard->table == NULL))
+		shard->table = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+
+	entry = g_hash_table_lookup (shard->table, str);
+	if (entry != NULL) {
+		entry->ref_count++;
+		shard->saved_bytes += len;
+	} else {
+		entry = g_malloc (sizeof (AsInternEntry) + len);
+		entry->ref_count = 1;
+		memcpy (entry->str, str, len);
+		g_hash_table_insert (shard->table, entry->str, entry);
+	}
+	g_mutex_unlock (&shard->mutex);
+
+	return entry->str;
+}
+
+/**
+ * as_intern_unref:
+ * @str: (nullable): A string returned by as_intern_ref().
+ *
+ * Release a reference on an interned string. The string is freed
+ * once no references are left.
+ */
+void
+as_intern_unref (const gchar *str)
+{
+	AsInternShard *shard;
+	AsInternEntry *entry;
+
+	if (str == NULL)
+		return;
+
+	shard = as_intern_get_shard (str);
+	g_mutex_lock (&shard->mutex);
+	entry = g_hash_table_lookup (shard->table, str);
+	g_assert (entry != NULL && entry->str == str);
+
+	if (--entry->ref_count == 0)
+		g_hash_table_remove (shard->table, str);
+	else
+		shard->saved_bytes -= strlen (str) + 1;
+	g_mutex_unlock (&shard->mutex);
+}
+
+/**
+ * as_intern_get_stats:
+ * @n_unique: (out) (optional): The number of strings in the table.
+ * @saved_bytes: (out) (optional): The memory which would be needed for copies
+ *               of the strings, if they weren't shared.
+ *
+ * Report how much memory the shared string table saves right now.
+ * The shards are looked at one after another, so the numbers may be slightly
+ * off while other threads intern strings.
+ */
+void
+as_intern_get_stats (guint *n_unique, gsize *saved_bytes)
+{
+	guint n = 0;
+	gsize saved = 0;
+	guint i;
+
+	for (i = 0; i < AS_INTERN_N_SHARDS; i++) {
+		AsInternShard *shard = &intern_shards[i];
+
+		g_mutex_lock (&shard->mutex);
+		if (shard->table != NULL)
+			n += g_hash_table_size (shard->table);
+		saved += shard->saved_bytes;
+		g_mutex_unlock (&shard->mutex);
+	}
+
+	if (n_unique != NULL)
+		*n_unique = n;
+	if (saved_bytes != NULL)
+		*saved_bytes = saved;
+}
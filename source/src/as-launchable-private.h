@@ -28,6 +28,16 @@
 G_BEGIN_DECLS
 #pragma GCC visibility push(hidden)
 
+/**
+ * AsLaunchableRecord:
+ *
+ * Plain value representation of a launchable, used to avoid
+ * creating a full #AsLaunchable object for every cache entry.
+ */
+typedef struct {
+	AsLaunchableKind	kind;
+	gchar			**entries;
+} AsLaunchableRecord;
 /* NOTE: The AsComponent load the AsLaunchable from XML, because it needs to aggregate multiple tags in one object. */
 
 void		as_launchable_to_xml_node (AsLaunchable *launchable,
@@ -47,6 +57,13 @@ void		as_launchable_to_variant (AsLaunchable *launch,
 gboolean	as_launchable_set_from_variant (AsLaunchable *launch,
 						GVariant *variant);
 
+void		as_launchable_record_clear (AsLaunchableRecord *rec);
+gboolean	as_launchable_record_set_from_variant (AsLaunchableRecord *rec,
+						       GVariant *variant);
+void		as_launchable_record_to_variant (const AsLaunchableRecord *rec,
+						 GVariantBuilder *builder);
+AsLaunchable	*as_launchable_new_from_record (AsLaunchableRecord *rec);
+
 #pragma GCC visibility pop
 G_END_DECLS
 
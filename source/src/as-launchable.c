@@ -314,6 +314,81 @@ as_launchable_set_from_variant (AsLaunchable *launch, GVariant *variant)
 	return TRUE;
 }
 
+/**
+ * as_launchable_record_clear:
+ * @rec: an #AsLaunchableRecord
+ *
+ * Free the data of a launchable record, but not the record itself.
+ */
+void
+as_launchable_record_clear (AsLaunchableRecord *rec)
+{
+	g_clear_pointer (&rec->entries, g_strfreev);
+}
+
+/**
+ * as_launchable_record_set_from_variant:
+ * @rec: an #AsLaunchableRecord
+ * @variant: The #GVariant to read from.
+ *
+ * Read a launchable from its #GVariant serialization without
+ * creating an #AsLaunchable instance.
+ */
+gboolean
+as_launchable_record_set_from_variant (AsLaunchableRecord *rec, GVariant *variant)
+{
+	g_autoptr(GVariant) entries_var = NULL;
+
+	g_variant_get (variant, "{uv}", &rec->kind, &entries_var);
+	g_strfreev (rec->entries);
+	rec->entries = g_variant_dup_strv (entries_var, NULL);
+
+	return TRUE;
+}
+
+/**
+ * as_launchable_record_to_variant:
+ * @rec: an #AsLaunchableRecord
+ * @builder: A #GVariantBuilder
+ *
+ * Serialize a launchable record in the same way as as_launchable_to_variant().
+ */
+void
+as_launchable_record_to_variant (const AsLaunchableRecord *rec, GVariantBuilder *builder)
+{
+	GVariant *var = g_variant_new ("{uv}",
+				       rec->kind,
+				       g_variant_new_strv ((const gchar * const*) rec->entries,
+							   rec->entries != NULL? -1 : 0));
+	g_variant_builder_add_value (builder, var);
+}
+
+/**
+ * as_launchable_new_from_record:
+ * @rec: an #AsLaunchableRecord
+ *
+ * Create a new #AsLaunchable, moving the data out of @rec.
+ *
+ * Returns: (transfer full): a #AsLaunchable
+ */
+AsLaunchable*
+as_launchable_new_from_record (AsLaunchableRecord *rec)
+{
+	AsLaunchable *launch = as_launchable_new ();
+	AsLaunchablePrivate *priv = GET_PRIVATE (launch);
+	guint i;
+
+	priv->kind = rec->kind;
+	if (rec->entries != NULL) {
+		for (i = 0; rec->entries[i] != NULL; i++)
+			g_ptr_array_add (priv->entries, rec->entries[i]);
+		/* the strings are owned by the launchable now */
+		g_free (g_steal_pointer (&rec->entries));
+	}
+
+	return launch;
+}
+
 /**
  * as_launchable_new:
  *
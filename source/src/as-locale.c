@@ -0,0 +1,277 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:as-locale
+ * @short_description: Fallback chains for the lookup of localized values.
+ * @include: appstream.h
+ *
+ * Localized values are looked up for the active locale first, then for
+ * less specific variants of it and finally for the untranslated "C" value,
+ * e.g. `de_AT@euro → de_AT → de@euro → de → C`.
+ * The active locale may also be a colon-separated list of preferred
+ * locales, in the format of the LANGUAGE environment variable.
+ *
+ * An #AsLocaleChain holds this order for one locale string. Chains are
+ * built once per distinct locale and are never freed, so lookups with
+ * them don't need to split or allocate locale strings.
+ */
+
+#include "config.h"
+#include "as-locale.h"
+
+#include <string.h>
+
+#include "as-utils-private.h"
+
+struct _AsLocaleChain
+{
+	gchar		**locales; /* the locales to try, in order, ending with "C" */
+	guint		n_specific; /* number of locales before the "C" fallback */
+	gchar		**languages; /* requested locales which are just a language, e.g. "de" */
+};
+
+/* protects the table of chains */
+static GMutex chains_mutex;
+static GHashTable *chains = NULL; /* utf8 -> AsLocaleChain */
+
+/**
+ * as_locale_chain_add_variant:
+ *
+ * Add a variant of a locale to the fallback list, if it is not in there yet.
+ */
+static void
+as_locale_chain_add_variant (GPtrArray *locales, const gchar *lang, const gchar *territory, const gchar *modifier)
+{
+	gchar *variant = g_strdup_printf ("%s%s%s",
+					  lang,
+					  (territory != NULL)? territory : "",
+					  (modifier != NULL)? modifier : "");
+	if (as_ptr_array_find_string (locales, variant) == NULL)
+		g_ptr_array_add (locales, variant);
+	else
+		g_free (variant);
+}
+
+/**
+ * as_locale_chain_add_locale:
+ *
+ * Add a single requested locale and its less specific variants.
+ */
+static void
+as_locale_chain_add_locale (GPtrArray *locales, GPtrArray *languages, const gchar *locale)
+{
+	g_autofree gchar *lang = NULL;
+	g_autofree gchar *territory = NULL;
+	g_autofree gchar *modifier = NULL;
+	const gchar *tmp;
+	gsize len;
+
+	/* split "lang_TERRITORY.codeset@modifier", the codeset is never used in metadata */
+	len = strcspn (locale, "_.@");
+	if (len == 0)
+		return;
+	lang = g_strndup (locale, len);
+	tmp = locale + len;
+	if (*tmp == '_') {
+		len = strcspn (tmp, ".@");
+		territory = g_strndup (tmp, len);
+		tmp += len;
+	}
+	if (*tmp == '.')
+		tmp += strcspn (tmp, "@");
+	if (*tmp == '@')
+		modifier = g_strdup (tmp);
+
+	as_locale_chain_add_variant (locales, locale, NULL, NULL);
+	if (territory != NULL) {
+		if (modifier != NULL)
+			as_locale_chain_add_variant (locales, lang, territory, modifier);
+		as_locale_chain_add_variant (locales, lang, territory, NULL);
+	}
+	if (modifier != NULL)
+		as_locale_chain_add_variant (locales, lang, NULL, modifier);
+	as_locale_chain_add_variant (locales, lang, NULL, NULL);
+
+	if ((territory == NULL) && (modifier == NULL) &&
+	    (g_strcmp0 (lang, "C") != 0) &&
+	    (as_ptr_array_find_string (languages, lang) == NULL))
+		g_ptr_array_add (languages, g_strdup (lang));
+}
+
+/**
+ * as_locale_chain_new:
+ *
+ * Build the fallback chain for a locale string.
+ */
+static AsLocaleChain*
+as_locale_chain_new (const gchar *locale)
+{
+	AsLocaleChain *chain;
+	GPtrArray *locales;
+	GPtrArray *languages;
+	g_auto(GStrv) parts = NULL;
+	guint i;
+
+	locales = g_ptr_array_new ();
+	languages = g_ptr_array_new ();
+	parts = g_strsplit (locale, ":", -1);
+	for (i = 0; parts[i] != NULL; i++)
+		as_locale_chain_add_locale (locales, languages, parts[i]);
+
+	chain = g_new0 (AsLocaleChain, 1);
+	chain->n_specific = locales->len;
+	if (as_ptr_array_find_string (locales, "C") == NULL)
+		g_ptr_array_add (locales, g_strdup ("C"));
+
+	g_ptr_array_add (locales, NULL);
+	chain->locales = (gchar**) g_ptr_array_free (locales, FALSE);
+	g_ptr_array_add (languages, NULL);
+	chain->languages = (gchar**) g_ptr_array_free (languages, FALSE);
+
+	return chain;
+}
+
+/**
+ * as_locale_chain_get:
+ * @locale: (nullable): a locale, or a colon-separated list of them.
+ *
+ * Get the fallback chain for a locale string. A %NULL locale
+ * is the same as "C".
+ *
+ * Returns: (transfer none): the shared chain for @locale.
+ */
+const AsLocaleChain*
+as_locale_chain_get (const gchar *locale)
+{
+	static gsize c_chain = 0;
+	AsLocaleChain *chain;
+
+	/* the unlocalized chain is needed all the time */
+	if ((locale == NULL) || (g_strcmp0 (locale, "C") == 0)) {
+		if (g_once_init_enter (&c_chain))
+			g_once_init_leave (&c_chain, (gsize) as_locale_chain_new ("C"));
+		return (const AsLocaleChain*) c_chain;
+	}
+
+	g_mutex_lock (&chains_mutex);
+	if (chains == NULL)
+		chains = g_hash_table_new (g_str_hash, g_str_equal);
+	chain = g_hash_table_lookup (chains, locale);
+	if (chain == NULL) {
+		chain = as_locale_chain_new (locale);
+		g_hash_table_insert (chains, g_strdup (locale), chain);
+	}
+	g_mutex_unlock (&chains_mutex);
+
+	return chain;
+}
+
+/**
+ * as_locale_chain_get_locales:
+ * @chain: an #AsLocaleChain.
+ *
+ * Returns: (transfer none): the locales of @chain in lookup order.
+ */
+const gchar * const*
+as_locale_chain_get_locales (const AsLocaleChain *chain)
+{
+	return (const gchar * const*) chain->locales;
+}
+
+/**
+ * as_locale_chain_lookup:
+ * @chain: an #AsLocaleChain.
+ * @table: (nullable): a table with locales as keys.
+ * @fallback: %FALSE to only look at the most specific locale.
+ *
+ * Find the value for the best locale of @chain in @table.
+ *
+ * Returns: the value, or %NULL if there is none.
+ */
+gpointer
+as_locale_chain_lookup (const AsLocaleChain *chain, GHashTable *table, gboolean fallback)
+{
+	gpointer value;
+	guint i;
+
+	if (table == NULL)
+		return NULL;
+
+	for (i = 0; chain->locales[i] != NULL; i++) {
+		value = g_hash_table_lookup (table, chain->locales[i]);
+		if ((value != NULL) || !fallback)
+			return value;
+	}
+
+	return NULL;
+}
+
+/**
+ * as_locale_chain_rank:
+ * @chain: an #AsLocaleChain.
+ * @locale: (nullable): the locale of a value, %NULL for untranslated values.
+ *
+ * Rank how well a value in @locale matches @chain, lower is better.
+ * Values for locales which are more specific than a requested language
+ * (e.g. "de_AT" if "de" was requested) rank right before "C".
+ *
+ * Returns: the rank, or -1 if @locale does not match.
+ */
+gint
+as_locale_chain_rank (const AsLocaleChain *chain, const gchar *locale)
+{
+	guint i;
+
+	if (locale == NULL)
+		locale = "C";
+
+	for (i = 0; i < chain->n_specific; i++) {
+		if (g_strcmp0 (chain->locales[i], locale) == 0)
+			return i;
+	}
+
+	for (i = 0; chain->languages[i] != NULL; i++) {
+		gsize len = strlen (chain->languages[i]);
+		if ((strncmp (locale, chain->languages[i], len) == 0) && (locale[len] == '_'))
+			return chain->n_specific;
+	}
+
+	if (g_strcmp0 (locale, "C") == 0)
+		return chain->n_specific + 1;
+	return -1;
+}
+
+/**
+ * as_locale_chain_accepts:
+ * @chain: an #AsLocaleChain.
+ * @locale: (nullable): the locale of a value.
+ *
+ * Check whether values in @locale are translations for @chain.
+ * The "C" fallback is only accepted if it was requested explicitly.
+ *
+ * Returns: %TRUE if @locale is compatible with @chain.
+ */
+gboolean
+as_locale_chain_accepts (const AsLocaleChain *chain, const gchar *locale)
+{
+	gint rank = as_locale_chain_rank (chain, locale);
+	return (rank >= 0) && ((guint) rank <= chain->n_specific);
+}
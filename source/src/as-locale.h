@@ -0,0 +1,55 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_LOCALE_H
+#define __AS_LOCALE_H
+
+#include <glib.h>
+#include "as-settings-private.h"
+
+G_BEGIN_DECLS
+#pragma GCC visibility push(hidden)
+
+typedef struct _AsLocaleChain AsLocaleChain;
+
+AS_INTERNAL_VISIBLE
+const AsLocaleChain	*as_locale_chain_get (const gchar *locale);
+AS_INTERNAL_VISIBLE
+const gchar * const	*as_locale_chain_get_locales (const AsLocaleChain *chain);
+
+AS_INTERNAL_VISIBLE
+gpointer		as_locale_chain_lookup (const AsLocaleChain *chain,
+						GHashTable *table,
+						gboolean fallback);
+AS_INTERNAL_VISIBLE
+gint			as_locale_chain_rank (const AsLocaleChain *chain,
+					      const gchar *locale);
+AS_INTERNAL_VISIBLE
+gboolean		as_locale_chain_accepts (const AsLocaleChain *chain,
+						 const gchar *locale);
+
+#pragma GCC visibility pop
+G_END_DECLS
+
+#endif /* __AS_LOCALE_H */
@@ -35,6 +35,7 @@
 #include <string.h>
 
 #include "as-metadata.h"
+#include "as-metadata-private.h"
 
 #include "as-utils.h"
 #include "as-utils-private.h"
@@ -46,6 +47,7 @@
 
 #include "as-xml.h"
 #include "as-yaml.h"
+#include "as-file-reader.h"
 
 typedef struct
 {
@@ -56,6 +58,7 @@ typedef struct
 	gchar *media_baseurl;
 	gchar *arch;
 	gint default_priority;
+	AsLoadProfile load_profile;
 
 	gboolean update_existing;
 	gboolean write_header;
@@ -63,6 +66,12 @@ typedef struct
 	GPtrArray *cpts;
 } AsMetadataPrivate;
 
+typedef struct
+{
+	AsFileReader	*reader;
+	GError		*error;
+} AsMetadataYamlReadState;
+
 G_DEFINE_TYPE_WITH_PRIVATE (AsMetadata, as_metadata, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (as_metadata_get_instance_private (o))
 
@@ -184,6 +193,7 @@ as_metadata_init (AsMetadata *metad)
 	priv->format_version = AS_CURRENT_FORMAT_VERSION;
 	priv->mode = AS_FORMAT_STYLE_METAINFO;
 	priv->default_priority = 0;
+	priv->load_profile = AS_LOAD_PROFILE_FULL;
 	priv->write_header = TRUE;
 	priv->update_existing = FALSE;
 
@@ -223,6 +233,7 @@ as_metadata_new_context (AsMetadata *metad, AsFormatStyle style, const gchar *fn
 	as_context_set_media_baseurl (context, priv->media_baseurl);
 	as_context_set_architecture (context, priv->arch);
 	as_context_set_priority (context, priv->default_priority);
+	as_context_set_load_profile (context, priv->load_profile);
 
 	as_context_set_style (context, style);
 	as_context_set_filename (context, fname);
@@ -300,7 +311,7 @@ as_metadata_xml_parse_components_node (AsMetadata *metad, AsContext *context, xm
  * as_metadata_yaml_parse_collection_doc:
  * @metad: an instance of #AsMetadata.
  * @context: an #AsContext
- * @data: YAML metadata to parse
+ * @parser: a YAML parser with its input set to the metadata to parse
  * @error: a #GError
  *
  * Read an array of #AsComponent from AppStream YAML metadata.
@@ -308,33 +319,23 @@ as_metadata_xml_parse_components_node (AsMetadata *metad, AsContext *context, xm
  * Returns: (transfer container) (element-type AsComponent): An array of #AsComponent or %NULL
  */
 static GPtrArray*
-as_metadata_yaml_parse_collection_doc (AsMetadata *metad, AsContext *context, const gchar *data, GError **error)
+as_metadata_yaml_parse_collection_doc (AsMetadata *metad, AsContext *context, yaml_parser_t *parser, GError **error)
 {
-	yaml_parser_t parser;
 	yaml_event_t event;
 	gboolean header = TRUE;
 	gboolean parse = TRUE;
 	gboolean ret = TRUE;
 	g_autoptr(GPtrArray) cpts = NULL;
 
-	/* we ignore empty data - usually happens if the file is broken, e.g. by disk corruption
-	 * or download interruption. */
-	if (data == NULL)
-		return NULL;
-
 	/* create container for the components we find */
 	cpts = g_ptr_array_new_with_free_func (g_object_unref);
 
-	/* initialize YAML parser */
-	yaml_parser_initialize (&parser);
-	yaml_parser_set_input_string (&parser, (unsigned char*) data, strlen (data));
-
 	while (parse) {
-		if (!yaml_parser_parse (&parser, &event)) {
+		if (!yaml_parser_parse (parser, &event)) {
 			g_set_error (error,
 					AS_METADATA_ERROR,
 					AS_METADATA_ERROR_PARSE,
-					"Invalid DEP-11 file found. Could not parse YAML: %s", parser.problem);
+					"Invalid DEP-11 file found. Could not parse YAML: %s", parser->problem);
 			ret = FALSE;
 			break;
 		}
@@ -346,7 +347,7 @@ as_metadata_yaml_parse_collection_doc (AsMetadata *metad, AsContext *context, co
 			g_autoptr(GNode) root = NULL;
 
 			root = g_node_new (g_strdup (""));
-			as_yaml_parse_layer (&parser, root, &tmp_error);
+			as_yaml_parse_layer (parser, root, &tmp_error);
 			if (tmp_error != NULL) {
 				/* stop immediately, since we found an error when parsing the document */
 				g_propagate_error (error, tmp_error);
@@ -444,8 +445,6 @@ as_metadata_yaml_parse_collection_doc (AsMetadata *metad, AsContext *context, co
 		yaml_event_delete (&event);
 	}
 
-	yaml_parser_delete (&parser);
-
 	/* return NULL on error, otherwise return the list of found components */
 	if (ret)
 		return g_ptr_array_ref (cpts);
@@ -453,6 +452,104 @@ as_metadata_yaml_parse_collection_doc (AsMetadata *metad, AsContext *context, co
 		return NULL;
 }
 
+/**
+ * as_metadata_parse_xml_doc:
+ * @metad: An instance of #AsMetadata.
+ * @doc: (transfer full): The XML document to read components from.
+ * @error: A #GError or %NULL.
+ *
+ * Helper function for as_metadata_parse() and as_metadata_parse_file().
+ **/
+static void
+as_metadata_parse_xml_doc (AsMetadata *metad, xmlDoc *doc, GError **error)
+{
+	AsMetadataPrivate *priv = GET_PRIVATE (metad);
+	xmlNode *root;
+
+	root = xmlDocGetRootElement (doc);
+
+	if (priv->mode == AS_FORMAT_STYLE_COLLECTION) {
+		/* prepare context */
+		g_autoptr(AsContext) context = as_metadata_new_context (metad, AS_FORMAT_STYLE_COLLECTION, NULL);
+
+		if (g_strcmp0 ((gchar*) root->name, "components") == 0) {
+			as_metadata_xml_parse_components_node (metad, context, root, error);
+		} else if (g_strcmp0 ((gchar*) root->name, "component") == 0) {
+			g_autoptr(AsComponent) cpt = as_component_new ();
+			/* we explicitly allow parsing single component entries in distro-XML mode, since this is a scenario
+			* which might very well happen, e.g. in AppStream metadata generators */
+			if (as_component_load_from_xml (cpt, context, root, error))
+				g_ptr_array_add (priv->cpts, g_object_ref (cpt));
+		} else {
+			g_set_error_literal (error,
+						AS_METADATA_ERROR,
+						AS_METADATA_ERROR_FAILED,
+						"XML file does not contain valid AppStream data!");
+		}
+	} else {
+		g_autoptr(AsContext) context = NULL;
+		AsComponent *cpt = as_component_new ();
+
+		context = as_metadata_new_context (metad, AS_FORMAT_STYLE_METAINFO, NULL);
+		if (priv->update_existing) {
+			/* we should update the existing component with new metadata */
+			cpt = as_metadata_get_component (metad);
+			if (cpt == NULL) {
+				g_set_error_literal (error,
+							AS_METADATA_ERROR,
+							AS_METADATA_ERROR_NO_COMPONENT,
+							"No component found that could be updated.");
+				xmlFreeDoc (doc);
+				return;
+			}
+			as_component_load_from_xml (cpt, context, root, error);
+		} else {
+			if (as_component_load_from_xml (cpt, context, root, error))
+				g_ptr_array_add (priv->cpts, g_object_ref (cpt));
+		}
+
+		if (cpt != NULL)
+			as_component_set_origin_kind (cpt, AS_ORIGIN_KIND_METAINFO);
+	}
+
+	/* free the XML document */
+	xmlFreeDoc (doc);
+}
+
+/**
+ * as_metadata_parse_yaml_parser:
+ * @metad: An instance of #AsMetadata.
+ * @parser: A YAML parser with its input already set.
+ * @error: A #GError or %NULL.
+ *
+ * Helper function for as_metadata_parse() and as_metadata_parse_file().
+ **/
+static void
+as_metadata_parse_yaml_parser (AsMetadata *metad, yaml_parser_t *parser, GError **error)
+{
+	AsMetadataPrivate *priv = GET_PRIVATE (metad);
+
+	if (priv->mode == AS_FORMAT_STYLE_COLLECTION) {
+		g_autoptr(AsContext) context = NULL;
+		g_autoptr(GPtrArray) new_cpts = NULL;
+		guint i;
+
+		context = as_metadata_new_context (metad, AS_FORMAT_STYLE_COLLECTION, NULL);
+		new_cpts = as_metadata_yaml_parse_collection_doc (metad, context, parser, error);
+		if (new_cpts == NULL)
+			return;
+		for (i = 0; i < new_cpts->len; i++) {
+			AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (new_cpts, i));
+			as_component_set_origin_kind (cpt, AS_ORIGIN_KIND_COLLECTION);
+
+			g_ptr_array_add (priv->cpts,
+					 g_object_ref (cpt));
+		}
+	} else {
+		g_warning ("Can not load non-collection AppStream YAML data, because their format is not specified.");
+	}
+}
+
 /**
  * as_metadata_parse:
  * @metad: An instance of #AsMetadata.
@@ -465,86 +562,28 @@ as_metadata_yaml_parse_collection_doc (AsMetadata *metad, AsContext *context, co
 void
 as_metadata_parse (AsMetadata *metad, const gchar *data, AsFormatKind format, GError **error)
 {
-	AsMetadataPrivate *priv = GET_PRIVATE (metad);
-
 	g_return_if_fail (format > AS_FORMAT_KIND_UNKNOWN && format < AS_FORMAT_KIND_LAST);
 
 	if (format == AS_FORMAT_KIND_XML) {
 		xmlDoc *doc;
-		xmlNode *root;
 
 		doc = as_xml_parse_document (data, error);
 		if (doc == NULL)
 			return;
-		root = xmlDocGetRootElement (doc);
-
-		if (priv->mode == AS_FORMAT_STYLE_COLLECTION) {
-			/* prepare context */
-			g_autoptr(AsContext) context = as_metadata_new_context (metad, AS_FORMAT_STYLE_COLLECTION, NULL);
-
-			if (g_strcmp0 ((gchar*) root->name, "components") == 0) {
-				as_metadata_xml_parse_components_node (metad, context, root, error);
-			} else if (g_strcmp0 ((gchar*) root->name, "component") == 0) {
-				g_autoptr(AsComponent) cpt = as_component_new ();
-				/* we explicitly allow parsing single component entries in distro-XML mode, since this is a scenario
-				* which might very well happen, e.g. in AppStream metadata generators */
-				if (as_component_load_from_xml (cpt, context, root, error))
-					g_ptr_array_add (priv->cpts, g_object_ref (cpt));
-			} else {
-				g_set_error_literal (error,
-							AS_METADATA_ERROR,
-							AS_METADATA_ERROR_FAILED,
-							"XML file does not contain valid AppStream data!");
-			}
-		} else {
-			g_autoptr(AsContext) context = NULL;
-			AsComponent *cpt = as_component_new ();
-
-			context = as_metadata_new_context (metad, AS_FORMAT_STYLE_METAINFO, NULL);
-			if (priv->update_existing) {
-				/* we should update the existing component with new metadata */
-				cpt = as_metadata_get_component (metad);
-				if (cpt == NULL) {
-					g_set_error_literal (error,
-								AS_METADATA_ERROR,
-								AS_METADATA_ERROR_NO_COMPONENT,
-								"No component found that could be updated.");
-					xmlFreeDoc (doc);
-					return;
-				}
-				as_component_load_from_xml (cpt, context, root, error);
-			} else {
-				if (as_component_load_from_xml (cpt, context, root, error))
-					g_ptr_array_add (priv->cpts, g_object_ref (cpt));
-			}
-
-			if (cpt != NULL)
-				as_component_set_origin_kind (cpt, AS_ORIGIN_KIND_METAINFO);
-		}
-
-		/* free the XML document */
-		xmlFreeDoc (doc);
+		as_metadata_parse_xml_doc (metad, doc, error);
 
 	} else if (format == AS_FORMAT_KIND_YAML) {
-		if (priv->mode == AS_FORMAT_STYLE_COLLECTION) {
-			g_autoptr(AsContext) context = NULL;
-			g_autoptr(GPtrArray) new_cpts = NULL;
-			guint i;
-
-			context = as_metadata_new_context (metad, AS_FORMAT_STYLE_COLLECTION, NULL);
-			new_cpts = as_metadata_yaml_parse_collection_doc (metad, context, data, error);
-			if (new_cpts == NULL)
-				return;
-			for (i = 0; i < new_cpts->len; i++) {
-				AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (new_cpts, i));
-				as_component_set_origin_kind (cpt, AS_ORIGIN_KIND_COLLECTION);
+		yaml_parser_t parser;
 
-				g_ptr_array_add (priv->cpts,
-						 g_object_ref (cpt));
-			}
-		} else {
-			g_warning ("Can not load non-collection AppStream YAML data, because their format is not specified.");
-		}
+		/* we ignore empty data - usually happens if the file is broken, e.g. by disk corruption
+		 * or download interruption. */
+		if (data == NULL)
+			return;
+
+		yaml_parser_initialize (&parser);
+		yaml_parser_set_input_string (&parser, (unsigned char*) data, strlen (data));
+		as_metadata_parse_yaml_parser (metad, &parser, error);
+		yaml_parser_delete (&parser);
 	} else if (format == AS_FORMAT_KIND_DESKTOP_ENTRY) {
 		g_critical ("Refusing to load desktop entry without knowing its ID. Use as_metadata_parse_desktop() to parse .desktop files.");
 	}
@@ -565,9 +604,11 @@ as_metadata_parse_desktop_data (AsMetadata *metad, const gchar *data, const gcha
 	AsMetadataPrivate *priv = GET_PRIVATE (metad);
 	AsComponent *cpt;
 
+	/* only keep the translations we need */
 	cpt = as_desktop_entry_parse_data (data,
 					   cid,
 					   priv->format_version,
+					   (g_strcmp0 (priv->locale, "ALL") == 0)? NULL : priv->locale,
 					   error);
 	if (cpt == NULL) {
 		if (*error == NULL)
@@ -583,88 +624,103 @@ as_metadata_parse_desktop_data (AsMetadata *metad, const gchar *data, const gcha
 }
 
 /**
- * as_metadata_parse_file:
+ * as_metadata_yaml_read_handler:
+ *
+ * Feed the YAML parser with data from an #AsFileReader.
+ */
+static int
+as_metadata_yaml_read_handler (void *data, unsigned char *buffer, size_t size, size_t *size_read)
+{
+	AsMetadataYamlReadState *state = (AsMetadataYamlReadState*) data;
+	gssize len;
+
+	len = as_file_reader_read (state->reader, (gchar*) buffer, size, &state->error);
+	if (len < 0)
+		return 0;
+
+	*size_read = len;
+	return 1;
+}
+
+/**
+ * as_metadata_parse_file_reader:
  * @metad: A valid #AsMetadata instance
- * @file: #GFile for the upstream metadata
+ * @reader: an #AsFileReader for the metadata file
  * @format: The format the data is in, or %AS_FORMAT_KIND_UNKNOWN if not known.
  * @error: A #GError or %NULL.
  *
- * Parses an AppStream upstream metadata file.
- *
+ * Parses an AppStream metadata file while it is still being read
+ * and decompressed by @reader.
  **/
 void
-as_metadata_parse_file (AsMetadata *metad, GFile *file, AsFormatKind format, GError **error)
+as_metadata_parse_file_reader (AsMetadata *metad, AsFileReader *reader, AsFormatKind format, GError **error)
 {
-	g_autofree gchar *file_basename = NULL;
-	g_autoptr(GFileInfo) info = NULL;
-	g_autoptr(GInputStream) file_stream = NULL;
-	g_autoptr(GInputStream) stream_data = NULL;
-	g_autoptr(GConverter) conv = NULL;
-	g_autoptr(GString) asdata = NULL;
-	gssize len;
-	const gsize buffer_size = 1024 * 32;
-	g_autofree gchar *buffer = NULL;
-	const gchar *content_type = NULL;
-
-	info = g_file_query_info (file,
-				G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
-				G_FILE_QUERY_INFO_NONE,
-				NULL, NULL);
-	if (info != NULL)
-		content_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
-
-	file_basename = g_file_get_basename (file);
-	if (format == AS_FORMAT_KIND_UNKNOWN) {
-		/* we should autodetect the format type. assume XML until we can find evidence that it's YAML */
-		format = AS_FORMAT_KIND_XML;
-
-		/* check if we are dealing with a YAML document */
-		if (g_strcmp0 (content_type, "application/x-yaml") == 0)
-			format = AS_FORMAT_KIND_YAML;
-
-		if ((g_str_has_suffix (file_basename, ".yml.gz")) ||
-		    (g_str_has_suffix (file_basename, ".yaml.gz")) ||
-		    (g_str_has_suffix (file_basename, ".yml")) ||
-		    (g_str_has_suffix (file_basename, ".yaml"))) {
-			format = AS_FORMAT_KIND_YAML;
-		}
+	const gchar *file_basename;
 
-		/* check if we have a .desktop file */
-		if (g_str_has_suffix (file_basename, ".desktop"))
-			format = AS_FORMAT_KIND_DESKTOP_ENTRY;
+	file_basename = as_file_reader_get_basename (reader);
+	if (format == AS_FORMAT_KIND_UNKNOWN) {
+		/* autodetect the format from the filename, or the data itself */
+		format = as_file_reader_guess_format (reader);
 	}
 
-	file_stream = G_INPUT_STREAM (g_file_read (file, NULL, error));
-	if (file_stream == NULL)
-		return;
+	if (format == AS_FORMAT_KIND_DESKTOP_ENTRY) {
+		g_autofree gchar *data = NULL;
 
-	if ((g_strcmp0 (content_type, "application/gzip") == 0) || (g_strcmp0 (content_type, "application/x-gzip") == 0)) {
-		/* decompress the GZip stream */
-		conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
-		stream_data = g_converter_input_stream_new (file_stream, conv);
-	} else {
-		stream_data = g_object_ref (file_stream);
-	}
-
-	/* Now read the whole file into memory to parse it.
-	 * On memory-contrained systems we could adjust the code later to allow parsing
-	 * a stream of data instead.
-	 */
+		/* desktop-entry files are tiny, just read them into memory */
+		data = as_file_reader_read_all (reader, error);
+		if (data == NULL)
+			return;
+		as_metadata_parse_desktop_data (metad, data, file_basename, error);
+	} else if (format == AS_FORMAT_KIND_XML) {
+		xmlDoc *doc;
 
-	asdata = g_string_new ("");
-	buffer = g_malloc (buffer_size);
-	while ((len = g_input_stream_read (stream_data, buffer, buffer_size, NULL, error)) > 0) {
-		g_string_append_len (asdata, buffer, len);
+		doc = as_xml_parse_document_reader (reader, error);
+		if (doc == NULL)
+			return;
+		as_metadata_parse_xml_doc (metad, doc, error);
+	} else if (format == AS_FORMAT_KIND_YAML) {
+		yaml_parser_t parser;
+		AsMetadataYamlReadState state = { reader, NULL };
+		const gchar *data;
+		gsize data_len;
+		GError *tmp_error = NULL;
+
+		yaml_parser_initialize (&parser);
+		if (as_file_reader_get_contents (reader, &data, &data_len))
+			yaml_parser_set_input_string (&parser, (const unsigned char*) data, data_len);
+		else
+			yaml_parser_set_input (&parser, as_metadata_yaml_read_handler, &state);
+		as_metadata_parse_yaml_parser (metad, &parser, &tmp_error);
+		yaml_parser_delete (&parser);
+
+		/* prefer I/O errors over the generic parser error they cause */
+		if (state.error != NULL) {
+			g_propagate_error (error, state.error);
+			g_clear_error (&tmp_error);
+		} else if (tmp_error != NULL) {
+			g_propagate_error (error, tmp_error);
+		}
 	}
-	/* check if there was an error */
-	if (len < 0)
-		return;
+}
 
-	/* parse metadata */
-	if (format == AS_FORMAT_KIND_DESKTOP_ENTRY)
-		as_metadata_parse_desktop_data (metad, asdata->str, file_basename, error);
-	else
-		as_metadata_parse (metad, asdata->str, format, error);
+/**
+ * as_metadata_parse_file:
+ * @metad: A valid #AsMetadata instance
+ * @file: #GFile for the upstream metadata
+ * @format: The format the data is in, or %AS_FORMAT_KIND_UNKNOWN if not known.
+ * @error: A #GError or %NULL.
+ *
+ * Parses an AppStream upstream metadata file.
+ *
+ **/
+void
+as_metadata_parse_file (AsMetadata *metad, GFile *file, AsFormatKind format, GError **error)
+{
+	g_autoptr(AsFileReader) reader = NULL;
+
+	/* data is read and decompressed in a separate thread while we parse */
+	reader = as_file_reader_new (file);
+	as_metadata_parse_file_reader (metad, reader, format, error);
 }
 
 /**
@@ -1134,6 +1190,42 @@ as_metadata_set_locale (AsMetadata *metad, const gchar *locale)
 	priv->locale = g_strdup (locale);
 }
 
+/**
+ * as_metadata_set_load_profile:
+ * @metad: a #AsMetadata instance.
+ * @profile: the #AsLoadProfile to use.
+ *
+ * Sets which parts of the component data should be loaded.
+ * Data that is not part of the profile is skipped by the parsers,
+ * which makes loading faster and reduces memory usage for users which
+ * only need some basic information about components.
+ * Use as_component_get_load_profile() to find out whether missing data
+ * is absent in the metadata or has not been loaded.
+ *
+ * Since: 0.12.1
+ **/
+void
+as_metadata_set_load_profile (AsMetadata *metad, AsLoadProfile profile)
+{
+	AsMetadataPrivate *priv = GET_PRIVATE (metad);
+	priv->load_profile = profile;
+}
+
+/**
+ * as_metadata_get_load_profile:
+ * @metad: a #AsMetadata instance.
+ *
+ * Returns: The #AsLoadProfile used when loading metadata.
+ *
+ * Since: 0.12.1
+ **/
+AsLoadProfile
+as_metadata_get_load_profile (AsMetadata *metad)
+{
+	AsMetadataPrivate *priv = GET_PRIVATE (metad);
+	return priv->load_profile;
+}
+
 /**
  * as_metadata_get_locale:
  * @metad: a #AsMetadata instance.
@@ -191,6 +191,10 @@ void			as_metadata_set_locale (AsMetadata *metad,
 							const gchar *locale);
 const gchar		*as_metadata_get_locale (AsMetadata *metad);
 
+void			as_metadata_set_load_profile (AsMetadata *metad,
+							AsLoadProfile profile);
+AsLoadProfile		as_metadata_get_load_profile (AsMetadata *metad);
+
 const gchar		*as_metadata_get_origin (AsMetadata *metad);
 void			as_metadata_set_origin (AsMetadata *metad,
 							const gchar *origin);
@@ -0,0 +1,344 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:as-metainfo-manifest
+ * @short_description: Index of the component IDs of metainfo files
+ * @include: appstream.h
+ *
+ * Maps metainfo files to the ID of the component they describe, so the
+ * pool can delay parsing a file until its component is actually needed.
+ * The ID is found by only reading a file up to its first <id/> element,
+ * and remembered along with the modification time and size of the file.
+ * This is a private/internal API.
+ */
+
+#include "config.h"
+#include "as-metainfo-manifest.h"
+
+#include <string.h>
+#include <libxml/xmlreader.h>
+
+#include "as-variant-cache.h"
+
+/* type of the serialized manifest entries: path, mtime, size, component-id */
+#define AS_METAINFO_MANIFEST_ENTRY_TYPE	"(sxts)"
+
+typedef struct {
+	gint64		mtime;
+	guint64		size;
+	gchar		*cid; /* empty if the file has no ID we could find */
+} AsManifestEntry;
+
+struct _AsMetainfoManifest {
+	GHashTable	*entries; /* path -> AsManifestEntry */
+	gboolean	dirty;
+};
+
+/**
+ * as_manifest_entry_free:
+ */
+static void
+as_manifest_entry_free (AsManifestEntry *entry)
+{
+	g_free (entry->cid);
+	g_slice_free (AsManifestEntry, entry);
+}
+
+/**
+ * as_metainfo_manifest_add_entry:
+ */
+static void
+as_metainfo_manifest_add_entry (AsMetainfoManifest *manifest,
+				const gchar *path,
+				gint64 mtime,
+				guint64 size,
+				const gchar *cid)
+{
+	AsManifestEntry *entry;
+
+	entry = g_slice_new0 (AsManifestEntry);
+	entry->mtime = mtime;
+	entry->size = size;
+	entry->cid = g_strdup (cid);
+	g_hash_table_insert (manifest->entries, g_strdup (path), entry);
+}
+
+/**
+ * as_metainfo_manifest_new:
+ *
+ * Returns: (transfer full): a new, empty #AsMetainfoManifest
+ */
+AsMetainfoManifest*
+as_metainfo_manifest_new (void)
+{
+	AsMetainfoManifest *manifest;
+
+	manifest = g_new0 (AsMetainfoManifest, 1);
+	manifest->entries = g_hash_table_new_full (g_str_hash,
+						   g_str_equal,
+						   g_free,
+						   (GDestroyNotify) as_manifest_entry_free);
+	return manifest;
+}
+
+/**
+ * as_metainfo_manifest_free:
+ * @manifest: an #AsMetainfoManifest
+ */
+void
+as_metainfo_manifest_free (AsMetainfoManifest *manifest)
+{
+	if (manifest == NULL)
+		return;
+	g_hash_table_unref (manifest->entries);
+	g_free (manifest);
+}
+
+/**
+ * as_metainfo_manifest_load:
+ * @manifest: an #AsMetainfoManifest
+ * @fname: the manifest file.
+ * @error: a #GError
+ *
+ * Load the manifest from @fname. A missing or incompatible
+ * file just results in an empty manifest.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+as_metainfo_manifest_load (AsMetainfoManifest *manifest, const gchar *fname, GError **error)
+{
+	g_autofree gchar *data = NULL;
+	gsize len;
+	g_autoptr(GVariant) main_gv = NULL;
+	g_autoptr(GVariant) gmvar = NULL;
+	g_autoptr(GVariant) entries_var = NULL;
+	GVariantIter iter;
+	const gchar *path;
+	const gchar *cid;
+	gint64 mtime;
+	guint64 size;
+	GError *tmp_error = NULL;
+
+	g_hash_table_remove_all (manifest->entries);
+	manifest->dirty = FALSE;
+
+	if (!g_file_get_contents (fname, &data, &len, &tmp_error)) {
+		if (g_error_matches (tmp_error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+			g_error_free (tmp_error);
+			return TRUE;
+		}
+		g_propagate_error (error, tmp_error);
+		return FALSE;
+	}
+
+	main_gv = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE_VARDICT,
+							       data, len,
+							       FALSE, NULL, NULL));
+
+	gmvar = g_variant_lookup_value (main_gv, "format_version", G_VARIANT_TYPE_UINT32);
+	if ((gmvar == NULL) || (g_variant_get_uint32 (gmvar) != CACHE_FORMAT_VERSION)) {
+		g_debug ("Ignored incompatible metainfo manifest '%s'.", fname);
+		return TRUE;
+	}
+
+	entries_var = g_variant_lookup_value (main_gv, "entries", G_VARIANT_TYPE ("a" AS_METAINFO_MANIFEST_ENTRY_TYPE));
+	if (entries_var == NULL)
+		return TRUE;
+
+	g_variant_iter_init (&iter, entries_var);
+	while (g_variant_iter_next (&iter, "(&sxt&s)", &path, &mtime, &size, &cid))
+		as_metainfo_manifest_add_entry (manifest, path, mtime, size, cid);
+
+	return TRUE;
+}
+
+/**
+ * as_metainfo_manifest_save:
+ * @manifest: an #AsMetainfoManifest
+ * @fname: the manifest file.
+ * @error: a #GError
+ *
+ * Write the manifest to @fname, replacing it atomically.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+as_metainfo_manifest_save (AsMetainfoManifest *manifest, const gchar *fname, GError **error)
+{
+	GVariantBuilder main_builder;
+	GVariantBuilder entries_builder;
+	g_autoptr(GVariant) main_gv = NULL;
+	GHashTableIter ht_iter;
+	gpointer key, value;
+
+	g_variant_builder_init (&entries_builder, G_VARIANT_TYPE ("a" AS_METAINFO_MANIFEST_ENTRY_TYPE));
+	g_hash_table_iter_init (&ht_iter, manifest->entries);
+	while (g_hash_table_iter_next (&ht_iter, &key, &value)) {
+		AsManifestEntry *entry = (AsManifestEntry*) value;
+
+		g_variant_builder_add (&entries_builder, AS_METAINFO_MANIFEST_ENTRY_TYPE,
+				       (const gchar*) key,
+				       entry->mtime,
+				       entry->size,
+				       entry->cid);
+	}
+
+	g_variant_builder_init (&main_builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&main_builder, "{sv}",
+				"format_version",
+				g_variant_new_uint32 (CACHE_FORMAT_VERSION));
+	g_variant_builder_add (&main_builder, "{sv}",
+				"entries",
+				g_variant_builder_end (&entries_builder));
+	main_gv = g_variant_ref_sink (g_variant_builder_end (&main_builder));
+
+	if (!g_file_set_contents (fname,
+				  g_variant_get_data (main_gv),
+				  g_variant_get_size (main_gv),
+				  error))
+		return FALSE;
+
+	manifest->dirty = FALSE;
+	return TRUE;
+}
+
+/**
+ * as_metainfo_skim_id:
+ * @fname: a metainfo file.
+ *
+ * Find the ID of the component described by a metainfo file,
+ * reading the file only up to the <id/> element.
+ *
+ * Returns: (transfer full): the component ID, or %NULL if none was found.
+ */
+gchar*
+as_metainfo_skim_id (const gchar *fname)
+{
+	xmlTextReaderPtr reader;
+	gchar *cid = NULL;
+
+	reader = xmlReaderForFile (fname, NULL, XML_PARSE_NONET | XML_PARSE_NOERROR | XML_PARSE_NOWARNING);
+	if (reader == NULL)
+		return NULL;
+
+	while (xmlTextReaderRead (reader) == 1) {
+		const gchar *name;
+		gint depth;
+
+		if (xmlTextReaderNodeType (reader) != XML_READER_TYPE_ELEMENT)
+			continue;
+
+		depth = xmlTextReaderDepth (reader);
+		name = (const gchar*) xmlTextReaderConstLocalName (reader);
+		if (depth == 0) {
+			/* this is not a metainfo file if the root isn't a single component */
+			if ((g_strcmp0 (name, "component") != 0) && (g_strcmp0 (name, "application") != 0))
+				break;
+		} else if ((depth == 1) && (g_strcmp0 (name, "id") == 0)) {
+			xmlChar *content = xmlTextReaderReadString (reader);
+
+			cid = g_strdup (g_strstrip ((gchar*) content));
+			xmlFree (content);
+			break;
+		}
+	}
+	xmlFreeTextReader (reader);
+
+	if ((cid != NULL) && (cid[0] == '\0'))
+		g_clear_pointer (&cid, g_free);
+	return cid;
+}
+
+/**
+ * as_metainfo_manifest_get_id:
+ * @manifest: an #AsMetainfoManifest
+ * @sfile: the metainfo file, with stat data.
+ *
+ * Get the component ID of @sfile, skimming the file if the
+ * manifest has no current information about it.
+ *
+ * Returns: the component ID, or %NULL if it could not be determined.
+ */
+const gchar*
+as_metainfo_manifest_get_id (AsMetainfoManifest *manifest, AsScannedFile *sfile)
+{
+	AsManifestEntry *entry;
+	g_autofree gchar *cid = NULL;
+
+	entry = g_hash_table_lookup (manifest->entries, sfile->path);
+	if ((entry == NULL) || (entry->mtime != sfile->mtime) || (entry->size != sfile->size)) {
+		cid = as_metainfo_skim_id (sfile->path);
+		as_metainfo_manifest_add_entry (manifest,
+						sfile->path,
+						sfile->mtime,
+						sfile->size,
+						(cid == NULL)? "" : cid);
+		manifest->dirty = TRUE;
+		entry = g_hash_table_lookup (manifest->entries, sfile->path);
+	}
+
+	if (entry->cid[0] == '\0')
+		return NULL;
+	return entry->cid;
+}
+
+/**
+ * as_metainfo_manifest_retain:
+ * @manifest: an #AsMetainfoManifest
+ * @sfiles: (element-type AsScannedFile): the files which currently exist.
+ *
+ * Drop the entries of files which do not exist anymore.
+ */
+void
+as_metainfo_manifest_retain (AsMetainfoManifest *manifest, GPtrArray *sfiles)
+{
+	g_autoptr(GHashTable) existing = NULL;
+	GHashTableIter iter;
+	gpointer key;
+	guint i;
+
+	existing = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < sfiles->len; i++) {
+		AsScannedFile *sfile = (AsScannedFile*) g_ptr_array_index (sfiles, i);
+		g_hash_table_add (existing, sfile->path);
+	}
+
+	g_hash_table_iter_init (&iter, manifest->entries);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if (g_hash_table_contains (existing, key))
+			continue;
+		g_hash_table_iter_remove (&iter);
+		manifest->dirty = TRUE;
+	}
+}
+
+/**
+ * as_metainfo_manifest_is_dirty:
+ * @manifest: an #AsMetainfoManifest
+ *
+ * Returns: %TRUE if the manifest was modified since it was loaded or saved.
+ */
+gboolean
+as_metainfo_manifest_is_dirty (AsMetainfoManifest *manifest)
+{
+	return manifest->dirty;
+}
@@ -0,0 +1,67 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_METAINFO_MANIFEST_H
+#define __AS_METAINFO_MANIFEST_H
+
+#include <glib-object.h>
+#include "as-dir-scanner.h"
+#include "as-settings-private.h"
+
+G_BEGIN_DECLS
+#pragma GCC visibility push(hidden)
+
+typedef struct _AsMetainfoManifest AsMetainfoManifest;
+
+AS_INTERNAL_VISIBLE
+AsMetainfoManifest	*as_metainfo_manifest_new (void);
+AS_INTERNAL_VISIBLE
+void			as_metainfo_manifest_free (AsMetainfoManifest *manifest);
+
+AS_INTERNAL_VISIBLE
+gboolean		as_metainfo_manifest_load (AsMetainfoManifest *manifest,
+						   const gchar *fname,
+						   GError **error);
+AS_INTERNAL_VISIBLE
+gboolean		as_metainfo_manifest_save (AsMetainfoManifest *manifest,
+						   const gchar *fname,
+						   GError **error);
+
+AS_INTERNAL_VISIBLE
+const gchar		*as_metainfo_manifest_get_id (AsMetainfoManifest *manifest,
+						      AsScannedFile *sfile);
+void			as_metainfo_manifest_retain (AsMetainfoManifest *manifest,
+						     GPtrArray *sfiles);
+AS_INTERNAL_VISIBLE
+gboolean		as_metainfo_manifest_is_dirty (AsMetainfoManifest *manifest);
+
+AS_INTERNAL_VISIBLE
+gchar			*as_metainfo_skim_id (const gchar *fname);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AsMetainfoManifest, as_metainfo_manifest_free)
+
+#pragma GCC visibility pop
+G_END_DECLS
+
+#endif /* __AS_METAINFO_MANIFEST_H */
@@ -0,0 +1,510 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:as-packed-text
+ * @short_description: Compressed storage for long texts.
+ * @include: appstream.h
+ *
+ * Long description markup makes up a large part of the memory used by
+ * a pool, but is usually only displayed when a user looks at the details
+ * of a component. Such texts can be stored deflate-compressed instead,
+ * and are only inflated again when they are actually read.
+ *
+ * A packed text is an opaque blob which starts with a byte that can never
+ * be part of valid UTF-8, so it can be stored in the same tables as the
+ * plain strings it replaces.
+ *
+ * Texts which are returned by getters are kept unpacked by the object which
+ * owns them, so they stay valid as long as the object does. Internal code
+ * which only needs a copy of a text uses a process-wide cache of limited
+ * size instead, which drops the least recently read texts first.
+ */
+
+#include "config.h"
+#include "as-packed-text.h"
+
+#include <string.h>
+#include <gio/gio.h>
+
+/* texts shorter than this compress badly, so we keep them as they are */
+#define AS_PACKED_TEXT_MIN_LENGTH	256
+
+/* 0xFF is never valid in UTF-8 */
+#define AS_PACKED_TEXT_MAGIC		'\xff'
+
+/* magic byte, length of the text, length of the compressed data */
+#define AS_PACKED_TEXT_HEADER_SIZE	(1 + sizeof (guint32) + sizeof (guint32))
+
+/* one (de)compressor per thread, so packing can run in parallel loaders */
+static GPrivate compressor_key = G_PRIVATE_INIT (g_object_unref);
+static GPrivate decompressor_key = G_PRIVATE_INIT (g_object_unref);
+
+/* size of the unpacked texts the shared cache keeps around at most */
+#define AS_PACKED_TEXT_CACHE_SIZE	(4 * 1024 * 1024)
+
+typedef struct
+{
+	gchar		*packed; /* a copy of the packed text, which is the key */
+	gchar		*text;
+	gsize		size;
+	GList		link; /* in the LRU queue */
+} AsPackedTextEntry;
+
+/* protects the caches of unpacked texts of the objects which own them */
+static GMutex owner_cache_mutex;
+
+/* protects the shared cache of unpacked texts */
+static GMutex cache_mutex;
+static GHashTable *cache_table = NULL; /* packed text -> AsPackedTextEntry */
+static GQueue cache_lru = G_QUEUE_INIT; /* most recently read entries first */
+static gsize cache_size = 0;
+
+/**
+ * as_packed_text_get_converter:
+ *
+ * Get a reset (de)compressor for the current thread.
+ */
+static GConverter*
+as_packed_text_get_converter (gboolean compress)
+{
+	GPrivate *key = compress? &compressor_key : &decompressor_key;
+	GConverter *conv = g_private_get (key);
+
+	if (conv == NULL) {
+		if (compress)
+			conv = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1));
+		else
+			conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+		g_private_set (key, conv);
+	} else {
+		g_converter_reset (conv);
+	}
+
+	return conv;
+}
+
+/**
+ * as_packed_text_is_packed:
+ * @data: (nullable): a string or packed text.
+ *
+ * Returns: %TRUE if @data is a packed text.
+ */
+gboolean
+as_packed_text_is_packed (const gchar *data)
+{
+	return data != NULL && data[0] == AS_PACKED_TEXT_MAGIC;
+}
+
+/**
+ * as_packed_text_pack:
+ * @text: a UTF-8 string.
+ *
+ * Compress a text, if that is worth it.
+ *
+ * Returns: (transfer full): the packed text, or %NULL if @text is too short
+ * or doesn't compress well. Free with g_free().
+ */
+gchar*
+as_packed_text_pack (const gchar *text)
+{
+	GConverter *conv;
+	GConverterResult res;
+	gsize len;
+	gsize bytes_read = 0;
+	gsize bytes_written = 0;
+	guint32 len32;
+	guint32 packed_len32;
+	gchar *blob;
+
+	if (text == NULL || as_packed_text_is_packed (text))
+		return NULL;
+	len = strlen (text);
+	if (len < AS_PACKED_TEXT_MIN_LENGTH || len > G_MAXUINT32)
+		return NULL;
+
+	/* the result has to be smaller than the text, otherwise we don't bother */
+	blob = g_malloc (len);
+	conv = as_packed_text_get_converter (TRUE);
+	res = g_converter_convert (conv,
+				   text, len,
+				   blob + AS_PACKED_TEXT_HEADER_SIZE, len - AS_PACKED_TEXT_HEADER_SIZE,
+				   G_CONVERTER_INPUT_AT_END,
+				   &bytes_read, &bytes_written,
+				   NULL);
+	if (res != G_CONVERTER_FINISHED || bytes_read != len) {
+		g_free (blob);
+		return NULL;
+	}
+
+	len32 = (guint32) len;
+	packed_len32 = (guint32) bytes_written;
+	blob[0] = AS_PACKED_TEXT_MAGIC;
+	memcpy (blob + 1, &len32, sizeof (len32));
+	memcpy (blob + 1 + sizeof (len32), &packed_len32, sizeof (packed_len32));
+
+	return g_realloc (blob, AS_PACKED_TEXT_HEADER_SIZE + bytes_written);
+}
+
+/**
+ * as_packed_text_get_size:
+ * @data: a string or packed text.
+ *
+ * Returns: the number of bytes @data occupies in memory.
+ */
+gsize
+as_packed_text_get_size (const gchar *data)
+{
+	guint32 packed_len;
+
+	if (data == NULL)
+		return 0;
+	if (!as_packed_text_is_packed (data))
+		return strlen (data) + 1;
+
+	memcpy (&packed_len, data + 1 + sizeof (guint32), sizeof (packed_len));
+	return AS_PACKED_TEXT_HEADER_SIZE + packed_len;
+}
+
+/**
+ * as_packed_text_dup:
+ * @data: (nullable): a string or packed text.
+ *
+ * Copy a string or packed text, keeping its representation.
+ *
+ * Returns: (transfer full): the copy, free with g_free().
+ */
+gchar*
+as_packed_text_dup (const gchar *data)
+{
+	gsize size;
+	gchar *res;
+
+	if (data == NULL)
+		return NULL;
+	size = as_packed_text_get_size (data);
+	res = g_malloc (size);
+	memcpy (res, data, size);
+
+	return res;
+}
+
+/**
+ * as_packed_text_unpack:
+ * @data: (nullable): a string or packed text.
+ *
+ * Get the original text of a packed text. Plain strings are just copied.
+ *
+ * Returns: (transfer full): the text, free with g_free().
+ */
+gchar*
+as_packed_text_unpack (const gchar *data)
+{
+	GConverter *conv;
+	GConverterResult res;
+	guint32 len;
+	guint32 packed_len;
+	gsize in_pos = 0;
+	gsize out_pos = 0;
+	gsize bytes_read;
+	gsize bytes_written;
+	g_autoptr(GError) error = NULL;
+	gchar *text;
+
+	if (!as_packed_text_is_packed (data))
+		return g_strdup (data);
+
+	memcpy (&len, data + 1, sizeof (len));
+	memcpy (&packed_len, data + 1 + sizeof (len), sizeof (packed_len));
+
+	/* leave some room, so zlib can always tell us that the stream has ended */
+	text = g_malloc (len + 1);
+	conv = as_packed_text_get_converter (FALSE);
+	do {
+		bytes_read = 0;
+		bytes_written = 0;
+		res = g_converter_convert (conv,
+					   data + AS_PACKED_TEXT_HEADER_SIZE + in_pos, packed_len - in_pos,
+					   text + out_pos, len + 1 - out_pos,
+					   G_CONVERTER_INPUT_AT_END,
+					   &bytes_read, &bytes_written,
+					   &error);
+		in_pos += bytes_read;
+		out_pos += bytes_written;
+	} while (res == G_CONVERTER_CONVERTED && (bytes_read > 0 || bytes_written > 0));
+
+	if (res != G_CONVERTER_FINISHED || out_pos != len) {
+		g_critical ("Unable to unpack text: %s", error != NULL? error->message : "unexpected size");
+		out_pos = 0;
+	}
+	text[out_pos] = '\0';
+
+	return text;
+}
+
+/**
+ * as_packed_text_pack_table:
+ * @table: a table of strings, with values freed by g_free().
+ *
+ * Replace all values of @table which are worth compressing with packed texts.
+ */
+void
+as_packed_text_pack_table (GHashTable *table)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	if (table == NULL)
+		return;
+
+	g_hash_table_iter_init (&iter, table);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		gchar *packed = as_packed_text_pack (value);
+		if (packed != NULL)
+			g_hash_table_iter_replace (&iter, packed);
+	}
+}
+
+/**
+ * as_packed_text_unpack_table:
+ * @table: (nullable): a table of strings and packed texts.
+ *
+ * Get a table with the original texts of @table, e.g. to serialize them.
+ * The keys are borrowed from @table, so it must outlive the returned table.
+ *
+ * Returns: (transfer full): a table of plain strings, or %NULL if @table was %NULL.
+ */
+GHashTable*
+as_packed_text_unpack_table (GHashTable *table)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	GHashTable *res;
+	gboolean have_packed = FALSE;
+
+	if (table == NULL)
+		return NULL;
+
+	g_hash_table_iter_init (&iter, table);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		if (as_packed_text_is_packed (value)) {
+			have_packed = TRUE;
+			break;
+		}
+	}
+	if (!have_packed)
+		return g_hash_table_ref (table);
+
+	res = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	g_hash_table_iter_init (&iter, table);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_hash_table_insert (res, key, as_packed_text_unpack (value));
+
+	return res;
+}
+
+/**
+ * as_packed_text_hash:
+ *
+ * Hash the contents of a packed text.
+ */
+static guint
+as_packed_text_hash (gconstpointer key)
+{
+	const guchar *data = key;
+	gsize size = as_packed_text_get_size (key);
+	guint hash = 5381;
+	gsize i;
+
+	for (i = 0; i < size; i++)
+		hash = (hash << 5) + hash + data[i];
+	return hash;
+}
+
+/**
+ * as_packed_text_equal:
+ *
+ * Compare the contents of two packed texts.
+ */
+static gboolean
+as_packed_text_equal (gconstpointer a, gconstpointer b)
+{
+	gsize size = as_packed_text_get_size (a);
+
+	if (size != as_packed_text_get_size (b))
+		return FALSE;
+	return memcmp (a, b, size) == 0;
+}
+
+/**
+ * as_packed_text_cache_entry_free:
+ */
+static void
+as_packed_text_cache_entry_free (AsPackedTextEntry *entry)
+{
+	g_free (entry->packed);
+	g_free (entry->text);
+	g_slice_free (AsPackedTextEntry, entry);
+}
+
+/**
+ * as_packed_text_cache_trim:
+ *
+ * Drop the least recently read texts until the cache fits its size again.
+ * The cache lock must be held.
+ */
+static void
+as_packed_text_cache_trim (void)
+{
+	/* always keep the text which was just added */
+	while (cache_size > AS_PACKED_TEXT_CACHE_SIZE && cache_lru.length > 1) {
+		AsPackedTextEntry *entry = g_queue_peek_tail (&cache_lru);
+
+		g_queue_unlink (&cache_lru, &entry->link);
+		cache_size -= entry->size;
+		g_hash_table_remove (cache_table, entry->packed);
+	}
+}
+
+/**
+ * as_packed_text_get:
+ * @cache: (inout): location of a cache of unpacked texts, created on demand.
+ * @data: (nullable): a string or packed text.
+ *
+ * Get the original text for @data, for returning it from a getter.
+ * Unpacked texts are kept in @cache, so they stay valid and repeated reads are cheap.
+ * The cache holds the texts by their packed contents, so it stays correct when
+ * the owner of @data replaces it with an identical copy, e.g. when reading it back
+ * from a cache. The owner must drop @cache when it sets a different text.
+ *
+ * Returns: the plain text.
+ */
+const gchar*
+as_packed_text_get (GHashTable **cache, const gchar *data)
+{
+	const gchar *text;
+	gchar *unpacked;
+
+	if (!as_packed_text_is_packed (data))
+		return data;
+
+	g_mutex_lock (&owner_cache_mutex);
+	text = *cache != NULL? g_hash_table_lookup (*cache, data) : NULL;
+	g_mutex_unlock (&owner_cache_mutex);
+	if (text != NULL)
+		return text;
+
+	unpacked = as_packed_text_unpack (data);
+
+	g_mutex_lock (&owner_cache_mutex);
+	if (*cache == NULL)
+		*cache = g_hash_table_new_full (as_packed_text_hash, as_packed_text_equal, g_free, g_free);
+	text = g_hash_table_lookup (*cache, data);
+	if (text == NULL) {
+		g_hash_table_insert (*cache, as_packed_text_dup (data), unpacked);
+		text = unpacked;
+	} else {
+		/* another thread was faster */
+		g_free (unpacked);
+	}
+	g_mutex_unlock (&owner_cache_mutex);
+
+	return text;
+}
+
+/**
+ * as_packed_text_unpack_cached:
+ * @data: (nullable): a string or packed text.
+ *
+ * Get a copy of the original text for @data, like as_packed_text_unpack().
+ * Unpacked texts are kept in a process-wide cache of limited size, which
+ * is shared by all objects, so repeated reads of the same text, e.g. for
+ * building search tokens, are cheap.
+ *
+ * Returns: (transfer full): the text, free with g_free().
+ */
+gchar*
+as_packed_text_unpack_cached (const gchar *data)
+{
+	AsPackedTextEntry *entry;
+	gchar *unpacked;
+	gchar *text;
+
+	if (!as_packed_text_is_packed (data))
+		return g_strdup (data);
+
+	g_mutex_lock (&cache_mutex);
+	entry = cache_table != NULL? g_hash_table_lookup (cache_table, data) : NULL;
+	if (entry != NULL) {
+		g_queue_unlink (&cache_lru, &entry->link);
+		g_queue_push_head_link (&cache_lru, &entry->link);
+		text = g_strdup (entry->text);
+		g_mutex_unlock (&cache_mutex);
+		return text;
+	}
+	g_mutex_unlock (&cache_mutex);
+
+	unpacked = as_packed_text_unpack (data);
+	text = g_strdup (unpacked);
+
+	g_mutex_lock (&cache_mutex);
+	if (cache_table == NULL)
+		cache_table = g_hash_table_new_full (as_packed_text_hash,
+						     as_packed_text_equal,
+						     NULL,
+						     (GDestroyNotify) as_packed_text_cache_entry_free);
+	entry = g_hash_table_lookup (cache_table, data);
+	if (entry == NULL) {
+		entry = g_slice_new0 (AsPackedTextEntry);
+		entry->packed = as_packed_text_dup (data);
+		entry->text = unpacked;
+		entry->size = as_packed_text_get_size (entry->packed) + strlen (unpacked) + 1;
+		entry->link.data = entry;
+		g_hash_table_insert (cache_table, entry->packed, entry);
+		g_queue_push_head_link (&cache_lru, &entry->link);
+		cache_size += entry->size;
+		as_packed_text_cache_trim ();
+	} else {
+		/* another thread was faster */
+		g_queue_unlink (&cache_lru, &entry->link);
+		g_queue_push_head_link (&cache_lru, &entry->link);
+		g_free (unpacked);
+	}
+	g_mutex_unlock (&cache_mutex);
+
+	return text;
+}
+
+/**
+ * as_packed_text_get_cache_size:
+ *
+ * Returns: the memory used by the shared cache of unpacked texts.
+ */
+gsize
+as_packed_text_get_cache_size (void)
+{
+	gsize size;
+
+	g_mutex_lock (&cache_mutex);
+	size = cache_size;
+	g_mutex_unlock (&cache_mutex);
+
+	return size;
+}
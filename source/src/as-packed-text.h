@@ -0,0 +1,58 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_PACKED_TEXT_H
+#define __AS_PACKED_TEXT_H
+
+#include <glib.h>
+#include "as-settings-private.h"
+
+G_BEGIN_DECLS
+#pragma GCC visibility push(hidden)
+
+AS_INTERNAL_VISIBLE
+gchar			*as_packed_text_pack (const gchar *text);
+AS_INTERNAL_VISIBLE
+gboolean		as_packed_text_is_packed (const gchar *data);
+AS_INTERNAL_VISIBLE
+gchar			*as_packed_text_unpack (const gchar *data);
+AS_INTERNAL_VISIBLE
+gsize			as_packed_text_get_size (const gchar *data);
+gchar			*as_packed_text_dup (const gchar *data);
+
+void			as_packed_text_pack_table (GHashTable *table);
+GHashTable		*as_packed_text_unpack_table (GHashTable *table);
+
+AS_INTERNAL_VISIBLE
+const gchar		*as_packed_text_get (GHashTable **cache,
+					     const gchar *data);
+AS_INTERNAL_VISIBLE
+gchar			*as_packed_text_unpack_cached (const gchar *data);
+AS_INTERNAL_VISIBLE
+gsize			as_packed_text_get_cache_size (void);
+
+#pragma GCC visibility pop
+G_END_DECLS
+
+#endif /* __AS_PACKED_TEXT_H */
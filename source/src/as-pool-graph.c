@@ -0,0 +1,344 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:as-pool-graph
+ * @short_description: Relations between the components of a pool
+ * @include: appstream.h
+ *
+ * Stores which component-IDs extend, suggest, require or recommend which
+ * other component-IDs, in both directions, together with the data-IDs
+ * of the components every component-ID belongs to.
+ * That way, the components related to a component can be found without
+ * walking the whole pool.
+ * This is a private/internal API.
+ */
+
+#include "config.h"
+#include "as-pool-graph.h"
+
+#include "as-utils-private.h"
+#include "as-intern.h"
+#include "as-suggested.h"
+#include "as-relation.h"
+
+struct _AsPoolGraph
+{
+	GHashTable	*nodes; /* cid -> GPtrArray of data-IDs */
+	GHashTable	*targets[AS_POOL_LINK_KIND_LAST]; /* cid -> GPtrArray of the cids it links to */
+	GHashTable	*sources[AS_POOL_LINK_KIND_LAST]; /* cid -> GPtrArray of the cids linking to it */
+};
+
+/**
+ * as_pool_graph_table_new:
+ *
+ * Create a table of interned strings to arrays of interned strings.
+ */
+static GHashTable*
+as_pool_graph_table_new (void)
+{
+	return g_hash_table_new_full (g_str_hash,
+				      g_str_equal,
+				      (GDestroyNotify) as_intern_unref,
+				      (GDestroyNotify) g_ptr_array_unref);
+}
+
+/**
+ * as_pool_graph_table_add:
+ *
+ * Add @value to the array of @key, unless it is in there already.
+ *
+ * Returns: %TRUE if @value was added.
+ */
+static gboolean
+as_pool_graph_table_add (GHashTable *table, const gchar *key, const gchar *value)
+{
+	GPtrArray *values;
+	guint i;
+
+	values = g_hash_table_lookup (table, key);
+	if (values == NULL) {
+		values = g_ptr_array_new_with_free_func ((GDestroyNotify) as_intern_unref);
+		g_hash_table_insert (table, (gpointer) as_intern_ref (key), values);
+	}
+
+	for (i = 0; i < values->len; i++) {
+		if (g_strcmp0 (g_ptr_array_index (values, i), value) == 0)
+			return FALSE;
+	}
+	g_ptr_array_add (values, (gpointer) as_intern_ref (value));
+
+	return TRUE;
+}
+
+/**
+ * as_pool_graph_new:
+ *
+ * Create an empty graph.
+ */
+AsPoolGraph*
+as_pool_graph_new (void)
+{
+	AsPoolGraph *graph;
+	guint i;
+
+	graph = g_slice_new0 (AsPoolGraph);
+	graph->nodes = as_pool_graph_table_new ();
+	for (i = AS_POOL_LINK_KIND_UNKNOWN + 1; i < AS_POOL_LINK_KIND_LAST; i++) {
+		graph->targets[i] = as_pool_graph_table_new ();
+		graph->sources[i] = as_pool_graph_table_new ();
+	}
+
+	return graph;
+}
+
+/**
+ * as_pool_graph_free:
+ * @graph: an #AsPoolGraph
+ *
+ * Free a graph.
+ */
+void
+as_pool_graph_free (AsPoolGraph *graph)
+{
+	guint i;
+
+	if (graph == NULL)
+		return;
+	g_hash_table_unref (graph->nodes);
+	for (i = AS_POOL_LINK_KIND_UNKNOWN + 1; i < AS_POOL_LINK_KIND_LAST; i++) {
+		g_hash_table_unref (graph->targets[i]);
+		g_hash_table_unref (graph->sources[i]);
+	}
+	g_slice_free (AsPoolGraph, graph);
+}
+
+/**
+ * as_pool_graph_add_node:
+ * @graph: an #AsPoolGraph
+ * @cid: the component-ID of a component
+ * @data_id: the data-ID of the same component
+ *
+ * Register a component, so links to its component-ID can be resolved.
+ */
+void
+as_pool_graph_add_node (AsPoolGraph *graph, const gchar *cid, const gchar *data_id)
+{
+	if (cid == NULL || data_id == NULL)
+		return;
+	as_pool_graph_table_add (graph->nodes, cid, data_id);
+}
+
+/**
+ * as_pool_graph_get_nodes:
+ * @graph: an #AsPoolGraph
+ * @cid: a component-ID
+ *
+ * Returns: (transfer none) (element-type utf8) (nullable): the data-IDs of
+ *          all components with @cid, or %NULL if there are none.
+ */
+GPtrArray*
+as_pool_graph_get_nodes (AsPoolGraph *graph, const gchar *cid)
+{
+	return g_hash_table_lookup (graph->nodes, cid);
+}
+
+/**
+ * as_pool_graph_add_link:
+ * @graph: an #AsPoolGraph
+ * @kind: the #AsPoolLinkKind
+ * @source: the component-ID the link starts at
+ * @target: the component-ID the link points to
+ *
+ * Add a link between two component-IDs. Links which exist already are ignored.
+ */
+void
+as_pool_graph_add_link (AsPoolGraph *graph, AsPoolLinkKind kind, const gchar *source, const gchar *target)
+{
+	g_return_if_fail (kind > AS_POOL_LINK_KIND_UNKNOWN && kind < AS_POOL_LINK_KIND_LAST);
+
+	if (as_str_empty (source) || as_str_empty (target))
+		return;
+	if (as_pool_graph_table_add (graph->targets[kind], source, target))
+		as_pool_graph_table_add (graph->sources[kind], target, source);
+}
+
+/**
+ * as_pool_graph_add_relations:
+ *
+ * Add links for all relations of @relations which reference a component.
+ */
+static void
+as_pool_graph_add_relations (AsPoolGraph *graph, AsPoolLinkKind kind, const gchar *cid, GPtrArray *relations)
+{
+	guint i;
+
+	if (relations == NULL)
+		return;
+	for (i = 0; i < relations->len; i++) {
+		AsRelation *relation = AS_RELATION (g_ptr_array_index (relations, i));
+
+		if (as_relation_get_item_kind (relation) != AS_RELATION_ITEM_KIND_ID)
+			continue;
+		as_pool_graph_add_link (graph, kind, cid, as_relation_get_value (relation));
+	}
+}
+
+/**
+ * as_pool_graph_add_links:
+ * @graph: an #AsPoolGraph
+ * @cpt: an #AsComponent
+ *
+ * Add the links to other components which are defined by @cpt.
+ */
+void
+as_pool_graph_add_links (AsPoolGraph *graph, AsComponent *cpt)
+{
+	GPtrArray *extends;
+	GPtrArray *suggestions;
+	const gchar *cid;
+	guint i, j;
+
+	cid = as_component_get_id (cpt);
+	if (cid == NULL)
+		return;
+
+	extends = as_component_get_extends (cpt);
+	if (extends != NULL) {
+		for (i = 0; i < extends->len; i++)
+			as_pool_graph_add_link (graph,
+						AS_POOL_LINK_KIND_EXTENDS,
+						cid,
+						(const gchar*) g_ptr_array_index (extends, i));
+	}
+
+	suggestions = as_component_get_suggested (cpt);
+	if (suggestions != NULL) {
+		for (i = 0; i < suggestions->len; i++) {
+			GPtrArray *ids = as_suggested_get_ids (AS_SUGGESTED (g_ptr_array_index (suggestions, i)));
+
+			for (j = 0; j < ids->len; j++)
+				as_pool_graph_add_link (graph,
+							AS_POOL_LINK_KIND_SUGGESTS,
+							cid,
+							(const gchar*) g_ptr_array_index (ids, j));
+		}
+	}
+
+	as_pool_graph_add_relations (graph,
+				     AS_POOL_LINK_KIND_REQUIRES,
+				     cid,
+				     as_component_get_requires (cpt));
+	as_pool_graph_add_relations (graph,
+				     AS_POOL_LINK_KIND_RECOMMENDS,
+				     cid,
+				     as_component_get_recommends (cpt));
+}
+
+/**
+ * as_pool_graph_get_targets:
+ * @graph: an #AsPoolGraph
+ * @cid: a component-ID
+ * @kind: the #AsPoolLinkKind
+ *
+ * Returns: (transfer none) (element-type utf8) (nullable): the component-IDs
+ *          @cid links to, or %NULL if there are none.
+ */
+GPtrArray*
+as_pool_graph_get_targets (AsPoolGraph *graph, const gchar *cid, AsPoolLinkKind kind)
+{
+	g_return_val_if_fail (kind > AS_POOL_LINK_KIND_UNKNOWN && kind < AS_POOL_LINK_KIND_LAST, NULL);
+	return g_hash_table_lookup (graph->targets[kind], cid);
+}
+
+/**
+ * as_pool_graph_get_sources:
+ * @graph: an #AsPoolGraph
+ * @cid: a component-ID
+ * @kind: the #AsPoolLinkKind
+ *
+ * Returns: (transfer none) (element-type utf8) (nullable): the component-IDs
+ *          which link to @cid, or %NULL if there are none.
+ */
+GPtrArray*
+as_pool_graph_get_sources (AsPoolGraph *graph, const gchar *cid, AsPoolLinkKind kind)
+{
+	g_return_val_if_fail (kind > AS_POOL_LINK_KIND_UNKNOWN && kind < AS_POOL_LINK_KIND_LAST, NULL);
+	return g_hash_table_lookup (graph->sources[kind], cid);
+}
+
+/**
+ * as_pool_graph_links_to_variant:
+ * @graph: an #AsPoolGraph
+ *
+ * Serialize the links of @graph, as an array of (kind, source, target)
+ * tuples. The nodes are not included, they belong to the components.
+ *
+ * Returns: (transfer floating): a #GVariant of type "a(uss)".
+ */
+GVariant*
+as_pool_graph_links_to_variant (AsPoolGraph *graph)
+{
+	GVariantBuilder builder;
+	guint kind;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(uss)"));
+	for (kind = AS_POOL_LINK_KIND_UNKNOWN + 1; kind < AS_POOL_LINK_KIND_LAST; kind++) {
+		GHashTableIter iter;
+		gpointer key, value;
+
+		g_hash_table_iter_init (&iter, graph->targets[kind]);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			GPtrArray *targets = (GPtrArray*) value;
+			guint i;
+
+			for (i = 0; i < targets->len; i++)
+				g_variant_builder_add (&builder, "(uss)",
+						       kind,
+						       (const gchar*) key,
+						       (const gchar*) g_ptr_array_index (targets, i));
+		}
+	}
+
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * as_pool_graph_add_links_from_variant:
+ * @graph: an #AsPoolGraph
+ * @links: a #GVariant created by as_pool_graph_links_to_variant()
+ *
+ * Add serialized links to @graph. Links of kinds we do not know are skipped.
+ */
+void
+as_pool_graph_add_links_from_variant (AsPoolGraph *graph, GVariant *links)
+{
+	GVariantIter iter;
+	guint32 kind;
+	const gchar *source;
+	const gchar *target;
+
+	g_variant_iter_init (&iter, links);
+	while (g_variant_iter_next (&iter, "(u&s&s)", &kind, &source, &target)) {
+		if (kind <= AS_POOL_LINK_KIND_UNKNOWN || kind >= AS_POOL_LINK_KIND_LAST)
+			continue;
+		as_pool_graph_add_link (graph, (AsPoolLinkKind) kind, source, target);
+	}
+}
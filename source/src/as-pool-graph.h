@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2017 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_POOL_GRAPH_H
+#define __AS_POOL_GRAPH_H
+
+#include <glib.h>
+#include "as-pool.h"
+#include "as-component.h"
+#include "as-settings-private.h"
+
+G_BEGIN_DECLS
+#pragma GCC visibility push(hidden)
+
+typedef struct _AsPoolGraph AsPoolGraph;
+
+AsPoolGraph		*as_pool_graph_new (void);
+void			as_pool_graph_free (AsPoolGraph *graph);
+
+void			as_pool_graph_add_node (AsPoolGraph *graph,
+						const gchar *cid,
+						const gchar *data_id);
+GPtrArray		*as_pool_graph_get_nodes (AsPoolGraph *graph,
+						  const gchar *cid);
+
+void			as_pool_graph_add_link (AsPoolGraph *graph,
+						AsPoolLinkKind kind,
+						const gchar *source,
+						const gchar *target);
+void			as_pool_graph_add_links (AsPoolGraph *graph,
+						 AsComponent *cpt);
+GPtrArray		*as_pool_graph_get_targets (AsPoolGraph *graph,
+						    const gchar *cid,
+						    AsPoolLinkKind kind);
+GPtrArray		*as_pool_graph_get_sources (AsPoolGraph *graph,
+						    const gchar *cid,
+						    AsPoolLinkKind kind);
+
+GVariant		*as_pool_graph_links_to_variant (AsPoolGraph *graph);
+void			as_pool_graph_add_links_from_variant (AsPoolGraph *graph,
+							      GVariant *links);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AsPoolGraph, as_pool_graph_free)
+
+#pragma GCC visibility pop
+G_END_DECLS
+
+#endif /* __AS_POOL_GRAPH_H */
@@ -28,6 +28,15 @@ G_BEGIN_DECLS
 #pragma GCC visibility push(hidden)
 
 time_t			as_pool_get_cache_age (AsPool *pool);
+AS_INTERNAL_VISIBLE
+void			as_pool_set_system_cache_dir (AsPool *pool,
+						      const gchar *dir);
+
+gboolean		as_pool_component_replaces (AsComponent *existing,
+						    AsComponent *cpt,
+						    const gchar *current_arch);
+gchar			**as_pool_build_search_terms (AsPool *pool,
+						      const gchar *search);
 
 AS_INTERNAL_VISIBLE
 void			as_cache_file_save (const gchar *fname,
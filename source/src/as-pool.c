@@ -33,12 +33,18 @@
  *
  * An AppStream cache object can also be created and read using the appstreamcli(1) utility.
  *
+ * Queries on an #AsPool may be run from any number of threads at the same time.
+ * They operate on an immutable snapshot of the pool contents, which is replaced
+ * in one step when new data is loaded, so a query never sees partially loaded data.
+ * Functions modifying the pool must not be called concurrently with each other.
+ *
  * See also: #AsComponent
  */
 
 #include "config.h"
 #include "as-pool.h"
 #include "as-pool-private.h"
+#include "as-pool-graph.h"
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -47,6 +53,7 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <errno.h>
 
 #include "as-utils.h"
 #include "as-utils-private.h"
@@ -56,13 +63,50 @@
 #include "as-distro-extras.h"
 #include "as-stemmer.h"
 #include "as-variant-cache.h"
+#include "as-intern.h"
 
 #include "as-metadata.h"
+#include "as-metadata-private.h"
+#include "as-dir-scanner.h"
+#include "as-desktop-cache.h"
+#include "as-metainfo-manifest.h"
+
+typedef struct {
+	volatile gint		ref_count;
+	AsPoolProgressCallback	cb;
+	gpointer		data;
+	GDestroyNotify		data_free;
+} AsPoolProgressNotify;
+
+typedef struct
+{
+	AsPool			*loader; /* the pool the data is loaded into */
+	GCancellable		*cancellable;
+	GMainContext		*context;
+	AsPoolProgressNotify	*progress;
+
+	AsPoolLoadPhase		phase;
+	guint			files_scanned;
+	guint			cpts_parsed;
+	gint64			last_report;
+
+	gboolean		ret;
+	GError			*error;
+} AsPoolLoadState;
+
+typedef struct
+{
+	volatile gint		ref_count;
+	GPtrArray		*cpts; /* of AsComponent */
+	GPtrArray		*evicted; /* of AsComponentHeavy, evicted while this was current */
+} AsPoolSnapshot;
 
 typedef struct
 {
 	GHashTable *cpt_table;
 	GHashTable *known_cids;
+	GHashTable *content_hashes; /* content hash -> data-ID of the first component with it */
+	GHashTable *pending_metainfo; /* cid -> metainfo file not parsed yet */
 	gchar *screenshot_service_url;
 	gchar *locale;
 	gchar *current_arch;
@@ -75,13 +119,43 @@ typedef struct
 
 	AsPoolFlags flags;
 	AsCacheFlags cache_flags;
+	AsLoadProfile load_profile;
 	gboolean prefer_local_metainfo;
 
+	gsize memory_budget; /* bytes of evictable component data to keep, 0 for no limit */
+
 	gchar *sys_cache_path;
 	gchar *user_cache_path;
 	time_t cache_ctime;
+
+	AsPoolLoadState *load_state; /* set while this pool is used to load data */
+
+	GMutex mutex; /* protects the published snapshot against changes of the pool data */
+	AsPoolSnapshot *snapshot; /* the published pool contents, or %NULL if they changed since */
+	AsPoolGraph *graph; /* relations between the components, or %NULL if they changed since */
+
+	GHashTable *file_cpts; /* filename -> GPtrArray of the components read from it */
+	gboolean collection_from_cache; /* whether collection data was read from the cache, without file information */
+	GPtrArray *monitors; /* of GFileMonitor */
+	GHashTable *changed_files; /* filename -> AsPoolFileKind */
+	guint changes_timeout_id;
 } AsPoolPrivate;
 
+typedef enum {
+	AS_POOL_FILE_KIND_COLLECTION,
+	AS_POOL_FILE_KIND_METAINFO,
+	AS_POOL_FILE_KIND_DESKTOP_ENTRY
+} AsPoolFileKind;
+
+enum {
+	SIGNAL_COMPONENTS_ADDED,
+	SIGNAL_COMPONENTS_REMOVED,
+	SIGNAL_COMPONENTS_CHANGED,
+	SIGNAL_LAST
+};
+
+static guint signals[SIGNAL_LAST] = { 0 };
+
 G_DEFINE_TYPE_WITH_PRIVATE (AsPool, as_pool, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (as_pool_get_instance_private (o))
 
@@ -110,6 +184,12 @@ static gchar *APPLICATIONS_DIR = "/usr/share/applications";
 static gchar *METAINFO_DIR = "/usr/share/metainfo";
 
 static void as_pool_add_metadata_location_internal (AsPool *pool, const gchar *directory, gboolean add_root);
+static void as_pool_clear_monitors (AsPool *pool);
+static void as_pool_setup_monitors (AsPool *pool);
+static GPtrArray *as_cache_file_read_internal (const gchar *fname,
+						const gchar *map_dir,
+						AsPoolGraph **links,
+						GError **error);
 
 /**
  * as_pool_check_cache_ctime:
@@ -133,6 +213,151 @@ as_pool_check_cache_ctime (AsPool *pool)
 		priv->cache_ctime = cache_sbuf.st_ctime;
 }
 
+/**
+ * as_pool_snapshot_new:
+ * @cpt_table: The components to publish, by data-ID.
+ *
+ * Create a new snapshot of the components in @cpt_table.
+ */
+static AsPoolSnapshot*
+as_pool_snapshot_new (GHashTable *cpt_table)
+{
+	AsPoolSnapshot *snapshot;
+	GHashTableIter iter;
+	gpointer value;
+
+	snapshot = g_slice_new0 (AsPoolSnapshot);
+	snapshot->ref_count = 1;
+	snapshot->cpts = g_ptr_array_new_full (g_hash_table_size (cpt_table), g_object_unref);
+
+	g_hash_table_iter_init (&iter, cpt_table);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		g_ptr_array_add (snapshot->cpts, g_object_ref (value));
+
+	return snapshot;
+}
+
+/**
+ * as_pool_snapshot_ref:
+ */
+static AsPoolSnapshot*
+as_pool_snapshot_ref (AsPoolSnapshot *snapshot)
+{
+	g_atomic_int_inc (&snapshot->ref_count);
+	return snapshot;
+}
+
+/**
+ * as_pool_snapshot_unref:
+ */
+static void
+as_pool_snapshot_unref (AsPoolSnapshot *snapshot)
+{
+	if (!g_atomic_int_dec_and_test (&snapshot->ref_count))
+		return;
+	g_ptr_array_unref (snapshot->cpts);
+	if (snapshot->evicted != NULL)
+		g_ptr_array_unref (snapshot->evicted);
+	g_slice_free (AsPoolSnapshot, snapshot);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AsPoolSnapshot, as_pool_snapshot_unref)
+
+/**
+ * as_pool_invalidate_snapshot:
+ *
+ * Drop the published snapshot and the component relations after
+ * the pool data was modified.
+ * The pool lock must be held.
+ */
+static void
+as_pool_invalidate_snapshot (AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	g_clear_pointer (&priv->graph, as_pool_graph_free);
+	if (priv->snapshot == NULL)
+		return;
+	as_pool_snapshot_unref (priv->snapshot);
+	priv->snapshot = NULL;
+}
+
+/**
+ * as_pool_cmp_heavy_used:
+ *
+ * Sort components by the last access to their evictable data, oldest first.
+ */
+static gint
+as_pool_cmp_heavy_used (gconstpointer a, gconstpointer b)
+{
+	gint used_a = as_component_get_heavy_used (*((AsComponent **) a));
+	gint used_b = as_component_get_heavy_used (*((AsComponent **) b));
+
+	if (used_a < used_b)
+		return -1;
+	if (used_a > used_b)
+		return 1;
+	return 0;
+}
+
+/**
+ * as_pool_trim_memory:
+ *
+ * Evict the long descriptions, screenshots and releases of the least
+ * recently used components until the pool is within its memory budget.
+ * Callers may still use pointers into the evicted data, so it is kept with
+ * the current snapshot, and freed once the pool contents have changed and
+ * no query uses that snapshot anymore.
+ * This must not be called from queries, as evicting data they hand out
+ * would make it grow with the number of queries. The pool lock must be held.
+ */
+static void
+as_pool_trim_memory (AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	GHashTableIter iter;
+	gpointer value;
+	g_autoptr(GPtrArray) resident = NULL;
+	gsize total = 0;
+	guint i;
+
+	if (priv->memory_budget == 0)
+		return;
+
+	resident = g_ptr_array_new ();
+	g_hash_table_iter_init (&iter, priv->cpt_table);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		AsComponent *cpt = AS_COMPONENT (value);
+		gsize size = as_component_get_heavy_size (cpt);
+
+		if (size == 0 || as_component_is_heavy_evicted (cpt))
+			continue;
+		total += size;
+		g_ptr_array_add (resident, cpt);
+	}
+	if (total <= priv->memory_budget)
+		return;
+
+	if (priv->snapshot == NULL)
+		priv->snapshot = as_pool_snapshot_new (priv->cpt_table);
+	if (priv->snapshot->evicted == NULL)
+		priv->snapshot->evicted = g_ptr_array_new_with_free_func ((GDestroyNotify) as_component_heavy_free);
+
+	g_ptr_array_sort (resident, as_pool_cmp_heavy_used);
+	for (i = 0; i < resident->len && total > priv->memory_budget; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (resident, i));
+		AsComponentHeavy *heavy = as_component_evict_heavy (cpt);
+
+		if (heavy == NULL)
+			continue;
+		total -= as_component_get_heavy_size (cpt);
+		g_ptr_array_add (priv->snapshot->evicted, heavy);
+	}
+
+	g_debug ("Evicted data of %u components to stay within the memory budget.",
+		 priv->snapshot->evicted->len);
+}
+
 /**
  * as_pool_init:
  **/
@@ -146,18 +371,43 @@ as_pool_init (AsPool *pool)
 	/* set active locale */
 	priv->locale = as_get_current_locale ();
 
+	g_mutex_init (&priv->mutex);
+
 	/* stores known components */
 	priv->cpt_table = g_hash_table_new_full (g_str_hash,
 						g_str_equal,
-						g_free,
+						(GDestroyNotify) as_intern_unref,
 						(GDestroyNotify) g_object_unref);
 
 	/* set which stores whether we have seen a component-ID already */
 	priv->known_cids = g_hash_table_new_full (g_str_hash,
 						  g_str_equal,
-						  g_free,
+						  (GDestroyNotify) as_intern_unref,
 						  NULL);
 
+	/* finds components with identical data, to share it */
+	priv->content_hashes = g_hash_table_new_full (g_str_hash,
+						      g_str_equal,
+						      g_free,
+						      (GDestroyNotify) as_intern_unref);
+
+	/* metainfo files which will only be parsed once their component is requested */
+	priv->pending_metainfo = g_hash_table_new_full (g_str_hash,
+							g_str_equal,
+							g_free,
+							g_free);
+
+	/* components of every file we read, only used if we monitor files */
+	priv->file_cpts = g_hash_table_new_full (g_str_hash,
+						 g_str_equal,
+						 g_free,
+						 (GDestroyNotify) g_ptr_array_unref);
+	priv->monitors = g_ptr_array_new_with_free_func (g_object_unref);
+	priv->changed_files = g_hash_table_new_full (g_str_hash,
+						     g_str_equal,
+						     g_free,
+						     NULL);
+
 	priv->xml_dirs = g_ptr_array_new_with_free_func (g_free);
 	priv->yaml_dirs = g_ptr_array_new_with_free_func (g_free);
 	priv->icon_dirs = g_ptr_array_new_with_free_func (g_free);
@@ -171,6 +421,9 @@ as_pool_init (AsPool *pool)
 	/* system-wide cache locations */
 	priv->sys_cache_path = g_strdup (AS_APPSTREAM_CACHE_PATH);
 
+	/* per-user cache location */
+	priv->user_cache_path = g_build_filename (g_get_user_cache_dir (), "appstream", NULL);
+
 	if (as_utils_is_root ()) {
 		/* users umask shouldn't interfere with us creating new files when we are root */
 		as_reset_umask ();
@@ -203,6 +456,9 @@ as_pool_init (AsPool *pool)
 
 	/* set default cache flags */
 	priv->cache_flags = AS_CACHE_FLAG_USE_SYSTEM | AS_CACHE_FLAG_USE_USER;
+
+	/* load all data by default */
+	priv->load_profile = AS_LOAD_PROFILE_FULL;
 }
 
 /**
@@ -215,8 +471,17 @@ as_pool_finalize (GObject *object)
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
 	g_free (priv->screenshot_service_url);
+	as_pool_invalidate_snapshot (pool);
+	g_mutex_clear (&priv->mutex);
 	g_hash_table_unref (priv->cpt_table);
 	g_hash_table_unref (priv->known_cids);
+	g_hash_table_unref (priv->content_hashes);
+	g_hash_table_unref (priv->pending_metainfo);
+
+	as_pool_clear_monitors (pool);
+	g_ptr_array_unref (priv->monitors);
+	g_hash_table_unref (priv->changed_files);
+	g_hash_table_unref (priv->file_cpts);
 
 	g_ptr_array_unref (priv->xml_dirs);
 	g_ptr_array_unref (priv->yaml_dirs);
@@ -241,6 +506,255 @@ as_pool_class_init (AsPoolClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	object_class->finalize = as_pool_finalize;
+
+	/**
+	 * AsPool::components-added:
+	 * @pool: the #AsPool
+	 * @cpts: (element-type AsComponent): the new components
+	 *
+	 * Emitted when a monitored metadata file introduced new components.
+	 *
+	 * Since: 0.12.1
+	 */
+	signals[SIGNAL_COMPONENTS_ADDED] =
+		g_signal_new ("components-added",
+			      G_TYPE_FROM_CLASS (object_class),
+			      G_SIGNAL_RUN_LAST,
+			      0, NULL, NULL,
+			      g_cclosure_marshal_VOID__BOXED,
+			      G_TYPE_NONE, 1, G_TYPE_PTR_ARRAY);
+
+	/**
+	 * AsPool::components-removed:
+	 * @pool: the #AsPool
+	 * @cpts: (element-type AsComponent): the components which were removed
+	 *
+	 * Emitted when components were removed from the pool because
+	 * a monitored metadata file was changed or deleted.
+	 *
+	 * Since: 0.12.1
+	 */
+	signals[SIGNAL_COMPONENTS_REMOVED] =
+		g_signal_new ("components-removed",
+			      G_TYPE_FROM_CLASS (object_class),
+			      G_SIGNAL_RUN_LAST,
+			      0, NULL, NULL,
+			      g_cclosure_marshal_VOID__BOXED,
+			      G_TYPE_NONE, 1, G_TYPE_PTR_ARRAY);
+
+	/**
+	 * AsPool::components-changed:
+	 * @pool: the #AsPool
+	 * @cpts: (element-type AsComponent): the new versions of the changed components
+	 *
+	 * Emitted when components were replaced with new data because
+	 * a monitored metadata file was changed.
+	 *
+	 * Since: 0.12.1
+	 */
+	signals[SIGNAL_COMPONENTS_CHANGED] =
+		g_signal_new ("components-changed",
+			      G_TYPE_FROM_CLASS (object_class),
+			      G_SIGNAL_RUN_LAST,
+			      0, NULL, NULL,
+			      g_cclosure_marshal_VOID__BOXED,
+			      G_TYPE_NONE, 1, G_TYPE_PTR_ARRAY);
+}
+
+/**
+ * as_pool_load_cancelled:
+ *
+ * Returns: %TRUE if the load operation this pool is used for was cancelled.
+ */
+static gboolean
+as_pool_load_cancelled (AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	if (priv->load_state == NULL)
+		return FALSE;
+	return g_cancellable_is_cancelled (priv->load_state->cancellable);
+}
+
+typedef struct {
+	AsPoolProgressNotify	*notify;
+	AsPoolLoadPhase		phase;
+	guint			files_scanned;
+	guint			cpts_parsed;
+} AsPoolProgressReport;
+
+/**
+ * as_pool_progress_notify_new:
+ *
+ * Wrap the progress callback of a load, so its user data is released
+ * once the load and all of its pending reports are done.
+ */
+static AsPoolProgressNotify*
+as_pool_progress_notify_new (AsPoolProgressCallback cb, gpointer data, GDestroyNotify data_free)
+{
+	AsPoolProgressNotify *notify;
+
+	notify = g_slice_new0 (AsPoolProgressNotify);
+	notify->ref_count = 1;
+	notify->cb = cb;
+	notify->data = data;
+	notify->data_free = data_free;
+	return notify;
+}
+
+/**
+ * as_pool_progress_notify_unref:
+ */
+static void
+as_pool_progress_notify_unref (AsPoolProgressNotify *notify)
+{
+	if (!g_atomic_int_dec_and_test (&notify->ref_count))
+		return;
+	if (notify->data_free != NULL)
+		notify->data_free (notify->data);
+	g_slice_free (AsPoolProgressNotify, notify);
+}
+
+/**
+ * as_pool_progress_report_free:
+ */
+static void
+as_pool_progress_report_free (AsPoolProgressReport *report)
+{
+	as_pool_progress_notify_unref (report->notify);
+	g_free (report);
+}
+
+/**
+ * as_pool_progress_report_cb:
+ *
+ * Deliver a progress report in the context of the caller.
+ */
+static gboolean
+as_pool_progress_report_cb (gpointer user_data)
+{
+	AsPoolProgressReport *report = (AsPoolProgressReport*) user_data;
+
+	report->notify->cb (report->phase,
+			    report->files_scanned,
+			    report->cpts_parsed,
+			    report->notify->data);
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * as_pool_progress_release_cb:
+ *
+ * Nothing to do, the reference to the progress callback is
+ * dropped in the context of the caller once this has run.
+ */
+static gboolean
+as_pool_progress_release_cb (gpointer user_data)
+{
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * as_pool_load_progress:
+ * @pool: The #AsPool data is loaded into.
+ * @phase: The current load phase.
+ * @n_files: The number of files which were just read.
+ * @n_cpts: The number of components which were just loaded.
+ *
+ * Account for loaded data, and notify the caller of the progress.
+ * Reports are sent on phase changes, and otherwise at most every 100ms.
+ */
+static void
+as_pool_load_progress (AsPool *pool, AsPoolLoadPhase phase, guint n_files, guint n_cpts)
+{
+	AsPoolLoadState *state;
+	AsPoolProgressReport *report;
+	gint64 now;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	state = priv->load_state;
+	if (state == NULL)
+		return;
+
+	state->files_scanned += n_files;
+	state->cpts_parsed += n_cpts;
+	if (state->progress == NULL)
+		return;
+
+	now = g_get_monotonic_time ();
+	if ((state->phase == phase) && (now - state->last_report < 100 * G_TIME_SPAN_MILLISECOND))
+		return;
+	state->phase = phase;
+	state->last_report = now;
+
+	report = g_new0 (AsPoolProgressReport, 1);
+	g_atomic_int_inc (&state->progress->ref_count);
+	report->notify = state->progress;
+	report->phase = phase;
+	report->files_scanned = state->files_scanned;
+	report->cpts_parsed = state->cpts_parsed;
+	g_main_context_invoke_full (state->context,
+				    G_PRIORITY_DEFAULT,
+				    as_pool_progress_report_cb,
+				    report,
+				    (GDestroyNotify) as_pool_progress_report_free);
+}
+
+/**
+ * as_pool_track_file_components:
+ * @pool: An instance of #AsPool.
+ * @fname: The file the components were read from.
+ * @cpts: (element-type AsComponent): The components read so far.
+ * @start: Index of the first component in @cpts which was read from @fname.
+ *
+ * Remember which components a file contained, so we can update them
+ * when the file changes. Only done if the pool is monitoring its files.
+ */
+static void
+as_pool_track_file_components (AsPool *pool, const gchar *fname, GPtrArray *cpts, guint start)
+{
+	GPtrArray *fcpts;
+	guint i;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	if (!as_flags_contains (priv->flags, AS_POOL_FLAG_MONITOR))
+		return;
+
+	fcpts = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = start; i < cpts->len; i++)
+		g_ptr_array_add (fcpts, g_object_ref (g_ptr_array_index (cpts, i)));
+	g_hash_table_insert (priv->file_cpts, g_strdup (fname), fcpts);
+}
+
+/**
+ * as_pool_share_identical_data:
+ *
+ * Let @cpt share its heavy data with a component that is already in the pool
+ * and has the same content hash, e.g. the same component shipped by the
+ * repositories of several architectures or suites.
+ */
+static void
+as_pool_share_identical_data (AsPool *pool, AsComponent *cpt)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	const gchar *hash;
+	const gchar *cdid;
+	AsComponent *donor = NULL;
+
+	hash = as_component_get_content_hash (cpt);
+	cdid = g_hash_table_lookup (priv->content_hashes, hash);
+	if (cdid != NULL)
+		donor = g_hash_table_lookup (priv->cpt_table, cdid);
+
+	/* the entry may be outdated if the component was replaced since */
+	if ((donor != NULL) && (g_strcmp0 (as_component_get_content_hash (donor), hash) == 0)) {
+		as_component_share_heavy (cpt, donor);
+		return;
+	}
+
+	g_hash_table_replace (priv->content_hashes,
+			      g_strdup (hash),
+			      (gpointer) as_intern_ref (as_component_get_data_id (cpt)));
 }
 
 /**
@@ -299,10 +813,11 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 
 	if (existing_cpt == NULL) {
 		g_hash_table_insert (priv->cpt_table,
-					g_strdup (cdid),
+					(gpointer) as_intern_ref (cdid),
 					g_object_ref (cpt));
-		g_hash_table_add (priv->known_cids,
-				  g_strdup (as_component_get_id (cpt)));
+		if (!g_hash_table_contains (priv->known_cids, as_component_get_id (cpt)))
+			g_hash_table_add (priv->known_cids,
+					  (gpointer) as_intern_ref (as_component_get_id (cpt)));
 		return TRUE;
 	}
 
@@ -310,7 +825,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 	if (!as_component_is_valid (existing_cpt)) {
 		g_debug ("Replacing invalid component '%s' with new one.", cdid);
 		g_hash_table_replace (priv->cpt_table,
-				      g_strdup (cdid),
+				      (gpointer) as_intern_ref (cdid),
 				      g_object_ref (cpt));
 		return TRUE;
 	}
@@ -326,7 +841,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 							AS_MERGE_KIND_APPEND);
 
 			g_hash_table_replace (priv->cpt_table,
-				g_strdup (cdid),
+				(gpointer) as_intern_ref (cdid),
 				g_object_ref (cpt));
 			g_debug ("Replaced '%s' with data from metainfo and desktop-entry file.", cdid);
 			return TRUE;
@@ -356,7 +871,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 		as_component_set_pkgnames (cpt, as_component_get_pkgnames (existing_cpt));
 
 		g_hash_table_replace (priv->cpt_table,
-				g_strdup (cdid),
+				(gpointer) as_intern_ref (cdid),
 				g_object_ref (cpt));
 		g_debug ("Replaced '%s' with data from metainfo file.", cdid);
 		return TRUE;
@@ -364,15 +879,20 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 
 	/* perform metadata merges if necessary */
 	if (as_component_get_merge_kind (cpt) != AS_MERGE_KIND_NONE) {
-		g_autoptr(GPtrArray) matches = NULL;
-		guint i;
+		GHashTableIter iter;
+		gpointer value;
+		const gchar *cid = as_component_get_id (cpt);
+
+		/* we merge the data into all components with matching IDs at time.
+		 * The pool lock is held by our caller already, so we must not use the public getters here */
+		g_hash_table_iter_init (&iter, priv->cpt_table);
+		while (g_hash_table_iter_next (&iter, NULL, &value)) {
+			AsComponent *match = AS_COMPONENT (value);
 
-		/* we merge the data into all components with matching IDs at time */
-		matches = as_pool_get_components_by_id (pool,
-							as_component_get_id (cpt));
-		for (i = 0; i < matches->len; i++) {
-			AsComponent *match = AS_COMPONENT (g_ptr_array_index (matches, i));
-			as_component_merge (match, cpt);
+			if (match == cpt)
+				continue;
+			if (g_strcmp0 (as_component_get_id (match), cid) == 0)
+				as_component_merge (match, cpt);
 		}
 
 		return TRUE;
@@ -383,7 +903,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 	pool_priority = as_component_get_priority (existing_cpt);
 	if (pool_priority < as_component_get_priority (cpt)) {
 		g_hash_table_replace (priv->cpt_table,
-					g_strdup (cdid),
+					(gpointer) as_intern_ref (cdid),
 					g_object_ref (cpt));
 		g_debug ("Replaced '%s' with data of higher priority.", cdid);
 	} else {
@@ -406,7 +926,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 				if (earch != NULL) {
 					if (as_arch_compatible (earch, priv->current_arch)) {
 						g_hash_table_replace (priv->cpt_table,
-									g_strdup (cdid),
+									(gpointer) as_intern_ref (cdid),
 									g_object_ref (cpt));
 						g_debug ("Preferred component for native architecture for %s (was %s)", cdid, earch);
 						return TRUE;
@@ -437,6 +957,93 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 	return TRUE;
 }
 
+/**
+ * as_pool_add_loaded_component:
+ * @pool: An instance of #AsPool
+ * @cpt: The #AsComponent the pool read itself.
+ * @error: A #GError or %NULL
+ *
+ * Add a component which was read from collection data or a cache by the
+ * pool itself. Once it was accepted into the pool, its memory use is reduced:
+ * long descriptions are stored compressed, and data which is identical to
+ * the one of another component is shared.
+ * Components added by API users are never changed like this, as they may
+ * still modify them.
+ *
+ * Returns: %TRUE if the component was added to the pool.
+ */
+static gboolean
+as_pool_add_loaded_component (AsPool *pool, AsComponent *cpt, GError **error)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	AsOriginKind orig_kind;
+	gboolean ret;
+
+	g_mutex_lock (&priv->mutex);
+	ret = as_pool_add_component_internal (pool, cpt, TRUE, error);
+	as_pool_invalidate_snapshot (pool);
+	if (!ret || g_hash_table_lookup (priv->cpt_table, as_component_get_data_id (cpt)) != cpt) {
+		g_mutex_unlock (&priv->mutex);
+		return ret;
+	}
+
+	/* long descriptions are rarely read, so we keep them compressed */
+	as_component_pack_descriptions (cpt);
+
+	/* catalog data and caches often contain the same component for several architectures or suites */
+	orig_kind = as_component_get_origin_kind (cpt);
+	if ((orig_kind == AS_ORIGIN_KIND_COLLECTION || orig_kind == AS_ORIGIN_KIND_UNKNOWN) &&
+	    (as_component_get_merge_kind (cpt) == AS_MERGE_KIND_NONE))
+		as_pool_share_identical_data (pool, cpt);
+	g_mutex_unlock (&priv->mutex);
+
+	return TRUE;
+}
+
+/**
+ * as_pool_component_replaces:
+ * @existing: The component which is known for a data-ID already.
+ * @cpt: Another component with the same data-ID.
+ * @current_arch: The architecture of the current system.
+ *
+ * Decide which of two components with the same data-ID should be used,
+ * following the rules of as_pool_add_component_internal(), but without
+ * merging any data.
+ *
+ * Returns: %TRUE if @cpt should be used instead of @existing.
+ */
+gboolean
+as_pool_component_replaces (AsComponent *existing, AsComponent *cpt, const gchar *current_arch)
+{
+	AsOriginKind new_cpt_orig_kind = as_component_get_origin_kind (cpt);
+	AsOriginKind existing_cpt_orig_kind = as_component_get_origin_kind (existing);
+	const gchar *earch;
+
+	if (as_component_is_ignored (cpt))
+		return FALSE;
+
+	/* data from .desktop entries is only used if nothing better exists */
+	if ((new_cpt_orig_kind == AS_ORIGIN_KIND_DESKTOP_ENTRY) &&
+	    (existing_cpt_orig_kind != AS_ORIGIN_KIND_DESKTOP_ENTRY))
+		return FALSE;
+	if (!as_component_is_valid (existing))
+		return TRUE;
+	if ((existing_cpt_orig_kind == AS_ORIGIN_KIND_DESKTOP_ENTRY) &&
+	    (new_cpt_orig_kind != AS_ORIGIN_KIND_DESKTOP_ENTRY))
+		return TRUE;
+
+	if (as_component_get_priority (existing) < as_component_get_priority (cpt))
+		return TRUE;
+
+	/* prefer components for the native architecture */
+	if (as_component_get_architecture (cpt) == NULL)
+		return FALSE;
+	if (!as_arch_compatible (as_component_get_architecture (cpt), current_arch))
+		return FALSE;
+	earch = as_component_get_architecture (existing);
+	return (earch != NULL) && as_arch_compatible (earch, current_arch);
+}
+
 /**
  * as_pool_add_component:
  * @pool: An instance of #AsPool
@@ -450,69 +1057,206 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 gboolean
 as_pool_add_component (AsPool *pool, AsComponent *cpt, GError **error)
 {
-	return as_pool_add_component_internal (pool, cpt, TRUE, error);
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	gboolean ret;
+
+	g_mutex_lock (&priv->mutex);
+	ret = as_pool_add_component_internal (pool, cpt, TRUE, error);
+	as_pool_invalidate_snapshot (pool);
+	g_mutex_unlock (&priv->mutex);
+
+	return ret;
 }
 
 /**
- * as_pool_update_addon_info:
+ * as_pool_ensure_graph:
+ * @pool: An instance of #AsPool.
+ * @links: (transfer full) (nullable): Links read from a cache file, or %NULL.
  *
- * Populate the "extensions" property of an #AsComponent, using the
- * "extends" information from other components.
+ * Build the relations between the components of the pool, if they are
+ * not known yet. If @links is set, it replaces the current relations and
+ * only the components need to be registered with it.
+ * The pool lock must be held.
  */
 static void
-as_pool_update_addon_info (AsPool *pool, AsComponent *cpt)
+as_pool_ensure_graph (AsPool *pool, AsPoolGraph *links)
 {
-	guint i;
-	GPtrArray *extends;
+	GHashTableIter iter;
+	gpointer key, value;
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
-	extends = as_component_get_extends (cpt);
-	if ((extends == NULL) || (extends->len == 0))
+	if (links != NULL) {
+		as_pool_graph_free (priv->graph);
+		priv->graph = links;
+	} else if (priv->graph != NULL) {
 		return;
+	} else {
+		priv->graph = as_pool_graph_new ();
+	}
 
-	for (i = 0; i < extends->len; i++) {
-		AsComponent *extended_cpt;
-		g_autofree gchar *extended_cdid = NULL;
-		const gchar *extended_cid = (const gchar*) g_ptr_array_index (extends, i);
-
-		extended_cdid = as_utils_build_data_id (AS_COMPONENT_SCOPE_SYSTEM, "os",
-							as_utils_get_component_bundle_kind (cpt),
-							extended_cid);
-
-		extended_cpt = g_hash_table_lookup (priv->cpt_table, extended_cdid);
-		if (extended_cpt == NULL) {
-			g_debug ("%s extends %s, but %s was not found.", as_component_get_data_id (cpt), extended_cdid, extended_cdid);
-			return;
-		}
-
-		/* don't act if we already have addons */
-		if (as_component_get_addons (extended_cpt)->len > 0)
-			continue;
+	g_hash_table_iter_init (&iter, priv->cpt_table);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		AsComponent *cpt = AS_COMPONENT (value);
 
-		as_component_add_addon (extended_cpt, cpt);
+		as_pool_graph_add_node (priv->graph, as_component_get_id (cpt), (const gchar*) key);
+		if (links == NULL)
+			as_pool_graph_add_links (priv->graph, cpt);
 	}
 }
 
 /**
- * as_pool_refine_data:
- *
- * Automatically refine the data we have about software components in the pool.
+ * as_pool_has_addon:
  *
- * Returns: %TRUE if all metadata was used, %FALSE if we skipped some stuff.
+ * Check whether @addon is already registered as addon of @cpt.
  */
 static gboolean
-as_pool_refine_data (AsPool *pool)
+as_pool_has_addon (AsComponent *cpt, AsComponent *addon)
 {
-	GHashTableIter iter;
-	gpointer key, value;
-	GHashTable *refined_cpts;
-	gboolean ret = TRUE;
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	GPtrArray *addons = as_component_get_addons (cpt);
+	guint i;
 
-	/* since we might remove stuff from the pool, we need a new table to store the result */
-	refined_cpts = g_hash_table_new_full (g_str_hash,
-						g_str_equal,
-						g_free,
+	if (addons == NULL)
+		return FALSE;
+	for (i = 0; i < addons->len; i++) {
+		if (g_ptr_array_index (addons, i) == addon)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * as_pool_drop_addon:
+ *
+ * Remove @addon from the addons of all components in the pool, e.g. because
+ * it was removed from the pool or replaced with new data.
+ * The pool lock must be held.
+ */
+static void
+as_pool_drop_addon (AsPool *pool, AsComponent *addon)
+{
+	GHashTableIter iter;
+	gpointer value;
+	GPtrArray *extends;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	/* only components which extend others are linked as addons */
+	extends = as_component_get_extends (addon);
+	if (extends == NULL || extends->len == 0)
+		return;
+
+	g_hash_table_iter_init (&iter, priv->cpt_table);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		as_component_remove_addon (AS_COMPONENT (value), addon);
+}
+
+/**
+ * as_pool_update_addon_info:
+ *
+ * Populate the "extensions" property of all components in the pool,
+ * using the "extends" information of the relations graph.
+ * An addon only extends the system component from the "os" origin with
+ * the same bundle kind as the addon itself, not e.g. a Flatpak build of
+ * a packaged application.
+ * The pool lock must be held.
+ */
+static void
+as_pool_update_addon_info (AsPool *pool)
+{
+	GHashTableIter iter;
+	gpointer value;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	as_pool_ensure_graph (pool, NULL);
+
+	g_hash_table_iter_init (&iter, priv->cpt_table);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		AsComponent *cpt = AS_COMPONENT (value);
+		GPtrArray *extended_cids;
+		guint i;
+
+		extended_cids = as_pool_graph_get_targets (priv->graph,
+							   as_component_get_id (cpt),
+							   AS_POOL_LINK_KIND_EXTENDS);
+		if (extended_cids == NULL)
+			continue;
+
+		for (i = 0; i < extended_cids->len; i++) {
+			AsComponent *extended_cpt;
+			g_autofree gchar *extended_cdid = NULL;
+			const gchar *extended_cid = (const gchar*) g_ptr_array_index (extended_cids, i);
+
+			extended_cdid = as_utils_build_data_id (AS_COMPONENT_SCOPE_SYSTEM, "os",
+								as_utils_get_component_bundle_kind (cpt),
+								extended_cid);
+
+			extended_cpt = g_hash_table_lookup (priv->cpt_table, extended_cdid);
+			if (extended_cpt == NULL) {
+				g_debug ("%s extends %s, but %s was not found.",
+					 as_component_get_data_id (cpt), extended_cdid, extended_cdid);
+				continue;
+			}
+
+			/* the pool might have linked this addon already */
+			if (as_pool_has_addon (extended_cpt, cpt))
+				continue;
+			as_component_add_addon (extended_cpt, cpt);
+		}
+	}
+}
+
+/**
+ * as_pool_refine_component:
+ *
+ * Validate a component and complete its data.
+ *
+ * Returns: %TRUE if the component is valid and should be kept in the pool.
+ */
+static gboolean
+as_pool_refine_component (AsPool *pool, AsComponent *cpt)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	/* validate the component */
+	if (!as_component_is_valid (cpt)) {
+		/* we still succeed if the components originates from a .desktop file -
+		 * we care less about them and they generally have bad quality, so some issues
+		 * pop up on pretty much every system */
+		if (as_component_get_origin_kind (cpt) == AS_ORIGIN_KIND_DESKTOP_ENTRY)
+			g_debug ("Ignored '%s': The component (from a .desktop file) is invalid.", as_component_get_id (cpt));
+		else
+			g_debug ("WARNING: Ignored component '%s': The component is invalid.", as_component_get_id (cpt));
+		return FALSE;
+	}
+
+	/* add additional data to the component, e.g. external screenshots. Also refines
+	* the component's icon paths */
+	as_component_complete (cpt,
+				priv->screenshot_service_url,
+				priv->icon_dirs);
+
+	return TRUE;
+}
+
+/**
+ * as_pool_refine_data:
+ *
+ * Automatically refine the data we have about software components in the pool.
+ *
+ * Returns: %TRUE if all metadata was used, %FALSE if we skipped some stuff.
+ */
+static gboolean
+as_pool_refine_data (AsPool *pool)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	GHashTable *refined_cpts;
+	gboolean ret = TRUE;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	/* since we might remove stuff from the pool, we need a new table to store the result */
+	refined_cpts = g_hash_table_new_full (g_str_hash,
+						g_str_equal,
+						(GDestroyNotify) as_intern_unref,
 						(GDestroyNotify) g_object_unref);
 
 	g_hash_table_iter_init (&iter, priv->cpt_table);
@@ -522,32 +1266,18 @@ as_pool_refine_data (AsPool *pool)
 		cpt = AS_COMPONENT (value);
 		cdid = (const gchar*) key;
 
-		/* validate the component */
-		if (!as_component_is_valid (cpt)) {
-			/* we still succeed if the components originates from a .desktop file -
-			 * we care less about them and they generally have bad quality, so some issues
-			 * pop up on pretty much every system */
-			if (as_component_get_origin_kind (cpt) == AS_ORIGIN_KIND_DESKTOP_ENTRY) {
-				g_debug ("Ignored '%s': The component (from a .desktop file) is invalid.", as_component_get_id (cpt));
-			} else {
-				g_debug ("WARNING: Ignored component '%s': The component is invalid.", as_component_get_id (cpt));
+		if (as_pool_load_cancelled (pool))
+			break;
+
+		if (!as_pool_refine_component (pool, cpt)) {
+			if (as_component_get_origin_kind (cpt) != AS_ORIGIN_KIND_DESKTOP_ENTRY)
 				ret = FALSE;
-			}
 			continue;
 		}
 
-		/* add additional data to the component, e.g. external screenshots. Also refines
-		* the component's icon paths */
-		as_component_complete (cpt,
-					priv->screenshot_service_url,
-					priv->icon_dirs);
-
-		/* set the "addons" information */
-		as_pool_update_addon_info (pool, cpt);
-
 		/* add to results table */
 		g_hash_table_insert (refined_cpts,
-					g_strdup (cdid),
+					(gpointer) as_intern_ref (cdid),
 					g_object_ref (cpt));
 	}
 
@@ -555,6 +1285,10 @@ as_pool_refine_data (AsPool *pool)
 	g_hash_table_unref (priv->cpt_table);
 	priv->cpt_table = refined_cpts;
 
+	/* find the relations between the components, and set the "addons" information */
+	g_clear_pointer (&priv->graph, as_pool_graph_free);
+	as_pool_update_addon_info (pool);
+
 	return ret;
 }
 
@@ -568,19 +1302,25 @@ void
 as_pool_clear (AsPool *pool)
 {
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->mutex);
+
+	as_pool_invalidate_snapshot (pool);
+	g_hash_table_remove_all (priv->pending_metainfo);
+	g_hash_table_remove_all (priv->file_cpts);
+	g_hash_table_remove_all (priv->content_hashes);
 	if (g_hash_table_size (priv->cpt_table) > 0) {
 		/* contents */
 		g_hash_table_unref (priv->cpt_table);
 		priv->cpt_table = g_hash_table_new_full (g_str_hash,
 							 g_str_equal,
-							 g_free,
+							 (GDestroyNotify) as_intern_unref,
 							 (GDestroyNotify) g_object_unref);
 
 		/* cid info set */
 		g_hash_table_unref (priv->known_cids);
 		priv->known_cids = g_hash_table_new_full (g_str_hash,
 						  g_str_equal,
-						  g_free,
+						  (GDestroyNotify) as_intern_unref,
 						  NULL);
 	}
 }
@@ -642,6 +1382,7 @@ as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
 	gboolean ret;
 	g_autoptr(AsMetadata) metad = NULL;
 	g_autoptr(GPtrArray) mdata_files = NULL;
+	g_autoptr(AsFileReader) next_reader = NULL;
 	GError *tmp_error = NULL;
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
@@ -656,6 +1397,7 @@ as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
 
 				fname = g_strdup_printf ("%s/%s.gvz", priv->sys_cache_path, priv->locale);
 				if (g_file_test (fname, G_FILE_TEST_EXISTS)) {
+					priv->collection_from_cache = TRUE;
 					return as_pool_load_cache_file (pool, fname, error);
 				} else {
 					g_debug ("Missing cache for language '%s', attempting to load fresh data.", priv->locale);
@@ -671,6 +1413,10 @@ as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
 	as_metadata_set_format_style (metad, AS_FORMAT_STYLE_COLLECTION);
 	as_metadata_set_locale (metad, priv->locale);
 
+	/* the cache needs to contain all data, no matter what we load */
+	if (!refresh)
+		as_metadata_set_load_profile (metad, priv->load_profile);
+
 	/* find AppStream metadata */
 	ret = TRUE;
 	mdata_files = g_ptr_array_new_with_free_func (g_free);
@@ -717,24 +1463,36 @@ as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
 		}
 	}
 
-	/* parse the found data */
+	/* parse the found data, reading and decompressing the next file while we parse the current one */
+	if (mdata_files->len > 0)
+		next_reader = as_file_reader_new_for_path ((const gchar*) g_ptr_array_index (mdata_files, 0));
 	for (i = 0; i < mdata_files->len; i++) {
-		g_autoptr(GFile) infile = NULL;
+		g_autoptr(AsFileReader) reader = NULL;
 		const gchar *fname;
+		guint n_cpts;
+
+		if (as_pool_load_cancelled (pool))
+			break;
 
 		fname = (const gchar*) g_ptr_array_index (mdata_files, i);
 		g_debug ("Reading: %s", fname);
 
-		infile = g_file_new_for_path (fname);
-		if (!g_file_query_exists (infile, NULL)) {
+		reader = g_steal_pointer (&next_reader);
+		if (i + 1 < mdata_files->len)
+			next_reader = as_file_reader_new_for_path ((const gchar*) g_ptr_array_index (mdata_files, i + 1));
+
+		n_cpts = as_metadata_get_components (metad)->len;
+		as_metadata_parse_file_reader (metad,
+						reader,
+						AS_FORMAT_KIND_UNKNOWN,
+						&tmp_error);
+		as_pool_track_file_components (pool, fname, as_metadata_get_components (metad), n_cpts);
+		as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_COLLECTION, 1, 0);
+		if (g_error_matches (tmp_error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
 			g_warning ("Metadata file '%s' does not exist.", fname);
+			g_clear_error (&tmp_error);
 			continue;
 		}
-
-		as_metadata_parse_file (metad,
-					infile,
-					AS_FORMAT_KIND_UNKNOWN,
-					&tmp_error);
 		if (tmp_error != NULL) {
 			g_debug ("WARNING: %s", tmp_error->message);
 			g_error_free (tmp_error);
@@ -763,6 +1521,9 @@ as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
 	for (i = 0; i < cpts->len; i++) {
 		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
 
+		if (as_pool_load_cancelled (pool))
+			return ret;
+
 		/* TODO: We support only system components at time */
 		as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
 
@@ -772,20 +1533,21 @@ as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
 			continue;
 		}
 
-		as_pool_add_component (pool, cpt, &tmp_error);
+		as_pool_add_loaded_component (pool, cpt, &tmp_error);
 		if (tmp_error != NULL) {
 			g_debug ("Metadata ignored: %s", tmp_error->message);
 			g_error_free (tmp_error);
 			tmp_error = NULL;
 		}
 	}
+	as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_COLLECTION, 0, cpts->len);
 
 	/* we need to merge the merge-components into the pool last, so the merge process can fetch
 	 * all components with matching IDs from the pool */
 	for (i = 0; i < merge_cpts->len; i++) {
 		AsComponent *mcpt = AS_COMPONENT (g_ptr_array_index (merge_cpts, i));
 
-		as_pool_add_component (pool, mcpt, &tmp_error);
+		as_pool_add_loaded_component (pool, mcpt, &tmp_error);
 		if (tmp_error != NULL) {
 			g_debug ("Merge component ignored: %s", tmp_error->message);
 			g_error_free (tmp_error);
@@ -797,37 +1559,159 @@ as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
 }
 
 /**
- * as_pool_load_metainfo_data:
+ * as_pool_load_metainfo_files:
+ * @pool: An instance of #AsPool.
+ * @fnames: (element-type filename): The metainfo files to read.
+ * @refine: %TRUE if the new components should be refined right away.
  *
- * Load fresh metadata from metainfo files.
+ * Parse metainfo files and add their components to the pool.
  */
 static void
-as_pool_load_metainfo_data (AsPool *pool)
+as_pool_load_metainfo_files (AsPool *pool, GPtrArray *fnames, gboolean refine)
 {
 	guint i;
+	guint n_cpts;
 	g_autoptr(AsMetadata) metad = NULL;
-	g_autoptr(GPtrArray) mi_files = NULL;
+	g_autoptr(AsFileBatch) batch = NULL;
+	AsFileReader *reader;
+	const gchar *fname;
 	GPtrArray *cpts;
 	GError *error = NULL;
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
+	if (fnames->len == 0)
+		return;
+
 	/* prepare metadata parser */
 	metad = as_metadata_new ();
 	as_metadata_set_locale (metad, priv->locale);
+	as_metadata_set_load_profile (metad, priv->load_profile);
+
+	/* parse the data, while the next files are already being read */
+	batch = as_file_batch_new (fnames);
+	while ((reader = as_file_batch_next (batch, &fname)) != NULL) {
+		if (as_pool_load_cancelled (pool)) {
+			as_file_reader_free (reader);
+			return;
+		}
+
+		g_debug ("Reading: %s", fname);
+		n_cpts = as_metadata_get_components (metad)->len;
+		as_metadata_parse_file_reader (metad,
+					       reader,
+					       AS_FORMAT_KIND_UNKNOWN,
+					       &error);
+		as_file_reader_free (reader);
+		as_pool_track_file_components (pool, fname, as_metadata_get_components (metad), n_cpts);
+		as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_METAINFO, 1, 0);
+		if (error != NULL) {
+			if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+				g_warning ("Metadata file '%s' does not exist.", fname);
+			else
+				g_debug ("WARNING: %s", error->message);
+			g_error_free (error);
+			error = NULL;
+		}
+	}
+
+	/* add found components to the metadata pool */
+	cpts = as_metadata_get_components (metad);
+	as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_METAINFO, 0, cpts->len);
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+		const gchar *cdid;
+
+		if (as_pool_load_cancelled (pool))
+			return;
+
+		/* We only read metainfo files from system directories */
+		as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
+
+		if (!as_pool_add_component_internal (pool, cpt, FALSE, &error)) {
+			if (error != NULL) {
+				g_debug ("Metadata ignored: %s", error->message);
+				g_error_free (error);
+				error = NULL;
+			}
+			continue;
+		}
+		if (!refine)
+			continue;
+
+		/* components loaded after the pool was refined need to be refined on their own,
+		 * in case they ended up in the pool */
+		cdid = as_component_get_data_id (cpt);
+		if (g_hash_table_lookup (priv->cpt_table, cdid) != cpt)
+			continue;
+		if (!as_pool_refine_component (pool, cpt))
+			g_hash_table_remove (priv->cpt_table, cdid);
+	}
+}
+
+/**
+ * as_pool_get_metainfo_manifest_fname:
+ *
+ * Returns: (transfer full): the filename of the metainfo manifest,
+ * or %NULL if the user cache is not used.
+ */
+static gchar*
+as_pool_get_metainfo_manifest_fname (AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	if (!as_flags_contains (priv->cache_flags, AS_CACHE_FLAG_USE_USER))
+		return NULL;
+	return g_build_filename (priv->user_cache_path, "metainfo-manifest.gv", NULL);
+}
+
+/**
+ * as_pool_load_metainfo_data:
+ *
+ * Load fresh metadata from metainfo files.
+ * Files whose component ID is known from the metainfo manifest are not
+ * parsed yet, but registered as pending and only read once their component
+ * is requested from the pool.
+ */
+static void
+as_pool_load_metainfo_data (AsPool *pool)
+{
+	guint i;
+	g_autoptr(GPtrArray) mi_files = NULL;
+	g_autoptr(GPtrArray) read_files = NULL;
+	g_autoptr(AsMetainfoManifest) manifest = NULL;
+	g_autofree gchar *manifest_fname = NULL;
+	const gchar *fname;
+	GError *error = NULL;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
 	/* find metainfo files */
 	g_debug ("Searching for data in: %s", METAINFO_DIR);
-	mi_files = as_utils_find_files_matching (METAINFO_DIR, "*.xml", FALSE, NULL);
+	mi_files = as_dir_scanner_scan (METAINFO_DIR, "*.xml", AS_DIR_SCAN_FLAG_WITH_STAT, &error);
 	if (mi_files == NULL) {
-		g_debug ("Unable find metainfo files.");
+		g_debug ("Unable find metainfo files: %s", error->message);
+		g_error_free (error);
 		return;
 	}
 
-	/* parse the found data */
+	/* load the manifest of component-IDs */
+	manifest = as_metainfo_manifest_new ();
+	manifest_fname = as_pool_get_metainfo_manifest_fname (pool);
+	if (manifest_fname != NULL) {
+		if (!as_metainfo_manifest_load (manifest, manifest_fname, &error)) {
+			g_debug ("Unable to load metainfo manifest: %s", error->message);
+			g_error_free (error);
+			error = NULL;
+		}
+		as_metainfo_manifest_retain (manifest, mi_files);
+	}
+
+	/* select the files we need to read right away */
+	read_files = g_ptr_array_new ();
 	for (i = 0; i < mi_files->len; i++) {
-		g_autoptr(GFile) infile = NULL;
-		const gchar *fname = (const gchar*) g_ptr_array_index (mi_files, i);
+		AsScannedFile *sfile = (AsScannedFile*) g_ptr_array_index (mi_files, i);
+		const gchar *cid;
 
+		fname = sfile->path;
 		if (!priv->prefer_local_metainfo) {
 			g_autofree gchar *mi_cid = NULL;
 
@@ -853,45 +1737,113 @@ as_pool_load_metainfo_data (AsPool *pool)
 			}
 		}
 
-		g_debug ("Reading: %s", fname);
-		infile = g_file_new_for_path (fname);
-		if (!g_file_query_exists (infile, NULL)) {
-			g_warning ("Metadata file '%s' does not exist.", fname);
+		/* files we can't get an unique ID for are read right away */
+		cid = as_metainfo_manifest_get_id (manifest, sfile);
+		if ((cid == NULL) || g_hash_table_contains (priv->pending_metainfo, cid)) {
+			g_ptr_array_add (read_files, (gpointer) fname);
 			continue;
 		}
 
-		as_metadata_parse_file (metad,
-					infile,
-					AS_FORMAT_KIND_UNKNOWN,
-					&error);
-		if (error != NULL) {
-			g_debug ("WARNING: %s", error->message);
+		g_hash_table_insert (priv->pending_metainfo,
+				     g_strdup (cid),
+				     g_strdup (fname));
+	}
+
+	if ((manifest_fname != NULL) && as_metainfo_manifest_is_dirty (manifest)) {
+		g_mkdir_with_parents (priv->user_cache_path, 0755);
+		if (!as_metainfo_manifest_save (manifest, manifest_fname, &error)) {
+			g_debug ("Unable to save metainfo manifest: %s", error->message);
 			g_error_free (error);
 			error = NULL;
 		}
 	}
 
-	/* add found components to the metadata pool */
-	cpts = as_metadata_get_components (metad);
-	for (i = 0; i < cpts->len; i++) {
-		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+	as_pool_load_metainfo_files (pool, read_files, FALSE);
+}
 
-		/* We only read metainfo files from system directories */
-		as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
+/**
+ * as_pool_load_pending_metainfo:
+ * @pool: An instance of #AsPool.
+ * @cid: The component-ID to load data for, or %NULL to load all pending files.
+ *
+ * Parse metainfo files which were registered with the pool,
+ * but have not been read yet.
+ *
+ * Returns: %TRUE if any files were read.
+ */
+static gboolean
+as_pool_load_pending_metainfo (AsPool *pool, const gchar *cid)
+{
+	g_autoptr(GPtrArray) fnames = NULL;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
-		as_pool_add_component_internal (pool, cpt, FALSE, &error);
-		if (error != NULL) {
-			g_debug ("Metadata ignored: %s", error->message);
-			g_error_free (error);
-			error = NULL;
+	if (g_hash_table_size (priv->pending_metainfo) == 0)
+		return FALSE;
+
+	/* entries are dropped from the pending table before parsing, so
+	 * lookups happening while components are added don't recurse */
+	fnames = g_ptr_array_new_with_free_func (g_free);
+	if (cid == NULL) {
+		GHashTableIter iter;
+		gpointer value;
+
+		g_hash_table_iter_init (&iter, priv->pending_metainfo);
+		while (g_hash_table_iter_next (&iter, NULL, &value)) {
+			g_ptr_array_add (fnames, value);
+			g_hash_table_iter_steal (&iter);
+		}
+	} else {
+		g_autofree gchar *alt_cid = NULL;
+		gchar *fname;
+		gpointer key;
+
+		/* desktop-applications may or may not carry the .desktop suffix in their ID */
+		if (g_str_has_suffix (cid, ".desktop"))
+			alt_cid = g_strndup (cid, strlen (cid) - 8);
+		else
+			alt_cid = g_strdup_printf ("%s.desktop", cid);
+
+		if (g_hash_table_lookup_extended (priv->pending_metainfo, cid, &key, (gpointer*) &fname)) {
+			g_hash_table_steal (priv->pending_metainfo, cid);
+			g_ptr_array_add (fnames, fname);
+			g_free (key);
+		}
+		if (g_hash_table_lookup_extended (priv->pending_metainfo, alt_cid, &key, (gpointer*) &fname)) {
+			g_hash_table_steal (priv->pending_metainfo, alt_cid);
+			g_ptr_array_add (fnames, fname);
+			g_free (key);
 		}
 	}
+
+	as_pool_load_metainfo_files (pool, fnames, TRUE);
+	return fnames->len > 0;
+}
+
+/**
+ * as_pool_get_desktop_cache_fname:
+ *
+ * Returns: (transfer full): the filename of the .desktop file cache,
+ * or %NULL if the user cache is not used.
+ */
+static gchar*
+as_pool_get_desktop_cache_fname (AsPool *pool)
+{
+	g_autofree gchar *basename = NULL;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	if (!as_flags_contains (priv->cache_flags, AS_CACHE_FLAG_USE_USER))
+		return NULL;
+
+	basename = g_strdup_printf ("desktop-entries-%s.gv", priv->locale);
+	return g_build_filename (priv->user_cache_path, basename, NULL);
 }
 
 /**
  * as_pool_load_desktop_entries:
  *
  * Load fresh metadata from .desktop files.
+ * Components of files which did not change since they were last read
+ * are taken from the desktop-entry cache.
  */
 static void
 as_pool_load_desktop_entries (AsPool *pool)
@@ -899,7 +1851,15 @@ as_pool_load_desktop_entries (AsPool *pool)
 	guint i;
 	g_autoptr(AsMetadata) metad = NULL;
 	g_autoptr(GPtrArray) de_files = NULL;
-	GPtrArray *cpts;
+	g_autoptr(GPtrArray) read_files = NULL;
+	g_autoptr(GPtrArray) read_sfiles = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(AsFileBatch) batch = NULL;
+	g_autoptr(AsDesktopCache) dcache = NULL;
+	g_autofree gchar *dcache_fname = NULL;
+	GPtrArray *parsed_cpts;
+	AsFileReader *reader;
+	const gchar *fname;
 	GError *error = NULL;
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
@@ -909,16 +1869,34 @@ as_pool_load_desktop_entries (AsPool *pool)
 
 	/* find .desktop files */
 	g_debug ("Searching for data in: %s", APPLICATIONS_DIR);
-	de_files = as_utils_find_files_matching (APPLICATIONS_DIR, "*.desktop", FALSE, NULL);
+	de_files = as_dir_scanner_scan (APPLICATIONS_DIR, "*.desktop", AS_DIR_SCAN_FLAG_WITH_STAT, &error);
 	if (de_files == NULL) {
-		g_debug ("Unable find .desktop files.");
+		g_debug ("Unable find .desktop files: %s", error->message);
+		g_error_free (error);
 		return;
 	}
 
-	/* parse the found data */
+	/* load the components of the files we have seen before */
+	dcache = as_desktop_cache_new (priv->locale);
+	dcache_fname = as_pool_get_desktop_cache_fname (pool);
+	if (dcache_fname != NULL) {
+		if (!as_desktop_cache_load (dcache, dcache_fname, &error)) {
+			g_debug ("Unable to load desktop-entry cache: %s", error->message);
+			g_clear_error (&error);
+		}
+		as_desktop_cache_retain (dcache, de_files);
+	}
+
+	/* select the files we need to read */
+	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	read_files = g_ptr_array_new ();
+	read_sfiles = g_ptr_array_new ();
 	for (i = 0; i < de_files->len; i++) {
-		g_autoptr(GFile) infile = NULL;
-		const gchar *fname = (const gchar*) g_ptr_array_index (de_files, i);
+		AsScannedFile *sfile = (AsScannedFile*) g_ptr_array_index (de_files, i);
+		g_autoptr(GPtrArray) cached_cpts = NULL;
+		guint j;
+
+		fname = sfile->path;
 
 		/* quickly check if we know the component already
 		 * We do not do this when reading metainfo files, since in that case we might
@@ -941,29 +1919,85 @@ as_pool_load_desktop_entries (AsPool *pool)
 			}
 		}
 
-		g_debug ("Reading: %s", fname);
-		infile = g_file_new_for_path (fname);
-		if (!g_file_query_exists (infile, NULL)) {
-			g_warning ("Metadata file '%s' does not exist.", fname);
+		/* check if we can use cached data */
+		cached_cpts = as_desktop_cache_lookup (dcache, sfile);
+		if (cached_cpts != NULL) {
+			g_debug ("Cached: %s", fname);
+			for (j = 0; j < cached_cpts->len; j++)
+				g_ptr_array_add (cpts, g_object_ref (g_ptr_array_index (cached_cpts, j)));
+			as_pool_track_file_components (pool, fname, cached_cpts, 0);
+			as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_DESKTOP_ENTRIES, 1, 0);
 			continue;
 		}
 
-		as_metadata_parse_file (metad,
-					infile,
-					AS_FORMAT_KIND_UNKNOWN,
-					&error);
+		g_ptr_array_add (read_files, (gpointer) fname);
+		g_ptr_array_add (read_sfiles, sfile);
+	}
+
+	/* parse the data, while the next files are already being read */
+	batch = as_file_batch_new (read_files);
+	for (i = 0; (reader = as_file_batch_next (batch, &fname)) != NULL; i++) {
+		guint n_cpts;
+
+		if (as_pool_load_cancelled (pool)) {
+			as_file_reader_free (reader);
+			return;
+		}
+
+		g_debug ("Reading: %s", fname);
+		parsed_cpts = as_metadata_get_components (metad);
+		n_cpts = parsed_cpts->len;
+
+		as_metadata_parse_file_reader (metad,
+					       reader,
+					       AS_FORMAT_KIND_UNKNOWN,
+					       &error);
+		as_file_reader_free (reader);
+		as_pool_track_file_components (pool, fname, parsed_cpts, n_cpts);
+		as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_DESKTOP_ENTRIES, 1, 0);
 		if (error != NULL) {
-			g_debug ("WARNING: %s", error->message);
+			if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+				g_warning ("Metadata file '%s' does not exist.", fname);
+			else
+				g_debug ("WARNING: %s", error->message);
 			g_error_free (error);
 			error = NULL;
+			continue;
+		}
+
+		/* remember what this file contained, even if it was nothing */
+		if (dcache_fname != NULL) {
+			g_autoptr(GPtrArray) file_cpts = g_ptr_array_new ();
+			guint j;
+
+			for (j = n_cpts; j < parsed_cpts->len; j++)
+				g_ptr_array_add (file_cpts, g_ptr_array_index (parsed_cpts, j));
+			as_desktop_cache_insert (dcache,
+						 (AsScannedFile*) g_ptr_array_index (read_sfiles, i),
+						 file_cpts);
+		}
+	}
+
+	/* write back the cache, if we parsed anything new */
+	if ((dcache_fname != NULL) && as_desktop_cache_is_dirty (dcache)) {
+		g_mkdir_with_parents (priv->user_cache_path, 0755);
+		if (!as_desktop_cache_save (dcache, dcache_fname, &error)) {
+			g_debug ("Unable to save desktop-entry cache: %s", error->message);
+			g_clear_error (&error);
 		}
 	}
 
 	/* add found components to the metadata pool */
-	cpts = as_metadata_get_components (metad);
+	parsed_cpts = as_metadata_get_components (metad);
+	for (i = 0; i < parsed_cpts->len; i++)
+		g_ptr_array_add (cpts, g_object_ref (g_ptr_array_index (parsed_cpts, i)));
+	as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_DESKTOP_ENTRIES, 0, cpts->len);
 	for (i = 0; i < cpts->len; i++) {
 		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
 
+		if (as_pool_load_cancelled (pool))
+			return;
+
 		/* We only read .desktop files from system directories at time */
 		as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
 
@@ -977,46 +2011,721 @@ as_pool_load_desktop_entries (AsPool *pool)
 }
 
 /**
- * as_pool_load:
- * @pool: An instance of #AsPool.
- * @error: A #GError or %NULL.
- *
- * Builds an index of all found components in the watched locations.
- * The function will try to get as much data into the pool as possible, so even if
- * the update completes with %FALSE, it might still have added components to the pool.
- *
- * The function will load from all possible data sources, preferring caches if they
- * are up to date.
- *
- * Returns: %TRUE if update completed without error.
- **/
-gboolean
-as_pool_load (AsPool *pool, GCancellable *cancellable, GError **error)
+ * as_pool_copy_str_array:
+ */
+static void
+as_pool_copy_str_array (GPtrArray *dest, GPtrArray *src)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	gboolean ret = TRUE;
+	guint i;
+
+	g_ptr_array_set_size (dest, 0);
+	for (i = 0; i < src->len; i++)
+		g_ptr_array_add (dest, g_strdup (g_ptr_array_index (src, i)));
+}
+
+/**
+ * as_pool_load_state_new:
+ * @pool: The #AsPool which should receive the data.
+ * @cancellable: a #GCancellable.
+ *
+ * Create the state for a load operation. Data is loaded into a new
+ * pool with the same configuration as @pool, so @pool stays usable
+ * until the new data is swapped in.
+ */
+static AsPoolLoadState*
+as_pool_load_state_new (AsPool *pool, GCancellable *cancellable)
+{
+	AsPoolLoadState *state;
+	AsPoolPrivate *lpriv;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	state = g_slice_new0 (AsPoolLoadState);
+	if (cancellable != NULL)
+		state->cancellable = g_object_ref (cancellable);
+
+	state->loader = as_pool_new ();
+	lpriv = GET_PRIVATE (state->loader);
+	lpriv->load_state = state;
+
+	g_free (lpriv->locale);
+	lpriv->locale = g_strdup (priv->locale);
+	g_free (lpriv->current_arch);
+	lpriv->current_arch = g_strdup (priv->current_arch);
+	g_free (lpriv->screenshot_service_url);
+	lpriv->screenshot_service_url = g_strdup (priv->screenshot_service_url);
+	g_free (lpriv->sys_cache_path);
+	lpriv->sys_cache_path = g_strdup (priv->sys_cache_path);
+	g_free (lpriv->user_cache_path);
+	lpriv->user_cache_path = g_strdup (priv->user_cache_path);
+
+	as_pool_copy_str_array (lpriv->xml_dirs, priv->xml_dirs);
+	as_pool_copy_str_array (lpriv->yaml_dirs, priv->yaml_dirs);
+	as_pool_copy_str_array (lpriv->icon_dirs, priv->icon_dirs);
+
+	lpriv->flags = priv->flags;
+	lpriv->cache_flags = priv->cache_flags;
+	lpriv->load_profile = priv->load_profile;
+	lpriv->prefer_local_metainfo = priv->prefer_local_metainfo;
+	lpriv->cache_ctime = priv->cache_ctime;
+	lpriv->memory_budget = priv->memory_budget;
+
+	return state;
+}
+
+/**
+ * as_pool_load_state_free:
+ */
+static void
+as_pool_load_state_free (AsPoolLoadState *state)
+{
+	AsPoolPrivate *lpriv = GET_PRIVATE (state->loader);
+
+	lpriv->load_state = NULL;
+	g_object_unref (state->loader);
+	g_clear_object (&state->cancellable);
+	if (state->progress != NULL) {
+		/* release the user data of the progress callback in the context it is called in */
+		g_main_context_invoke_full (state->context,
+					    G_PRIORITY_DEFAULT,
+					    as_pool_progress_release_cb,
+					    state->progress,
+					    (GDestroyNotify) as_pool_progress_notify_unref);
+	}
+	if (state->context != NULL)
+		g_main_context_unref (state->context);
+	g_clear_error (&state->error);
+	g_slice_free (AsPoolLoadState, state);
+}
+
+/**
+ * as_pool_load_run:
+ *
+ * Load all data into the loader pool of @state.
+ */
+static void
+as_pool_load_run (AsPoolLoadState *state)
+{
+	AsPool *pool = state->loader;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
-	/* load means to reload, so we get rid of all the old data */
-	as_pool_clear (pool);
+	state->ret = TRUE;
 
 	/* read all AppStream metadata that we can find */
-	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_COLLECTION))
-		ret = as_pool_load_collection_data (pool, FALSE, error);
+	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_COLLECTION)) {
+		as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_COLLECTION, 0, 0);
+		state->ret = as_pool_load_collection_data (pool, FALSE, &state->error);
+	}
 
 	/* read all metainfo files that we can find */
-	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_METAINFO))
+	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_METAINFO) && !as_pool_load_cancelled (pool)) {
+		as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_METAINFO, 0, 0);
 		as_pool_load_metainfo_data (pool);
+	}
 
 	/* read all .desktop file data that we can find */
-	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_DESKTOP_FILES))
+	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_DESKTOP_FILES) && !as_pool_load_cancelled (pool)) {
+		as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_DESKTOP_ENTRIES, 0, 0);
 		as_pool_load_desktop_entries (pool);
+	}
+
+	if (as_pool_load_cancelled (pool))
+		return;
 
 	/* automatically refine the metadata we have in the pool */
-	ret = as_pool_refine_data (pool) && ret;
+	as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_REFINE, 0, 0);
+	state->ret = as_pool_refine_data (pool) && state->ret;
+
+	/* refining may have read back evicted data, so get within the memory budget again */
+	g_mutex_lock (&priv->mutex);
+	as_pool_trim_memory (pool);
+	g_mutex_unlock (&priv->mutex);
+
+	as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_DONE, 0, 0);
+}
+
+/**
+ * as_pool_take_data:
+ * @pool: An instance of #AsPool.
+ * @loader: The #AsPool data was loaded into.
+ *
+ * Replace the contents of @pool with the data of @loader in one step.
+ * The old data is released together with @loader, queries which are still
+ * running on it keep their snapshot of it.
+ */
+static void
+as_pool_take_data (AsPool *pool, AsPool *loader)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	AsPoolPrivate *lpriv = GET_PRIVATE (loader);
+	AsPoolSnapshot *snapshot;
+	GHashTable *tmp;
+
+	/* publish the new data before taking the lock, so readers are never blocked for long */
+	snapshot = as_pool_snapshot_new (lpriv->cpt_table);
+
+	g_mutex_lock (&priv->mutex);
+	as_pool_invalidate_snapshot (pool);
+	priv->snapshot = snapshot;
+
+	tmp = priv->cpt_table;
+	priv->cpt_table = lpriv->cpt_table;
+	lpriv->cpt_table = tmp;
+
+	tmp = priv->known_cids;
+	priv->known_cids = lpriv->known_cids;
+	lpriv->known_cids = tmp;
+
+	tmp = priv->content_hashes;
+	priv->content_hashes = lpriv->content_hashes;
+	lpriv->content_hashes = tmp;
+
+	tmp = priv->pending_metainfo;
+	priv->pending_metainfo = lpriv->pending_metainfo;
+	lpriv->pending_metainfo = tmp;
+
+	tmp = priv->file_cpts;
+	priv->file_cpts = lpriv->file_cpts;
+	lpriv->file_cpts = tmp;
+
+	/* the relations were dropped with the old snapshot, the loader's still match its data */
+	priv->graph = lpriv->graph;
+	lpriv->graph = NULL;
+	priv->collection_from_cache = lpriv->collection_from_cache;
+	g_mutex_unlock (&priv->mutex);
+}
+
+/**
+ * as_pool_load:
+ * @pool: An instance of #AsPool.
+ * @cancellable: a #GCancellable.
+ * @error: A #GError or %NULL.
+ *
+ * Builds an index of all found components in the watched locations.
+ * The function will try to get as much data into the pool as possible, so even if
+ * the update completes with %FALSE, it might still have added components to the pool.
+ *
+ * The function will load from all possible data sources, preferring caches if they
+ * are up to date.
+ *
+ * The previous contents of the pool are replaced once all data has been loaded.
+ * If the operation is cancelled, the pool is left unchanged.
+ *
+ * Returns: %TRUE if update completed without error.
+ **/
+gboolean
+as_pool_load (AsPool *pool, GCancellable *cancellable, GError **error)
+{
+	AsPoolLoadState *state;
+	gboolean ret;
+
+	state = as_pool_load_state_new (pool, cancellable);
+	as_pool_load_run (state);
+	if (g_cancellable_set_error_if_cancelled (cancellable, error)) {
+		as_pool_load_state_free (state);
+		return FALSE;
+	}
+
+	as_pool_take_data (pool, state->loader);
+	as_pool_setup_monitors (pool);
+	ret = state->ret;
+	if (state->error != NULL) {
+		g_propagate_error (error, state->error);
+		state->error = NULL;
+	}
+	as_pool_load_state_free (state);
 
 	return ret;
 }
 
+/**
+ * as_pool_load_thread:
+ */
+static void
+as_pool_load_thread (GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	AsPoolLoadState *state = (AsPoolLoadState*) task_data;
+
+	as_pool_load_run (state);
+	if (g_task_return_error_if_cancelled (task))
+		return;
+	g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * as_pool_load_async:
+ * @pool: An instance of #AsPool.
+ * @progress_callback: (scope notified) (closure progress_data) (nullable): function to call with progress information, or %NULL.
+ * @progress_data: user data for @progress_callback.
+ * @progress_data_free: (destroy progress_data) (nullable): function to free @progress_data once
+ *                      no more progress is reported, or %NULL.
+ * @cancellable: a #GCancellable.
+ * @callback: A #GAsyncReadyCallback to call when the data is loaded.
+ * @user_data: user data for @callback.
+ *
+ * Asynchronously load all data into the pool, like as_pool_load() does.
+ * The data is read in a separate thread; @progress_callback is called in the
+ * thread-default main context of the caller. Once the operation is finished,
+ * call as_pool_load_finish() to replace the pool contents with the new data.
+ *
+ * Since: 0.12.1
+ **/
+void
+as_pool_load_async (AsPool *pool,
+		    AsPoolProgressCallback progress_callback,
+		    gpointer progress_data,
+		    GDestroyNotify progress_data_free,
+		    GCancellable *cancellable,
+		    GAsyncReadyCallback callback,
+		    gpointer user_data)
+{
+	AsPoolLoadState *state;
+	g_autoptr(GTask) task = NULL;
+
+	state = as_pool_load_state_new (pool, cancellable);
+	state->context = g_main_context_ref_thread_default ();
+	if (progress_callback != NULL)
+		state->progress = as_pool_progress_notify_new (progress_callback, progress_data, progress_data_free);
+
+	task = g_task_new (pool, cancellable, callback, user_data);
+	g_task_set_source_tag (task, as_pool_load_async);
+	g_task_set_task_data (task, state, (GDestroyNotify) as_pool_load_state_free);
+	g_task_run_in_thread (task, as_pool_load_thread);
+}
+
+/**
+ * as_pool_load_finish:
+ * @pool: An instance of #AsPool.
+ * @result: A #GAsyncResult.
+ * @error: A #GError or %NULL.
+ *
+ * Finish an asynchronous load operation started with as_pool_load_async(),
+ * replacing the contents of the pool with the loaded data. If the operation
+ * was cancelled, the pool is left unchanged.
+ *
+ * Returns: %TRUE if the data was loaded without error.
+ *
+ * Since: 0.12.1
+ **/
+gboolean
+as_pool_load_finish (AsPool *pool, GAsyncResult *result, GError **error)
+{
+	AsPoolLoadState *state;
+	GTask *task;
+
+	g_return_val_if_fail (g_task_is_valid (result, pool), FALSE);
+	task = G_TASK (result);
+
+	if (!g_task_propagate_boolean (task, error))
+		return FALSE;
+
+	state = (AsPoolLoadState*) g_task_get_task_data (task);
+	as_pool_take_data (pool, state->loader);
+	as_pool_setup_monitors (pool);
+	if (state->error != NULL) {
+		g_propagate_error (error, state->error);
+		state->error = NULL;
+	}
+
+	return state->ret;
+}
+
+/**
+ * as_pool_has_merge_components:
+ */
+static gboolean
+as_pool_has_merge_components (GPtrArray *cpts)
+{
+	guint i;
+
+	if (cpts == NULL)
+		return FALSE;
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+		if (as_component_get_merge_kind (cpt) != AS_MERGE_KIND_NONE)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * as_pool_update_file:
+ * @pool: An instance of #AsPool.
+ * @fname: The metadata file which changed.
+ * @kind: The kind of metadata in @fname.
+ * @added: Array to add new components to.
+ * @removed: Array to add removed components to.
+ * @changed: Array to add changed components to.
+ *
+ * Read a changed metadata file again, and replace the components
+ * it contained with the new data.
+ *
+ * Returns: %FALSE if the file could not be updated on its own, and
+ * all data needs to be reloaded.
+ */
+static gboolean
+as_pool_update_file (AsPool *pool,
+		     const gchar *fname,
+		     AsPoolFileKind kind,
+		     GPtrArray *added,
+		     GPtrArray *removed,
+		     GPtrArray *changed)
+{
+	GPtrArray *new_cpts;
+	g_autoptr(GPtrArray) old_cpts = NULL;
+	g_autoptr(GHashTable) old_table = NULL;
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+	GHashTableIter iter;
+	gpointer value;
+	guint i;
+	GError *error = NULL;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	/* read the new data, if the file still exists */
+	metad = as_metadata_new ();
+	as_metadata_set_locale (metad, priv->locale);
+	as_metadata_set_load_profile (metad, priv->load_profile);
+	if (kind == AS_POOL_FILE_KIND_COLLECTION)
+		as_metadata_set_format_style (metad, AS_FORMAT_STYLE_COLLECTION);
+	if (g_file_test (fname, G_FILE_TEST_EXISTS)) {
+		g_autoptr(AsFileReader) reader = NULL;
+
+		g_debug ("Reading changed file: %s", fname);
+		reader = as_file_reader_new_for_path (fname);
+		as_metadata_parse_file_reader (metad, reader, AS_FORMAT_KIND_UNKNOWN, &error);
+		if (error != NULL) {
+			g_debug ("WARNING: %s", error->message);
+			g_clear_error (&error);
+		}
+	}
+	new_cpts = as_metadata_get_components (metad);
+
+	locker = g_mutex_locker_new (&priv->mutex);
+	as_pool_invalidate_snapshot (pool);
+
+	/* components of pending metainfo files were never handed out, so we just read the file now */
+	if (kind == AS_POOL_FILE_KIND_METAINFO) {
+		g_hash_table_iter_init (&iter, priv->pending_metainfo);
+		while (g_hash_table_iter_next (&iter, NULL, &value)) {
+			if (g_strcmp0 ((const gchar*) value, fname) == 0)
+				g_hash_table_iter_remove (&iter);
+		}
+	}
+
+	old_cpts = g_hash_table_lookup (priv->file_cpts, fname);
+	if (old_cpts != NULL) {
+		g_ptr_array_ref (old_cpts);
+		g_hash_table_remove (priv->file_cpts, fname);
+	} else if ((kind == AS_POOL_FILE_KIND_COLLECTION) && priv->collection_from_cache) {
+		/* we don't know which components were in this file */
+		return FALSE;
+	}
+
+	/* merge components modify other components, so we can't update them in place */
+	if (as_pool_has_merge_components (old_cpts) || as_pool_has_merge_components (new_cpts))
+		return FALSE;
+
+	/* take the old components of this file out of the pool */
+	old_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+	for (i = 0; (old_cpts != NULL) && (i < old_cpts->len); i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (old_cpts, i));
+		const gchar *cdid = as_component_get_data_id (cpt);
+
+		if (g_hash_table_lookup (priv->cpt_table, cdid) != cpt)
+			continue;
+		g_hash_table_insert (old_table, g_strdup (cdid), g_object_ref (cpt));
+		g_hash_table_remove (priv->cpt_table, cdid);
+	}
+
+	/* add the new data */
+	for (i = 0; i < new_cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (new_cpts, i));
+		const gchar *cdid;
+
+		/* We only read metadata from system directories at time */
+		as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
+
+		if (!as_pool_add_component_internal (pool, cpt, FALSE, &error)) {
+			if (error != NULL) {
+				g_debug ("Metadata ignored: %s", error->message);
+				g_clear_error (&error);
+			}
+			continue;
+		}
+
+		cdid = as_component_get_data_id (cpt);
+		if (g_hash_table_lookup (priv->cpt_table, cdid) != cpt)
+			continue;
+		if (!as_pool_refine_component (pool, cpt)) {
+			g_hash_table_remove (priv->cpt_table, cdid);
+			continue;
+		}
+
+		if (g_hash_table_remove (old_table, cdid))
+			g_ptr_array_add (changed, g_object_ref (cpt));
+		else
+			g_ptr_array_add (added, g_object_ref (cpt));
+	}
+
+	/* whatever is left of the old data is gone now */
+	g_hash_table_iter_init (&iter, old_table);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		g_ptr_array_add (removed, g_object_ref (value));
+
+	/* no component may keep the old data of this file as addon */
+	for (i = 0; (old_cpts != NULL) && (i < old_cpts->len); i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (old_cpts, i));
+
+		if (g_hash_table_lookup (priv->cpt_table, as_component_get_data_id (cpt)) != cpt)
+			as_pool_drop_addon (pool, cpt);
+	}
+
+	/* find the relations of the new data, and link its addons */
+	g_clear_pointer (&priv->graph, as_pool_graph_free);
+	as_pool_update_addon_info (pool);
+
+	as_pool_track_file_components (pool, fname, new_cpts, 0);
+	return TRUE;
+}
+
+/**
+ * as_pool_reload_with_changes:
+ *
+ * Load all data again, and find out what changed compared to the
+ * old pool contents.
+ */
+static void
+as_pool_reload_with_changes (AsPool *pool, GPtrArray *added, GPtrArray *removed, GPtrArray *changed)
+{
+	AsPoolLoadState *state;
+	GHashTable *old_table;
+	GHashTableIter iter;
+	gpointer key, value;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	g_debug ("Metadata changed in a way that requires a full reload.");
+	state = as_pool_load_state_new (pool, NULL);
+	as_pool_load_run (state);
+	if (state->error != NULL)
+		g_debug ("Error while reloading metadata: %s", state->error->message);
+	as_pool_take_data (pool, state->loader);
+
+	/* without knowing where components came from, every component we still have might have changed */
+	g_mutex_lock (&priv->mutex);
+	old_table = GET_PRIVATE (state->loader)->cpt_table;
+	g_hash_table_iter_init (&iter, priv->cpt_table);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		if (g_hash_table_contains (old_table, key))
+			g_ptr_array_add (changed, g_object_ref (value));
+		else
+			g_ptr_array_add (added, g_object_ref (value));
+	}
+	g_hash_table_iter_init (&iter, old_table);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		if (!g_hash_table_contains (priv->cpt_table, key))
+			g_ptr_array_add (removed, g_object_ref (value));
+	}
+	g_mutex_unlock (&priv->mutex);
+
+	as_pool_load_state_free (state);
+}
+
+/**
+ * as_pool_process_changes_cb:
+ *
+ * Update the pool with the data of all files which changed recently.
+ */
+static gboolean
+as_pool_process_changes_cb (gpointer user_data)
+{
+	AsPool *pool = AS_POOL (user_data);
+	g_autoptr(GHashTable) changed_files = NULL;
+	g_autoptr(GPtrArray) added = NULL;
+	g_autoptr(GPtrArray) removed = NULL;
+	g_autoptr(GPtrArray) changed = NULL;
+	GHashTableIter iter;
+	gpointer key, value;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	priv->changes_timeout_id = 0;
+
+	changed_files = priv->changed_files;
+	priv->changed_files = g_hash_table_new_full (g_str_hash,
+						     g_str_equal,
+						     g_free,
+						     NULL);
+
+	added = g_ptr_array_new_with_free_func (g_object_unref);
+	removed = g_ptr_array_new_with_free_func (g_object_unref);
+	changed = g_ptr_array_new_with_free_func (g_object_unref);
+
+	g_hash_table_iter_init (&iter, changed_files);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		if (as_pool_update_file (pool,
+					 (const gchar*) key,
+					 (AsPoolFileKind) GPOINTER_TO_INT (value),
+					 added, removed, changed))
+			continue;
+
+		/* the remaining changes are part of the full reload */
+		g_ptr_array_set_size (added, 0);
+		g_ptr_array_set_size (removed, 0);
+		g_ptr_array_set_size (changed, 0);
+		as_pool_reload_with_changes (pool, added, removed, changed);
+		break;
+	}
+
+	g_object_ref (pool);
+	if (removed->len > 0)
+		g_signal_emit (pool, signals[SIGNAL_COMPONENTS_REMOVED], 0, removed);
+	if (added->len > 0)
+		g_signal_emit (pool, signals[SIGNAL_COMPONENTS_ADDED], 0, added);
+	if (changed->len > 0)
+		g_signal_emit (pool, signals[SIGNAL_COMPONENTS_CHANGED], 0, changed);
+	g_object_unref (pool);
+
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * as_pool_file_changed:
+ *
+ * Queue a changed file for processing. Changes are collected for a short
+ * while, since packages usually install or remove several files at once.
+ */
+static void
+as_pool_file_changed (AsPool *pool, GFileMonitor *monitor, GFile *file)
+{
+	const gchar *pattern;
+	g_autofree gchar *basename = NULL;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	if (file == NULL)
+		return;
+
+	basename = g_file_get_basename (file);
+	pattern = (const gchar*) g_object_get_data (G_OBJECT (monitor), "as-file-pattern");
+	if ((basename == NULL) || (basename[0] == '.') || !as_dir_scanner_match (pattern, basename))
+		return;
+
+	g_hash_table_insert (priv->changed_files,
+			     g_file_get_path (file),
+			     g_object_get_data (G_OBJECT (monitor), "as-file-kind"));
+	if (priv->changes_timeout_id == 0)
+		priv->changes_timeout_id = g_timeout_add (500, as_pool_process_changes_cb, pool);
+}
+
+/**
+ * as_pool_monitor_changed_cb:
+ */
+static void
+as_pool_monitor_changed_cb (GFileMonitor *monitor,
+			    GFile *file,
+			    GFile *other_file,
+			    GFileMonitorEvent event_type,
+			    AsPool *pool)
+{
+	switch (event_type) {
+	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+	case G_FILE_MONITOR_EVENT_CREATED:
+	case G_FILE_MONITOR_EVENT_DELETED:
+	case G_FILE_MONITOR_EVENT_MOVED_IN:
+	case G_FILE_MONITOR_EVENT_MOVED_OUT:
+		as_pool_file_changed (pool, monitor, file);
+		break;
+	case G_FILE_MONITOR_EVENT_RENAMED:
+		as_pool_file_changed (pool, monitor, file);
+		as_pool_file_changed (pool, monitor, other_file);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * as_pool_add_monitor:
+ */
+static void
+as_pool_add_monitor (AsPool *pool, const gchar *dir, const gchar *pattern, AsPoolFileKind kind)
+{
+	GFileMonitor *monitor;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GError) error = NULL;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	file = g_file_new_for_path (dir);
+	monitor = g_file_monitor_directory (file, G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
+	if (monitor == NULL) {
+		g_debug ("Unable to monitor '%s': %s", dir, error->message);
+		return;
+	}
+
+	g_object_set_data (G_OBJECT (monitor), "as-file-kind", GINT_TO_POINTER (kind));
+	g_object_set_data_full (G_OBJECT (monitor), "as-file-pattern", g_strdup (pattern), g_free);
+	g_signal_connect (monitor, "changed",
+			  G_CALLBACK (as_pool_monitor_changed_cb), pool);
+	g_ptr_array_add (priv->monitors, monitor);
+}
+
+/**
+ * as_pool_clear_monitors:
+ */
+static void
+as_pool_clear_monitors (AsPool *pool)
+{
+	guint i;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	for (i = 0; i < priv->monitors->len; i++) {
+		GFileMonitor *monitor = G_FILE_MONITOR (g_ptr_array_index (priv->monitors, i));
+
+		g_signal_handlers_disconnect_by_data (monitor, pool);
+		g_file_monitor_cancel (monitor);
+	}
+	g_ptr_array_set_size (priv->monitors, 0);
+
+	if (priv->changes_timeout_id != 0) {
+		g_source_remove (priv->changes_timeout_id);
+		priv->changes_timeout_id = 0;
+	}
+	g_hash_table_remove_all (priv->changed_files);
+}
+
+/**
+ * as_pool_setup_monitors:
+ *
+ * Watch all metadata locations the pool reads from,
+ * if monitoring was requested.
+ */
+static void
+as_pool_setup_monitors (AsPool *pool)
+{
+	guint i;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	as_pool_clear_monitors (pool);
+	if (!as_flags_contains (priv->flags, AS_POOL_FLAG_MONITOR))
+		return;
+
+	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_COLLECTION)) {
+		for (i = 0; i < priv->xml_dirs->len; i++)
+			as_pool_add_monitor (pool,
+					     (const gchar*) g_ptr_array_index (priv->xml_dirs, i),
+					     "*.xml*",
+					     AS_POOL_FILE_KIND_COLLECTION);
+		for (i = 0; i < priv->yaml_dirs->len; i++)
+			as_pool_add_monitor (pool,
+					     (const gchar*) g_ptr_array_index (priv->yaml_dirs, i),
+					     "*.yml*",
+					     AS_POOL_FILE_KIND_COLLECTION);
+	}
+	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_METAINFO))
+		as_pool_add_monitor (pool, METAINFO_DIR, "*.xml", AS_POOL_FILE_KIND_METAINFO);
+	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_DESKTOP_FILES))
+		as_pool_add_monitor (pool, APPLICATIONS_DIR, "*.desktop", AS_POOL_FILE_KIND_DESKTOP_ENTRY);
+}
+
 /**
  * as_pool_load_cache_file:
  * @pool: An instance of #AsPool.
@@ -1028,25 +2737,38 @@ as_pool_load (AsPool *pool, GCancellable *cancellable, GError **error)
 gboolean
 as_pool_load_cache_file (AsPool *pool, const gchar *fname, GError **error)
 {
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
 	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(AsPoolGraph) links = NULL;
+	gboolean pool_empty;
 	guint i;
 	GError *tmp_error = NULL;
 
-	/* load list of components in cache */
-	cpts = as_cache_file_read (fname, &tmp_error);
+	/* load list of components in cache, keeping the data around to read back evicted fields
+	 * if we have a memory budget */
+	cpts = as_cache_file_read_internal (fname,
+					    (priv->memory_budget > 0)? priv->user_cache_path : NULL,
+					    &links,
+					    &tmp_error);
 	if (tmp_error != NULL) {
 		g_propagate_error (error, tmp_error);
 		return FALSE;
 	}
 
+	/* the stored relations only describe the pool if it has no other data */
+	g_mutex_lock (&priv->mutex);
+	pool_empty = g_hash_table_size (priv->cpt_table) == 0;
+	g_mutex_unlock (&priv->mutex);
+
 	/* add cache objects to the pool */
+	as_pool_load_progress (pool, AS_POOL_LOAD_PHASE_COLLECTION, 1, cpts->len);
 	for (i = 0; i < cpts->len; i++) {
 		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
 
 		/* TODO: Caches are system wide only at time, so we only have system-scope components in there */
 		as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
 
-		as_pool_add_component (pool, cpt, &tmp_error);
+		as_pool_add_loaded_component (pool, cpt, &tmp_error);
 		if (tmp_error != NULL) {
 			g_warning ("Cached data ignored: %s", tmp_error->message);
 			g_error_free (tmp_error);
@@ -1055,17 +2777,259 @@ as_pool_load_cache_file (AsPool *pool, const gchar *fname, GError **error)
 		}
 	}
 
-	/* find addons for the loaded components */
-	for (i = 0; i < cpts->len; i++) {
-		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+	/* find relations and addons for the loaded components */
+	g_mutex_lock (&priv->mutex);
+	if (pool_empty && links != NULL)
+		as_pool_ensure_graph (pool, g_steal_pointer (&links));
+	as_pool_update_addon_info (pool);
+	as_pool_trim_memory (pool);
+	g_mutex_unlock (&priv->mutex);
+
+	/* NOTE: Caches don't have merge components, so we don't need to special-case them here */
+
+	return TRUE;
+}
+
+/**
+ * as_pool_get_snapshot:
+ * @pool: An instance of #AsPool.
+ * @cid: The component-ID a query is about, or %NULL if it needs all data.
+ *
+ * Get the current contents of the pool for a query, loading pending
+ * data the query needs first.
+ *
+ * Returns: (transfer full): a snapshot of the pool contents.
+ */
+static AsPoolSnapshot*
+as_pool_get_snapshot (AsPool *pool, const gchar *cid)
+{
+	AsPoolSnapshot *snapshot;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	g_mutex_lock (&priv->mutex);
+	if (as_pool_load_pending_metainfo (pool, cid))
+		as_pool_invalidate_snapshot (pool);
+	if (priv->snapshot == NULL)
+		priv->snapshot = as_pool_snapshot_new (priv->cpt_table);
+	snapshot = as_pool_snapshot_ref (priv->snapshot);
+	g_mutex_unlock (&priv->mutex);
+
+	return snapshot;
+}
+
+/**
+ * as_pool_map_pkgnames:
+ * @pool: An instance of #AsPool.
+ * @pkgnames: (array zero-terminated=1): A list of package names, e.g. of installed packages.
+ * @installed: (out) (optional) (transfer container) (element-type AsComponent): Location
+ *             to store the components whose packages are all in @pkgnames, or %NULL.
+ *
+ * Find the components for a whole list of packages at once.
+ * This is a lot faster than looking for the components of each package
+ * separately, as the pool is only walked once.
+ *
+ * Returns: (transfer container) (element-type utf8 GPtrArray): a map of the package
+ *          names from @pkgnames which have components to arrays of these components.
+ *
+ * Since: 0.12.1
+ */
+GHashTable*
+as_pool_map_pkgnames (AsPool *pool, gchar **pkgnames, GPtrArray **installed)
+{
+	g_autoptr(AsPoolSnapshot) snapshot = NULL;
+	g_autoptr(GHashTable) pkg_set = NULL;
+	GHashTable *pkg_map;
+	guint i;
+
+	g_return_val_if_fail (pkgnames != NULL, NULL);
+
+	/* build the lookup table from the (usually smaller) package list, then probe it
+	 * with the package names of every component */
+	pkg_set = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; pkgnames[i] != NULL; i++)
+		g_hash_table_add (pkg_set, pkgnames[i]);
+
+	pkg_map = g_hash_table_new_full (g_str_hash,
+					 g_str_equal,
+					 g_free,
+					 (GDestroyNotify) g_ptr_array_unref);
+	if (installed != NULL)
+		*installed = g_ptr_array_new_with_free_func (g_object_unref);
+
+	snapshot = as_pool_get_snapshot (pool, NULL);
+	for (i = 0; i < snapshot->cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (snapshot->cpts, i));
+		gchar **cpt_pkgnames = as_component_get_pkgnames (cpt);
+		gboolean all_found = TRUE;
+		guint j;
+
+		if ((cpt_pkgnames == NULL) || (cpt_pkgnames[0] == NULL))
+			continue;
 
-		/* find and reference addons */
-		as_pool_update_addon_info (pool, cpt);
+		for (j = 0; cpt_pkgnames[j] != NULL; j++) {
+			GPtrArray *pkg_cpts;
+
+			if (!g_hash_table_contains (pkg_set, cpt_pkgnames[j])) {
+				all_found = FALSE;
+				continue;
+			}
+
+			pkg_cpts = g_hash_table_lookup (pkg_map, cpt_pkgnames[j]);
+			if (pkg_cpts == NULL) {
+				pkg_cpts = g_ptr_array_new_with_free_func (g_object_unref);
+				g_hash_table_insert (pkg_map, g_strdup (cpt_pkgnames[j]), pkg_cpts);
+			}
+			g_ptr_array_add (pkg_cpts, g_object_ref (cpt));
+		}
+
+		if (all_found && (installed != NULL))
+			g_ptr_array_add (*installed, g_object_ref (cpt));
 	}
 
-	/* NOTE: Caches don't have merge components, so we don't need to special-case them here */
+	return pkg_map;
+}
+
+struct _AsPoolView
+{
+	volatile gint		ref_count;
+	AsPoolSnapshot		*snapshot;
+	GPtrArray		*cpts; /* borrowed from the snapshot */
+};
+
+G_DEFINE_BOXED_TYPE (AsPoolView, as_pool_view, as_pool_view_ref, as_pool_view_unref)
+
+/**
+ * as_pool_foreach:
+ * @pool: An instance of #AsPool.
+ * @func: (scope call): The function to call for every component.
+ * @user_data: User data for @func.
+ *
+ * Call @func for every component in the pool, until it returns %FALSE.
+ * Unlike as_pool_get_components(), this does not allocate anything per component.
+ * The pool contents may change while @func runs, @func will only see the
+ * components which were in the pool when the iteration started.
+ *
+ * Since: 0.12.1
+ */
+void
+as_pool_foreach (AsPool *pool, AsPoolForeachFunc func, gpointer user_data)
+{
+	g_autoptr(AsPoolSnapshot) snapshot = NULL;
+	guint i;
+
+	g_return_if_fail (func != NULL);
+
+	snapshot = as_pool_get_snapshot (pool, NULL);
+	for (i = 0; i < snapshot->cpts->len; i++) {
+		if (!func (AS_COMPONENT (g_ptr_array_index (snapshot->cpts, i)), user_data))
+			break;
+	}
+}
+
+/**
+ * as_pool_get_view:
+ * @pool: An instance of #AsPool.
+ * @filter: (scope call) (nullable): A function selecting the components of the view, or %NULL for all components.
+ * @user_data: User data for @filter.
+ *
+ * Get a read-only view of the current pool contents, which does not hold
+ * references to the individual components.
+ *
+ * Returns: (transfer full): a new #AsPoolView, free with as_pool_view_unref().
+ *
+ * Since: 0.12.1
+ */
+AsPoolView*
+as_pool_get_view (AsPool *pool, AsPoolFilterFunc filter, gpointer user_data)
+{
+	AsPoolView *view;
+	guint i;
+
+	view = g_slice_new0 (AsPoolView);
+	view->ref_count = 1;
+	view->snapshot = as_pool_get_snapshot (pool, NULL);
+	if (filter == NULL) {
+		view->cpts = g_ptr_array_ref (view->snapshot->cpts);
+		return view;
+	}
+
+	view->cpts = g_ptr_array_new ();
+	for (i = 0; i < view->snapshot->cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (view->snapshot->cpts, i));
+		if (filter (cpt, user_data))
+			g_ptr_array_add (view->cpts, cpt);
+	}
+
+	return view;
+}
+
+/**
+ * as_pool_view_ref:
+ * @view: An #AsPoolView.
+ *
+ * Increases the reference count of @view.
+ *
+ * Returns: (transfer full): @view
+ *
+ * Since: 0.12.1
+ */
+AsPoolView*
+as_pool_view_ref (AsPoolView *view)
+{
+	g_atomic_int_inc (&view->ref_count);
+	return view;
+}
+
+/**
+ * as_pool_view_unref:
+ * @view: An #AsPoolView.
+ *
+ * Decreases the reference count of @view, and frees it once it drops to zero.
+ * The components of the view must not be used after that, unless a reference
+ * was taken on them.
+ *
+ * Since: 0.12.1
+ */
+void
+as_pool_view_unref (AsPoolView *view)
+{
+	if (!g_atomic_int_dec_and_test (&view->ref_count))
+		return;
+	g_ptr_array_unref (view->cpts);
+	as_pool_snapshot_unref (view->snapshot);
+	g_slice_free (AsPoolView, view);
+}
+
+/**
+ * as_pool_view_get_size:
+ * @view: An #AsPoolView.
+ *
+ * Returns: the number of components in @view.
+ *
+ * Since: 0.12.1
+ */
+guint
+as_pool_view_get_size (AsPoolView *view)
+{
+	return view->cpts->len;
+}
 
-	return TRUE;
+/**
+ * as_pool_view_index:
+ * @view: An #AsPoolView.
+ * @idx: The index of the component.
+ *
+ * Get a component of the view.
+ *
+ * Returns: (transfer none): the #AsComponent at @idx, valid as long as @view is.
+ *
+ * Since: 0.12.1
+ */
+AsComponent*
+as_pool_view_index (AsPoolView *view, guint idx)
+{
+	g_return_val_if_fail (idx < view->cpts->len, NULL);
+	return AS_COMPONENT (g_ptr_array_index (view->cpts, idx));
 }
 
 /**
@@ -1080,11 +3044,11 @@ gboolean
 as_pool_save_cache_file (AsPool *pool, const gchar *fname, GError **error)
 {
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(AsPoolView) view = NULL;
 
-	cpts = as_pool_get_components (pool);
-	as_cache_file_save (fname, priv->locale, cpts, error);
-	g_ptr_array_unref (cpts);
+	/* the cache is written straight from the pool data, without copying it */
+	view = as_pool_get_view (pool, NULL, NULL);
+	as_cache_file_save (fname, priv->locale, view->cpts, error);
 
 	return TRUE;
 }
@@ -1100,17 +3064,15 @@ as_pool_save_cache_file (AsPool *pool, const gchar *fname, GError **error)
 GPtrArray*
 as_pool_get_components (AsPool *pool)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
+	g_autoptr(AsPoolSnapshot) snapshot = NULL;
 	GPtrArray *cpts;
+	guint i;
 
-	cpts = g_ptr_array_new_with_free_func (g_object_unref);
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		AsComponent *cpt = AS_COMPONENT (value);
-		g_ptr_array_add (cpts, g_object_ref (cpt));
-	}
+	snapshot = as_pool_get_snapshot (pool, NULL);
+
+	cpts = g_ptr_array_new_full (snapshot->cpts->len, g_object_unref);
+	for (i = 0; i < snapshot->cpts->len; i++)
+		g_ptr_array_add (cpts, g_object_ref (g_ptr_array_index (snapshot->cpts, i)));
 
 	return cpts;
 }
@@ -1129,18 +3091,17 @@ as_pool_get_components (AsPool *pool)
 GPtrArray*
 as_pool_get_components_by_id (AsPool *pool, const gchar *cid)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	g_autoptr(AsPoolSnapshot) snapshot = NULL;
 	GPtrArray *result;
-	GHashTableIter iter;
-	gpointer value;
+	guint i;
 
 	result = g_ptr_array_new_with_free_func (g_object_unref);
 	if (cid == NULL)
 		return result;
+	snapshot = as_pool_get_snapshot (pool, cid);
 
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		AsComponent *cpt = AS_COMPONENT (value);
+	for (i = 0; i < snapshot->cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (snapshot->cpts, i));
 		if (g_strcmp0 (as_component_get_id (cpt), cid) == 0)
 			g_ptr_array_add (result,
 					 g_object_ref (cpt));
@@ -1164,20 +3125,21 @@ as_pool_get_components_by_provided_item (AsPool *pool,
 					      AsProvidedKind kind,
 					      const gchar *item)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
+	g_autoptr(AsPoolSnapshot) snapshot = NULL;
 	GPtrArray *results;
+	guint j;
 
 	/* sanity check */
 	g_return_val_if_fail (item != NULL, NULL);
 
+	/* matching needs the data of all components */
+	snapshot = as_pool_get_snapshot (pool, NULL);
+
 	results = g_ptr_array_new_with_free_func (g_object_unref);
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+	for (j = 0; j < snapshot->cpts->len; j++) {
 		GPtrArray *provided = NULL;
 		guint i;
-		AsComponent *cpt = AS_COMPONENT (value);
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (snapshot->cpts, j));
 
 		provided = as_component_get_provided (cpt);
 		for (i = 0; i < provided->len; i++) {
@@ -1208,18 +3170,19 @@ as_pool_get_components_by_provided_item (AsPool *pool,
 GPtrArray*
 as_pool_get_components_by_kind (AsPool *pool, AsComponentKind kind)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
+	g_autoptr(AsPoolSnapshot) snapshot = NULL;
 	GPtrArray *results;
+	guint i;
 
 	/* sanity check */
 	g_return_val_if_fail ((kind < AS_COMPONENT_KIND_LAST) && (kind > AS_COMPONENT_KIND_UNKNOWN), NULL);
 
+	/* matching needs the data of all components */
+	snapshot = as_pool_get_snapshot (pool, NULL);
+
 	results = g_ptr_array_new_with_free_func (g_object_unref);
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		AsComponent *cpt = AS_COMPONENT (value);
+	for (i = 0; i < snapshot->cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (snapshot->cpts, i));
 
 		if (as_component_get_kind (cpt) == kind)
 				g_ptr_array_add (results, g_object_ref (cpt));
@@ -1240,12 +3203,13 @@ as_pool_get_components_by_kind (AsPool *pool, AsComponentKind kind)
 GPtrArray*
 as_pool_get_components_by_categories (AsPool *pool, gchar **categories)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
-	guint i;
+	g_autoptr(AsPoolSnapshot) snapshot = NULL;
+	guint i, j;
 	GPtrArray *results;
 
+	/* matching needs the data of all components */
+	snapshot = as_pool_get_snapshot (pool, NULL);
+
 	results = g_ptr_array_new_with_free_func (g_object_unref);
 
 	/* sanity check */
@@ -1255,9 +3219,8 @@ as_pool_get_components_by_categories (AsPool *pool, gchar **categories)
 		}
 	}
 
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		AsComponent *cpt = AS_COMPONENT (value);
+	for (j = 0; j < snapshot->cpts->len; j++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (snapshot->cpts, j));
 
 		for (i = 0; categories[i] != NULL; i++) {
 			if (as_component_has_category (cpt, categories[i]))
@@ -1286,39 +3249,23 @@ as_pool_get_components_by_launchable (AsPool *pool,
 					      AsLaunchableKind kind,
 					      const gchar *id)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
+	g_autoptr(AsPoolSnapshot) snapshot = NULL;
 	GPtrArray *results;
+	guint k;
 
 	/* sanity check */
 	g_return_val_if_fail (id != NULL, NULL);
 
-	results = g_ptr_array_new_with_free_func (g_object_unref);
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		GPtrArray *launchables = NULL;
-		guint i;
-		AsComponent *cpt = AS_COMPONENT (value);
-
-		launchables = as_component_get_launchables (cpt);
-		for (i = 0; i < launchables->len; i++) {
-			guint j;
-			GPtrArray *entries;
-			AsLaunchable *launch = AS_LAUNCHABLE (g_ptr_array_index (launchables, i));
+	/* matching needs the data of all components */
+	snapshot = as_pool_get_snapshot (pool, NULL);
 
-			if (kind != AS_LAUNCHABLE_KIND_UNKNOWN) {
-				/* check if the kind matches. an unknown kind matches all provides types */
-				if (as_launchable_get_kind (launch) != kind)
-					continue;
-			}
+	results = g_ptr_array_new_with_free_func (g_object_unref);
+	for (k = 0; k < snapshot->cpts->len; k++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (snapshot->cpts, k));
 
-			entries = as_launchable_get_entries (launch);
-			for (j = 0; j < entries->len; j++) {
-				if (g_strcmp0 ((const gchar*) g_ptr_array_index (entries, j), id) == 0)
-					g_ptr_array_add (results, g_object_ref (cpt));
-			}
-		}
+		/* an unknown kind matches all launchable types */
+		if (as_component_has_launchable_entry (cpt, kind, id))
+			g_ptr_array_add (results, g_object_ref (cpt));
 	}
 
 	return results;
@@ -1330,7 +3277,7 @@ as_pool_get_components_by_launchable (AsPool *pool,
  * Build an array of search terms from a search string and improve the search terms
  * slightly, by stripping whitespaces, casefolding the terms and removing greylist words.
  */
-static gchar**
+gchar**
 as_pool_build_search_terms (AsPool *pool, const gchar *search)
 {
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
@@ -1384,20 +3331,23 @@ as_pool_build_search_terms (AsPool *pool, const gchar *search)
 	return terms;
 }
 
+/* a search result, with the score it got for this particular query */
+typedef struct {
+	AsComponent	*cpt;
+	guint		score;
+} AsPoolSearchMatch;
+
 /**
- * as_sort_components_by_score_cb:
+ * as_sort_matches_by_score_cb:
  *
- * Helper method to sort result arrays by the #AsComponent match score
+ * Helper method to sort search matches by their match score
  * with higher scores appearing higher in the list.
  */
 static gint
-as_sort_components_by_score_cb (gconstpointer a, gconstpointer b)
+as_sort_matches_by_score_cb (gconstpointer a, gconstpointer b)
 {
-	guint s1, s2;
-	AsComponent *cpt1 = *((AsComponent **) a);
-	AsComponent *cpt2 = *((AsComponent **) b);
-	s1 = as_component_get_sort_score (cpt1);
-	s2 = as_component_get_sort_score (cpt2);
+	guint s1 = ((const AsPoolSearchMatch*) a)->score;
+	guint s2 = ((const AsPoolSearchMatch*) b)->score;
 
 	if (s1 > s2)
 		return -1;
@@ -1421,15 +3371,14 @@ as_sort_components_by_score_cb (gconstpointer a, gconstpointer b)
 GPtrArray*
 as_pool_search (AsPool *pool, const gchar *search)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
 	g_auto(GStrv) terms = NULL;
+	g_autoptr(AsPoolSnapshot) snapshot = NULL;
+	g_autoptr(GArray) matches = NULL;
 	GPtrArray *results;
-	GHashTableIter iter;
-	gpointer value;
+	guint i;
 
 	/* sanitize user's search term */
 	terms = as_pool_build_search_terms (pool, search);
-	results = g_ptr_array_new_with_free_func (g_object_unref);
 
 	if (terms == NULL) {
 		g_debug ("Search term invalid. Matching everything.");
@@ -1439,24 +3388,119 @@ as_pool_search (AsPool *pool, const gchar *search)
 		g_debug ("Searching for: %s", tmp_str);
 	}
 
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		guint score;
-		AsComponent *cpt = AS_COMPONENT (value);
+	/* matching needs the data of all components */
+	snapshot = as_pool_get_snapshot (pool, NULL);
 
-		score = as_component_search_matches_all (cpt, terms);
-		if (score == 0)
+	/* scores are kept with the query, so concurrent searches don't interfere */
+	matches = g_array_new (FALSE, FALSE, sizeof (AsPoolSearchMatch));
+	for (i = 0; i < snapshot->cpts->len; i++) {
+		AsPoolSearchMatch match;
+
+		match.cpt = AS_COMPONENT (g_ptr_array_index (snapshot->cpts, i));
+		match.score = as_component_search_matches_all (match.cpt, terms);
+		if (match.score == 0)
 			continue;
 
-		g_ptr_array_add (results, g_object_ref (cpt));
+		g_array_append_val (matches, match);
 	}
 
 	/* sort the results by their priority */
-	g_ptr_array_sort (results, as_sort_components_by_score_cb);
+	g_array_sort (matches, as_sort_matches_by_score_cb);
+
+	results = g_ptr_array_new_full (matches->len, g_object_unref);
+	for (i = 0; i < matches->len; i++)
+		g_ptr_array_add (results, g_object_ref (g_array_index (matches, AsPoolSearchMatch, i).cpt));
 
 	return results;
 }
 
+/**
+ * as_pool_get_linked_internal:
+ *
+ * Find the components linked to or from @cid, using the relations graph.
+ */
+static GPtrArray*
+as_pool_get_linked_internal (AsPool *pool, const gchar *cid, AsPoolLinkKind kind, gboolean reverse)
+{
+	GPtrArray *result;
+	GPtrArray *linked_cids;
+	guint i;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	g_return_val_if_fail (cid != NULL, NULL);
+	g_return_val_if_fail (kind > AS_POOL_LINK_KIND_UNKNOWN && kind < AS_POOL_LINK_KIND_LAST, NULL);
+
+	result = g_ptr_array_new_with_free_func (g_object_unref);
+
+	/* any component might link to any other, so the graph needs all data */
+	g_mutex_lock (&priv->mutex);
+	if (as_pool_load_pending_metainfo (pool, NULL))
+		as_pool_invalidate_snapshot (pool);
+	as_pool_ensure_graph (pool, NULL);
+
+	linked_cids = reverse? as_pool_graph_get_sources (priv->graph, cid, kind) :
+			       as_pool_graph_get_targets (priv->graph, cid, kind);
+	for (i = 0; linked_cids != NULL && i < linked_cids->len; i++) {
+		GPtrArray *cdids;
+		guint j;
+
+		cdids = as_pool_graph_get_nodes (priv->graph, g_ptr_array_index (linked_cids, i));
+		for (j = 0; cdids != NULL && j < cdids->len; j++) {
+			AsComponent *cpt = g_hash_table_lookup (priv->cpt_table,
+								g_ptr_array_index (cdids, j));
+			if (cpt != NULL)
+				g_ptr_array_add (result, g_object_ref (cpt));
+		}
+	}
+	g_mutex_unlock (&priv->mutex);
+
+	return result;
+}
+
+/**
+ * as_pool_get_linked:
+ * @pool: An instance of #AsPool.
+ * @cid: The component-ID to find the relations of.
+ * @kind: The #AsPoolLinkKind of the relations.
+ *
+ * Find the components which the components with ID @cid link to, e.g.
+ * the components they extend if @kind is %AS_POOL_LINK_KIND_EXTENDS, or
+ * the components they require if it is %AS_POOL_LINK_KIND_REQUIRES.
+ *
+ * The relations are computed once when the pool is loaded, or read from
+ * the cache, so this does not need to look at all components of the pool.
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of the linked #AsComponent objects.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_pool_get_linked (AsPool *pool, const gchar *cid, AsPoolLinkKind kind)
+{
+	return as_pool_get_linked_internal (pool, cid, kind, FALSE);
+}
+
+/**
+ * as_pool_get_linked_by:
+ * @pool: An instance of #AsPool.
+ * @cid: The component-ID to find the relations of.
+ * @kind: The #AsPoolLinkKind of the relations.
+ *
+ * Find the components which link to the components with ID @cid.
+ * This is the reverse of as_pool_get_linked(), e.g. it returns all
+ * addons of a component if @kind is %AS_POOL_LINK_KIND_EXTENDS, or
+ * everything which depends on a runtime if it is %AS_POOL_LINK_KIND_REQUIRES.
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of the linking #AsComponent objects.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_pool_get_linked_by (AsPool *pool, const gchar *cid, AsPoolLinkKind kind)
+{
+	return as_pool_get_linked_internal (pool, cid, kind, TRUE);
+}
+
 /**
  * as_pool_refresh_cache:
  * @pool: An instance of #AsPool.
@@ -1471,6 +3515,7 @@ gboolean
 as_pool_refresh_cache (AsPool *pool, gboolean force, GError **error)
 {
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	AsPoolLoadState *state;
 	gboolean ret = FALSE;
 	gboolean ret_poolupdate;
 	g_autofree gchar *cache_fname = NULL;
@@ -1514,16 +3559,17 @@ as_pool_refresh_cache (AsPool *pool, gboolean force, GError **error)
 	}
 	g_debug ("Refreshing AppStream cache");
 
-	/* ensure we start with an empty pool */
-	as_pool_clear (pool);
-
-	/* NOTE: we will only cache AppStream metadata, no .desktop file metadata etc. */
+	/* NOTE: we will only cache AppStream metadata here, .desktop file data has its own cache */
 
-	/* load AppStream collection metadata only and refine it */
-	ret = as_pool_load_collection_data (pool, TRUE, &data_load_error);
-	ret_poolupdate = as_pool_refine_data (pool) && ret;
+	/* load AppStream collection metadata only and refine it, into a fresh pool
+	 * so queries keep seeing the old data until the new data is complete */
+	state = as_pool_load_state_new (pool, NULL);
+	ret = as_pool_load_collection_data (state->loader, TRUE, &data_load_error);
+	ret_poolupdate = as_pool_refine_data (state->loader) && ret;
 	if (data_load_error != NULL)
 		g_debug ("Error while updating the in-memory data pool: %s", data_load_error->message);
+	as_pool_take_data (pool, state->loader);
+	as_pool_load_state_free (state);
 
 	/* save the cache object */
 	as_pool_save_cache_file (pool, cache_fname, &tmp_error);
@@ -1578,6 +3624,7 @@ as_cache_file_save (const gchar *fname, const gchar *locale, GPtrArray *cpts, GE
 	g_autoptr(GVariant) main_gv = NULL;
 	g_autoptr(GVariantBuilder) main_builder = NULL;
 	g_autoptr(GVariantBuilder) builder = NULL;
+	g_autoptr(AsPoolGraph) links = NULL;
 
 	g_autoptr(GFile) ofile = NULL;
 	g_autoptr(GFileOutputStream) file_out = NULL;
@@ -1594,6 +3641,7 @@ as_cache_file_save (const gchar *fname, const gchar *locale, GPtrArray *cpts, GE
 
 	main_builder = g_variant_builder_new (G_VARIANT_TYPE_VARDICT);
 	builder = g_variant_builder_new (G_VARIANT_TYPE_ARRAY);
+	links = as_pool_graph_new ();
 
 	for (cindex = 0; cindex < cpts->len; cindex++) {
 		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, cindex));
@@ -1614,6 +3662,7 @@ as_cache_file_save (const gchar *fname, const gchar *locale, GPtrArray *cpts, GE
 		serializable_components_found = TRUE;
 
 		as_component_to_variant (cpt, builder);
+		as_pool_graph_add_links (links, cpt);
 	}
 
 	/* check if we actually have some valid components serialized to a GVariant */
@@ -1633,6 +3682,11 @@ as_cache_file_save (const gchar *fname, const gchar *locale, GPtrArray *cpts, GE
 	g_variant_builder_add (main_builder, "{sv}",
 				"components",
 				g_variant_builder_end (builder));
+
+	/* store the relations, so loading the cache does not need to compute them */
+	g_variant_builder_add (main_builder, "{sv}",
+				"links",
+				as_pool_graph_links_to_variant (links));
 	main_gv = g_variant_builder_end (main_builder);
 
 	ofile = g_file_new_for_path (fname);
@@ -1671,102 +3725,652 @@ as_cache_file_save (const gchar *fname, const gchar *locale, GPtrArray *cpts, GE
 }
 
 /**
- * as_cache_read:
- * @fname: The file to save the data to.
- * @locale: The locale this cache file is for.
- * @cpts: (element-type AsComponent): The components to serialize.
+ * as_cache_file_map_data:
+ * @dir: The directory to create the temporary file in.
+ * @bytes: The uncompressed cache data.
+ *
+ * Move uncompressed cache data into a file which is unlinked right away and
+ * map it, so its pages can be dropped by the kernel instead of using heap
+ * memory while we keep it around.
+ *
+ * Returns: (transfer full) (nullable): the mapped data, or %NULL on error.
+ */
+static GBytes*
+as_cache_file_map_data (const gchar *dir, GBytes *bytes)
+{
+	g_autofree gchar *fname = NULL;
+	g_autoptr(GMappedFile) mfile = NULL;
+	g_autoptr(GError) tmp_error = NULL;
+	const guint8 *data;
+	gsize len;
+	gint fd;
+
+	g_mkdir_with_parents (dir, 0755);
+	fname = g_build_filename (dir, "pool-data-XXXXXX", NULL);
+	fd = g_mkstemp (fname);
+	if (fd < 0) {
+		g_debug ("Unable to create file for uncompressed cache data: %s", g_strerror (errno));
+		return NULL;
+	}
+
+	data = g_bytes_get_data (bytes, &len);
+	while (len > 0) {
+		gssize written = write (fd, data, len);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		data += written;
+		len -= written;
+	}
+	if (len == 0)
+		mfile = g_mapped_file_new_from_fd (fd, FALSE, &tmp_error);
+	else
+		g_debug ("Unable to write uncompressed cache data: %s", g_strerror (errno));
+
+	/* the mapping stays valid after the file is gone */
+	g_unlink (fname);
+	close (fd);
+	if (mfile == NULL) {
+		if (tmp_error != NULL)
+			g_debug ("Unable to map uncompressed cache data: %s", tmp_error->message);
+		return NULL;
+	}
+
+	return g_mapped_file_get_bytes (mfile);
+}
+
+/**
+ * as_cache_file_load_data:
+ * @fname: The cache file to read.
+ * @map_dir: (nullable): Directory to keep the uncompressed data in, or %NULL.
+ * @mapped: (out): Set to %TRUE if the data is mapped from a file in @map_dir.
+ * @error: A #GError
+ *
+ * Read and uncompress the serialized data of a cache file.
+ *
+ * Returns: (transfer full): the cache data, or %NULL if it could not be read.
+ */
+static GVariant*
+as_cache_file_load_data (const gchar *fname, const gchar *map_dir, gboolean *mapped, GError **error)
+{
+	g_autoptr(GFile) ifile = NULL;
+	g_autoptr(GInputStream) file_stream = NULL;
+	g_autoptr(GInputStream) stream_data = NULL;
+	g_autoptr(GConverter) conv = NULL;
+
+	GByteArray *byte_array;
+	g_autoptr(GBytes) bytes = NULL;
+	gssize len;
+	const gsize buffer_size = 1024 * 32;
+	g_autofree guint8 *buffer = NULL;
+
+	g_autoptr(GVariant) main_gv = NULL;
+	g_autoptr(GVariant) gmvar = NULL;
+
+	*mapped = FALSE;
+	ifile = g_file_new_for_path (fname);
+
+	file_stream = G_INPUT_STREAM (g_file_read (ifile, NULL, error));
+	if (file_stream == NULL)
+		return NULL;
+
+	/* decompress the GZip stream */
+	conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+	stream_data = g_converter_input_stream_new (file_stream, conv);
+
+	buffer = g_malloc (buffer_size);
+	byte_array = g_byte_array_new ();
+	while ((len = g_input_stream_read (stream_data, buffer, buffer_size, NULL, error)) > 0) {
+		g_byte_array_append (byte_array, buffer, len);
+	}
+	bytes = g_byte_array_free_to_bytes (byte_array);
+
+	/* check if there was an error */
+	if (len < 0)
+		return NULL;
+	if ((error != NULL) && (*error != NULL))
+		return NULL;
+
+	if (map_dir != NULL) {
+		GBytes *mapped_bytes = as_cache_file_map_data (map_dir, bytes);
+		if (mapped_bytes != NULL) {
+			g_bytes_unref (bytes);
+			bytes = mapped_bytes;
+			*mapped = TRUE;
+		}
+	}
+
+	main_gv = g_variant_new_from_bytes (G_VARIANT_TYPE_VARDICT, bytes, TRUE);
+
+	gmvar = g_variant_lookup_value (main_gv,
+					"format_version",
+					G_VARIANT_TYPE_UINT32);
+	if ((gmvar == NULL) || (g_variant_get_uint32 (gmvar) != CACHE_FORMAT_VERSION)) {
+		/* don't try to load incompatible cache versions */
+		if (gmvar == NULL)
+			g_warning ("Skipped loading of broken cache file '%s'.", fname);
+		else
+			g_warning ("Skipped loading of incompatible or broken cache file '%s': Format is %i (expected %i)",
+					fname, g_variant_get_uint32 (gmvar), CACHE_FORMAT_VERSION);
+
+		/* TODO: Maybe emit a proper GError? */
+		return NULL;
+	}
+
+	return g_steal_pointer (&main_gv);
+}
+
+/**
+ * as_cache_file_get_locale:
+ *
+ * Returns: (transfer full): the locale the data of a cache file was serialized with.
+ */
+static gchar*
+as_cache_file_get_locale (GVariant *main_gv)
+{
+	g_autoptr(GVariant) gmvar = NULL;
+
+	gmvar = g_variant_lookup_value (main_gv,
+					"locale",
+					G_VARIANT_TYPE_MAYBE);
+	return g_strdup (as_variant_get_mstring (&gmvar));
+}
+
+/**
+ * as_cache_component_new:
+ * @cptv: The serialized component.
+ * @context: The context shared by the components of the cache file.
+ * @locale: The locale of the cache file.
+ *
+ * Create a component from its cache serialization.
+ *
+ * Returns: (transfer full): the component, or %NULL if the data was invalid.
+ */
+static AsComponent*
+as_cache_component_new (GVariant *cptv, AsContext *context, const gchar *locale)
+{
+	g_autoptr(AsComponent) cpt = as_component_new ();
+
+	as_component_set_context (cpt, context);
+	if (!as_component_set_from_variant (cpt, cptv, locale))
+		return NULL;
+
+	if (!as_component_is_valid (cpt)) {
+		g_autofree gchar *str = as_component_to_string (cpt);
+		g_warning ("Ignored serialized component: %s", str);
+		return NULL;
+	}
+
+	return g_steal_pointer (&cpt);
+}
+
+/**
+ * as_cache_file_read_internal:
+ * @fname: The cache file to read.
+ * @map_dir: (nullable): Directory to keep the uncompressed data in, or %NULL.
+ * @links: (out) (optional) (transfer full): Location to store the relations
+ *         between the components in, %NULL if the cache has none stored.
+ * @error: A #GError
+ *
+ * Read components from a cache file. If @map_dir is set, the uncompressed
+ * data is kept mapped from a file in it, and the components keep their
+ * serialized data so their heavy fields can be evicted.
+ */
+static GPtrArray*
+as_cache_file_read_internal (const gchar *fname, const gchar *map_dir, AsPoolGraph **links, GError **error)
+{
+	GPtrArray *cpts = NULL;
+	g_autoptr(GVariant) main_gv = NULL;
+	g_autoptr(GVariant) cptsv_array = NULL;
+	g_autoptr(AsContext) context = NULL;
+	g_autofree gchar *locale = NULL;
+	GVariant *cptv;
+	GVariantIter main_iter;
+	gboolean mapped;
+
+	main_gv = as_cache_file_load_data (fname, map_dir, &mapped, error);
+	if (main_gv == NULL)
+		return NULL;
+
+	locale = as_cache_file_get_locale (main_gv);
+	cptsv_array = g_variant_lookup_value (main_gv,
+					      "components",
+					      G_VARIANT_TYPE_ARRAY);
+
+	/* a shared context lets all components use the same copies of repeated strings */
+	context = as_context_new ();
+	as_context_set_locale (context, locale);
+
+	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	g_variant_iter_init (&main_iter, cptsv_array);
+	while ((cptv = g_variant_iter_next_value (&main_iter))) {
+		AsComponent *cpt = as_cache_component_new (cptv, context, locale);
+
+		/* without a mapped file we can still work, just without evicting data */
+		if (cpt != NULL) {
+			if (mapped)
+				as_component_set_cache_data (cpt, cptv, locale);
+			g_ptr_array_add (cpts, cpt);
+		}
+		g_variant_unref (cptv);
+	}
+
+	if (links != NULL) {
+		g_autoptr(GVariant) links_gv = NULL;
+
+		/* older caches don't store the relations yet */
+		*links = NULL;
+		links_gv = g_variant_lookup_value (main_gv, "links", G_VARIANT_TYPE ("a(uss)"));
+		if (links_gv != NULL) {
+			*links = as_pool_graph_new ();
+			as_pool_graph_add_links_from_variant (*links, links_gv);
+		}
+	}
+
+	return cpts;
+}
+
+/**
+ * as_cache_file_read:
+ * @fname: The cache file to read.
  * @error: A #GError
  *
- * Serialize components to a cache file and store it on disk.
+ * Read the components of a cache file.
  */
 GPtrArray*
 as_cache_file_read (const gchar *fname, GError **error)
 {
-	GPtrArray *cpts = NULL;
-	g_autoptr(GFile) ifile = NULL;
-	g_autoptr(GInputStream) file_stream = NULL;
-	g_autoptr(GInputStream) stream_data = NULL;
-	g_autoptr(GConverter) conv = NULL;
+	return as_cache_file_read_internal (fname, NULL, NULL, error);
+}
 
-	GByteArray *byte_array;
-	g_autoptr(GBytes) bytes = NULL;
-	gssize len;
-	const gsize buffer_size = 1024 * 32;
-	g_autofree guint8 *buffer = NULL;
+struct _AsPoolDelta
+{
+	volatile gint		ref_count;
+	GPtrArray		*added; /* of AsComponent */
+	GPtrArray		*removed; /* of AsComponent */
+	GPtrArray		*changed; /* of AsComponent */
+};
 
-	g_autoptr(GVariant) main_gv = NULL;
-	g_autoptr(GVariant) cptsv_array = NULL;
-	g_autoptr(GVariant) cptv = NULL;
-	g_autoptr(GVariant) gmvar = NULL;
-	const gchar *locale = NULL;
-	GVariantIter main_iter;
+G_DEFINE_BOXED_TYPE (AsPoolDelta, as_pool_delta, as_pool_delta_ref, as_pool_delta_unref)
 
-	ifile = g_file_new_for_path (fname);
+/**
+ * as_pool_delta_new:
+ *
+ * Create an empty delta.
+ */
+static AsPoolDelta*
+as_pool_delta_new (void)
+{
+	AsPoolDelta *delta;
 
-	file_stream = G_INPUT_STREAM (g_file_read (ifile, NULL, error));
-	if (file_stream == NULL)
-		return NULL;
+	delta = g_slice_new0 (AsPoolDelta);
+	delta->ref_count = 1;
+	delta->added = g_ptr_array_new_with_free_func (g_object_unref);
+	delta->removed = g_ptr_array_new_with_free_func (g_object_unref);
+	delta->changed = g_ptr_array_new_with_free_func (g_object_unref);
 
-	/* decompress the GZip stream */
-	conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
-	stream_data = g_converter_input_stream_new (file_stream, conv);
+	return delta;
+}
 
-	buffer = g_malloc (buffer_size);
-	byte_array = g_byte_array_new ();
-	while ((len = g_input_stream_read (stream_data, buffer, buffer_size, NULL, error)) > 0) {
-		g_byte_array_append (byte_array, buffer, len);
-	}
-	bytes = g_byte_array_free_to_bytes (byte_array);
+/**
+ * as_pool_delta_cmp_data_id:
+ *
+ * Sort components by their data-ID.
+ */
+static gint
+as_pool_delta_cmp_data_id (gconstpointer a, gconstpointer b)
+{
+	AsComponent *cpt1 = *((AsComponent **) a);
+	AsComponent *cpt2 = *((AsComponent **) b);
 
-	/* check if there was an error */
-	if (len < 0)
-		return NULL;
-	if ((error != NULL) && (*error != NULL))
-		return NULL;
+	return g_strcmp0 (as_component_get_data_id (cpt1),
+			  as_component_get_data_id (cpt2));
+}
 
-	main_gv = g_variant_new_from_bytes (G_VARIANT_TYPE_VARDICT, bytes, TRUE);
-	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+/**
+ * as_pool_delta_sort:
+ *
+ * Give the results a stable order.
+ */
+static void
+as_pool_delta_sort (AsPoolDelta *delta)
+{
+	g_ptr_array_sort (delta->added, as_pool_delta_cmp_data_id);
+	g_ptr_array_sort (delta->removed, as_pool_delta_cmp_data_id);
+	g_ptr_array_sort (delta->changed, as_pool_delta_cmp_data_id);
+}
 
-	gmvar = g_variant_lookup_value (main_gv,
-					"format_version",
-					G_VARIANT_TYPE_UINT32);
-	if ((gmvar == NULL) || (g_variant_get_uint32 (gmvar) != CACHE_FORMAT_VERSION)) {
-		/* don't try to load incompatible cache versions */
-		if (gmvar == NULL)
-			g_warning ("Skipped loading of broken cache file '%s'.", fname);
-		else
-			g_warning ("Skipped loading of incompatible or broken cache file '%s': Format is %i (expected %i)",
-					fname, g_variant_get_uint32 (gmvar), CACHE_FORMAT_VERSION);
+/**
+ * as_pool_diff:
+ * @old_pool: An instance of #AsPool with the previous data.
+ * @new_pool: An instance of #AsPool with the current data.
+ *
+ * Find the components which were added to, removed from or changed in
+ * @new_pool compared to @old_pool.
+ * Components are matched by their data-ID, and compared using their
+ * content hash (see as_component_get_content_hash()).
+ *
+ * Returns: (transfer full): a new #AsPoolDelta, free with as_pool_delta_unref().
+ *
+ * Since: 0.12.1
+ */
+AsPoolDelta*
+as_pool_diff (AsPool *old_pool, AsPool *new_pool)
+{
+	g_autoptr(AsPoolSnapshot) old_snapshot = NULL;
+	g_autoptr(AsPoolSnapshot) new_snapshot = NULL;
+	g_autoptr(GHashTable) old_cpts = NULL;
+	AsPoolDelta *delta;
+	GHashTableIter iter;
+	gpointer value;
+	guint i;
 
-		/* TODO: Maybe emit a proper GError? */
-		return NULL;
+	old_snapshot = as_pool_get_snapshot (old_pool, NULL);
+	new_snapshot = as_pool_get_snapshot (new_pool, NULL);
+	delta = as_pool_delta_new ();
+
+	old_cpts = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < old_snapshot->cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (old_snapshot->cpts, i));
+		g_hash_table_insert (old_cpts, (gpointer) as_component_get_data_id (cpt), cpt);
 	}
 
-	g_variant_unref (gmvar);
-	gmvar = g_variant_lookup_value (main_gv,
-					"locale",
-					G_VARIANT_TYPE_MAYBE);
-	locale = as_variant_get_mstring (&gmvar);
+	for (i = 0; i < new_snapshot->cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (new_snapshot->cpts, i));
+		AsComponent *old_cpt;
+
+		old_cpt = g_hash_table_lookup (old_cpts, as_component_get_data_id (cpt));
+		if (old_cpt == NULL) {
+			g_ptr_array_add (delta->added, g_object_ref (cpt));
+			continue;
+		}
+		if (g_strcmp0 (as_component_get_content_hash (old_cpt),
+			       as_component_get_content_hash (cpt)) != 0)
+			g_ptr_array_add (delta->changed, g_object_ref (cpt));
+		g_hash_table_remove (old_cpts, as_component_get_data_id (cpt));
+	}
+
+	/* everything left over is gone */
+	g_hash_table_iter_init (&iter, old_cpts);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		g_ptr_array_add (delta->removed, g_object_ref (AS_COMPONENT (value)));
+
+	as_pool_delta_sort (delta);
+	return delta;
+}
+
+/**
+ * as_cache_file_index:
+ *
+ * Map the data-IDs of the components in cache data to their
+ * serialization, without deserializing them.
+ *
+ * Returns: (transfer full): a table of data-ID to #GVariant.
+ */
+static GHashTable*
+as_cache_file_index (GVariant *main_gv)
+{
+	GHashTable *index;
+	g_autoptr(GVariant) cptsv_array = NULL;
+	GVariantIter main_iter;
+	GVariant *cptv;
 
+	index = g_hash_table_new_full (g_str_hash,
+				       g_str_equal,
+				       g_free,
+				       (GDestroyNotify) g_variant_unref);
 	cptsv_array = g_variant_lookup_value (main_gv,
 					      "components",
 					      G_VARIANT_TYPE_ARRAY);
+	if (cptsv_array == NULL)
+		return index;
 
 	g_variant_iter_init (&main_iter, cptsv_array);
 	while ((cptv = g_variant_iter_next_value (&main_iter))) {
-		g_autoptr(AsComponent) cpt = as_component_new ();
-		if (as_component_set_from_variant (cpt, cptv, locale)) {
-			/* add to result list */
-			if (as_component_is_valid (cpt)) {
-				g_ptr_array_add (cpts, g_object_ref (cpt));
-			} else {
-				g_autofree gchar *str = as_component_to_string (cpt);
-				g_warning ("Ignored serialized component: %s", str);
-			}
+		GVariantDict dict;
+		GVariant *id_var;
+		GVariant *origin_var;
+		g_autoptr(GVariant) bundles = NULL;
+		const gchar *origin;
+		AsBundleKind bundle_kind = AS_BUNDLE_KIND_PACKAGE;
+		gchar *data_id;
+
+		g_variant_dict_init (&dict, cptv);
+		bundles = g_variant_dict_lookup_value (&dict, "bundles", G_VARIANT_TYPE_ARRAY);
+		if ((bundles != NULL) && (g_variant_n_children (bundles) > 0)) {
+			g_autoptr(GVariant) bundle = g_variant_get_child_value (bundles, 0);
+			guint32 kind;
+
+			if (g_variant_lookup (bundle, "type", "u", &kind))
+				bundle_kind = kind;
 		}
+
+		/* same rules as as_utils_build_data_id_for_cpt(), caches only contain system-scope data */
+		origin = as_variant_get_dict_mstr (&dict, "origin", &origin_var);
+		data_id = as_utils_build_data_id (AS_COMPONENT_SCOPE_SYSTEM,
+						  (bundle_kind == AS_BUNDLE_KIND_PACKAGE)? "os" : origin,
+						  bundle_kind,
+						  as_variant_get_dict_mstr (&dict, "id", &id_var));
+		g_hash_table_replace (index, data_id, cptv);
+
+		if (id_var != NULL)
+			g_variant_unref (id_var);
+		if (origin_var != NULL)
+			g_variant_unref (origin_var);
+		g_variant_dict_clear (&dict);
 	}
 
-	return cpts;
+	return index;
+}
+
+/**
+ * as_cache_file_get_content_hash:
+ *
+ * Returns: (transfer full): the content hash of a serialized component.
+ */
+static gchar*
+as_cache_file_get_content_hash (GVariant *cptv)
+{
+	g_autoptr(GVariant) var = NULL;
+
+	/* older caches don't store the hash yet */
+	var = g_variant_lookup_value (cptv, "content_hash", G_VARIANT_TYPE_STRING);
+	if (var == NULL)
+		return as_component_hash_variant (cptv);
+	return g_variant_dup_string (var, NULL);
+}
+
+/**
+ * as_pool_diff_add_cached:
+ *
+ * Deserialize a component of a cache file and add it to @dest.
+ */
+static void
+as_pool_diff_add_cached (GPtrArray *dest, GVariant *cptv, AsContext *context)
+{
+	AsComponent *cpt;
+
+	cpt = as_cache_component_new (cptv, context, as_context_get_locale (context));
+	if (cpt == NULL)
+		return;
+	as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
+	g_ptr_array_add (dest, cpt);
+}
+
+/**
+ * as_pool_diff_cache_files:
+ * @old_fname: A cache file with the previous data.
+ * @new_fname: A cache file with the current data.
+ * @error: A #GError or %NULL.
+ *
+ * Find the components which were added to, removed from or changed in
+ * the cache file @new_fname compared to @old_fname, e.g. after the cache
+ * was refreshed.
+ * Only the data-IDs and content hashes of the cached components are read,
+ * so only components which are part of the result are loaded.
+ *
+ * Returns: (transfer full): a new #AsPoolDelta, or %NULL on error.
+ *
+ * Since: 0.12.1
+ */
+AsPoolDelta*
+as_pool_diff_cache_files (const gchar *old_fname, const gchar *new_fname, GError **error)
+{
+	g_autoptr(GVariant) old_gv = NULL;
+	g_autoptr(GVariant) new_gv = NULL;
+	g_autoptr(GHashTable) old_index = NULL;
+	g_autoptr(GHashTable) new_index = NULL;
+	g_autoptr(AsContext) old_context = NULL;
+	g_autoptr(AsContext) new_context = NULL;
+	g_autofree gchar *old_locale = NULL;
+	g_autofree gchar *new_locale = NULL;
+	AsPoolDelta *delta;
+	GHashTableIter iter;
+	gpointer key, value;
+	gboolean mapped;
+	const gchar *fnames[] = { old_fname, new_fname };
+	GVariant **gvs[] = { &old_gv, &new_gv };
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (fnames); i++) {
+		GError *tmp_error = NULL;
+
+		*gvs[i] = as_cache_file_load_data (fnames[i], NULL, &mapped, &tmp_error);
+		if (*gvs[i] != NULL)
+			continue;
+		if (tmp_error != NULL)
+			g_propagate_prefixed_error (error, tmp_error, "Unable to read cache file '%s': ", fnames[i]);
+		else
+			g_set_error (error,
+				     AS_POOL_ERROR,
+				     AS_POOL_ERROR_FAILED,
+				     "Unable to read cache file '%s': Incompatible or broken cache.", fnames[i]);
+		return NULL;
+	}
+
+	old_index = as_cache_file_index (old_gv);
+	new_index = as_cache_file_index (new_gv);
+
+	old_locale = as_cache_file_get_locale (old_gv);
+	old_context = as_context_new ();
+	as_context_set_locale (old_context, old_locale);
+	new_locale = as_cache_file_get_locale (new_gv);
+	new_context = as_context_new ();
+	as_context_set_locale (new_context, new_locale);
+
+	delta = as_pool_delta_new ();
+	g_hash_table_iter_init (&iter, new_index);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		GVariant *old_cptv = g_hash_table_lookup (old_index, key);
+		g_autofree gchar *old_hash = NULL;
+		g_autofree gchar *new_hash = NULL;
+
+		if (old_cptv == NULL) {
+			as_pool_diff_add_cached (delta->added, value, new_context);
+			continue;
+		}
+
+		old_hash = as_cache_file_get_content_hash (old_cptv);
+		new_hash = as_cache_file_get_content_hash (value);
+		if (g_strcmp0 (old_hash, new_hash) != 0)
+			as_pool_diff_add_cached (delta->changed, value, new_context);
+	}
+
+	g_hash_table_iter_init (&iter, old_index);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		if (!g_hash_table_contains (new_index, key))
+			as_pool_diff_add_cached (delta->removed, value, old_context);
+	}
+
+	as_pool_delta_sort (delta);
+	return delta;
+}
+
+/**
+ * as_pool_delta_ref:
+ * @delta: An #AsPoolDelta.
+ *
+ * Increases the reference count of @delta.
+ *
+ * Returns: (transfer full): @delta
+ *
+ * Since: 0.12.1
+ */
+AsPoolDelta*
+as_pool_delta_ref (AsPoolDelta *delta)
+{
+	g_atomic_int_inc (&delta->ref_count);
+	return delta;
+}
+
+/**
+ * as_pool_delta_unref:
+ * @delta: An #AsPoolDelta.
+ *
+ * Decreases the reference count of @delta, and frees it once it drops to zero.
+ *
+ * Since: 0.12.1
+ */
+void
+as_pool_delta_unref (AsPoolDelta *delta)
+{
+	if (!g_atomic_int_dec_and_test (&delta->ref_count))
+		return;
+	g_ptr_array_unref (delta->added);
+	g_ptr_array_unref (delta->removed);
+	g_ptr_array_unref (delta->changed);
+	g_slice_free (AsPoolDelta, delta);
+}
+
+/**
+ * as_pool_delta_get_added:
+ * @delta: An #AsPoolDelta.
+ *
+ * Get the components which only exist in the new data.
+ *
+ * Returns: (element-type AsComponent) (transfer none): the added components, sorted by data-ID.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_pool_delta_get_added (AsPoolDelta *delta)
+{
+	return delta->added;
+}
+
+/**
+ * as_pool_delta_get_removed:
+ * @delta: An #AsPoolDelta.
+ *
+ * Get the components which only exist in the old data.
+ *
+ * Returns: (element-type AsComponent) (transfer none): the removed components, as they were in the old data, sorted by data-ID.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_pool_delta_get_removed (AsPoolDelta *delta)
+{
+	return delta->removed;
+}
+
+/**
+ * as_pool_delta_get_changed:
+ * @delta: An #AsPoolDelta.
+ *
+ * Get the components which exist in both the old and new data,
+ * but with different content.
+ *
+ * Returns: (element-type AsComponent) (transfer none): the changed components, as they are in the new data, sorted by data-ID.
+ *
+ * Since: 0.12.1
+ */
+GPtrArray*
+as_pool_delta_get_changed (AsPoolDelta *delta)
+{
+	return delta->changed;
 }
 
 /**
@@ -1951,6 +4555,108 @@ as_pool_set_flags (AsPool *pool, AsPoolFlags flags)
 	priv->flags = flags;
 }
 
+/**
+ * as_pool_get_load_profile:
+ * @pool: An instance of #AsPool.
+ *
+ * Get the #AsLoadProfile for this data pool.
+ *
+ * Since: 0.12.1
+ */
+AsLoadProfile
+as_pool_get_load_profile (AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	return priv->load_profile;
+}
+
+/**
+ * as_pool_set_load_profile:
+ * @pool: An instance of #AsPool.
+ * @profile: The new #AsLoadProfile.
+ *
+ * Set which parts of the component data are loaded from metadata files
+ * by as_pool_load(). Components read from an up-to-date cache always
+ * contain all data.
+ *
+ * Since: 0.12.1
+ */
+void
+as_pool_set_load_profile (AsPool *pool, AsLoadProfile profile)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	priv->load_profile = profile;
+}
+
+/**
+ * as_pool_get_memory_budget:
+ * @pool: An instance of #AsPool.
+ *
+ * Returns: the memory budget for evictable component data in bytes,
+ *          or 0 if there is no limit.
+ *
+ * Since: 0.12.1
+ */
+gsize
+as_pool_get_memory_budget (AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	return priv->memory_budget;
+}
+
+/**
+ * as_pool_set_memory_budget:
+ * @pool: An instance of #AsPool.
+ * @budget: Bytes of evictable data to keep in memory, or 0 for no limit.
+ *
+ * Limit how much memory the long descriptions, screenshots and releases
+ * of components loaded from the cache may use. If the pool holds more
+ * of this data, it is dropped for the components which were not accessed
+ * for the longest time, and read back from the cache transparently when
+ * they are used again.
+ * The budget needs to be set before the pool data is loaded. Data is
+ * dropped while loading and whenever this function is called, never
+ * while the pool is queried.
+ *
+ * Data handed out for these fields stays valid as long as the component
+ * it belongs to, so it is never dropped for components which returned
+ * their description, releases or screenshots through the public getters.
+ * Reading these fields of all components keeps them in memory, even
+ * when this exceeds the budget. The memory of data dropped while the pool
+ * is loaded is only given back once the pool contents change, as internal
+ * queries may still use it.
+ *
+ * Since: 0.12.1
+ */
+void
+as_pool_set_memory_budget (AsPool *pool, gsize budget)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	g_mutex_lock (&priv->mutex);
+	priv->memory_budget = budget;
+	as_pool_trim_memory (pool);
+	g_mutex_unlock (&priv->mutex);
+}
+
+/**
+ * as_pool_set_system_cache_dir:
+ * @pool: An instance of #AsPool.
+ * @dir: The directory to read the system cache from.
+ *
+ * Read the system cache from a different location, e.g. for tests.
+ * The locale of the pool should be set already.
+ */
+void
+as_pool_set_system_cache_dir (AsPool *pool, const gchar *dir)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	g_free (priv->sys_cache_path);
+	priv->sys_cache_path = g_strdup (dir);
+	as_pool_check_cache_ctime (pool);
+}
+
 /**
  * as_pool_get_cache_age:
  * @pool: An instance of #AsPool.
@@ -66,6 +66,7 @@ typedef enum {
  * @AS_POOL_FLAG_READ_COLLECTION:	Add AppStream collection metadata to the pool.
  * @AS_POOL_FLAG_READ_METAINFO:		Add data from AppStream metainfo files to the pool.
  * @AS_POOL_FLAG_READ_DESKTOP_FILES:	Add metadata from .desktop files to the pool.
+ * @AS_POOL_FLAG_MONITOR:		Watch the metadata locations after loading, and update the pool when files change.
  *
  * Flags on how caching should be used.
  **/
@@ -74,6 +75,7 @@ typedef enum {
 	AS_POOL_FLAG_READ_COLLECTION    = 1 << 0,
 	AS_POOL_FLAG_READ_METAINFO      = 1 << 1,
 	AS_POOL_FLAG_READ_DESKTOP_FILES = 1 << 2,
+	AS_POOL_FLAG_MONITOR            = 1 << 3,
 } AsPoolFlags;
 
 /**
@@ -94,6 +96,115 @@ typedef enum {
 	AS_POOL_ERROR_LAST
 } AsPoolError;
 
+/**
+ * AsPoolLoadPhase:
+ * @AS_POOL_LOAD_PHASE_UNKNOWN:		Loading has not started yet.
+ * @AS_POOL_LOAD_PHASE_COLLECTION:	Reading AppStream collection metadata.
+ * @AS_POOL_LOAD_PHASE_METAINFO:	Reading metainfo files.
+ * @AS_POOL_LOAD_PHASE_DESKTOP_ENTRIES:	Reading .desktop files.
+ * @AS_POOL_LOAD_PHASE_REFINE:		Validating and completing the loaded components.
+ * @AS_POOL_LOAD_PHASE_DONE:		All data has been loaded.
+ *
+ * The step an asynchronous pool load is in.
+ *
+ * Since: 0.12.1
+ **/
+typedef enum {
+	AS_POOL_LOAD_PHASE_UNKNOWN,
+	AS_POOL_LOAD_PHASE_COLLECTION,
+	AS_POOL_LOAD_PHASE_METAINFO,
+	AS_POOL_LOAD_PHASE_DESKTOP_ENTRIES,
+	AS_POOL_LOAD_PHASE_REFINE,
+	AS_POOL_LOAD_PHASE_DONE,
+	/*< private >*/
+	AS_POOL_LOAD_PHASE_LAST
+} AsPoolLoadPhase;
+
+/**
+ * AsPoolLinkKind:
+ * @AS_POOL_LINK_KIND_UNKNOWN:		Unknown link kind.
+ * @AS_POOL_LINK_KIND_EXTENDS:		The component is an addon extending the other component.
+ * @AS_POOL_LINK_KIND_SUGGESTS:		The component suggests the other component.
+ * @AS_POOL_LINK_KIND_REQUIRES:		The component requires the other component.
+ * @AS_POOL_LINK_KIND_RECOMMENDS:	The component recommends the other component.
+ *
+ * The kind of a relation between two components in the pool.
+ *
+ * Since: 0.12.1
+ **/
+typedef enum {
+	AS_POOL_LINK_KIND_UNKNOWN,
+	AS_POOL_LINK_KIND_EXTENDS,
+	AS_POOL_LINK_KIND_SUGGESTS,
+	AS_POOL_LINK_KIND_REQUIRES,
+	AS_POOL_LINK_KIND_RECOMMENDS,
+	/*< private >*/
+	AS_POOL_LINK_KIND_LAST
+} AsPoolLinkKind;
+
+/**
+ * AsPoolProgressCallback:
+ * @phase: The current #AsPoolLoadPhase.
+ * @files_scanned: The number of metadata files read so far.
+ * @components_parsed: The number of components loaded so far.
+ * @user_data: User data passed to as_pool_load_async().
+ *
+ * Reports the progress of as_pool_load_async().
+ *
+ * Since: 0.12.1
+ **/
+typedef void (*AsPoolProgressCallback) (AsPoolLoadPhase phase,
+					guint files_scanned,
+					guint components_parsed,
+					gpointer user_data);
+
+/**
+ * AsPoolForeachFunc:
+ * @cpt: (transfer none): A component of the pool.
+ * @user_data: User data passed to as_pool_foreach().
+ *
+ * Called for every component visited by as_pool_foreach().
+ *
+ * Returns: %TRUE to continue, %FALSE to stop the iteration.
+ *
+ * Since: 0.12.1
+ **/
+typedef gboolean (*AsPoolForeachFunc) (AsComponent *cpt,
+				       gpointer user_data);
+
+/**
+ * AsPoolFilterFunc:
+ * @cpt: (transfer none): A component of the pool.
+ * @user_data: User data passed to as_pool_get_view().
+ *
+ * Selects the components which are part of an #AsPoolView.
+ *
+ * Returns: %TRUE if @cpt should be part of the view.
+ *
+ * Since: 0.12.1
+ **/
+typedef gboolean (*AsPoolFilterFunc) (AsComponent *cpt,
+				      gpointer user_data);
+
+/**
+ * AsPoolView:
+ *
+ * A read-only list of components of an #AsPool, as they were when the
+ * view was created. The view does not own references to the individual
+ * components, they stay valid for as long as the view exists.
+ *
+ * Since: 0.12.1
+ **/
+typedef struct _AsPoolView AsPoolView;
+
+#define AS_TYPE_POOL_VIEW (as_pool_view_get_type ())
+GType			as_pool_view_get_type (void);
+
+typedef struct _AsPoolDelta AsPoolDelta;
+
+#define AS_TYPE_POOL_DELTA (as_pool_delta_get_type ())
+GType			as_pool_delta_get_type (void);
+
 #define AS_POOL_ERROR	as_pool_error_quark ()
 GQuark			as_pool_error_quark (void);
 
@@ -106,6 +217,16 @@ void			as_pool_set_locale (AsPool *pool,
 gboolean		as_pool_load (AsPool *pool,
 					GCancellable *cancellable,
 					GError **error);
+void			as_pool_load_async (AsPool *pool,
+					    AsPoolProgressCallback progress_callback,
+					    gpointer progress_data,
+					    GDestroyNotify progress_data_free,
+					    GCancellable *cancellable,
+					    GAsyncReadyCallback callback,
+					    gpointer user_data);
+gboolean		as_pool_load_finish (AsPool *pool,
+					     GAsyncResult *result,
+					     GError **error);
 
 gboolean		as_pool_load_cache_file (AsPool *pool,
 						 const gchar *fname,
@@ -135,6 +256,30 @@ GPtrArray		*as_pool_get_components_by_launchable (AsPool *pool,
 GPtrArray		*as_pool_search (AsPool *pool,
 					 const gchar *search);
 
+GPtrArray		*as_pool_get_linked (AsPool *pool,
+					     const gchar *cid,
+					     AsPoolLinkKind kind);
+GPtrArray		*as_pool_get_linked_by (AsPool *pool,
+						const gchar *cid,
+						AsPoolLinkKind kind);
+
+GHashTable		*as_pool_map_pkgnames (AsPool *pool,
+						gchar **pkgnames,
+						GPtrArray **installed);
+
+void			as_pool_foreach (AsPool *pool,
+					 AsPoolForeachFunc func,
+					 gpointer user_data);
+AsPoolView		*as_pool_get_view (AsPool *pool,
+					   AsPoolFilterFunc filter,
+					   gpointer user_data);
+
+AsPoolView		*as_pool_view_ref (AsPoolView *view);
+void			as_pool_view_unref (AsPoolView *view);
+guint			as_pool_view_get_size (AsPoolView *view);
+AsComponent		*as_pool_view_index (AsPoolView *view,
+					     guint idx);
+
 void			as_pool_clear_metadata_locations (AsPool *pool);
 void			as_pool_add_metadata_location (AsPool *pool,
 						       const gchar *directory);
@@ -147,10 +292,33 @@ AsPoolFlags		as_pool_get_flags (AsPool *pool);
 void			as_pool_set_flags (AsPool *pool,
 						AsPoolFlags flags);
 
+AsLoadProfile		as_pool_get_load_profile (AsPool *pool);
+void			as_pool_set_load_profile (AsPool *pool,
+						  AsLoadProfile profile);
+
+gsize			as_pool_get_memory_budget (AsPool *pool);
+void			as_pool_set_memory_budget (AsPool *pool,
+						   gsize budget);
+
 gboolean		as_pool_refresh_cache (AsPool *pool,
 						gboolean force,
 						GError **error);
 
+AsPoolDelta		*as_pool_diff (AsPool *old_pool,
+				       AsPool *new_pool);
+AsPoolDelta		*as_pool_diff_cache_files (const gchar *old_fname,
+						   const gchar *new_fname,
+						   GError **error);
+
+AsPoolDelta		*as_pool_delta_ref (AsPoolDelta *delta);
+void			as_pool_delta_unref (AsPoolDelta *delta);
+GPtrArray		*as_pool_delta_get_added (AsPoolDelta *delta);
+GPtrArray		*as_pool_delta_get_removed (AsPoolDelta *delta);
+GPtrArray		*as_pool_delta_get_changed (AsPoolDelta *delta);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AsPoolView, as_pool_view_unref)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AsPoolDelta, as_pool_delta_unref)
+
 G_END_DECLS
 
 #endif /* __AS_POOL_H */
@@ -32,6 +32,8 @@ AsContext		*as_release_get_context (AsRelease *release);
 void			as_release_set_context (AsRelease *release,
 						AsContext *context);
 
+void			as_release_pack_description (AsRelease *release);
+
 gboolean		as_release_load_from_xml (AsRelease *release,
 						  AsContext *ctx,
 						  xmlNode *node,
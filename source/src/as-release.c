@@ -40,16 +40,20 @@
 #include "as-utils-private.h"
 #include "as-checksum-private.h"
 #include "as-variant-cache.h"
+#include "as-packed-text.h"
+#include "as-locale.h"
 
 typedef struct
 {
 	AsReleaseKind	kind;
 	gchar		*version;
-	GHashTable	*description;
+	GHashTable	*description; /* values may be packed */
+	GHashTable	*description_cache; /* unpacked descriptions that were read */
 	guint64		timestamp;
 
 	AsContext	*context;
 	gchar		*active_locale_override;
+	const AsLocaleChain *locale_chain; /* fallbacks for @active_locale_override */
 
 	GPtrArray	*locations;
 	GPtrArray	*checksums;
@@ -175,6 +179,7 @@ as_release_finalize (GObject *object)
 	g_free (priv->version);
 	g_free (priv->active_locale_override);
 	g_hash_table_unref (priv->description);
+	g_clear_pointer (&priv->description_cache, g_hash_table_unref);
 	g_ptr_array_unref (priv->locations);
 	g_ptr_array_unref (priv->checksums);
 	if (priv->context != NULL)
@@ -374,6 +379,38 @@ as_release_set_size (AsRelease *release, guint64 size, AsSizeKind kind)
 	priv->size[kind] = size;
 }
 
+/**
+ * as_release_get_locale_chain:
+ *
+ * Get the fallback chain of the current active locale.
+ */
+static const AsLocaleChain*
+as_release_get_locale_chain (AsRelease *release)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+	const AsLocaleChain *chain;
+
+	/* use the context locale, if the locale isn't explicitly overridden for this release */
+	if ((priv->context != NULL) && (priv->active_locale_override == NULL))
+		chain = as_context_get_locale_chain (priv->context);
+	else
+		chain = priv->locale_chain;
+
+	return (chain != NULL)? chain : as_locale_chain_get (NULL);
+}
+
+/**
+ * as_release_lookup_description:
+ *
+ * Find the description for the active locale, which may be packed.
+ */
+static const gchar*
+as_release_lookup_description (AsRelease *release)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+	return as_locale_chain_lookup (as_release_get_locale_chain (release), priv->description, TRUE);
+}
+
 /**
  * as_release_get_description:
  * @release: a #AsRelease instance.
@@ -385,16 +422,9 @@ as_release_set_size (AsRelease *release, guint64 size, AsSizeKind kind)
 const gchar*
 as_release_get_description (AsRelease *release)
 {
-	const gchar *desc;
 	AsReleasePrivate *priv = GET_PRIVATE (release);
-
-	desc = g_hash_table_lookup (priv->description, as_release_get_active_locale (release));
-	if (desc == NULL) {
-		/* fall back to untranslated / default */
-		desc = g_hash_table_lookup (priv->description, "C");
-	}
-
-	return desc;
+	return as_packed_text_get (&priv->description_cache,
+				   as_release_lookup_description (release));
 }
 
 /**
@@ -415,6 +445,21 @@ as_release_set_description (AsRelease *release, const gchar *description, const
 	g_hash_table_insert (priv->description,
 				g_strdup (locale),
 				g_strdup (description));
+	g_clear_pointer (&priv->description_cache, g_hash_table_unref);
+}
+
+/**
+ * as_release_pack_description:
+ * @release: a #AsRelease instance.
+ *
+ * Store the description markup compressed, until it is read again.
+ **/
+void
+as_release_pack_description (AsRelease *release)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+
+	as_packed_text_pack_table (priv->description);
 }
 
 /**
@@ -458,6 +503,7 @@ as_release_set_active_locale (AsRelease *release, const gchar *locale)
 
 	g_free (priv->active_locale_override);
 	priv->active_locale_override = g_strdup (locale);
+	priv->locale_chain = as_locale_chain_get (locale);
 }
 
 /**
@@ -583,6 +629,7 @@ as_release_set_context (AsRelease *release, AsContext *context)
 	/* reset individual properties, so the new context overrides them */
 	g_free (priv->active_locale_override);
 	priv->active_locale_override = NULL;
+	priv->locale_chain = NULL;
 }
 
 /**
@@ -681,7 +728,7 @@ as_release_load_from_xml (AsRelease *release, AsContext *ctx, xmlNode *node, GEr
 			g_free (prop);
 		} else if (g_strcmp0 ((gchar*) iter->name, "description") == 0) {
 			if (as_context_get_style (ctx) == AS_FORMAT_STYLE_COLLECTION) {
-				g_autofree gchar *lang;
+				const gchar *lang;
 
 				/* for collection XML, the "description" tag has a language property, so parsing it is simple */
 				content = as_xml_dump_node_children (iter);
@@ -713,6 +760,7 @@ as_release_to_xml_node (AsRelease *release, AsContext *ctx, xmlNode *root)
 {
 	AsReleasePrivate *priv = GET_PRIVATE (release);
 	xmlNode *subnode;
+	g_autoptr(GHashTable) desc = NULL;
 	guint j;
 
 	/* set release version */
@@ -777,7 +825,8 @@ as_release_to_xml_node (AsRelease *release, AsContext *ctx, xmlNode *root)
 	}
 
 	/* add description */
-	as_xml_add_description_node (ctx, subnode, priv->description);
+	desc = as_packed_text_unpack_table (priv->description);
+	as_xml_add_description_node (ctx, subnode, desc);
 }
 
 /**
@@ -841,6 +890,7 @@ void
 as_release_emit_yaml (AsRelease *release, AsContext *ctx, yaml_emitter_t *emitter)
 {
 	AsReleasePrivate *priv = GET_PRIVATE (release);
+	g_autoptr(GHashTable) desc = NULL;
 	guint j;
 
 	/* start mapping for this release */
@@ -877,9 +927,10 @@ as_release_emit_yaml (AsRelease *release, AsContext *ctx, yaml_emitter_t *emitte
 	}
 
 	/* description */
+	desc = as_packed_text_unpack_table (priv->description);
 	as_yaml_emit_long_localized_entry (emitter,
 					   "description",
-					   priv->description);
+					   desc);
 
 	/* location URLs */
 	if (priv->locations->len > 0) {
@@ -913,6 +964,7 @@ as_release_to_variant (AsRelease *release, GVariantBuilder *builder)
 {
 	AsReleasePrivate *priv = GET_PRIVATE (release);
 	guint j;
+	g_autofree gchar *desc = NULL;
 	GVariantBuilder checksum_b;
 	GVariantBuilder sizes_b;
 	GVariantBuilder rel_b;
@@ -945,7 +997,9 @@ as_release_to_variant (AsRelease *release, GVariantBuilder *builder)
 	g_variant_builder_add_parsed (&rel_b, "{'version', %v}", as_variant_mstring_new (priv->version));
 	g_variant_builder_add_parsed (&rel_b, "{'timestamp', <%t>}", priv->timestamp);
 	g_variant_builder_add_parsed (&rel_b, "{'urgency', <%u>}", priv->urgency);
-	g_variant_builder_add_parsed (&rel_b, "{'description', %v}", as_variant_mstring_new (as_release_get_description (release)));
+	/* don't keep the description unpacked, we only need it once */
+	desc = as_packed_text_unpack (as_release_lookup_description (release));
+	g_variant_builder_add_parsed (&rel_b, "{'description', %v}", as_variant_mstring_new (desc));
 
 	locations_var = as_variant_from_string_ptrarray (priv->locations);
 	if (locations_var)
@@ -36,6 +36,7 @@
 #include "as-utils-private.h"
 #include "as-image-private.h"
 #include "as-variant-cache.h"
+#include "as-locale.h"
 
 typedef struct
 {
@@ -46,6 +47,7 @@ typedef struct
 
 	AsContext *context;
 	gchar *active_locale_override;
+	const AsLocaleChain *locale_chain; /* fallbacks for @active_locale_override */
 } AsScreenshotPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsScreenshot, as_screenshot, G_TYPE_OBJECT)
@@ -179,6 +181,26 @@ as_screenshot_get_images (AsScreenshot *screenshot)
 	return priv->images_lang;
 }
 
+/**
+ * as_screenshot_get_locale_chain:
+ *
+ * Get the fallback chain of the current active locale.
+ */
+static const AsLocaleChain*
+as_screenshot_get_locale_chain (AsScreenshot *screenshot)
+{
+	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
+	const AsLocaleChain *chain;
+
+	/* use the context locale, if the locale isn't explicitly overridden for this screenshot */
+	if ((priv->context != NULL) && (priv->active_locale_override == NULL))
+		chain = as_context_get_locale_chain (priv->context);
+	else
+		chain = priv->locale_chain;
+
+	return (chain != NULL)? chain : as_locale_chain_get (NULL);
+}
+
 /**
  * as_screenshot_add_image:
  * @screenshot: a #AsScreenshot instance.
@@ -192,7 +214,7 @@ as_screenshot_add_image (AsScreenshot *screenshot, AsImage *image)
 	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
 	g_ptr_array_add (priv->images, g_object_ref (image));
 
-	if (as_utils_locale_is_compatible (as_image_get_locale (image), as_screenshot_get_active_locale (screenshot)))
+	if (as_locale_chain_accepts (as_screenshot_get_locale_chain (screenshot), as_image_get_locale (image)))
 		g_ptr_array_add (priv->images_lang, g_object_ref (image));
 }
 
@@ -207,17 +229,8 @@ as_screenshot_add_image (AsScreenshot *screenshot, AsImage *image)
 const gchar*
 as_screenshot_get_caption (AsScreenshot *screenshot)
 {
-	const gchar *caption;
 	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
-
-	caption = g_hash_table_lookup (priv->caption,
-					as_screenshot_get_active_locale (screenshot));
-	if (caption == NULL) {
-		/* fall back to untranslated / default */
-		caption = g_hash_table_lookup (priv->caption, "C");
-	}
-
-	return caption;
+	return as_locale_chain_lookup (as_screenshot_get_locale_chain (screenshot), priv->caption, TRUE);
 }
 
 /**
@@ -265,6 +278,7 @@ static void
 as_screenshot_rebuild_suitable_images_list (AsScreenshot *screenshot)
 {
 	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
+	const AsLocaleChain *chain = as_screenshot_get_locale_chain (screenshot);
 	guint i;
 
 	/* rebuild our list of images suitable for the current locale */
@@ -272,7 +286,7 @@ as_screenshot_rebuild_suitable_images_list (AsScreenshot *screenshot)
 	priv->images_lang = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	for (i = 0; i < priv->images->len; i++) {
 		AsImage *img = AS_IMAGE (g_ptr_array_index (priv->images, i));
-		if (!as_utils_locale_is_compatible (as_image_get_locale (img), as_screenshot_get_active_locale (screenshot)))
+		if (!as_locale_chain_accepts (chain, as_image_get_locale (img)))
 			continue;
 		g_ptr_array_add (priv->images_lang, g_object_ref (img));
 	}
@@ -319,6 +333,7 @@ as_screenshot_set_active_locale (AsScreenshot *screenshot, const gchar *locale)
 
 	g_free (priv->active_locale_override);
 	priv->active_locale_override = g_strdup (locale);
+	priv->locale_chain = as_locale_chain_get (locale);
 
 	/* rebuild our list of images suitable for the current locale */
 	as_screenshot_rebuild_suitable_images_list (screenshot);
@@ -379,6 +394,7 @@ as_screenshot_set_context (AsScreenshot *screenshot, AsContext *context)
 	/* reset individual properties, so the new context overrides them */
 	g_free (priv->active_locale_override);
 	priv->active_locale_override = NULL;
+	priv->locale_chain = NULL;
 
 	as_screenshot_rebuild_suitable_images_list (screenshot);
 }
@@ -420,7 +436,7 @@ as_screenshot_load_from_xml (AsScreenshot *screenshot, AsContext *ctx, xmlNode *
 				as_screenshot_add_image (screenshot, image);
 		} else if (g_strcmp0 (node_name, "caption") == 0) {
 			g_autofree gchar *content = NULL;
-			g_autofree gchar *lang = NULL;
+			const gchar *lang;
 
 			content = as_xml_get_node_value (iter);
 			if (content == NULL)
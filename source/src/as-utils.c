@@ -42,6 +42,8 @@
 #include "as-category.h"
 #include "as-component.h"
 #include "as-component-private.h"
+#include "as-dir-scanner.h"
+#include "as-intern.h"
 
 /**
  * SECTION:as-utils
@@ -67,6 +69,25 @@ as_get_appstream_version (void)
 	return PACKAGE_VERSION;
 }
 
+/**
+ * as_utils_get_string_stats:
+ * @n_strings: (out) (optional): The number of distinct shared strings.
+ * @saved_bytes: (out) (optional): The memory which is saved by sharing them.
+ *
+ * Report how much memory is saved by sharing repeated strings, like IDs,
+ * locale names, categories, licenses, origins and architectures, between
+ * components and the pool tables.
+ * Strings are shared by all pools and parsers of the process, so the numbers
+ * are process-wide and cover the data of all of them.
+ *
+ * Since: 0.12.1
+ */
+void
+as_utils_get_string_stats (guint *n_strings, gsize *saved_bytes)
+{
+	as_intern_get_stats (n_strings, saved_bytes);
+}
+
 /**
  * as_description_markup_convert_simple:
  * @markup: the text to copy.
@@ -276,70 +297,32 @@ out:
 GPtrArray*
 as_utils_find_files_matching (const gchar* dir, const gchar* pattern, gboolean recursive, GError **error)
 {
-	GPtrArray* list;
-	GFileInfo *file_info;
-	GFileEnumerator *enumerator = NULL;
-	GFile *fdir;
+	GPtrArray *list;
+	g_autoptr(GPtrArray) sfiles = NULL;
+	AsDirScanFlags flags = AS_DIR_SCAN_FLAG_NONE;
 	GError *tmp_error = NULL;
+	guint i;
 	g_return_val_if_fail (dir != NULL, NULL);
 	g_return_val_if_fail (pattern != NULL, NULL);
 
-	list = g_ptr_array_new_with_free_func (g_free);
-	fdir =  g_file_new_for_path (dir);
-	enumerator = g_file_enumerate_children (fdir, G_FILE_ATTRIBUTE_STANDARD_NAME, 0, NULL, &tmp_error);
-	if (tmp_error != NULL)
-		goto out;
-
-	while ((file_info = g_file_enumerator_next_file (enumerator, NULL, &tmp_error)) != NULL) {
-		gchar *path;
-
-		if (tmp_error != NULL)
-			goto out;
-		if (g_file_info_get_is_hidden (file_info))
-			continue;
+	if (recursive)
+		flags = AS_DIR_SCAN_FLAG_RECURSIVE | AS_DIR_SCAN_FLAG_PARALLEL;
 
-		path = g_build_filename (dir,
-					 g_file_info_get_name (file_info),
-					 NULL);
-
-		if ((!g_file_test (path, G_FILE_TEST_IS_REGULAR)) && (recursive)) {
-			GPtrArray *subdir_list;
-			guint i;
-			subdir_list = as_utils_find_files_matching (path, pattern, recursive, &tmp_error);
-			/* if there was an error, exit */
-			if (subdir_list == NULL) {
-				g_ptr_array_unref (list);
-				list = NULL;
-				g_free (path);
-				goto out;
-			}
-			for (i=0; i<subdir_list->len; i++)
-				g_ptr_array_add (list,
-						 g_strdup ((gchar *) g_ptr_array_index (subdir_list, i)));
-			g_ptr_array_unref (subdir_list);
+	sfiles = as_dir_scanner_scan (dir, pattern, flags, &tmp_error);
+	if (sfiles == NULL) {
+		if (error == NULL) {
+			g_debug ("Error while searching for files in %s: %s", dir, tmp_error->message);
+			g_error_free (tmp_error);
 		} else {
-			if (!as_str_empty (pattern)) {
-				if (!g_pattern_match_simple (pattern, g_file_info_get_name (file_info))) {
-					g_free (path);
-					continue;
-				}
-			}
-			g_ptr_array_add (list, path);
+			g_propagate_error (error, tmp_error);
 		}
+		return NULL;
 	}
 
-
-out:
-	g_object_unref (fdir);
-	if (enumerator != NULL)
-		g_object_unref (enumerator);
-	if (tmp_error != NULL) {
-		if (error == NULL)
-			g_debug ("Error while searching for files in %s: %s", dir, tmp_error->message);
-		else
-			g_propagate_error (error, tmp_error);
-		g_ptr_array_unref (list);
-		return NULL;
+	list = g_ptr_array_new_full (sfiles->len, g_free);
+	for (i = 0; i < sfiles->len; i++) {
+		AsScannedFile *sfile = (AsScannedFile*) g_ptr_array_index (sfiles, i);
+		g_ptr_array_add (list, g_steal_pointer (&sfile->path));
 	}
 
 	return list;
@@ -1156,15 +1139,13 @@ as_utils_data_id_get_cid (const gchar *data_id)
 AsBundleKind
 as_utils_get_component_bundle_kind (AsComponent *cpt)
 {
-	GPtrArray *bundles;
 	AsBundleKind bundle_kind;
 
 	/* determine bundle - what should we do if there are multiple bundles of different types
 	 * defined for one component? */
 	bundle_kind = AS_BUNDLE_KIND_PACKAGE;
-	bundles = as_component_get_bundles (cpt);
-	if (bundles->len > 0)
-		bundle_kind = as_bundle_get_kind (AS_BUNDLE (g_ptr_array_index (bundles, 0)));
+	if (as_component_has_bundle (cpt))
+		bundle_kind = as_component_get_first_bundle_kind (cpt);
 
 	return bundle_kind;
 }
@@ -43,6 +43,9 @@ gint		as_utils_compare_versions (const gchar* a,
 
 const gchar	*as_get_appstream_version (void);
 
+void		as_utils_get_string_stats (guint *n_strings,
+					   gsize *saved_bytes);
+
 G_END_DECLS
 
 #endif /* __AS_UTILS_H */
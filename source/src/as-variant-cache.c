@@ -215,3 +215,67 @@ as_variant_builder_add_kv (GVariantBuilder *builder, const gchar *key, GVariant
 		return;
 	g_variant_builder_add (builder, "{sv}", key, value);
 }
+
+/**
+ * as_variant_cmp_dict_entries:
+ *
+ * Sort dictionary entries by their key.
+ */
+static gint
+as_variant_cmp_dict_entries (gconstpointer a, gconstpointer b)
+{
+	g_autoptr(GVariant) key1 = g_variant_get_child_value (*((GVariant**) a), 0);
+	g_autoptr(GVariant) key2 = g_variant_get_child_value (*((GVariant**) b), 0);
+
+	return g_variant_compare (key1, key2);
+}
+
+/**
+ * as_variant_normalize:
+ * @value: a #GVariant.
+ *
+ * Get a copy of @value with the entries of all dictionaries sorted by key,
+ * so equal data has the same serialization no matter in which order it was added.
+ *
+ * Returns: (transfer full): the normalized value.
+ */
+GVariant*
+as_variant_normalize (GVariant *value)
+{
+	const GVariantType *type;
+	GVariantIter iter;
+	GVariant *child;
+	GVariant *res;
+	g_autoptr(GPtrArray) children = NULL;
+
+	if (!g_variant_is_container (value))
+		return g_variant_ref (value);
+
+	children = g_ptr_array_new_with_free_func ((GDestroyNotify) g_variant_unref);
+	g_variant_iter_init (&iter, value);
+	while ((child = g_variant_iter_next_value (&iter))) {
+		g_ptr_array_add (children, as_variant_normalize (child));
+		g_variant_unref (child);
+	}
+
+	type = g_variant_get_type (value);
+	if (g_variant_type_is_variant (type)) {
+		res = g_variant_new_variant (g_ptr_array_index (children, 0));
+	} else if (g_variant_type_is_maybe (type)) {
+		res = g_variant_new_maybe (g_variant_type_element (type),
+					   (children->len > 0)? g_ptr_array_index (children, 0) : NULL);
+	} else if (g_variant_type_is_array (type)) {
+		if (g_variant_type_is_dict_entry (g_variant_type_element (type)))
+			g_ptr_array_sort (children, as_variant_cmp_dict_entries);
+		res = g_variant_new_array (g_variant_type_element (type),
+					   (GVariant**) children->pdata,
+					   children->len);
+	} else if (g_variant_type_is_dict_entry (type)) {
+		res = g_variant_new_dict_entry (g_ptr_array_index (children, 0),
+						g_ptr_array_index (children, 1));
+	} else {
+		res = g_variant_new_tuple ((GVariant**) children->pdata, children->len);
+	}
+
+	return g_variant_ref_sink (res);
+}
@@ -63,6 +63,8 @@ void			as_variant_builder_add_kv (GVariantBuilder *builder,
 						   const gchar *key,
 						   GVariant *value);
 
+GVariant		*as_variant_normalize (GVariant *value);
+
 #pragma GCC visibility pop
 G_END_DECLS
 
@@ -23,6 +23,7 @@
 #include <string.h>
 #include "as-utils.h"
 #include "as-utils-private.h"
+#include "as-context-private.h"
 
 /**
  * SECTION:as-xml
@@ -50,36 +51,37 @@ as_xml_get_node_value (xmlNode *node)
  *
  * Returns: The locale of a node, if the node should be considered for inclusion.
  * %NULL if the node should be ignored due to a not-matching locale.
+ * The returned string is interned in @ctx and must not be freed.
  */
-gchar*
+const gchar*
 as_xmldata_get_node_locale (AsContext *ctx, xmlNode *node)
 {
-	gchar *lang;
+	g_autofree gchar *lang = NULL;
+	const AsLocaleChain *chain;
 
 	lang = (gchar*) xmlGetProp (node, (xmlChar*) "lang");
 
-	if (lang == NULL) {
-		lang = g_strdup ("C");
-		goto out;
-	}
+	if (lang == NULL)
+		return as_context_intern (ctx, "C");
 
 	if (as_context_get_all_locale_enabled (ctx)) {
 		/* we should read all languages */
-		goto out;
+		return as_context_intern (ctx, lang);
 	}
 
-	if (as_utils_locale_is_compatible (as_context_get_locale (ctx), lang)) {
-		goto out;
+	chain = as_context_get_locale_chain (ctx);
+	if (chain == NULL) {
+		/* no locale was set, so we read the languages of this process */
+		if (as_utils_locale_is_compatible (NULL, lang))
+			return as_context_intern (ctx, lang);
+	} else if (as_locale_chain_accepts (chain, lang)) {
+		return as_context_intern (ctx, lang);
 	}
 
 	/* If we are here, we haven't found a matching locale.
 	 * In that case, we return %NULL to indicate that this element should not be added.
 	 */
-	g_free (lang);
-	lang = NULL;
-
-out:
-	return lang;
+	return NULL;
 }
 
 /**
@@ -171,7 +173,8 @@ as_xml_parse_metainfo_description_node (AsContext *ctx, xmlNode *node, GHFunc fu
 	gchar *node_name;
 	g_autoptr(GHashTable) desc = NULL;
 
-	desc = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	/* keys are interned in the context */
+	desc = g_hash_table_new (g_str_hash, g_str_equal);
 	for (iter = node->children; iter != NULL; iter = iter->next) {
 		GString *str;
 
@@ -181,7 +184,7 @@ as_xml_parse_metainfo_description_node (AsContext *ctx, xmlNode *node, GHFunc fu
 
 		node_name = (gchar*) iter->name;
 		if (g_strcmp0 (node_name, "p") == 0) {
-			g_autofree gchar *lang = NULL;
+			const gchar *lang;
 			g_autofree gchar *content = NULL;
 			g_autofree gchar *tmp = NULL;
 
@@ -193,7 +196,7 @@ as_xml_parse_metainfo_description_node (AsContext *ctx, xmlNode *node, GHFunc fu
 			str = g_hash_table_lookup (desc, lang);
 			if (str == NULL) {
 				str = g_string_new ("");
-				g_hash_table_insert (desc, g_strdup (lang), str);
+				g_hash_table_insert (desc, (gpointer) lang, str);
 			}
 
 			tmp = as_xml_get_node_value (iter);
@@ -213,7 +216,7 @@ as_xml_parse_metainfo_description_node (AsContext *ctx, xmlNode *node, GHFunc fu
 			}
 
 			for (iter2 = iter->children; iter2 != NULL; iter2 = iter2->next) {
-				g_autofree gchar *lang = NULL;
+				const gchar *lang;
 				g_autofree gchar *content = NULL;
 				g_autofree gchar *tmp = NULL;
 
@@ -231,7 +234,7 @@ as_xml_parse_metainfo_description_node (AsContext *ctx, xmlNode *node, GHFunc fu
 				if (str == NULL) {
 					str = g_string_new ("");
 					g_string_append_printf (str, "<%s>\n", node_name);
-					g_hash_table_insert (desc, g_strdup (lang), str);
+					g_hash_table_insert (desc, (gpointer) lang, str);
 				}
 
 				tmp = as_xml_get_node_value (iter2);
@@ -534,22 +537,19 @@ as_xml_set_out_of_context_error (gchar **error_msg_str)
 }
 
 /**
- * as_xmldata_parse_document:
+ * as_xml_parse_memory:
+ *
+ * Parse an XML document of @len bytes, which is completely in memory.
  */
-xmlDoc*
-as_xml_parse_document (const gchar *data, GError **error)
+static xmlDoc*
+as_xml_parse_memory (const gchar *data, gsize len, GError **error)
 {
 	xmlDoc *doc;
 	xmlNode *root;
 	g_autofree gchar *error_msg_str = NULL;
 
-	if (data == NULL) {
-		/* empty document means no components */
-		return NULL;
-	}
-
 	as_xml_set_out_of_context_error (&error_msg_str);
-	doc = xmlReadMemory (data, strlen (data),
+	doc = xmlReadMemory (data, len,
 			     NULL,
 			     "utf-8",
 			     XML_PARSE_NOBLANKS | XML_PARSE_NONET);
@@ -583,6 +583,93 @@ as_xml_parse_document (const gchar *data, GError **error)
 	return doc;
 }
 
+/**
+ * as_xmldata_parse_document:
+ */
+xmlDoc*
+as_xml_parse_document (const gchar *data, GError **error)
+{
+	if (data == NULL) {
+		/* empty document means no components */
+		return NULL;
+	}
+
+	return as_xml_parse_memory (data, strlen (data), error);
+}
+
+/**
+ * as_xml_parse_document_reader:
+ *
+ * Parse an XML document incrementally, while the reader is still
+ * busy reading and decompressing the remaining data.
+ */
+xmlDoc*
+as_xml_parse_document_reader (AsFileReader *reader, GError **error)
+{
+	xmlParserCtxt *ctxt;
+	xmlDoc *doc;
+	xmlNode *root;
+	const gchar *data;
+	gsize len;
+	GError *tmp_error = NULL;
+
+	/* parse the data in place if the file was read into memory as a whole */
+	if (as_file_reader_get_contents (reader, &data, &len))
+		return as_xml_parse_memory (data, len, error);
+
+	ctxt = xmlCreatePushParserCtxt (NULL, NULL, NULL, 0, as_file_reader_get_basename (reader));
+	xmlCtxtUseOptions (ctxt, XML_PARSE_NOBLANKS | XML_PARSE_NONET | XML_PARSE_NOERROR | XML_PARSE_NOWARNING);
+
+	while (as_file_reader_next (reader, &data, &len, &tmp_error)) {
+		if (xmlParseChunk (ctxt, data, len, 0) != 0)
+			break;
+	}
+	if (tmp_error != NULL) {
+		g_propagate_error (error, tmp_error);
+		if (ctxt->myDoc != NULL)
+			xmlFreeDoc (ctxt->myDoc);
+		xmlFreeParserCtxt (ctxt);
+		return NULL;
+	}
+
+	/* terminate the document */
+	xmlParseChunk (ctxt, NULL, 0, 1);
+
+	doc = ctxt->myDoc;
+	if (!ctxt->wellFormed) {
+		xmlErrorPtr xerr = xmlCtxtGetLastError (ctxt);
+		if ((xerr == NULL) || (xerr->message == NULL)) {
+			g_set_error (error,
+					AS_METADATA_ERROR,
+					AS_METADATA_ERROR_FAILED,
+					"Could not parse XML data.");
+		} else {
+			g_set_error (error,
+					AS_METADATA_ERROR,
+					AS_METADATA_ERROR_FAILED,
+					"Could not parse XML data: %s", xerr->message);
+		}
+		if (doc != NULL)
+			xmlFreeDoc (doc);
+		xmlFreeParserCtxt (ctxt);
+		return NULL;
+	}
+	xmlFreeParserCtxt (ctxt);
+
+	root = (doc == NULL)? NULL : xmlDocGetRootElement (doc);
+	if (root == NULL) {
+		g_set_error_literal (error,
+				     AS_METADATA_ERROR,
+				     AS_METADATA_ERROR_FAILED,
+				     "The XML document is empty.");
+		if (doc != NULL)
+			xmlFreeDoc (doc);
+		return NULL;
+	}
+
+	return doc;
+}
+
 /**
  * as_xml_node_to_str:
  *
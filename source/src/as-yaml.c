@@ -405,32 +405,26 @@ as_yaml_get_localized_node (AsContext *ctx, GNode *node, gchar *locale_override)
 {
 	GNode *n;
 	GNode *tnode = NULL;
-	const gchar *locale;
+	const AsLocaleChain *chain = NULL;
+	gint best_rank = -1;
 
 	if (locale_override == NULL)
-		locale = as_context_get_locale (ctx);
-	else
-		locale = locale_override;
+		chain = as_context_get_locale_chain (ctx);
+	if (chain == NULL)
+		chain = as_locale_chain_get (locale_override);
 
+	/* find the value for the most specific locale in the fallback chain */
 	for (n = node->children; n != NULL; n = n->next) {
-		const gchar *key = as_yaml_node_get_key (n);
-
-		if ((tnode == NULL) && (g_strcmp0 (key, "C") == 0)) {
-			tnode = n;
-			if (g_strcmp0 (locale, "C") == 0)
-				goto out;
-		}
+		gint rank = as_locale_chain_rank (chain, as_yaml_node_get_key (n));
 
-		if (g_strcmp0 (locale, key) == 0) {
-			tnode = n;
-			goto out;
-		}
-
-		if (as_utils_locale_is_compatible (locale, key))
-			tnode = n;
+		if ((rank < 0) || ((tnode != NULL) && (rank >= best_rank)))
+			continue;
+		tnode = n;
+		best_rank = rank;
+		if (rank == 0)
+			break;
 	}
 
-out:
 	return tnode;
 }
 
@@ -19,8 +19,14 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include "appstream.h"
 #include "as-component-private.h"
+#include "as-file-reader.h"
+#include "as-dir-scanner.h"
+#include "as-desktop-entry.h"
+#include "as-packed-text.h"
+#include "as-locale.h"
 
 #include "as-test-utils.h"
 
@@ -157,6 +163,270 @@ test_translation_fallback (void)
 	g_assert_nonnull (as_component_get_description (cpt));
 }
 
+/**
+ * test_component_lazy_containers:
+ *
+ * Test that lists are only created on demand, and that adding data
+ * still works as expected.
+ */
+static void
+test_component_lazy_containers (void)
+{
+	g_autoptr(AsComponent) cpt1 = NULL;
+	g_autoptr(AsComponent) cpt2 = NULL;
+	g_autoptr(AsRelease) rel = NULL;
+
+	cpt1 = as_component_new ();
+	cpt2 = as_component_new ();
+
+	/* nothing was added yet, but every component still hands out its own lists */
+	g_assert_cmpint (as_component_get_releases (cpt1)->len, ==, 0);
+	g_assert_true (as_component_get_releases (cpt1) == as_component_get_releases (cpt1));
+	g_assert_true (as_component_get_releases (cpt1) != as_component_get_releases (cpt2));
+	g_assert_true (as_component_get_suggested (cpt1) != as_component_get_screenshots (cpt2));
+	g_assert_true (as_component_get_custom (cpt1) != as_component_get_custom (cpt2));
+	g_assert_cmpint (g_hash_table_size (as_component_get_custom (cpt1)), ==, 0);
+	g_assert_null (as_component_get_custom_value (cpt1, "foo"));
+	g_assert_null (as_component_get_name (cpt1));
+	g_assert_null (as_component_get_keywords (cpt1));
+
+	/* writing allocates storage for this component only */
+	rel = as_release_new ();
+	as_release_set_version (rel, "1.0");
+	as_component_add_release (cpt1, rel);
+	as_component_insert_custom_value (cpt1, "foo", "bar");
+	as_component_add_category (cpt1, "Utility");
+
+	g_assert_cmpint (as_component_get_releases (cpt1)->len, ==, 1);
+	g_assert_cmpint (as_component_get_releases (cpt2)->len, ==, 0);
+	g_assert_cmpstr (as_component_get_custom_value (cpt1, "foo"), ==, "bar");
+	g_assert_cmpint (g_hash_table_size (as_component_get_custom (cpt2)), ==, 0);
+	g_assert_cmpint (as_component_get_categories (cpt1)->len, ==, 1);
+	g_assert_cmpint (as_component_get_categories (cpt2)->len, ==, 0);
+
+	/* changing a list handed out by a getter only affects its component */
+	g_ptr_array_add (as_component_get_extends (cpt2), g_strdup ("org.example.Base"));
+	g_assert_cmpint (as_component_get_extends (cpt2)->len, ==, 1);
+	g_assert_cmpint (as_component_get_extends (cpt1)->len, ==, 0);
+	g_hash_table_insert (as_component_get_custom (cpt2), g_strdup ("foo"), g_strdup ("baz"));
+	g_assert_cmpstr (as_component_get_custom_value (cpt2, "foo"), ==, "baz");
+	g_assert_cmpstr (as_component_get_custom_value (cpt1, "foo"), ==, "bar");
+}
+
+/**
+ * test_component_search_tokens:
+ *
+ * Test exact and prefix matching on the sorted search tokens.
+ */
+static void
+test_component_search_tokens (void)
+{
+	g_autoptr(AsComponent) cpt = NULL;
+	g_autoptr(GPtrArray) tokens = NULL;
+	g_autofree gchar *prefix = NULL;
+	const gchar *token;
+	guint i;
+
+	cpt = as_component_new ();
+	as_component_set_id (cpt, "org.example.Tokens");
+	as_component_set_name (cpt, "Marimba Xylophone", "C");
+	as_component_set_summary (cpt, "Play a wooden keyboard", "C");
+
+	tokens = as_component_get_search_tokens (cpt);
+	g_assert_cmpint (tokens->len, >, 0);
+	for (i = 1; i < tokens->len; i++)
+		g_assert_cmpint (g_strcmp0 (g_ptr_array_index (tokens, i - 1), g_ptr_array_index (tokens, i)), <, 0);
+
+	/* every token matches exactly and by its prefix */
+	for (i = 0; i < tokens->len; i++) {
+		token = g_ptr_array_index (tokens, i);
+		g_assert_cmpint (as_component_search_matches (cpt, token), >, 0);
+		g_free (prefix);
+		prefix = g_strndup (token, 3);
+		g_assert_cmpint (as_component_search_matches (cpt, prefix), >, 0);
+	}
+	g_assert_cmpint (as_component_search_matches (cpt, "zzzzz"), ==, 0);
+	g_assert_cmpint (as_component_search_matches (cpt, "0"), ==, 0);
+}
+
+/**
+ * test_packed_text:
+ *
+ * Test compressed storage of long descriptions.
+ */
+static void
+test_packed_text (void)
+{
+	g_autoptr(AsComponent) cpt = NULL;
+	g_autoptr(GString) text = NULL;
+	g_autofree gchar *packed = NULL;
+	g_autofree gchar *unpacked = NULL;
+	const gchar *desc;
+	guint i;
+
+	text = g_string_new ("<p>");
+	for (i = 0; i < 40; i++)
+		g_string_append (text, "This text repeats itself a lot, so it should compress well. ");
+	g_string_append (text, "</p>");
+
+	/* short texts are not worth it */
+	g_assert_null (as_packed_text_pack ("<p>Short</p>"));
+	g_assert_false (as_packed_text_is_packed ("<p>Short</p>"));
+
+	packed = as_packed_text_pack (text->str);
+	g_assert_nonnull (packed);
+	g_assert_true (as_packed_text_is_packed (packed));
+	g_assert_cmpint (as_packed_text_get_size (packed), <, text->len);
+
+	unpacked = as_packed_text_unpack (packed);
+	g_assert_cmpstr (unpacked, ==, text->str);
+
+	/* packing must not be visible from the outside */
+	cpt = as_component_new ();
+	as_component_set_id (cpt, "org.example.Packed");
+	as_component_set_description (cpt, text->str, "C");
+	as_component_pack_descriptions (cpt);
+
+	desc = as_component_get_description (cpt);
+	g_assert_cmpstr (desc, ==, text->str);
+	g_assert_true (desc == as_component_get_description (cpt));
+
+	/* the shared cache only keeps a bounded amount of texts unpacked */
+	for (i = 0; i < 3000; i++) {
+		g_autofree gchar *utext = g_strdup_printf ("<p>%u</p>%s", i, text->str);
+		g_autofree gchar *upacked = as_packed_text_pack (utext);
+		g_autofree gchar *ucopy = as_packed_text_unpack_cached (upacked);
+
+		g_assert_cmpstr (ucopy, ==, utext);
+	}
+	g_assert_cmpint (as_packed_text_get_cache_size (), <=, 4 * 1024 * 1024);
+
+	/* while the text returned by the component stays valid */
+	g_assert_cmpstr (desc, ==, text->str);
+	g_assert_true (desc == as_component_get_description (cpt));
+}
+
+/**
+ * test_read_peak_rss:
+ *
+ * Returns: the peak resident set size of this process in KiB, or 0 if unknown.
+ */
+static guint64
+test_read_peak_rss (void)
+{
+	g_autofree gchar *status = NULL;
+	const gchar *line;
+
+	if (!g_file_get_contents ("/proc/self/status", &status, NULL, NULL))
+		return 0;
+	line = g_strstr_len (status, -1, "VmHWM:");
+	if (line == NULL)
+		return 0;
+	return g_ascii_strtoull (line + sizeof ("VmHWM:") - 1, NULL, 10);
+}
+
+/**
+ * test_packed_text_memory:
+ *
+ * Measure the peak memory use when reading all long descriptions
+ * of many components with packed descriptions.
+ */
+static void
+test_packed_text_memory (void)
+{
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GString) text = NULL;
+	guint64 rss_start;
+	guint64 rss_peak;
+	guint i;
+
+	rss_start = test_read_peak_rss ();
+	if (rss_start == 0) {
+		g_test_skip ("Peak RSS of the process is unknown.");
+		return;
+	}
+
+	text = g_string_new ("<p>");
+	for (i = 0; i < 40; i++)
+		g_string_append (text, "This text repeats itself a lot, so it should compress well. ");
+	g_string_append (text, "</p>");
+
+	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; i < 50000; i++) {
+		AsComponent *cpt = as_component_new ();
+		g_autofree gchar *cid = g_strdup_printf ("org.example.Test%u", i);
+		g_autofree gchar *desc = g_strdup_printf ("<p>%s</p>%s", cid, text->str);
+
+		as_component_set_id (cpt, cid);
+		as_component_set_description (cpt, desc, "C");
+		as_component_pack_descriptions (cpt);
+		g_ptr_array_add (cpts, cpt);
+	}
+
+	for (i = 0; i < cpts->len; i++)
+		g_assert_nonnull (as_component_get_description (AS_COMPONENT (g_ptr_array_index (cpts, i))));
+
+	rss_peak = test_read_peak_rss ();
+	g_test_minimized_result ((gdouble) (rss_peak - rss_start),
+				 "peak RSS grew by %" G_GUINT64_FORMAT " KiB reading %u descriptions",
+				 rss_peak - rss_start, cpts->len);
+}
+
+/**
+ * test_locale_chain:
+ *
+ * Test the fallback chains used to look up localized values.
+ */
+static void
+test_locale_chain (void)
+{
+	g_autoptr(AsComponent) cpt = NULL;
+	const AsLocaleChain *chain;
+	const gchar * const *locales;
+
+	chain = as_locale_chain_get ("de_AT.UTF-8@euro");
+	g_assert_true (chain == as_locale_chain_get ("de_AT.UTF-8@euro"));
+	locales = as_locale_chain_get_locales (chain);
+	g_assert_cmpstr (locales[0], ==, "de_AT.UTF-8@euro");
+	g_assert_cmpstr (locales[1], ==, "de_AT@euro");
+	g_assert_cmpstr (locales[2], ==, "de_AT");
+	g_assert_cmpstr (locales[3], ==, "de@euro");
+	g_assert_cmpstr (locales[4], ==, "de");
+	g_assert_cmpstr (locales[5], ==, "C");
+	g_assert_null (locales[6]);
+
+	/* several preferred languages */
+	chain = as_locale_chain_get ("pt_BR:fr");
+	locales = as_locale_chain_get_locales (chain);
+	g_assert_cmpstr (locales[0], ==, "pt_BR");
+	g_assert_cmpstr (locales[1], ==, "pt");
+	g_assert_cmpstr (locales[2], ==, "fr");
+	g_assert_cmpstr (locales[3], ==, "C");
+
+	/* values for other regions of a requested language are accepted, but not preferred */
+	g_assert_true (as_locale_chain_accepts (chain, "pt"));
+	g_assert_true (as_locale_chain_accepts (chain, "fr_CA"));
+	g_assert_false (as_locale_chain_accepts (chain, "pt_PT"));
+	g_assert_false (as_locale_chain_accepts (chain, "C"));
+	g_assert_cmpint (as_locale_chain_rank (chain, "fr"), <, as_locale_chain_rank (chain, "fr_CA"));
+	g_assert_cmpint (as_locale_chain_rank (chain, "fr_CA"), <, as_locale_chain_rank (chain, "C"));
+	g_assert_true (as_locale_chain_accepts (as_locale_chain_get (NULL), "C"));
+
+	/* components use the chain of their active locale */
+	cpt = as_component_new ();
+	as_component_set_id (cpt, "org.example.Localized");
+	as_component_set_summary (cpt, "Untranslated", "C");
+	as_component_set_summary (cpt, "Auf Deutsch", "de");
+	as_component_set_summary (cpt, "En français", "fr");
+
+	as_component_set_active_locale (cpt, "de_AT@euro");
+	g_assert_cmpstr (as_component_get_summary (cpt), ==, "Auf Deutsch");
+	as_component_set_active_locale (cpt, "it:fr_FR");
+	g_assert_cmpstr (as_component_get_summary (cpt), ==, "En français");
+	as_component_set_active_locale (cpt, "it");
+	g_assert_cmpstr (as_component_get_summary (cpt), ==, "Untranslated");
+}
+
 /**
  * test_spdx:
  *
@@ -322,6 +592,7 @@ test_desktop_entry ()
 	file = g_file_new_for_path (nautilus_de_fname);
 
 	metad = as_metadata_new ();
+	as_metadata_set_locale (metad, "ALL");
 	as_metadata_parse_file (metad, file, AS_FORMAT_KIND_UNKNOWN, &error);
 	g_assert_no_error (error);
 	cpt = as_metadata_get_component (metad);
@@ -379,6 +650,299 @@ test_desktop_entry ()
 	g_free (tmp);
 }
 
+/**
+ * as_desktop_entry_to_xml:
+ *
+ * Parse desktop-entry data with either parser, and serialize the result.
+ */
+static gchar*
+as_desktop_entry_to_xml (const gchar *data, const gchar *locale, gboolean use_keyfile)
+{
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(AsComponent) cpt = NULL;
+	g_autoptr(GError) error = NULL;
+	gchar *xml;
+
+	if (use_keyfile)
+		cpt = as_desktop_entry_parse_data_keyfile (data, "org.example.Test.desktop", AS_CURRENT_FORMAT_VERSION, locale, &error);
+	else
+		cpt = as_desktop_entry_parse_data (data, "org.example.Test.desktop", AS_CURRENT_FORMAT_VERSION, locale, &error);
+	if (error != NULL)
+		return g_strdup_printf ("error: %s", error->message);
+	if (cpt == NULL)
+		return g_strdup ("none");
+
+	metad = as_metadata_new ();
+	as_metadata_add_component (metad, cpt);
+	xml = as_metadata_components_to_collection (metad, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+
+	return xml;
+}
+
+/**
+ * test_desktop_entry_parser_parity:
+ *
+ * Test that the single-pass desktop-entry parser gives the same results
+ * as reading the data with GKeyFile.
+ */
+static void
+test_desktop_entry_parser_parity ()
+{
+	const gchar *locales[] = { NULL, "C", "de_DE", "lt", "pt_BR" };
+	const gchar *samples[] = {
+		"[Desktop Entry]\nType=Application\nName=Test\nName[de]=Versuch\nComment=A test\n"
+		"Comment[de_DE]=Ein Test\nIcon=test.png\nCategories=GTK;Utility;X-Test;\n"
+		"Keywords=a;b;c;\nKeywords[de]=x;y;\nMimeType=text/plain;image/png;\n",
+		/* comments, whitespace and CRLF line endings */
+		"# comment\r\n\r\n[Desktop Entry]  \r\n  Type = Application\r\nName=  Spaced Name \r\n"
+		"Comment[pt_BR.UTF-8]=Olá\r\nIcon=/usr/share/icons/test.svg\r\n",
+		/* escapes */
+		"[Desktop Entry]\nType=Application\nName=Line\\sone\\ttab\\\\\nIcon=first.svg\nName[lt]=Pirmas\n",
+		/* other groups must not influence the result */
+		"[Desktop Entry]\nType=Application\nName=Main\n\n[Desktop Action New]\nName=New Window\nIcon=other\n",
+		/* filtered and ignored entries */
+		"[Desktop Entry]\nType=Application\nName=Hidden\nNoDisplay=true\n",
+		"[Desktop Entry]\nType=Application\nName=Ignored\nX-AppStream-Ignore=true\n",
+		"[Desktop Entry]\nType=Link\nName=Link\n",
+		"[Desktop Entry]\nName=No type\n",
+		/* data we hand over to GKeyFile */
+		"[Desktop Entry]\nType=Application\nName=Bad\\xescape\nComment=Test\n",
+		"Name=No group\n",
+		"[Desktop Entry]\nType=Application\nthis is not a key-value pair\n",
+		"[Other Group]\nName=Other\n\n[Desktop Entry]\nType=Application\nName=Second\n",
+		"",
+		NULL
+	};
+	g_autofree gchar *nautilus_data = NULL;
+	g_autofree gchar *nautilus_fname = NULL;
+	g_autoptr(GError) error = NULL;
+	guint i, j;
+
+	nautilus_fname = g_build_filename (datadir, "org.gnome.Nautilus.desktop", NULL);
+	g_file_get_contents (nautilus_fname, &nautilus_data, NULL, &error);
+	g_assert_no_error (error);
+
+	for (i = 0; i < G_N_ELEMENTS (samples); i++) {
+		const gchar *data = (samples[i] == NULL)? nautilus_data : samples[i];
+
+		for (j = 0; j < G_N_ELEMENTS (locales); j++) {
+			g_autofree gchar *xml_keyfile = NULL;
+			g_autofree gchar *xml = NULL;
+
+			xml_keyfile = as_desktop_entry_to_xml (data, locales[j], TRUE);
+			xml = as_desktop_entry_to_xml (data, locales[j], FALSE);
+			g_assert_cmpstr (xml, ==, xml_keyfile);
+		}
+	}
+}
+
+/**
+ * test_file_reader:
+ *
+ * Test the pipelined metadata file reader.
+ */
+static void
+test_file_reader ()
+{
+	g_autofree gchar *plain_fname = NULL;
+	g_autofree gchar *gz_fname = NULL;
+	g_autofree gchar *missing_fname = NULL;
+	g_autofree gchar *expected_data = NULL;
+	g_autofree gchar *data = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(AsFileReader) reader = NULL;
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(GString) large_data = NULL;
+	g_autoptr(GError) error = NULL;
+
+	plain_fname = g_build_filename (datadir, "appstream-dxml.xml", NULL);
+	gz_fname = g_build_filename (datadir, "appstream-dxml.xml.gz", NULL);
+	missing_fname = g_build_filename (datadir, "does-not-exist.xml", NULL);
+
+	g_file_get_contents (plain_fname, &expected_data, NULL, &error);
+	g_assert_no_error (error);
+
+	/* compressed data must be decompressed while reading */
+	file = g_file_new_for_path (gz_fname);
+	reader = as_file_reader_new (file);
+	data = as_file_reader_read_all (reader, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (data, ==, expected_data);
+	g_clear_pointer (&reader, as_file_reader_free);
+
+	/* parsing must give the same result as for the uncompressed file */
+	metad = as_metadata_new ();
+	as_metadata_set_format_style (metad, AS_FORMAT_STYLE_COLLECTION);
+	as_metadata_parse_file (metad, file, AS_FORMAT_KIND_UNKNOWN, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (as_metadata_get_components (metad)->len, ==, 1);
+	g_object_unref (file);
+
+	/* uncompressed local data is read directly */
+	reader = as_file_reader_new_for_path (plain_fname);
+	g_assert_cmpint (as_file_reader_guess_format (reader), ==, AS_FORMAT_KIND_XML);
+	g_free (data);
+	data = as_file_reader_read_all (reader, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (data, ==, expected_data);
+	g_clear_pointer (&reader, as_file_reader_free);
+
+	/* large files are streamed, and must give the same data */
+	large_data = g_string_new (NULL);
+	while (large_data->len <= 9 * 1024 * 1024)
+		g_string_append (large_data, expected_data);
+	g_file_set_contents ("/tmp/as-unittest-large.xml", large_data->str, large_data->len, &error);
+	g_assert_no_error (error);
+	reader = as_file_reader_new_for_path ("/tmp/as-unittest-large.xml");
+	g_free (data);
+	data = as_file_reader_read_all (reader, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (data, ==, large_data->str);
+	g_clear_pointer (&reader, as_file_reader_free);
+	g_remove ("/tmp/as-unittest-large.xml");
+
+	/* errors are reported when the data is requested */
+	file = g_file_new_for_path (missing_fname);
+	reader = as_file_reader_new (file);
+	g_free (data);
+	data = as_file_reader_read_all (reader, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert (data == NULL);
+}
+
+/**
+ * test_file_batch:
+ *
+ * Test reading many files at once.
+ */
+static void
+test_file_batch ()
+{
+	g_autoptr(GPtrArray) fnames = NULL;
+	g_autoptr(AsFileBatch) batch = NULL;
+	g_autofree gchar *expected_data = NULL;
+	AsFileReader *reader;
+	const gchar *fname;
+	guint i;
+
+	fnames = g_ptr_array_new_with_free_func (g_free);
+	for (i = 0; i < 200; i++) {
+		if (i % 50 == 49)
+			g_ptr_array_add (fnames, g_build_filename (datadir, "does-not-exist.xml", NULL));
+		else
+			g_ptr_array_add (fnames, g_build_filename (datadir, "appstream-dxml.xml", NULL));
+	}
+	g_file_get_contents ((const gchar*) g_ptr_array_index (fnames, 0), &expected_data, NULL, NULL);
+
+	/* the readers are returned in order */
+	batch = as_file_batch_new (fnames);
+	for (i = 0; (reader = as_file_batch_next (batch, &fname)) != NULL; i++) {
+		g_autofree gchar *data = NULL;
+		g_autoptr(GError) error = NULL;
+
+		g_assert_cmpstr (fname, ==, (const gchar*) g_ptr_array_index (fnames, i));
+		data = as_file_reader_read_all (reader, &error);
+		if (i % 50 == 49) {
+			g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+		} else {
+			g_assert_no_error (error);
+			g_assert_cmpstr (data, ==, expected_data);
+		}
+		as_file_reader_free (reader);
+	}
+	g_assert_cmpint (i, ==, 200);
+	g_clear_pointer (&batch, as_file_batch_free);
+
+	/* freeing an unfinished batch must not leak or block */
+	batch = as_file_batch_new (fnames);
+	reader = as_file_batch_next (batch, NULL);
+	g_assert (reader != NULL);
+	as_file_reader_free (reader);
+}
+
+/**
+ * test_dir_scanner:
+ *
+ * Test the directory scanner.
+ */
+static void
+test_dir_scanner ()
+{
+	g_autoptr(GPtrArray) sfiles = NULL;
+	g_autofree gchar *collection_dir = NULL;
+	g_autofree gchar *tmp_dir = NULL;
+	g_autoptr(GError) error = NULL;
+	guint i;
+
+	g_assert (as_dir_scanner_match ("*.xml", "foobar-1.xml"));
+	g_assert (as_dir_scanner_match ("*.xml*", "appstream-dxml.xml.gz"));
+	g_assert (as_dir_scanner_match ("*Components-*.yml.gz", "a_Components-amd64.yml.gz"));
+	g_assert (as_dir_scanner_match ("foo?ar", "foobar"));
+	g_assert (as_dir_scanner_match ("", "anything"));
+	g_assert (!as_dir_scanner_match ("*.xml", "foobar.xml.gz"));
+	g_assert (!as_dir_scanner_match ("*.desktop", "desktop"));
+
+	/* non-recursive scans list subdirectories too */
+	sfiles = as_dir_scanner_scan (datadir, "coll*", AS_DIR_SCAN_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (sfiles->len, ==, 1);
+	g_ptr_array_unref (sfiles);
+
+	/* recursive, parallel scan with file metadata */
+	collection_dir = g_build_filename (datadir, "collection", NULL);
+	sfiles = as_dir_scanner_scan (collection_dir,
+				      "*.xml",
+				      AS_DIR_SCAN_FLAG_RECURSIVE | AS_DIR_SCAN_FLAG_PARALLEL | AS_DIR_SCAN_FLAG_WITH_STAT,
+				      &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (sfiles->len, ==, 3);
+	for (i = 0; i < sfiles->len; i++) {
+		AsScannedFile *sfile = (AsScannedFile*) g_ptr_array_index (sfiles, i);
+		GStatBuf st;
+
+		g_assert (g_str_has_prefix (sfile->path, collection_dir));
+		g_assert_cmpint (g_stat (sfile->path, &st), ==, 0);
+		g_assert_cmpint (sfile->size, ==, st.st_size);
+		g_assert_cmpint (sfile->mtime, ==, st.st_mtime);
+		g_assert_cmpint (sfile->inode, ==, st.st_ino);
+	}
+	g_ptr_array_unref (sfiles);
+
+	/* many subdirectories are scanned by worker threads, with the same result */
+	tmp_dir = g_dir_make_tmp ("as-unittest-scan-XXXXXX", &error);
+	g_assert_no_error (error);
+	for (i = 0; i < 12; i++) {
+		g_autofree gchar *subdir = g_strdup_printf ("%s/dir%02u", tmp_dir, i);
+		g_autofree gchar *fname = g_build_filename (subdir, "data.xml", NULL);
+
+		g_assert_cmpint (g_mkdir (subdir, 0755), ==, 0);
+		g_file_set_contents (fname, "<components/>", -1, &error);
+		g_assert_no_error (error);
+	}
+	sfiles = as_dir_scanner_scan (tmp_dir, "*.xml", AS_DIR_SCAN_FLAG_RECURSIVE | AS_DIR_SCAN_FLAG_PARALLEL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (sfiles->len, ==, 12);
+	g_ptr_array_unref (sfiles);
+	sfiles = as_dir_scanner_scan (tmp_dir, "*.xml", AS_DIR_SCAN_FLAG_RECURSIVE, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (sfiles->len, ==, 12);
+	for (i = 0; i < sfiles->len; i++) {
+		AsScannedFile *sfile = (AsScannedFile*) g_ptr_array_index (sfiles, i);
+		g_autofree gchar *subdir = g_path_get_dirname (sfile->path);
+
+		g_assert_cmpint (g_remove (sfile->path), ==, 0);
+		g_assert_cmpint (g_rmdir (subdir), ==, 0);
+	}
+	g_ptr_array_unref (sfiles);
+	g_assert_cmpint (g_rmdir (tmp_dir), ==, 0);
+
+	/* missing directories are an error */
+	sfiles = as_dir_scanner_scan ("/nonexistent/directory", "*", AS_DIR_SCAN_FLAG_NONE, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert (sfiles == NULL);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -404,7 +968,17 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStream/Component", test_component);
 	g_test_add_func ("/AppStream/SPDX", test_spdx);
 	g_test_add_func ("/AppStream/TranslationFallback", test_translation_fallback);
+	g_test_add_func ("/AppStream/ComponentLazyContainers", test_component_lazy_containers);
+	g_test_add_func ("/AppStream/ComponentSearchTokens", test_component_search_tokens);
+	g_test_add_func ("/AppStream/PackedText", test_packed_text);
+	g_test_add_func ("/AppStream/LocaleChain", test_locale_chain);
 	g_test_add_func ("/AppStream/DesktopEntry", test_desktop_entry);
+	g_test_add_func ("/AppStream/DesktopEntryParserParity", test_desktop_entry_parser_parity);
+	g_test_add_func ("/AppStream/FileReader", test_file_reader);
+	g_test_add_func ("/AppStream/FileBatch", test_file_batch);
+	g_test_add_func ("/AppStream/DirScanner", test_dir_scanner);
+	if (g_test_perf ())
+		g_test_add_func ("/AppStream/PackedTextMemory", test_packed_text_memory);
 
 	ret = g_test_run ();
 	g_free (datadir);
@@ -20,12 +20,17 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
 
 #include "appstream.h"
 #include "as-pool-private.h"
 #include "as-test-utils.h"
 #include "../src/as-utils-private.h"
 #include "../src/as-component-private.h"
+#include "../src/as-dir-scanner.h"
+#include "../src/as-desktop-cache.h"
+#include "../src/as-metainfo-manifest.h"
+#include "../src/as-intern.h"
 
 
 static gchar *datadir = NULL;
@@ -74,6 +79,9 @@ test_cache ()
 	g_autoptr(AsPool) dpool = NULL;
 	g_autoptr(AsComponent) cpt1 = NULL;
 	g_autoptr(AsComponent) cpt2 = NULL;
+	g_autoptr(AsBundle) bundle = NULL;
+	g_autoptr(AsLaunchable) launch = NULL;
+	g_autoptr(GPtrArray) result = NULL;
 	g_autoptr(GError) error = NULL;
 
 	/* prepare our components */
@@ -90,6 +98,18 @@ test_cache ()
 	as_component_set_summary (cpt2, "Another unit-test dummy entry", NULL);
 	as_component_insert_custom_value (cpt2, "mykey", "stuff");
 
+	bundle = as_bundle_new ();
+	as_bundle_set_kind (bundle, AS_BUNDLE_KIND_FLATPAK);
+	as_bundle_set_id (bundle, "app/org.example.NewFooBar/x86_64/stable");
+	as_component_add_bundle (cpt2, bundle);
+	g_clear_object (&bundle);
+
+	launch = as_launchable_new ();
+	as_launchable_set_kind (launch, AS_LAUNCHABLE_KIND_DESKTOP_ID);
+	as_launchable_add_entry (launch, "org.example.NewFooBar.desktop");
+	as_component_add_launchable (cpt2, launch);
+	g_clear_object (&launch);
+
 	/* add data to the pool */
 	dpool = as_pool_new ();
 	as_pool_add_component (dpool, cpt1, &error);
@@ -125,6 +145,270 @@ test_cache ()
 	g_assert_cmpstr (as_component_get_name (cpt2), ==, "Second FooBar App");
 	g_assert_cmpstr (as_component_get_summary (cpt2), ==, "Another unit-test dummy entry");
 	g_assert_cmpstr (as_component_get_custom_value (cpt2, "mykey"), ==, "stuff");
+
+	/* bundles and launchables are loaded as plain records, check both lookup paths */
+	result = as_pool_get_components_by_launchable (dpool, AS_LAUNCHABLE_KIND_DESKTOP_ID, "org.example.NewFooBar.desktop");
+	g_assert_cmpint (result->len, ==, 1);
+	g_assert_true (g_ptr_array_index (result, 0) == (gpointer) cpt2);
+	g_assert_true (as_component_has_bundle (cpt2));
+	g_assert_false (as_component_has_bundle (cpt1));
+
+	g_assert_cmpint (as_component_get_launchables (cpt2)->len, ==, 1);
+	launch = g_object_ref (as_component_get_launchable (cpt2, AS_LAUNCHABLE_KIND_DESKTOP_ID));
+	g_assert_cmpstr (g_ptr_array_index (as_launchable_get_entries (launch), 0), ==, "org.example.NewFooBar.desktop");
+	bundle = g_object_ref (as_component_get_bundle (cpt2, AS_BUNDLE_KIND_FLATPAK));
+	g_assert_cmpstr (as_bundle_get_id (bundle), ==, "app/org.example.NewFooBar/x86_64/stable");
+}
+
+/**
+ * test_cache_memory_budget:
+ *
+ * Test evicting heavy component data loaded from a cache file.
+ */
+static void
+test_cache_memory_budget ()
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(AsComponent) cpt1 = NULL;
+	g_autoptr(AsComponent) cpt2 = NULL;
+	g_autoptr(AsRelease) rel = NULL;
+	g_autoptr(GError) error = NULL;
+	GPtrArray *releases;
+	const gchar *desc;
+
+	cpt1 = as_component_new ();
+	as_component_set_kind (cpt1, AS_COMPONENT_KIND_GENERIC);
+	as_component_set_id (cpt1, "org.example.Heavy1");
+	as_component_set_name (cpt1, "Heavy 1", NULL);
+	as_component_set_summary (cpt1, "A unit-test dummy entry", NULL);
+	as_component_set_description (cpt1, "<p>The first long description.</p>", NULL);
+	rel = as_release_new ();
+	as_release_set_version (rel, "1.0");
+	as_component_add_release (cpt1, rel);
+
+	cpt2 = as_component_new ();
+	as_component_set_kind (cpt2, AS_COMPONENT_KIND_GENERIC);
+	as_component_set_id (cpt2, "org.example.Heavy2");
+	as_component_set_name (cpt2, "Heavy 2", NULL);
+	as_component_set_summary (cpt2, "Another unit-test dummy entry", NULL);
+	as_component_set_description (cpt2, "<p>The second long description.</p>", NULL);
+
+	dpool = as_pool_new ();
+	as_pool_add_component (dpool, cpt1, &error);
+	g_assert_no_error (error);
+	as_pool_add_component (dpool, cpt2, &error);
+	g_assert_no_error (error);
+	as_pool_save_cache_file (dpool, "/tmp/as-unittest-budget.gvz", &error);
+	g_assert_no_error (error);
+	g_clear_object (&dpool);
+	g_clear_object (&cpt1);
+	g_clear_object (&cpt2);
+
+	/* with a tiny budget, everything is evicted right after loading */
+	dpool = as_pool_new ();
+	as_pool_set_memory_budget (dpool, 1);
+	g_assert_cmpint (as_pool_get_memory_budget (dpool), ==, 1);
+	as_pool_load_cache_file (dpool, "/tmp/as-unittest-budget.gvz", &error);
+	g_assert_no_error (error);
+
+	cpt1 = _as_get_single_component_by_cid (dpool, "org.example.Heavy1");
+	cpt2 = _as_get_single_component_by_cid (dpool, "org.example.Heavy2");
+	g_assert_nonnull (cpt1);
+	g_assert_nonnull (cpt2);
+	g_assert_cmpint (as_component_get_heavy_size (cpt1), >, 0);
+	g_assert_true (as_component_is_heavy_evicted (cpt1));
+	g_assert_true (as_component_is_heavy_evicted (cpt2));
+
+	/* the data is read back when it is accessed */
+	desc = as_component_get_description (cpt1);
+	g_assert_cmpstr (desc, ==, "<p>The first long description.</p>");
+	g_assert_false (as_component_is_heavy_evicted (cpt1));
+	g_assert_true (as_component_is_heavy_evicted (cpt2));
+	g_assert_cmpint (as_component_get_releases (cpt1)->len, ==, 1);
+
+	/* queries don't evict anything */
+	g_clear_object (&cpt2);
+	cpt2 = _as_get_single_component_by_cid (dpool, "org.example.Heavy2");
+	g_assert_false (as_component_is_heavy_evicted (cpt1));
+	g_assert_true (as_component_is_heavy_evicted (cpt2));
+
+	/* reading the data internally, e.g. to write a cache, does not keep it around */
+	as_pool_save_cache_file (dpool, "/tmp/as-unittest-budget-copy.gvz", &error);
+	g_assert_no_error (error);
+	g_remove ("/tmp/as-unittest-budget-copy.gvz");
+	g_assert_false (as_component_is_heavy_evicted (cpt2));
+
+	/* trimming evicts it again, but data handed out by getters stays valid for as long as the component lives */
+	releases = as_component_get_releases (cpt1);
+	as_pool_set_memory_budget (dpool, 1);
+	g_assert_true (as_component_is_heavy_evicted (cpt2));
+	g_assert_false (as_component_is_heavy_evicted (cpt1));
+	g_assert_true (as_component_get_description (cpt1) == desc);
+	g_assert_cmpstr (desc, ==, "<p>The first long description.</p>");
+	g_assert_true (as_component_get_releases (cpt1) == releases);
+	g_assert_cmpstr (as_release_get_version (AS_RELEASE (g_ptr_array_index (releases, 0))), ==, "1.0");
+	g_assert_cmpstr (as_component_get_description (cpt2), ==, "<p>The second long description.</p>");
+
+	/* modified data can not be evicted anymore */
+	as_component_set_description (cpt2, "<p>Changed.</p>", NULL);
+	g_assert_cmpint (as_component_get_heavy_size (cpt2), ==, 0);
+	as_pool_set_memory_budget (dpool, 1);
+	g_assert_false (as_component_is_heavy_evicted (cpt2));
+	g_assert_cmpstr (as_component_get_description (cpt2), ==, "<p>Changed.</p>");
+	g_clear_object (&cpt1);
+	g_clear_object (&cpt2);
+	g_clear_object (&dpool);
+
+	/* the budget is applied when loading the cache through the regular pool loading as well */
+	{
+		g_autofree gchar *tmpdir = NULL;
+		g_autofree gchar *cache_fname = NULL;
+
+		tmpdir = g_dir_make_tmp ("as-unittest-budget-XXXXXX", NULL);
+		g_assert_nonnull (tmpdir);
+		cache_fname = g_build_filename (tmpdir, "C.gvz", NULL);
+		g_assert_cmpint (g_rename ("/tmp/as-unittest-budget.gvz", cache_fname), ==, 0);
+
+		dpool = as_pool_new ();
+		as_pool_clear_metadata_locations (dpool);
+		as_pool_set_locale (dpool, "C");
+		as_pool_set_system_cache_dir (dpool, tmpdir);
+		as_pool_set_flags (dpool, AS_POOL_FLAG_READ_COLLECTION);
+		as_pool_set_cache_flags (dpool, AS_CACHE_FLAG_USE_SYSTEM);
+		as_pool_set_memory_budget (dpool, 1);
+		g_assert (as_pool_load (dpool, NULL, &error));
+		g_assert_no_error (error);
+
+		cpt1 = _as_get_single_component_by_cid (dpool, "org.example.Heavy1");
+		g_assert_nonnull (cpt1);
+		g_assert_true (as_component_is_heavy_evicted (cpt1));
+		g_assert_cmpstr (as_component_get_description (cpt1), ==, "<p>The first long description.</p>");
+
+		g_remove (cache_fname);
+		g_rmdir (tmpdir);
+	}
+}
+
+/**
+ * test_content_sharing:
+ *
+ * Test sharing the data of identical components from several origins.
+ */
+static void
+test_content_sharing ()
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(AsComponent) cpt1 = NULL;
+	g_autoptr(AsComponent) cpt2 = NULL;
+	g_autoptr(AsRelease) rel = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *hash = NULL;
+	guint i;
+
+	dpool = as_pool_new ();
+	for (i = 0; i < 2; i++) {
+		g_autoptr(AsComponent) cpt = as_component_new ();
+		g_autoptr(AsRelease) crel = as_release_new ();
+		g_autoptr(AsBundle) bundle = as_bundle_new ();
+
+		as_component_set_kind (cpt, AS_COMPONENT_KIND_GENERIC);
+		as_component_set_id (cpt, "org.example.Shared");
+
+		/* packages share one namespace, so use bundles to get a data-ID per origin */
+		as_component_set_origin (cpt, (i == 0)? "example-stable" : "example-beta");
+		as_bundle_set_kind (bundle, AS_BUNDLE_KIND_FLATPAK);
+		as_bundle_set_id (bundle, "app/org.example.Shared/x86_64/stable");
+		as_component_add_bundle (cpt, bundle);
+		as_component_set_name (cpt, "Shared", NULL);
+		as_component_set_summary (cpt, "A unit-test dummy entry", NULL);
+		as_component_set_description (cpt, "<p>The same long description.</p>", NULL);
+		as_component_add_url (cpt, AS_URL_KIND_HOMEPAGE, "https://example.org");
+		as_component_add_language (cpt, "de", 80);
+		as_component_add_language (cpt, "fr", 60);
+		as_release_set_version (crel, "1.0");
+		as_component_add_release (cpt, crel);
+
+		as_pool_add_component (dpool, cpt, &error);
+		g_assert_no_error (error);
+	}
+
+	cpts = as_pool_get_components_by_id (dpool, "org.example.Shared");
+	g_assert_cmpint (cpts->len, ==, 2);
+	cpt1 = g_object_ref (AS_COMPONENT (g_ptr_array_index (cpts, 0)));
+	cpt2 = g_object_ref (AS_COMPONENT (g_ptr_array_index (cpts, 1)));
+
+	/* the origin is not part of the hash, so both are identical */
+	hash = g_strdup (as_component_get_content_hash (cpt1));
+	g_assert_cmpint (strlen (hash), ==, 64);
+	g_assert_cmpstr (as_component_get_content_hash (cpt2), ==, hash);
+
+	/* components added by API users are never changed by the pool, they might still modify them */
+	g_assert_true (g_ptr_array_index (as_component_get_releases (cpt1), 0) !=
+		       g_ptr_array_index (as_component_get_releases (cpt2), 0));
+	g_assert_cmpstr (as_component_get_description (cpt1), ==, "<p>The same long description.</p>");
+	g_assert_cmpstr (as_component_get_description (cpt2), ==, "<p>The same long description.</p>");
+
+	/* the hash survives the cache */
+	as_pool_save_cache_file (dpool, "/tmp/as-unittest-sharing.gvz", &error);
+	g_assert_no_error (error);
+	g_clear_object (&dpool);
+	g_clear_pointer (&cpts, g_ptr_array_unref);
+	g_clear_object (&cpt1);
+	g_clear_object (&cpt2);
+
+	dpool = as_pool_new ();
+	as_pool_load_cache_file (dpool, "/tmp/as-unittest-sharing.gvz", &error);
+	g_assert_no_error (error);
+	cpts = as_pool_get_components_by_id (dpool, "org.example.Shared");
+	g_assert_cmpint (cpts->len, ==, 2);
+	for (i = 0; i < cpts->len; i++)
+		g_assert_cmpstr (as_component_get_content_hash (AS_COMPONENT (g_ptr_array_index (cpts, i))), ==, hash);
+
+	/* data the pool loaded itself is shared, but handed out containers are not */
+	cpt1 = g_object_ref (AS_COMPONENT (g_ptr_array_index (cpts, 0)));
+	cpt2 = g_object_ref (AS_COMPONENT (g_ptr_array_index (cpts, 1)));
+	g_assert_true (as_component_get_releases (cpt1) != as_component_get_releases (cpt2));
+	g_assert_true (g_ptr_array_index (as_component_get_releases (cpt1), 0) ==
+		       g_ptr_array_index (as_component_get_releases (cpt2), 0));
+	g_assert_cmpstr (as_component_get_description (cpt1), ==, "<p>The same long description.</p>");
+	g_assert_cmpstr (as_component_get_description (cpt2), ==, "<p>The same long description.</p>");
+
+	/* modifying one component does not change the other */
+	rel = as_release_new ();
+	as_release_set_version (rel, "2.0");
+	as_component_add_release (cpt1, rel);
+	g_assert_cmpint (as_component_get_releases (cpt1)->len, ==, 2);
+	g_assert_cmpint (as_component_get_releases (cpt2)->len, ==, 1);
+	g_assert_cmpstr (as_component_get_content_hash (cpt1), !=, hash);
+	g_assert_cmpstr (as_component_get_content_hash (cpt2), ==, hash);
+
+	as_component_set_description (cpt2, "<p>Changed.</p>", NULL);
+	g_assert_cmpstr (as_component_get_description (cpt1), ==, "<p>The same long description.</p>");
+	g_assert_cmpstr (as_component_get_description (cpt2), ==, "<p>Changed.</p>");
+	g_free (hash);
+
+	/* every other change resets the hash as well */
+	hash = g_strdup (as_component_get_content_hash (cpt2));
+	as_component_set_name (cpt2, "Renamed", NULL);
+	g_assert_cmpstr (as_component_get_content_hash (cpt2), !=, hash);
+	g_free (hash);
+	hash = g_strdup (as_component_get_content_hash (cpt2));
+	as_component_add_url (cpt2, AS_URL_KIND_BUGTRACKER, "https://example.org/bugs");
+	g_assert_cmpstr (as_component_get_content_hash (cpt2), !=, hash);
+
+	/* changes to the releases themselves are picked up when writing the cache */
+	g_free (hash);
+	hash = g_strdup (as_component_get_content_hash (cpt1));
+	as_release_set_version (rel, "2.1");
+	g_assert_cmpstr (as_component_get_content_hash (cpt1), ==, hash);
+	g_clear_object (&dpool);
+	dpool = as_pool_new ();
+	as_pool_add_component (dpool, cpt1, &error);
+	g_assert_no_error (error);
+	as_pool_save_cache_file (dpool, "/tmp/as-unittest-sharing.gvz", &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (as_component_get_content_hash (cpt1), !=, hash);
 }
 
 /**
@@ -235,6 +519,129 @@ test_cache_file ()
 	as_assert_component_lists_equal (cpts, cpts_prev);
 }
 
+/**
+ * test_desktop_cache:
+ *
+ * Test the cache for components read from .desktop files.
+ */
+static void
+test_desktop_cache ()
+{
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(AsDesktopCache) dcache = NULL;
+	g_autoptr(GPtrArray) sfiles = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GPtrArray) no_files = NULL;
+	g_autoptr(GFile) file = NULL;
+	AsScannedFile *sfile;
+	AsComponent *cpt;
+	GError *error = NULL;
+
+	sfiles = as_dir_scanner_scan (datadir, "org.gnome.Nautilus.desktop", AS_DIR_SCAN_FLAG_WITH_STAT, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (sfiles->len, ==, 1);
+	sfile = (AsScannedFile*) g_ptr_array_index (sfiles, 0);
+
+	metad = as_metadata_new ();
+	as_metadata_set_locale (metad, "C");
+	file = g_file_new_for_path (sfile->path);
+	as_metadata_parse_file (metad, file, AS_FORMAT_KIND_DESKTOP_ENTRY, &error);
+	g_assert_no_error (error);
+
+	/* nothing is known before the file was added */
+	dcache = as_desktop_cache_new ("C");
+	g_assert (as_desktop_cache_lookup (dcache, sfile) == NULL);
+	as_desktop_cache_insert (dcache, sfile, as_metadata_get_components (metad));
+	g_assert (as_desktop_cache_is_dirty (dcache));
+
+	as_desktop_cache_save (dcache, "/tmp/as-unittest-desktop-cache.gv", &error);
+	g_assert_no_error (error);
+	g_assert (!as_desktop_cache_is_dirty (dcache));
+	g_clear_pointer (&dcache, as_desktop_cache_free);
+
+	/* unchanged files are read from the cache */
+	dcache = as_desktop_cache_new ("C");
+	as_desktop_cache_load (dcache, "/tmp/as-unittest-desktop-cache.gv", &error);
+	g_assert_no_error (error);
+	cpts = as_desktop_cache_lookup (dcache, sfile);
+	g_assert (cpts != NULL);
+	as_assert_component_lists_equal (cpts, as_metadata_get_components (metad));
+	cpt = AS_COMPONENT (g_ptr_array_index (cpts, 0));
+	g_assert_cmpstr (as_component_get_id (cpt), ==, "org.gnome.Nautilus");
+	g_assert_cmpint (as_component_get_origin_kind (cpt), ==, AS_ORIGIN_KIND_DESKTOP_ENTRY);
+
+	/* files rewritten within the same second, with the same size, need to be read again */
+	sfile->ctime_ns++;
+	g_assert (as_desktop_cache_lookup (dcache, sfile) == NULL);
+	sfile->ctime_ns--;
+
+	/* modified files need to be read again */
+	sfile->mtime++;
+	g_assert (as_desktop_cache_lookup (dcache, sfile) == NULL);
+
+	/* entries for removed files are dropped */
+	no_files = g_ptr_array_new ();
+	as_desktop_cache_retain (dcache, no_files);
+	g_assert (as_desktop_cache_is_dirty (dcache));
+	sfile->mtime--;
+	g_assert (as_desktop_cache_lookup (dcache, sfile) == NULL);
+	g_clear_pointer (&dcache, as_desktop_cache_free);
+
+	/* caches for a different locale are not used */
+	dcache = as_desktop_cache_new ("de_DE");
+	as_desktop_cache_load (dcache, "/tmp/as-unittest-desktop-cache.gv", &error);
+	g_assert_no_error (error);
+	g_assert (as_desktop_cache_lookup (dcache, sfile) == NULL);
+}
+
+/**
+ * test_metainfo_manifest:
+ *
+ * Test the manifest of component-IDs of metainfo files.
+ */
+static void
+test_metainfo_manifest ()
+{
+	g_autoptr(AsMetainfoManifest) manifest = NULL;
+	g_autoptr(GPtrArray) sfiles = NULL;
+	g_autofree gchar *fname = NULL;
+	g_autofree gchar *cid = NULL;
+	AsScannedFile *sfile;
+	GError *error = NULL;
+
+	/* only the ID of single-component files is found */
+	fname = g_build_filename (datadir, "appdata.xml", NULL);
+	cid = as_metainfo_skim_id (fname);
+	g_assert_cmpstr (cid, ==, "firefox.desktop");
+	g_free (fname);
+	fname = g_build_filename (datadir, "collection", "xml", "foobar-1.xml", NULL);
+	g_assert (as_metainfo_skim_id (fname) == NULL);
+
+	sfiles = as_dir_scanner_scan (datadir, "appdata.xml", AS_DIR_SCAN_FLAG_WITH_STAT, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (sfiles->len, ==, 1);
+	sfile = (AsScannedFile*) g_ptr_array_index (sfiles, 0);
+
+	manifest = as_metainfo_manifest_new ();
+	g_assert_cmpstr (as_metainfo_manifest_get_id (manifest, sfile), ==, "firefox.desktop");
+	g_assert (as_metainfo_manifest_is_dirty (manifest));
+	as_metainfo_manifest_save (manifest, "/tmp/as-unittest-metainfo-manifest.gv", &error);
+	g_assert_no_error (error);
+	g_clear_pointer (&manifest, as_metainfo_manifest_free);
+
+	/* known files don't need to be read again */
+	manifest = as_metainfo_manifest_new ();
+	as_metainfo_manifest_load (manifest, "/tmp/as-unittest-metainfo-manifest.gv", &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (as_metainfo_manifest_get_id (manifest, sfile), ==, "firefox.desktop");
+	g_assert (!as_metainfo_manifest_is_dirty (manifest));
+
+	/* modified files are skimmed again */
+	sfile->size++;
+	g_assert_cmpstr (as_metainfo_manifest_get_id (manifest, sfile), ==, "firefox.desktop");
+	g_assert (as_metainfo_manifest_is_dirty (manifest));
+}
+
 /**
  * test_pool_read:
  *
@@ -396,6 +803,823 @@ test_pool_read ()
 	g_ptr_array_unref (result);
 }
 
+typedef struct {
+	GMainLoop	*loop;
+	GAsyncResult	*result;
+	AsPoolLoadPhase	last_phase;
+	guint		n_reports;
+	gboolean	progress_freed;
+} AsTestLoadData;
+
+/**
+ * test_pool_load_progress_cb:
+ */
+static void
+test_pool_load_progress_cb (AsPoolLoadPhase phase, guint files_scanned, guint components_parsed, gpointer user_data)
+{
+	AsTestLoadData *data = (AsTestLoadData*) user_data;
+
+	g_assert_cmpint (phase, >=, data->last_phase);
+	data->last_phase = phase;
+	data->n_reports++;
+}
+
+/**
+ * test_pool_load_progress_free_cb:
+ */
+static void
+test_pool_load_progress_free_cb (gpointer user_data)
+{
+	AsTestLoadData *data = (AsTestLoadData*) user_data;
+
+	g_assert (!data->progress_freed);
+	data->progress_freed = TRUE;
+}
+
+/**
+ * test_pool_load_ready_cb:
+ */
+static void
+test_pool_load_ready_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	AsTestLoadData *data = (AsTestLoadData*) user_data;
+
+	data->result = g_object_ref (result);
+	g_main_loop_quit (data->loop);
+}
+
+/**
+ * test_pool_load_async:
+ *
+ * Test loading the pool asynchronously, and cancelling a load.
+ */
+static void
+test_pool_load_async ()
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(GPtrArray) all_cpts = NULL;
+	g_autoptr(GCancellable) cancellable = NULL;
+	g_autoptr(GMainLoop) loop = NULL;
+	AsTestLoadData data = { NULL, NULL, AS_POOL_LOAD_PHASE_UNKNOWN, 0, FALSE };
+	GError *error = NULL;
+
+	dpool = test_get_sampledata_pool (FALSE);
+	loop = g_main_loop_new (NULL, FALSE);
+	data.loop = loop;
+
+	as_pool_load_async (dpool,
+			    test_pool_load_progress_cb, &data, test_pool_load_progress_free_cb,
+			    NULL,
+			    test_pool_load_ready_cb, &data);
+	g_main_loop_run (loop);
+
+	/* the pool only has the data once the load is finished */
+	all_cpts = as_pool_get_components (dpool);
+	g_assert_cmpint (all_cpts->len, ==, 0);
+	g_ptr_array_unref (all_cpts);
+
+	g_assert (as_pool_load_finish (dpool, data.result, &error));
+	g_assert_no_error (error);
+	g_clear_object (&data.result);
+	all_cpts = as_pool_get_components (dpool);
+	g_assert_cmpint (all_cpts->len, ==, 18);
+
+	/* progress is reported up to the end of the load */
+	while (g_main_context_iteration (NULL, FALSE));
+	g_assert_cmpint (data.n_reports, >, 0);
+	g_assert_cmpint (data.last_phase, ==, AS_POOL_LOAD_PHASE_DONE);
+	g_assert (data.progress_freed);
+
+	/* a cancelled load leaves the pool untouched */
+	cancellable = g_cancellable_new ();
+	g_cancellable_cancel (cancellable);
+	as_pool_load_async (dpool,
+			    NULL, NULL, NULL,
+			    cancellable,
+			    test_pool_load_ready_cb, &data);
+	g_main_loop_run (loop);
+
+	g_assert (!as_pool_load_finish (dpool, data.result, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_clear_error (&error);
+	g_clear_object (&data.result);
+	g_ptr_array_unref (all_cpts);
+	all_cpts = as_pool_get_components (dpool);
+	g_assert_cmpint (all_cpts->len, ==, 18);
+
+	g_assert (!as_pool_load (dpool, cancellable, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_clear_error (&error);
+	g_ptr_array_unref (all_cpts);
+	all_cpts = as_pool_get_components (dpool);
+	g_assert_cmpint (all_cpts->len, ==, 18);
+}
+
+typedef struct {
+	gboolean	timed_out;
+	guint		n_added;
+	guint		n_removed;
+	guint		n_changed;
+} AsTestMonitorData;
+
+/**
+ * test_monitor_components_cb:
+ */
+static void
+test_monitor_components_cb (AsPool *pool, GPtrArray *cpts, guint *counter)
+{
+	*counter += cpts->len;
+}
+
+/**
+ * test_monitor_timeout_cb:
+ */
+static gboolean
+test_monitor_timeout_cb (gpointer user_data)
+{
+	AsTestMonitorData *data = (AsTestMonitorData*) user_data;
+	data->timed_out = TRUE;
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * test_monitor_wait:
+ *
+ * Iterate the main context until the pool has emitted a change.
+ */
+static void
+test_monitor_wait (AsTestMonitorData *data)
+{
+	guint timeout_id;
+	guint n_events = data->n_added + data->n_removed + data->n_changed;
+
+	data->timed_out = FALSE;
+	timeout_id = g_timeout_add_seconds (10, test_monitor_timeout_cb, data);
+	while (!data->timed_out && (data->n_added + data->n_removed + data->n_changed == n_events))
+		g_main_context_iteration (NULL, TRUE);
+	if (!data->timed_out)
+		g_source_remove (timeout_id);
+}
+
+/**
+ * test_pool_monitor:
+ *
+ * Test updating the pool when monitored metadata files change.
+ */
+static void
+test_pool_monitor ()
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *xmldir = NULL;
+	g_autofree gchar *first_fname = NULL;
+	g_autofree gchar *second_fname = NULL;
+	g_autofree gchar *addon_fname = NULL;
+	AsTestMonitorData data = { FALSE, 0, 0, 0 };
+	GError *error = NULL;
+	const gchar *cpt_xml = "<components version=\"0.10\" origin=\"test\">\n"
+				"  <component type=\"generic\">\n"
+				"    <id>org.example.%s</id>\n"
+				"    <name>%s</name>\n"
+				"    <summary>A test component</summary>\n"
+				"  </component>\n"
+				"</components>\n";
+	const gchar *addon_xml = "<components version=\"0.10\" origin=\"test\">\n"
+				"  <component type=\"addon\">\n"
+				"    <id>org.example.Plugin</id>\n"
+				"    <extends>org.example.First</extends>\n"
+				"    <name>Plugin</name>\n"
+				"    <summary>A test addon</summary>\n"
+				"  </component>\n"
+				"</components>\n";
+
+	tmpdir = g_dir_make_tmp ("as-unittest-monitor-XXXXXX", &error);
+	g_assert_no_error (error);
+	xmldir = g_build_filename (tmpdir, "xml", NULL);
+	g_mkdir (xmldir, 0755);
+	first_fname = g_build_filename (xmldir, "first.xml", NULL);
+	second_fname = g_build_filename (xmldir, "second.xml", NULL);
+	addon_fname = g_build_filename (xmldir, "addon.xml", NULL);
+
+	{
+		g_autofree gchar *xml = g_strdup_printf (cpt_xml, "First", "First");
+		g_file_set_contents (first_fname, xml, -1, &error);
+		g_assert_no_error (error);
+	}
+
+	dpool = as_pool_new ();
+	as_pool_clear_metadata_locations (dpool);
+	as_pool_add_metadata_location (dpool, tmpdir);
+	as_pool_set_locale (dpool, "C");
+	as_pool_set_cache_flags (dpool, AS_CACHE_FLAG_NONE);
+	as_pool_set_flags (dpool, AS_POOL_FLAG_READ_COLLECTION | AS_POOL_FLAG_MONITOR);
+	as_pool_load (dpool, NULL, &error);
+	g_assert_no_error (error);
+
+	g_signal_connect (dpool, "components-added", G_CALLBACK (test_monitor_components_cb), &data.n_added);
+	g_signal_connect (dpool, "components-removed", G_CALLBACK (test_monitor_components_cb), &data.n_removed);
+	g_signal_connect (dpool, "components-changed", G_CALLBACK (test_monitor_components_cb), &data.n_changed);
+
+	/* new file */
+	{
+		g_autofree gchar *xml = g_strdup_printf (cpt_xml, "Second", "Second");
+		g_file_set_contents (second_fname, xml, -1, &error);
+		g_assert_no_error (error);
+	}
+	test_monitor_wait (&data);
+	g_assert_cmpint (data.n_added, ==, 1);
+	result = as_pool_get_components_by_id (dpool, "org.example.Second");
+	g_assert_cmpint (result->len, ==, 1);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	/* modified file */
+	{
+		g_autofree gchar *xml = g_strdup_printf (cpt_xml, "First", "First Renamed");
+		g_file_set_contents (first_fname, xml, -1, &error);
+		g_assert_no_error (error);
+	}
+	test_monitor_wait (&data);
+	g_assert_cmpint (data.n_changed, ==, 1);
+	result = as_pool_get_components_by_id (dpool, "org.example.First");
+	g_assert_cmpint (result->len, ==, 1);
+	g_assert_cmpstr (as_component_get_name (AS_COMPONENT (g_ptr_array_index (result, 0))), ==, "First Renamed");
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	/* removed file */
+	g_remove (second_fname);
+	test_monitor_wait (&data);
+	g_assert_cmpint (data.n_removed, ==, 1);
+	result = as_pool_get_components_by_id (dpool, "org.example.Second");
+	g_assert_cmpint (result->len, ==, 0);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	g_assert_cmpint (data.n_added, ==, 1);
+	g_assert_cmpint (data.n_changed, ==, 1);
+
+	/* new addon, which is linked to the component it extends */
+	g_file_set_contents (addon_fname, addon_xml, -1, &error);
+	g_assert_no_error (error);
+	test_monitor_wait (&data);
+	g_assert_cmpint (data.n_added, ==, 2);
+	result = as_pool_get_components_by_id (dpool, "org.example.First");
+	g_assert_cmpint (result->len, ==, 1);
+	g_assert_cmpint (as_component_get_addons (AS_COMPONENT (g_ptr_array_index (result, 0)))->len, ==, 1);
+	g_clear_pointer (&result, g_ptr_array_unref);
+	result = as_pool_get_linked_by (dpool, "org.example.First", AS_POOL_LINK_KIND_EXTENDS);
+	g_assert_cmpint (result->len, ==, 1);
+	g_assert_cmpstr (as_component_get_id (AS_COMPONENT (g_ptr_array_index (result, 0))), ==, "org.example.Plugin");
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	/* removed addon, which is not linked anymore */
+	g_remove (addon_fname);
+	test_monitor_wait (&data);
+	g_assert_cmpint (data.n_removed, ==, 2);
+	result = as_pool_get_components_by_id (dpool, "org.example.First");
+	g_assert_cmpint (result->len, ==, 1);
+	g_assert_cmpint (as_component_get_addons (AS_COMPONENT (g_ptr_array_index (result, 0)))->len, ==, 0);
+	g_clear_pointer (&result, g_ptr_array_unref);
+	result = as_pool_get_linked_by (dpool, "org.example.First", AS_POOL_LINK_KIND_EXTENDS);
+	g_assert_cmpint (result->len, ==, 0);
+
+	g_remove (first_fname);
+	g_rmdir (xmldir);
+	g_rmdir (tmpdir);
+}
+
+/**
+ * test_search_thread:
+ *
+ * Run the same searches many times, and check that the results never change.
+ */
+static gpointer
+test_search_thread (gpointer user_data)
+{
+	AsPool *pool = AS_POOL (user_data);
+	const gchar *queries[] = { "logic", "scalable graphics", "kig", "sh", NULL };
+	const guint expected_len[] = { 2, 1, 1, 18 };
+	guint i, j;
+
+	for (i = 0; i < 100; i++) {
+		for (j = 0; queries[j] != NULL; j++) {
+			g_autoptr(GPtrArray) result = as_pool_search (pool, queries[j]);
+			g_assert_cmpint (result->len, ==, expected_len[j]);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * test_pool_concurrent_read:
+ *
+ * Test querying the pool from several threads, while its data is reloaded.
+ */
+static void
+test_pool_concurrent_read ()
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	GThread *threads[4];
+	guint i;
+	g_autoptr(GError) error = NULL;
+
+	dpool = test_get_sampledata_pool (FALSE);
+	as_pool_load (dpool, NULL, &error);
+	g_assert_no_error (error);
+
+	for (i = 0; i < G_N_ELEMENTS (threads); i++)
+		threads[i] = g_thread_new ("as-test-search", test_search_thread, dpool);
+
+	/* readers keep seeing complete data while a new generation is swapped in */
+	for (i = 0; i < 3; i++) {
+		as_pool_load (dpool, NULL, &error);
+		g_assert_no_error (error);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (threads); i++)
+		g_thread_join (threads[i]);
+
+	result = as_pool_get_components (dpool);
+	g_assert_cmpint (result->len, ==, 18);
+}
+
+/**
+ * test_composite_add_cpt:
+ */
+static void
+test_composite_add_cpt (AsPool *pool, const gchar *cid, const gchar *name, gint priority)
+{
+	g_autoptr(AsComponent) cpt = NULL;
+	g_autoptr(GError) error = NULL;
+
+	cpt = as_component_new ();
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_GENERIC);
+	as_component_set_id (cpt, cid);
+	as_component_set_name (cpt, name, "C");
+	as_component_set_summary (cpt, "A test component", "C");
+	as_component_set_priority (cpt, priority);
+	as_pool_add_component (pool, cpt, &error);
+	g_assert_no_error (error);
+}
+
+/**
+ * test_composite_pool:
+ *
+ * Test querying several pools stacked in a composite pool.
+ */
+static void
+test_composite_pool ()
+{
+	g_autoptr(AsCompositePool) cpool = NULL;
+	g_autoptr(AsPool) low = NULL;
+	g_autoptr(AsPool) high = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	AsComponent *cpt;
+
+	low = as_pool_new ();
+	as_pool_set_locale (low, "C");
+	test_composite_add_cpt (low, "org.example.Foo", "Foo Low", 10);
+	test_composite_add_cpt (low, "org.example.Bar", "Bar Low", 0);
+
+	high = as_pool_new ();
+	as_pool_set_locale (high, "C");
+	test_composite_add_cpt (high, "org.example.Foo", "Foo High", 0);
+	test_composite_add_cpt (high, "org.example.Bar", "Bar High", 0);
+	test_composite_add_cpt (high, "org.example.Baz", "Baz High", 0);
+
+	cpool = as_composite_pool_new ();
+	as_composite_pool_add_layer (cpool, low, 0);
+	as_composite_pool_add_layer (cpool, high, 10);
+
+	result = as_composite_pool_get_layers (cpool);
+	g_assert_cmpint (result->len, ==, 2);
+	g_assert (g_ptr_array_index (result, 0) == high);
+	g_ptr_array_unref (result);
+
+	result = as_composite_pool_get_components (cpool);
+	g_assert_cmpint (result->len, ==, 3);
+	g_ptr_array_unref (result);
+
+	/* the component priority decides first */
+	result = as_composite_pool_get_components_by_id (cpool, "org.example.Foo");
+	g_assert_cmpint (result->len, ==, 1);
+	cpt = AS_COMPONENT (g_ptr_array_index (result, 0));
+	g_assert_cmpstr (as_component_get_name (cpt), ==, "Foo Low");
+	g_ptr_array_unref (result);
+
+	/* ...and the layer priority if the components are equal */
+	result = as_composite_pool_get_components_by_id (cpool, "org.example.Bar");
+	g_assert_cmpint (result->len, ==, 1);
+	cpt = AS_COMPONENT (g_ptr_array_index (result, 0));
+	g_assert_cmpstr (as_component_get_name (cpt), ==, "Bar High");
+	g_ptr_array_unref (result);
+
+	result = as_composite_pool_search (cpool, "baz");
+	g_assert_cmpint (result->len, ==, 1);
+	g_ptr_array_unref (result);
+
+	/* a layer can be changed without touching the others */
+	as_pool_clear (high);
+	result = as_composite_pool_get_components (cpool);
+	g_assert_cmpint (result->len, ==, 2);
+	g_ptr_array_unref (result);
+
+	g_assert (as_composite_pool_remove_layer (cpool, low));
+	g_assert (!as_composite_pool_remove_layer (cpool, low));
+	result = as_composite_pool_get_components (cpool);
+	g_assert_cmpint (result->len, ==, 0);
+}
+
+/**
+ * test_pool_diff_check:
+ *
+ * Check that a delta contains exactly one component of each kind of change.
+ */
+static void
+test_pool_diff_check (AsPoolDelta *delta)
+{
+	GPtrArray *cpts;
+
+	cpts = as_pool_delta_get_added (delta);
+	g_assert_cmpint (cpts->len, ==, 1);
+	g_assert_cmpstr (as_component_get_id (AS_COMPONENT (g_ptr_array_index (cpts, 0))), ==, "org.example.Delta4");
+
+	cpts = as_pool_delta_get_removed (delta);
+	g_assert_cmpint (cpts->len, ==, 1);
+	g_assert_cmpstr (as_component_get_id (AS_COMPONENT (g_ptr_array_index (cpts, 0))), ==, "org.example.Delta3");
+
+	cpts = as_pool_delta_get_changed (delta);
+	g_assert_cmpint (cpts->len, ==, 1);
+	g_assert_cmpstr (as_component_get_id (AS_COMPONENT (g_ptr_array_index (cpts, 0))), ==, "org.example.Delta2");
+	g_assert_cmpstr (as_component_get_name (AS_COMPONENT (g_ptr_array_index (cpts, 0))), ==, "Delta 2 (new)");
+}
+
+/**
+ * test_pool_diff:
+ *
+ * Test computing the changes between two pools and two cache files.
+ */
+static void
+test_pool_diff ()
+{
+	g_autoptr(AsPool) old_pool = NULL;
+	g_autoptr(AsPool) new_pool = NULL;
+	g_autoptr(AsPoolDelta) delta = NULL;
+	g_autoptr(GError) error = NULL;
+
+	old_pool = as_pool_new ();
+	as_pool_set_locale (old_pool, "C");
+	test_composite_add_cpt (old_pool, "org.example.Delta1", "Delta 1", 0);
+	test_composite_add_cpt (old_pool, "org.example.Delta2", "Delta 2", 0);
+	test_composite_add_cpt (old_pool, "org.example.Delta3", "Delta 3", 0);
+
+	new_pool = as_pool_new ();
+	as_pool_set_locale (new_pool, "C");
+	test_composite_add_cpt (new_pool, "org.example.Delta1", "Delta 1", 0);
+	test_composite_add_cpt (new_pool, "org.example.Delta2", "Delta 2 (new)", 0);
+	test_composite_add_cpt (new_pool, "org.example.Delta4", "Delta 4", 0);
+
+	delta = as_pool_diff (old_pool, new_pool);
+	test_pool_diff_check (delta);
+	g_clear_pointer (&delta, as_pool_delta_unref);
+
+	/* nothing changed between a pool and itself */
+	delta = as_pool_diff (new_pool, new_pool);
+	g_assert_cmpint (as_pool_delta_get_added (delta)->len, ==, 0);
+	g_assert_cmpint (as_pool_delta_get_removed (delta)->len, ==, 0);
+	g_assert_cmpint (as_pool_delta_get_changed (delta)->len, ==, 0);
+	g_clear_pointer (&delta, as_pool_delta_unref);
+
+	/* the same works on cache files */
+	as_pool_save_cache_file (old_pool, "/tmp/as-unittest-diff-old.gvz", &error);
+	g_assert_no_error (error);
+	as_pool_save_cache_file (new_pool, "/tmp/as-unittest-diff-new.gvz", &error);
+	g_assert_no_error (error);
+
+	delta = as_pool_diff_cache_files ("/tmp/as-unittest-diff-old.gvz",
+					  "/tmp/as-unittest-diff-new.gvz",
+					  &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (delta);
+	test_pool_diff_check (delta);
+	g_clear_pointer (&delta, as_pool_delta_unref);
+
+	delta = as_pool_diff_cache_files ("/tmp/as-unittest-diff-old.gvz",
+					  "/tmp/as-unittest-diff-missing.gvz",
+					  &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null (delta);
+}
+
+/**
+ * test_pool_relations_check:
+ */
+static void
+test_pool_relations_check (AsPool *pool)
+{
+	g_autoptr(GPtrArray) result = NULL;
+
+	result = as_pool_get_linked_by (pool, "org.example.Base", AS_POOL_LINK_KIND_EXTENDS);
+	g_assert_cmpint (result->len, ==, 2);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	result = as_pool_get_linked (pool, "org.example.AddonA", AS_POOL_LINK_KIND_EXTENDS);
+	g_assert_cmpint (result->len, ==, 1);
+	g_assert_cmpstr (as_component_get_id (AS_COMPONENT (g_ptr_array_index (result, 0))), ==, "org.example.Base");
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	result = as_pool_get_linked (pool, "org.example.App", AS_POOL_LINK_KIND_REQUIRES);
+	g_assert_cmpint (result->len, ==, 1);
+	g_assert_cmpstr (as_component_get_id (AS_COMPONENT (g_ptr_array_index (result, 0))), ==, "org.example.AddonA");
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	result = as_pool_get_linked_by (pool, "org.example.Base", AS_POOL_LINK_KIND_SUGGESTS);
+	g_assert_cmpint (result->len, ==, 1);
+	g_assert_cmpstr (as_component_get_id (AS_COMPONENT (g_ptr_array_index (result, 0))), ==, "org.example.App");
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	result = as_pool_get_linked_by (pool, "org.example.App", AS_POOL_LINK_KIND_RECOMMENDS);
+	g_assert_cmpint (result->len, ==, 0);
+}
+
+/**
+ * test_pool_relations:
+ *
+ * Test finding related components through the relations graph of the pool.
+ */
+static void
+test_pool_relations ()
+{
+	g_autoptr(AsPool) pool = NULL;
+	g_autoptr(AsPool) cpool = NULL;
+	g_autoptr(AsComponent) cpt = NULL;
+	g_autoptr(AsSuggested) suggested = NULL;
+	g_autoptr(AsRelation) relation = NULL;
+	g_autoptr(AsBundle) bundle = NULL;
+	g_autoptr(GPtrArray) base = NULL;
+	g_autoptr(GError) error = NULL;
+	guint i;
+
+	pool = as_pool_new ();
+	as_pool_set_locale (pool, "C");
+	test_composite_add_cpt (pool, "org.example.Base", "Base", 0);
+
+	cpt = as_component_new ();
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_ADDON);
+	as_component_set_id (cpt, "org.example.AddonA");
+	as_component_set_name (cpt, "Addon A", "C");
+	as_component_set_summary (cpt, "A test addon", "C");
+	as_component_add_extends (cpt, "org.example.Missing");
+	as_component_add_extends (cpt, "org.example.Base");
+	as_pool_add_component (pool, cpt, &error);
+	g_assert_no_error (error);
+	g_clear_object (&cpt);
+
+	cpt = as_component_new ();
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_ADDON);
+	as_component_set_id (cpt, "org.example.AddonB");
+	as_component_set_name (cpt, "Addon B", "C");
+	as_component_set_summary (cpt, "A test addon", "C");
+	as_component_add_extends (cpt, "org.example.Base");
+	as_pool_add_component (pool, cpt, &error);
+	g_assert_no_error (error);
+	g_clear_object (&cpt);
+
+	cpt = as_component_new ();
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_GENERIC);
+	as_component_set_id (cpt, "org.example.App");
+	as_component_set_name (cpt, "App", "C");
+	as_component_set_summary (cpt, "A test application", "C");
+	suggested = as_suggested_new ();
+	as_suggested_set_kind (suggested, AS_SUGGESTED_KIND_UPSTREAM);
+	as_suggested_add_id (suggested, "org.example.Base");
+	as_component_add_suggested (cpt, suggested);
+	relation = as_relation_new ();
+	as_relation_set_kind (relation, AS_RELATION_KIND_REQUIRES);
+	as_relation_set_item_kind (relation, AS_RELATION_ITEM_KIND_ID);
+	as_relation_set_value (relation, "org.example.AddonA");
+	as_component_add_relation (cpt, relation);
+	as_pool_add_component (pool, cpt, &error);
+	g_assert_no_error (error);
+
+	/* the relations are found in a pool we added data to */
+	test_pool_relations_check (pool);
+
+	/* and in a pool reading them back from the cache */
+	as_pool_save_cache_file (pool, "/tmp/as-unittest-relations.gvz", &error);
+	g_assert_no_error (error);
+
+	cpool = as_pool_new ();
+	as_pool_set_locale (cpool, "C");
+	as_pool_load_cache_file (cpool, "/tmp/as-unittest-relations.gvz", &error);
+	g_assert_no_error (error);
+	test_pool_relations_check (cpool);
+
+	/* all addons were linked, even though the first component AddonA extends is missing */
+	base = as_pool_get_components_by_id (cpool, "org.example.Base");
+	g_assert_cmpint (base->len, ==, 1);
+	g_assert_cmpint (as_component_get_addons (AS_COMPONENT (g_ptr_array_index (base, 0)))->len, ==, 2);
+	g_clear_pointer (&base, g_ptr_array_unref);
+	g_clear_object (&cpool);
+
+	/* packaged addons do not extend a Flatpak build of the same application */
+	g_clear_object (&cpt);
+	cpt = as_component_new ();
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_GENERIC);
+	as_component_set_id (cpt, "org.example.Base");
+	as_component_set_name (cpt, "Base", "C");
+	as_component_set_summary (cpt, "A test component", "C");
+	as_component_set_origin (cpt, "flathub");
+	bundle = as_bundle_new ();
+	as_bundle_set_kind (bundle, AS_BUNDLE_KIND_FLATPAK);
+	as_bundle_set_id (bundle, "app/org.example.Base/x86_64/stable");
+	as_component_add_bundle (cpt, bundle);
+	as_pool_add_component (pool, cpt, &error);
+	g_assert_no_error (error);
+
+	as_pool_save_cache_file (pool, "/tmp/as-unittest-relations.gvz", &error);
+	g_assert_no_error (error);
+
+	cpool = as_pool_new ();
+	as_pool_set_locale (cpool, "C");
+	as_pool_load_cache_file (cpool, "/tmp/as-unittest-relations.gvz", &error);
+	g_assert_no_error (error);
+
+	base = as_pool_get_components_by_id (cpool, "org.example.Base");
+	g_assert_cmpint (base->len, ==, 2);
+	for (i = 0; i < base->len; i++) {
+		AsComponent *bcpt = AS_COMPONENT (g_ptr_array_index (base, i));
+
+		if (g_strcmp0 (as_component_get_origin (bcpt), "flathub") == 0)
+			g_assert_cmpint (as_component_get_addons (bcpt)->len, ==, 0);
+		else
+			g_assert_cmpint (as_component_get_addons (bcpt)->len, ==, 2);
+	}
+}
+
+/**
+ * test_foreach_count_cb:
+ */
+static gboolean
+test_foreach_count_cb (AsComponent *cpt, gpointer user_data)
+{
+	guint *count = (guint*) user_data;
+	*count += 1;
+	return *count < 5;
+}
+
+/**
+ * test_view_filter_cb:
+ */
+static gboolean
+test_view_filter_cb (AsComponent *cpt, gpointer user_data)
+{
+	return as_component_get_kind (cpt) == AS_COMPONENT_KIND_DESKTOP_APP;
+}
+
+/**
+ * test_pool_foreach:
+ *
+ * Test iterating over the pool and borrowed views of its contents.
+ */
+static void
+test_pool_foreach ()
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(AsPoolView) view = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	guint count = 0;
+	guint i;
+	g_autoptr(GError) error = NULL;
+
+	dpool = test_get_sampledata_pool (FALSE);
+	as_pool_load (dpool, NULL, &error);
+	g_assert_no_error (error);
+
+	/* the iteration stops once the callback returns FALSE */
+	as_pool_foreach (dpool, test_foreach_count_cb, &count);
+	g_assert_cmpint (count, ==, 5);
+
+	view = as_pool_get_view (dpool, NULL, NULL);
+	g_assert_cmpint (as_pool_view_get_size (view), ==, 18);
+	g_clear_pointer (&view, as_pool_view_unref);
+
+	view = as_pool_get_view (dpool, test_view_filter_cb, NULL);
+	result = as_pool_get_components_by_kind (dpool, AS_COMPONENT_KIND_DESKTOP_APP);
+	g_assert_cmpint (as_pool_view_get_size (view), ==, result->len);
+
+	/* the view stays valid when the pool changes */
+	as_pool_clear (dpool);
+	for (i = 0; i < as_pool_view_get_size (view); i++) {
+		AsComponent *cpt = as_pool_view_index (view, i);
+		g_assert_cmpint (as_component_get_kind (cpt), ==, AS_COMPONENT_KIND_DESKTOP_APP);
+	}
+	g_clear_pointer (&view, as_pool_view_unref);
+
+	view = as_pool_get_view (dpool, NULL, NULL);
+	g_assert_cmpint (as_pool_view_get_size (view), ==, 0);
+}
+
+/**
+ * test_pool_map_pkgnames:
+ *
+ * Test finding the components of many packages at once.
+ */
+static void
+test_pool_map_pkgnames ()
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(AsComponent) cpt = NULL;
+	g_autoptr(GHashTable) pkg_map = NULL;
+	g_autoptr(GPtrArray) installed = NULL;
+	GPtrArray *pkg_cpts;
+	gchar *pkgnames[] = { "kig", "inkscape", "no-such-package", NULL };
+	gchar *multi_pkgnames[] = { "multi-data", "multi-bin", NULL };
+	g_autoptr(GError) error = NULL;
+
+	dpool = test_get_sampledata_pool (FALSE);
+	as_pool_load (dpool, NULL, &error);
+	g_assert_no_error (error);
+
+	pkg_map = as_pool_map_pkgnames (dpool, pkgnames, &installed);
+	g_assert_cmpint (g_hash_table_size (pkg_map), ==, 2);
+	pkg_cpts = g_hash_table_lookup (pkg_map, "kig");
+	g_assert_nonnull (pkg_cpts);
+	g_assert_cmpint (pkg_cpts->len, ==, 1);
+	g_assert_cmpstr (as_component_get_pkgnames (AS_COMPONENT (g_ptr_array_index (pkg_cpts, 0)))[0], ==, "kig");
+	g_assert_null (g_hash_table_lookup (pkg_map, "no-such-package"));
+	g_assert_cmpint (installed->len, ==, 2);
+	g_clear_pointer (&pkg_map, g_hash_table_unref);
+	g_clear_pointer (&installed, g_ptr_array_unref);
+
+	/* a component is only installed if all of its packages are */
+	cpt = as_component_new ();
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_GENERIC);
+	as_component_set_id (cpt, "org.example.Multi");
+	as_component_set_name (cpt, "Multi", "C");
+	as_component_set_summary (cpt, "A component in several packages", "C");
+	as_component_set_pkgnames (cpt, multi_pkgnames);
+	as_pool_add_component (dpool, cpt, &error);
+	g_assert_no_error (error);
+
+	multi_pkgnames[1] = NULL;
+	pkg_map = as_pool_map_pkgnames (dpool, multi_pkgnames, &installed);
+	g_assert_cmpint (g_hash_table_size (pkg_map), ==, 1);
+	g_assert_cmpint (installed->len, ==, 0);
+	g_clear_pointer (&pkg_map, g_hash_table_unref);
+	g_clear_pointer (&installed, g_ptr_array_unref);
+
+	multi_pkgnames[1] = "multi-bin";
+	pkg_map = as_pool_map_pkgnames (dpool, multi_pkgnames, &installed);
+	g_assert_cmpint (g_hash_table_size (pkg_map), ==, 2);
+	g_assert_cmpint (installed->len, ==, 1);
+	g_assert (g_ptr_array_index (installed, 0) == (gpointer) cpt);
+}
+
+/**
+ * test_pool_string_stats:
+ *
+ * Test that repeated strings are shared between components.
+ */
+static void
+test_pool_string_stats ()
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	AsComponent *cpt1;
+	AsComponent *cpt2;
+	guint n_strings;
+	gsize saved_bytes;
+	gsize saved_bytes_loaded;
+	g_autoptr(GError) error = NULL;
+
+	dpool = test_get_sampledata_pool (FALSE);
+	as_pool_load (dpool, NULL, &error);
+	g_assert_no_error (error);
+
+	as_utils_get_string_stats (&n_strings, &saved_bytes_loaded);
+	g_assert_cmpint (n_strings, >, 0);
+	g_assert_cmpint (saved_bytes_loaded, >, 0);
+
+	/* components of the same file share one copy of their origin */
+	cpts = as_pool_get_components_by_id (dpool, "org.inkscape.Inkscape");
+	g_assert_cmpint (cpts->len, ==, 1);
+	cpt1 = AS_COMPONENT (g_ptr_array_index (cpts, 0));
+	g_clear_pointer (&cpts, g_ptr_array_unref);
+	cpts = as_pool_get_components_by_id (dpool, "kig.desktop");
+	g_assert_cmpint (cpts->len, ==, 1);
+	cpt2 = AS_COMPONENT (g_ptr_array_index (cpts, 0));
+	g_assert_nonnull (as_component_get_origin (cpt1));
+	g_assert (as_component_get_origin (cpt1) == as_component_get_origin (cpt2));
+	g_clear_pointer (&cpts, g_ptr_array_unref);
+
+	/* the memory is given back with the data */
+	g_clear_object (&dpool);
+	as_intern_get_stats (NULL, &saved_bytes);
+	g_assert_cmpint (saved_bytes, <, saved_bytes_loaded);
+}
+
 /**
  * test_merge_components:
  *
@@ -448,6 +1672,70 @@ test_merge_components ()
 	g_assert_cmpstr (as_component_get_name (cpt), ==, "Kiki (name changed by merge)");
 }
 
+/**
+ * test_merge_components_all:
+ *
+ * Test that a merge component is applied to all components with its ID,
+ * when it is loaded together with them.
+ */
+static void
+test_merge_components_all ()
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *xmldir = NULL;
+	g_autofree gchar *fname = NULL;
+	GError *error = NULL;
+	guint i;
+	const gchar *xml = "<components version=\"0.10\" origin=\"test\">\n"
+			   "  <component type=\"desktop-application\">\n"
+			   "    <id>org.example.Merged</id>\n"
+			   "    <name>Package</name>\n"
+			   "    <summary>A test component</summary>\n"
+			   "    <pkgname>merged</pkgname>\n"
+			   "  </component>\n"
+			   "  <component type=\"desktop-application\">\n"
+			   "    <id>org.example.Merged</id>\n"
+			   "    <name>Flatpak</name>\n"
+			   "    <summary>A test component</summary>\n"
+			   "    <bundle type=\"flatpak\">app/org.example.Merged/x86_64/stable</bundle>\n"
+			   "  </component>\n"
+			   "  <component merge=\"replace\">\n"
+			   "    <id>org.example.Merged</id>\n"
+			   "    <name>Renamed by merge</name>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	tmpdir = g_dir_make_tmp ("as-unittest-merge-XXXXXX", &error);
+	g_assert_no_error (error);
+	xmldir = g_build_filename (tmpdir, "xml", NULL);
+	g_mkdir (xmldir, 0755);
+	fname = g_build_filename (xmldir, "merge.xml", NULL);
+	g_file_set_contents (fname, xml, -1, &error);
+	g_assert_no_error (error);
+
+	dpool = as_pool_new ();
+	as_pool_clear_metadata_locations (dpool);
+	as_pool_add_metadata_location (dpool, tmpdir);
+	as_pool_set_locale (dpool, "C");
+	as_pool_set_cache_flags (dpool, AS_CACHE_FLAG_NONE);
+	as_pool_set_flags (dpool, AS_POOL_FLAG_READ_COLLECTION);
+	g_assert (as_pool_load (dpool, NULL, &error));
+	g_assert_no_error (error);
+
+	result = as_pool_get_components_by_id (dpool, "org.example.Merged");
+	g_assert_cmpint (result->len, ==, 2);
+	for (i = 0; i < result->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (result, i));
+		g_assert_cmpstr (as_component_get_name (cpt), ==, "Renamed by merge");
+	}
+
+	g_remove (fname);
+	g_rmdir (xmldir);
+	g_rmdir (tmpdir);
+}
+
 /**
  * main:
  */
@@ -473,9 +1761,23 @@ main (int argc, char **argv)
 	g_log_set_fatal_mask (NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
 
 	g_test_add_func ("/AppStream/PoolRead", test_pool_read);
+	g_test_add_func ("/AppStream/PoolLoadAsync", test_pool_load_async);
+	g_test_add_func ("/AppStream/PoolMonitor", test_pool_monitor);
+	g_test_add_func ("/AppStream/PoolConcurrentRead", test_pool_concurrent_read);
+	g_test_add_func ("/AppStream/CompositePool", test_composite_pool);
+	g_test_add_func ("/AppStream/PoolDiff", test_pool_diff);
+	g_test_add_func ("/AppStream/PoolRelations", test_pool_relations);
+	g_test_add_func ("/AppStream/PoolForeach", test_pool_foreach);
+	g_test_add_func ("/AppStream/PoolMapPkgnames", test_pool_map_pkgnames);
+	g_test_add_func ("/AppStream/PoolStringStats", test_pool_string_stats);
 	g_test_add_func ("/AppStream/CacheFile", test_cache_file);
 	g_test_add_func ("/AppStream/Cache", test_cache);
+	g_test_add_func ("/AppStream/CacheMemoryBudget", test_cache_memory_budget);
+	g_test_add_func ("/AppStream/ContentSharing", test_content_sharing);
+	g_test_add_func ("/AppStream/DesktopCache", test_desktop_cache);
+	g_test_add_func ("/AppStream/MetainfoManifest", test_metainfo_manifest);
 	g_test_add_func ("/AppStream/Merges", test_merge_components);
+	g_test_add_func ("/AppStream/MergesAll", test_merge_components_all);
 
 	ret = g_test_run ();
 	g_free (datadir);
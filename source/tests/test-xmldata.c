@@ -24,6 +24,7 @@
 #include "appstream.h"
 #include "as-xml.h"
 #include "as-component-private.h"
+#include "as-context-private.h"
 #include "as-test-utils.h"
 
 static gchar *datadir = NULL;
@@ -1292,6 +1293,191 @@ test_xml_write_recommends_requires (void)
 	g_assert (as_test_compare_lines (res, xmldata_recommends_requires));
 }
 
+/**
+ * test_xml_build_collection:
+ *
+ * Build collection XML with @n_cpts similar components.
+ */
+static GString*
+test_xml_build_collection (guint n_cpts)
+{
+	GString *xmldata;
+	guint i;
+
+	xmldata = g_string_new ("<components version=\"0.10\" origin=\"test\" architecture=\"amd64\">\n");
+	for (i = 0; i < n_cpts; i++) {
+		g_string_append_printf (xmldata,
+					"  <component type=\"desktop-application\">\n"
+					"    <id>org.example.App%u</id>\n"
+					"    <name>Application %u</name>\n"
+					"    <name xml:lang=\"de\">Anwendung %u</name>\n"
+					"    <name xml:lang=\"fr\">Application %u</name>\n"
+					"    <summary>Does things</summary>\n"
+					"    <summary xml:lang=\"de\">Macht Dinge</summary>\n"
+					"    <categories>\n"
+					"      <category>Utility</category>\n"
+					"      <category>Network</category>\n"
+					"    </categories>\n"
+					"  </component>\n",
+					i, i, i, i);
+	}
+	g_string_append (xmldata, "</components>\n");
+
+	return xmldata;
+}
+
+/**
+ * test_xml_intern_strings:
+ *
+ * Test that repeated short strings are shared by components
+ * loaded with the same context.
+ */
+static void
+test_xml_intern_strings ()
+{
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(GString) xmldata = NULL;
+	g_autoptr(GError) error = NULL;
+	GPtrArray *cpts;
+	AsComponent *cpt1;
+	AsComponent *cpt2;
+	AsContext *ctx;
+	guint n_requests;
+	guint n_unique;
+	const guint n_cpts = 500;
+
+	xmldata = test_xml_build_collection (n_cpts);
+
+	metad = as_metadata_new ();
+	as_metadata_set_locale (metad, "ALL");
+	as_metadata_parse (metad, xmldata->str, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+
+	cpts = as_metadata_get_components (metad);
+	g_assert_cmpint (cpts->len, ==, n_cpts);
+
+	cpt1 = AS_COMPONENT (g_ptr_array_index (cpts, 0));
+	cpt2 = AS_COMPONENT (g_ptr_array_index (cpts, n_cpts - 1));
+	g_assert (as_component_get_context (cpt1) == as_component_get_context (cpt2));
+	g_assert_cmpstr (as_component_get_origin (cpt2), ==, "test");
+
+	/* categories of both components must reference the same memory */
+	g_assert_cmpint (as_component_get_categories (cpt1)->len, ==, 2);
+	g_assert (g_ptr_array_index (as_component_get_categories (cpt1), 0) ==
+		  g_ptr_array_index (as_component_get_categories (cpt2), 0));
+
+	as_component_set_active_locale (cpt2, "de");
+	g_assert_cmpstr (as_component_get_name (cpt2), ==, "Anwendung 499");
+
+	/* every name, summary and category entry was a request */
+	ctx = as_component_get_context (cpt1);
+	as_context_get_intern_stats (ctx, &n_requests, &n_unique, NULL);
+	g_assert_cmpint (n_requests, >=, n_cpts * 7);
+	g_assert_cmpint (n_unique, <, 16);
+}
+
+/**
+ * test_xml_intern_benchmark:
+ *
+ * Measure parsing a large collection, and report how many string
+ * allocations interning saved.
+ * Only run in performance mode ("-m perf").
+ */
+static void
+test_xml_intern_benchmark ()
+{
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(GString) xmldata = NULL;
+	g_autoptr(GError) error = NULL;
+	GPtrArray *cpts;
+	guint n_requests;
+	guint n_unique;
+	gsize saved_bytes;
+	gdouble elapsed;
+	const guint n_cpts = 50000;
+
+	xmldata = test_xml_build_collection (n_cpts);
+
+	metad = as_metadata_new ();
+	as_metadata_set_locale (metad, "ALL");
+	g_test_timer_start ();
+	as_metadata_parse (metad, xmldata->str, AS_FORMAT_KIND_XML, &error);
+	elapsed = g_test_timer_elapsed ();
+	g_assert_no_error (error);
+
+	cpts = as_metadata_get_components (metad);
+	g_assert_cmpint (cpts->len, ==, n_cpts);
+
+	as_context_get_intern_stats (as_component_get_context (AS_COMPONENT (g_ptr_array_index (cpts, 0))),
+				     &n_requests, &n_unique, &saved_bytes);
+	g_test_minimized_result (elapsed, "Parsed %u components in %.3f seconds", n_cpts, elapsed);
+	g_test_maximized_result (n_requests - n_unique,
+				 "Interned %u strings: %u unique, %u allocations and %lu bytes saved",
+				 n_requests, n_unique, n_requests - n_unique, (gulong) saved_bytes);
+}
+
+/**
+ * test_xml_load_profile:
+ *
+ * Test that data which is not part of the load profile is skipped.
+ */
+static void
+test_xml_load_profile ()
+{
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(GError) error = NULL;
+	AsComponent *cpt;
+	const gchar *xmldata = "<component>\n"
+				"  <id>org.example.ProfileTest</id>\n"
+				"  <name>Profile Test</name>\n"
+				"  <summary>Tests load profiles</summary>\n"
+				"  <description><p>A long description.</p></description>\n"
+				"  <keywords><keyword>profile</keyword></keywords>\n"
+				"  <categories><category>Utility</category></categories>\n"
+				"  <screenshots>\n"
+				"    <screenshot type=\"default\"><image>https://example.org/alpha.png</image></screenshot>\n"
+				"  </screenshots>\n"
+				"  <releases>\n"
+				"    <release version=\"1.0\" date=\"2017-01-01\" />\n"
+				"  </releases>\n"
+				"  <custom><value key=\"foo\">bar</value></custom>\n"
+				"</component>\n";
+
+	metad = as_metadata_new ();
+	as_metadata_set_locale (metad, "C");
+	as_metadata_set_load_profile (metad, AS_LOAD_PROFILE_WITH_MEDIA);
+	as_metadata_parse (metad, xmldata, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+
+	cpt = as_metadata_get_component (metad);
+	g_assert_nonnull (cpt);
+	g_assert_cmpint (as_component_get_load_profile (cpt), ==, AS_LOAD_PROFILE_WITH_MEDIA);
+
+	/* basic data and screenshots are loaded */
+	g_assert_cmpstr (as_component_get_id (cpt), ==, "org.example.ProfileTest");
+	g_assert_cmpstr (as_component_get_name (cpt), ==, "Profile Test");
+	g_assert_cmpint (as_component_get_categories (cpt)->len, ==, 1);
+	g_assert_cmpint (as_component_get_screenshots (cpt)->len, ==, 1);
+
+	/* everything else is skipped */
+	g_assert_null (as_component_get_description (cpt));
+	g_assert_null (as_component_get_keywords (cpt));
+	g_assert_cmpint (as_component_get_releases (cpt)->len, ==, 0);
+	g_assert_cmpint (g_hash_table_size (as_component_get_custom (cpt)), ==, 0);
+
+	/* with the default profile, all data is there */
+	as_metadata_clear_components (metad);
+	as_metadata_set_load_profile (metad, AS_LOAD_PROFILE_FULL);
+	as_metadata_parse (metad, xmldata, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+
+	cpt = as_metadata_get_component (metad);
+	g_assert_cmpint (as_component_get_load_profile (cpt), ==, AS_LOAD_PROFILE_FULL);
+	g_assert_nonnull (as_component_get_description (cpt));
+	g_assert_cmpint (as_component_get_releases (cpt)->len, ==, 1);
+	g_assert_cmpstr (as_component_get_custom_value (cpt, "foo"), ==, "bar");
+}
+
 /**
  * main:
  */
@@ -1349,6 +1535,11 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/XML/Write/MetainfoToCollection", test_appstream_write_metainfo_to_collection);
 
+	g_test_add_func ("/XML/Read/InternStrings", test_xml_intern_strings);
+	if (g_test_perf ())
+		g_test_add_func ("/XML/Read/InternBenchmark", test_xml_intern_benchmark);
+	g_test_add_func ("/XML/Read/LoadProfile", test_xml_load_profile);
+
 	ret = g_test_run ();
 	g_free (datadir);
 	return ret;
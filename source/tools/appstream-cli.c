@@ -532,6 +532,31 @@ as_client_run_convert (char **argv, int argc)
 				   mformat);
 }
 
+/**
+ * as_client_run_diff:
+ *
+ * Compare two cache files.
+ */
+static int
+as_client_run_diff (char **argv, int argc)
+{
+	const gchar *fname1 = NULL;
+	const gchar *fname2 = NULL;
+	const gchar *command = "diff";
+
+	if (argc > 4) {
+		as_client_print_help_hint (command, argv[4]);
+		return 1;
+	}
+
+	if (argc > 2)
+		fname1 = argv[2];
+	if (argc > 3)
+		fname2 = argv[3];
+
+	return ascli_diff_caches (fname1, fname2);
+}
+
 /**
  * as_client_run_new_template:
  *
@@ -606,6 +631,7 @@ as_client_get_summary ()
 	g_string_append (string, "\n");
 	g_string_append_printf (string, "  %s - %s\n", "dump COMPONENT-ID", _("Dump raw XML metadata for a component matching the ID."));
 	g_string_append_printf (string, "  %s - %s\n", "refresh-cache    ", _("Rebuild the component metadata cache."));
+	g_string_append_printf (string, "  %s - %s\n", "diff CACHE CACHE ", _("Show the components added (+), removed (-) or changed (~) between two cache files."));
 	g_string_append (string, "\n");
 	g_string_append_printf (string, "  %s - %s\n", "validate FILE          ", _("Validate AppStream XML files for issues."));
 	g_string_append_printf (string, "  %s - %s\n", "validate-tree DIRECTORY", _("Validate an installed file-tree of an application for valid metadata."));
@@ -743,6 +769,8 @@ as_client_run (char **argv, int argc)
 		return as_client_run_status (argv, argc);
 	} else if (g_strcmp0 (command, "convert") == 0) {
 		return as_client_run_convert (argv, argc);
+	} else if (g_strcmp0 (command, "diff") == 0) {
+		return as_client_run_diff (argv, argc);
 	} else if (g_strcmp0 (command, "new-template") == 0) {
 		return as_client_run_new_template (argv, argc);
 	} else {
@@ -553,3 +553,48 @@ ascli_create_metainfo_template (const gchar *out_fname, const gchar *cpt_kind_st
 
 	return 0;
 }
+
+/**
+ * ascli_diff_print_components:
+ *
+ * Print the data-IDs of components, prefixed with a change marker.
+ */
+static void
+ascli_diff_print_components (const gchar *marker, GPtrArray *cpts)
+{
+	guint i;
+
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+		g_print ("%s %s\n", marker, as_component_get_data_id (cpt));
+	}
+}
+
+/**
+ * ascli_diff_caches:
+ *
+ * Show which components were added, removed or changed between two cache files.
+ */
+int
+ascli_diff_caches (const gchar *old_fname, const gchar *new_fname)
+{
+	g_autoptr(AsPoolDelta) delta = NULL;
+	g_autoptr(GError) error = NULL;
+
+	if (old_fname == NULL || new_fname == NULL) {
+		ascli_print_stderr (_("You need to specify an old and a new cache file."));
+		return 3;
+	}
+
+	delta = as_pool_diff_cache_files (old_fname, new_fname, &error);
+	if (delta == NULL) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+
+	ascli_diff_print_components ("+", as_pool_delta_get_added (delta));
+	ascli_diff_print_components ("-", as_pool_delta_get_removed (delta));
+	ascli_diff_print_components ("~", as_pool_delta_get_changed (delta));
+
+	return 0;
+}
@@ -60,6 +60,9 @@ int		ascli_create_metainfo_template (const gchar *out_fname,
 						const gchar *cpt_kind_str,
 						const gchar *desktop_file);
 
+int		ascli_diff_caches (const gchar *old_fname,
+				   const gchar *new_fname);
+
 
 G_END_DECLS
 
@@ -146,9 +146,17 @@ ascli_show_status (void)
 	as_pool_load (dpool, NULL, &error);
 	if (error == NULL) {
 		g_autoptr(GPtrArray) cpts = NULL;
+		g_autofree gchar *saved_str = NULL;
+		guint n_strings;
+		gsize saved_bytes;
+
 		cpts = as_pool_get_components (dpool);
+		as_utils_get_string_stats (&n_strings, &saved_bytes);
+		saved_str = g_format_size (saved_bytes);
 
 		ascli_print_stdout (_("We have information on %i software components."), cpts->len);
+		/* TRANSLATORS: Memory statistics in the status summary of ascli, the second placeholder is a size, like "1.2 MB" */
+		ascli_print_stdout (_("Sharing %u distinct strings saves %s of memory."), n_strings, saved_str);
 		/* TODO: Request the on-disk cache status from #AsPool and display it here.
 		 * ascli_print_stdout (_("The system metadata cache exists."));
 		 * ascli_print_stdout (_("The system metadata cache does not exist."));